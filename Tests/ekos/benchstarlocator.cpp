@@ -0,0 +1,57 @@
+/*  KStars Testing - Guide Star Locator Benchmark
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "benchstarlocator.h"
+#include "testframes.h"
+
+#include <cmath>
+
+BenchStarLocator::BenchStarLocator(): QObject()
+{
+}
+
+BenchStarLocator::~BenchStarLocator()
+{
+}
+
+void BenchStarLocator::benchmark_data()
+{
+    QTest::addColumn<bool>("integral");
+    QTest::addColumn<int>("boxSize");
+
+    // The tracking box sizes offered by the guide module
+    foreach (int size, QList<int>() << 16 << 32 << 64 << 128)
+    {
+        QTest::newRow(QString("direct %1").arg(size).toLatin1().constData()) << false << size;
+        QTest::newRow(QString("integral %1").arg(size).toLatin1().constData()) << true << size;
+    }
+}
+
+void BenchStarLocator::benchmark()
+{
+    QFETCH(bool, integral);
+    QFETCH(int, boxSize);
+
+    QVector<float> frame = makeFrame(640.4, 512.6, 5000, 1.8, 11);
+    QRect box(640 - boxSize/2, 512 - boxSize/2, boxSize, boxSize);
+    Vector located;
+
+    if (integral)
+    {
+        QBENCHMARK { located = StarLocator::findCentroid(frame.constData(), FRAME_WIDTH, FRAME_HEIGHT, box); }
+    }
+    else
+    {
+        QBENCHMARK { located = directFit(frame.constData(), box); }
+    }
+
+    QVERIFY(fabs(located.x - 640.4) < 0.5);
+}
+
+QTEST_GUILESS_MAIN(BenchStarLocator)
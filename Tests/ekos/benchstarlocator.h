@@ -0,0 +1,32 @@
+/*  KStars Testing - Guide Star Locator Benchmark
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef BENCHSTARLOCATOR_H
+#define BENCHSTARLOCATOR_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include "ekos/guide/starlocator.h"
+
+// Not registered with ctest. Run benchstarlocator by hand to compare the integral image to the direct fit.
+class BenchStarLocator: public QObject
+{
+  Q_OBJECT
+ public:
+
+  BenchStarLocator();
+  ~BenchStarLocator();
+
+ private slots:
+   void benchmark_data();
+   void benchmark();
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*  KStars Testing - Synthetic Guide Frames
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef TESTFRAMES_H
+#define TESTFRAMES_H
+
+#include <QRect>
+#include <QVector>
+
+#include <cmath>
+#include <cstdlib>
+
+#include "ekos/guide/starlocator.h"
+
+#define FRAME_WIDTH     1280
+#define FRAME_HEIGHT    1024
+
+// A guide frame: sky background with noise, and a gaussian star
+inline QVector<float> makeFrame(double starX, double starY, double flux, double sigma, int seed)
+{
+    QVector<float> frame(FRAME_WIDTH * FRAME_HEIGHT);
+    qsrand(seed);
+
+    for (int y=0; y < FRAME_HEIGHT; y++)
+    {
+        for (int x=0; x < FRAME_WIDTH; x++)
+        {
+            double r2 = (x - starX) * (x - starX) + (y - starY) * (y - starY);
+            double noise = 20 * (qrand() / static_cast<double>(RAND_MAX) - 0.5);
+            frame[y * FRAME_WIDTH + x] = 300 + noise + flux * exp(-r2 / (2 * sigma * sigma));
+        }
+    }
+
+    return frame;
+}
+
+// The 9x9 direct evaluation that the integral image replaces
+inline Vector directFit(const float *frame, const QRect &box)
+{
+    static double P0 = 0.906, P1 = 0.584, P2 = 0.365, P3 = 0.117, P4 = 0.049, P5 = -0.05, P6 = -0.064, P7 = -0.074, P8 = -0.094;
+
+    const int video_width = FRAME_WIDTH;
+    const float *psrc = frame + box.y() * video_width + box.x();
+    float i0, i1, i2, i3, i4, i5, i6, i7, i8;
+    int ix = 0, iy = 0;
+    int xM4;
+    const float *p;
+    double average, fit, bestFit = 0;
+
+    for (int x = 0; x < box.width(); x++)
+        for (int y = 0; y < box.height(); y++)
+        {
+            i0 = i1 = i2 = i3 = i4 = i5 = i6 = i7 = i8 = 0;
+            xM4 = x - 4;
+            p = psrc + (y - 4) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y - 3) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i7 += *p++; i6 += *p++; i7 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y - 2) * video_width + xM4; i8 += *p++; i8 += *p++; i5 += *p++; i4 += *p++; i3 += *p++; i4 += *p++; i5 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y - 1) * video_width + xM4; i8 += *p++; i7 += *p++; i4 += *p++; i2 += *p++; i1 += *p++; i2 += *p++; i4 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y + 0) * video_width + xM4; i8 += *p++; i6 += *p++; i3 += *p++; i1 += *p++; i0 += *p++; i1 += *p++; i3 += *p++; i6 += *p++; i8 += *p++;
+            p = psrc + (y + 1) * video_width + xM4; i8 += *p++; i7 += *p++; i4 += *p++; i2 += *p++; i1 += *p++; i2 += *p++; i4 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y + 2) * video_width + xM4; i8 += *p++; i8 += *p++; i5 += *p++; i4 += *p++; i3 += *p++; i4 += *p++; i5 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y + 3) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i7 += *p++; i6 += *p++; i7 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
+            p = psrc + (y + 4) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
+            average = (i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7 + i8) / 85.0;
+            fit = P0 * (i0 - average) + P1 * (i1 - 4 * average) + P2 * (i2 - 4 * average) + P3 * (i3 - 4 * average) + P4 * (i4 - 8 * average) + P5 * (i5 - 4 * average) + P6 * (i6 - 4 * average) + P7 * (i7 - 8 * average) + P8 * (i8 - 48 * average);
+            if (bestFit < fit)
+            {
+                bestFit = fit;
+                ix = x;
+                iy = y;
+            }
+        }
+
+    if (bestFit <= 50)
+        return Vector(-1,-1,-1);
+
+    double sumX = 0, sumY = 0, total = 0;
+    for (int y = iy - 4; y <= iy + 4; y++)
+    {
+        p = psrc + y * video_width + ix - 4;
+        for (int x = ix - 4; x <= ix + 4; x++)
+        {
+            double w = *p++;
+            sumX += x * w;
+            sumY += y * w;
+            total += w;
+        }
+    }
+
+    return Vector(box.x() + sumX/total, box.y() + sumY/total, 0);
+}
+
+#endif
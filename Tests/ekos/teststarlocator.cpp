@@ -0,0 +1,65 @@
+/*  KStars Testing - Guide Star Locator
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "teststarlocator.h"
+#include "testframes.h"
+
+#include <cmath>
+
+TestStarLocator::TestStarLocator(): QObject()
+{
+}
+
+TestStarLocator::~TestStarLocator()
+{
+}
+
+void TestStarLocator::matchesDirectFit_data()
+{
+    QTest::addColumn<double>("starX");
+    QTest::addColumn<double>("starY");
+    QTest::addColumn<double>("flux");
+    QTest::addColumn<double>("sigma");
+    QTest::addColumn<int>("boxSize");
+
+    QTest::newRow("bright, centered") << 640.3 << 512.7 << 20000.0 << 1.5 << 32;
+    QTest::newRow("faint") << 400.5 << 300.25 << 500.0 << 2.0 << 64;
+    QTest::newRow("wide") << 900.1 << 700.9 << 8000.0 << 3.5 << 128;
+    QTest::newRow("off center") << 630.0 << 500.0 << 5000.0 << 1.2 << 16;
+}
+
+void TestStarLocator::matchesDirectFit()
+{
+    QFETCH(double, starX);
+    QFETCH(double, starY);
+    QFETCH(double, flux);
+    QFETCH(double, sigma);
+    QFETCH(int, boxSize);
+
+    QVector<float> frame = makeFrame(starX, starY, flux, sigma, 7);
+    QRect box(qRound(starX) - boxSize/2 + 3, qRound(starY) - boxSize/2 - 2, boxSize, boxSize);
+
+    Vector expected = directFit(frame.constData(), box);
+    Vector located  = StarLocator::findCentroid(frame.constData(), FRAME_WIDTH, FRAME_HEIGHT, box);
+
+    QVERIFY(expected.x != -1);
+    QVERIFY(fabs(located.x - expected.x) < 1e-6);
+    QVERIFY(fabs(located.y - expected.y) < 1e-6);
+}
+
+void TestStarLocator::noStar()
+{
+    QVector<float> frame = makeFrame(0, 0, 0, 1, 3);
+
+    Vector located = StarLocator::findCentroid(frame.constData(), FRAME_WIDTH, FRAME_HEIGHT, QRect(600, 400, 64, 64));
+    QCOMPARE(located.x, -1.0);
+    QCOMPARE(located.y, -1.0);
+}
+
+QTEST_GUILESS_MAIN(TestStarLocator)
@@ -0,0 +1,32 @@
+/*  KStars Testing - Guide Star Locator
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef TESTSTARLOCATOR_H
+#define TESTSTARLOCATOR_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include "ekos/guide/starlocator.h"
+
+class TestStarLocator: public QObject
+{
+  Q_OBJECT
+ public:
+
+  TestStarLocator();
+  ~TestStarLocator();
+
+ private slots:
+   void matchesDirectFit_data();
+   void matchesDirectFit();
+   void noStar();
+};
+
+#endif
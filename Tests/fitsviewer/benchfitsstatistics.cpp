@@ -0,0 +1,57 @@
+/*  KStars Testing - FITS Statistics Benchmark
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "benchfitsstatistics.h"
+#include "testimages.h"
+
+BenchFITSStatistics::BenchFITSStatistics(): QObject()
+{
+}
+
+BenchFITSStatistics::~BenchFITSStatistics()
+{
+}
+
+void BenchFITSStatistics::benchmark_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<uint>("width");
+    QTest::addColumn<uint>("height");
+
+    // Guide camera, common cooled CMOS and a full frame sensor
+    QTest::newRow("uint16 1280x960") << 16 << 1280u << 960u;
+    QTest::newRow("uint16 4656x3520") << 16 << 4656u << 3520u;
+    QTest::newRow("uint16 9576x6388") << 16 << 9576u << 6388u;
+    QTest::newRow("float 1280x960") << -32 << 1280u << 960u;
+    QTest::newRow("float 4656x3520") << -32 << 4656u << 3520u;
+    QTest::newRow("float 9576x6388") << -32 << 9576u << 6388u;
+}
+
+void BenchFITSStatistics::benchmark()
+{
+    QFETCH(int, type);
+    QFETCH(uint, width);
+    QFETCH(uint, height);
+
+    uint32_t samples = width * height;
+    FITSStatistics::Channel result;
+
+    if (type == 16)
+    {
+        QVector<uint16_t> image = makeImage<uint16_t>(samples, 1, 1200, 300, 65535);
+        QBENCHMARK { FITSStatistics::calculate(image.constData(), samples, 1, &result); }
+    }
+    else
+    {
+        QVector<float> image = makeImage<float>(samples, 1, 1200, 300, 65535);
+        QBENCHMARK { FITSStatistics::calculate(image.constData(), samples, 1, &result); }
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchFITSStatistics)
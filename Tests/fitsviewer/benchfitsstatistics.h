@@ -0,0 +1,32 @@
+/*  KStars Testing - FITS Statistics Benchmark
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef BENCHFITSSTATISTICS_H
+#define BENCHFITSSTATISTICS_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include "fitsviewer/fitsstatistics.h"
+
+// Not registered with ctest, the largest frames need several hundred megabytes. Run benchfitsstatistics by hand.
+class BenchFITSStatistics: public QObject
+{
+  Q_OBJECT
+ public:
+
+  BenchFITSStatistics();
+  ~BenchFITSStatistics();
+
+ private slots:
+   void benchmark_data();
+   void benchmark();
+};
+
+#endif
@@ -0,0 +1,124 @@
+/*  KStars Testing - FITS Statistics
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "testfitsstatistics.h"
+#include "testimages.h"
+
+#include <algorithm>
+#include <cmath>
+
+TestFITSStatistics::TestFITSStatistics(): QObject()
+{
+}
+
+TestFITSStatistics::~TestFITSStatistics()
+{
+}
+
+template<typename T> static void reference(const QVector<T> &image, uint32_t samples, int channel, FITSStatistics::Channel &result)
+{
+    QVector<double> values(samples);
+    for (uint32_t i=0; i < samples; i++)
+        values[i] = image[channel * samples + i];
+
+    double sum=0;
+    result.min = result.max = values[0];
+    foreach (double value, values)
+    {
+        result.min = qMin(result.min, value);
+        result.max = qMax(result.max, value);
+        sum += value;
+    }
+    result.mean = sum / samples;
+
+    double squares=0;
+    foreach (double value, values)
+        squares += (value - result.mean) * (value - result.mean);
+    result.stddev = sqrt(squares / (samples - 1));
+
+    std::sort(values.begin(), values.end());
+    result.median = (values[(samples - 1) / 2] + values[samples / 2]) / 2.0;
+}
+
+template<typename T> static void compare(uint32_t samples, int channels, double background, double noise, double peak)
+{
+    QVector<T> image = makeImage<T>(samples, channels, background, noise, peak);
+
+    FITSStatistics::Channel results[3];
+    FITSStatistics::calculate(image.constData(), samples, channels, results);
+
+    for (int c=0; c < channels; c++)
+    {
+        FITSStatistics::Channel expected;
+        reference(image, samples, c, expected);
+
+        QCOMPARE(results[c].min, expected.min);
+        QCOMPARE(results[c].max, expected.max);
+        QCOMPARE(results[c].median, expected.median);
+        QVERIFY(fabs(results[c].mean - expected.mean) < 1e-9 * qMax(1.0, fabs(expected.mean)));
+        QVERIFY(fabs(results[c].stddev - expected.stddev) < 1e-6 * qMax(1.0, expected.stddev));
+    }
+}
+
+void TestFITSStatistics::compareToReference_data()
+{
+    QTest::addColumn<int>("type");
+    QTest::addColumn<uint>("samples");
+    QTest::addColumn<int>("channels");
+
+    // Odd and even sizes, smaller and larger than one band
+    QTest::newRow("uint8 odd") << 8 << 10001u << 1;
+    QTest::newRow("uint16 even") << 16 << 640u * 480u << 1;
+    QTest::newRow("uint16 rgb") << 16 << 321u * 241u << 3;
+    QTest::newRow("int32") << 32 << 1000u * 999u << 1;
+    QTest::newRow("float even") << -32 << 640u * 480u << 1;
+    QTest::newRow("float odd") << -32 << 777u * 555u << 3;
+    QTest::newRow("double") << -64 << 1001u * 1001u << 1;
+}
+
+void TestFITSStatistics::compareToReference()
+{
+    QFETCH(int, type);
+    QFETCH(uint, samples);
+    QFETCH(int, channels);
+
+    switch (type)
+    {
+    case 8:
+        compare<uint8_t>(samples, channels, 40, 20, 255);
+        break;
+    case 16:
+        compare<uint16_t>(samples, channels, 1200, 300, 65535);
+        break;
+    case 32:
+        compare<int32_t>(samples, channels, -500, 2000, 1e6);
+        break;
+    case -32:
+        compare<float>(samples, channels, 1200.25, 300, 65535);
+        break;
+    case -64:
+        compare<double>(samples, channels, 0.01, 0.002, 1);
+        break;
+    }
+}
+
+void TestFITSStatistics::medianOfConstantImage()
+{
+    QVector<float> image(100000, 3.5f);
+
+    FITSStatistics::Channel result;
+    FITSStatistics::calculate(image.constData(), image.size(), 1, &result);
+
+    QCOMPARE(result.min, 3.5);
+    QCOMPARE(result.max, 3.5);
+    QCOMPARE(result.median, 3.5);
+    QCOMPARE(result.stddev, 0.0);
+}
+
+QTEST_GUILESS_MAIN(TestFITSStatistics)
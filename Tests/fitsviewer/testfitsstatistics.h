@@ -0,0 +1,32 @@
+/*  KStars Testing - FITS Statistics
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef TESTFITSSTATISTICS_H
+#define TESTFITSSTATISTICS_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include "fitsviewer/fitsstatistics.h"
+
+class TestFITSStatistics: public QObject
+{
+  Q_OBJECT
+ public:
+
+  TestFITSStatistics();
+  ~TestFITSStatistics();
+
+ private slots:
+   void compareToReference_data();
+   void compareToReference();
+   void medianOfConstantImage();
+};
+
+#endif
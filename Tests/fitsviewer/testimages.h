@@ -0,0 +1,35 @@
+/*  KStars Testing - Synthetic FITS Images
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef TESTIMAGES_H
+#define TESTIMAGES_H
+
+#include <QVector>
+
+#include <cstdint>
+#include <cstdlib>
+
+// Sky background with noise and a few saturated stars, like a guide or focus frame
+template<typename T> inline QVector<T> makeImage(uint32_t samples, int channels, double background, double noise, double peak)
+{
+    QVector<T> image(samples * channels);
+    qsrand(42);
+
+    for (int i=0; i < image.size(); i++)
+    {
+        double value = background + noise * (qrand() / static_cast<double>(RAND_MAX) - 0.5);
+        if (qrand() % 997 == 0)
+            value = peak;
+        image[i] = static_cast<T>(value);
+    }
+
+    return image;
+}
+
+#endif
@@ -0,0 +1,98 @@
+/***************************************************************************
+                  test_satellite.cpp  -  KStars Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+/* Project Includes */
+#include "test_satellite.h"
+
+#include <cmath>
+
+/* The day after the epoch of the TLE, which is 2008 September 20, 12:25:40 UTC */
+#define START_JD    2454730.0
+#define STOP_JD     2454731.0
+/* Tolerance on the times of a pass, as the search refines them to a second */
+#define ONE_SECOND  ( 1.0 / 86400.0 )
+
+TestSatellite::TestSatellite() : QObject() {
+    // The International Space Station, as seen from 45 degrees North
+    m_Satellite = new Satellite( "ISS (ZARYA)",
+                                 "1 25544U 98067A   08264.51782528 -.00002182  00000-0 -11606-4 0  2927",
+                                 "2 25544  51.6416 247.4627 0006703 130.5360 325.0288 15.72125391563537" );
+    m_Geo = new GeoLocation( dms( 5.0 ), dms( 45.0 ) );
+    m_Passes = m_Satellite->findPasses( START_JD, STOP_JD, m_Geo );
+}
+
+TestSatellite::~TestSatellite() {
+    delete m_Satellite;
+    delete m_Geo;
+}
+
+// Altitude in degrees, found on a copy as findPasses() does
+double TestSatellite::altitude( double jd ) {
+    Satellite sat( *m_Satellite );
+    if ( sat.updatePos( Satellite::Instant( jd, m_Geo ) ) != 0 )
+        return -90.0;
+    return sat.alt().Degrees();
+}
+
+void TestSatellite::testPassOrder() {
+    /* A low orbit at this inclination passes several times a day at mid latitudes */
+    QVERIFY( m_Passes.size() >= 2 );
+
+    double last = START_JD;
+    foreach ( const Satellite::Pass &pass, m_Passes ) {
+        QVERIFY( pass.rise >= last );
+        QVERIFY( pass.rise < pass.culmination );
+        QVERIFY( pass.culmination < pass.set );
+        QVERIFY( pass.set <= STOP_JD );
+        QVERIFY( pass.maxAlt.Degrees() > 0.0 && pass.maxAlt.Degrees() <= 90.0 );
+
+        /* The station crosses the sky in about ten minutes */
+        QVERIFY( pass.set - pass.rise < 20.0 / 1440.0 );
+
+        last = pass.set;
+    }
+}
+
+void TestSatellite::testPassPrecision() {
+    foreach ( const Satellite::Pass &pass, m_Passes ) {
+        /* The rise and set are within a second of the horizon, and on the side above it */
+        if ( pass.rise > START_JD ) {
+            QVERIFY( altitude( pass.rise ) >= 0.0 );
+            QVERIFY( altitude( pass.rise - ONE_SECOND ) < 0.0 );
+        }
+        if ( pass.set < STOP_JD ) {
+            QVERIFY( altitude( pass.set ) >= 0.0 );
+            QVERIFY( altitude( pass.set + ONE_SECOND ) < 0.0 );
+        }
+
+        /* The culmination is the highest altitude of the pass */
+        const double maxAlt = altitude( pass.culmination );
+        QVERIFY( fabs( maxAlt - pass.maxAlt.Degrees() ) < 1.e-6 );
+
+        /* A pass that is cut may culminate where it is cut */
+        if ( pass.rise <= START_JD || pass.set >= STOP_JD )
+            continue;
+
+        QVERIFY( altitude( pass.culmination - 30.0 * ONE_SECOND ) < maxAlt );
+        QVERIFY( altitude( pass.culmination + 30.0 * ONE_SECOND ) < maxAlt );
+        QVERIFY( altitude( pass.rise + ( pass.culmination - pass.rise ) / 2.0 ) < maxAlt );
+        QVERIFY( altitude( pass.culmination + ( pass.set - pass.culmination ) / 2.0 ) < maxAlt );
+    }
+}
+
+QTEST_GUILESS_MAIN( TestSatellite )
@@ -0,0 +1,55 @@
+/***************************************************************************
+                    test_satellite.h  -  KStars Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TEST_SATELLITE_H
+#define TEST_SATELLITE_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#define UNIT_TEST
+
+#include "skyobjects/satellite.h"
+#include "auxiliary/geolocation.h"
+
+/**
+ * @class TestSatellite
+ * @short Tests for the passes of the satellites
+ */
+
+class TestSatellite : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    TestSatellite();
+    ~TestSatellite();
+
+private slots:
+    void testPassOrder();
+    void testPassPrecision();
+
+private:
+    double altitude( double jd );
+
+    Satellite *m_Satellite;
+    GeoLocation *m_Geo;
+    QList<Satellite::Pass> m_Passes;
+};
+
+#endif
@@ -0,0 +1,66 @@
+/***************************************************************************
+                   test_vsop87.cpp  -  KStars Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+
+/* Project Includes */
+#include "test_vsop87.h"
+
+#include <cmath>
+
+
+void TestVSOP87::testPosition() {
+    /*
+     * Venus on 1992 December 20, 0h TD, from Meeus, Astronomical Algorithms,
+     * example 32.a, with the complete VSOP87 theory
+     */
+    const double jm = ( 2448976.5 - 2451545.0 ) / 365250.0;
+    const int venus = VSOP87::planet( "VENUS" );
+    QVERIFY( venus != -1 );
+    QVERIFY( VSOP87::planet( "Pluto" ) == -1 );
+
+    double L = fmod( VSOP87::evaluate( venus, VSOP87::LONGITUDE, jm ) * 180.0 / M_PI, 360.0 );
+    if ( L < 0 )
+        L += 360.0;
+    double B = VSOP87::evaluate( venus, VSOP87::LATITUDE, jm ) * 180.0 / M_PI;
+    double R = VSOP87::evaluate( venus, VSOP87::RADIUS, jm );
+
+    QVERIFY( fabs( L - 26.11412 ) < 1.e-5 );
+    QVERIFY( fabs( B - ( -2.62060 ) ) < 1.e-5 );
+    QVERIFY( fabs( R - 0.724602 ) < 1.e-6 );
+}
+
+void TestVSOP87::testTruncation() {
+    /* The terms that are left out must never add up to more than the accuracy */
+    const int earth = VSOP87::planet( "earth" );
+    const int jupiter = VSOP87::planet( "jupiter" );
+    const double accuracies[] = { 1.e-8, 1.e-6, 1.e-4 };
+
+    for ( double accuracy : accuracies ) {
+        for ( double jm = -0.5; jm <= 0.5; jm += 0.0137 ) {
+            for ( int planet : { earth, jupiter } ) {
+                for ( int c = VSOP87::LONGITUDE; c <= VSOP87::RADIUS; ++c ) {
+                    VSOP87::Coordinate coordinate = (VSOP87::Coordinate) c;
+                    double full = VSOP87::evaluate( planet, coordinate, jm );
+                    double truncated = VSOP87::evaluate( planet, coordinate, jm, accuracy );
+                    QVERIFY( fabs( full - truncated ) <= accuracy );
+                }
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN( TestVSOP87 )
@@ -0,0 +1,47 @@
+/***************************************************************************
+                     test_vsop87.h  -  KStars Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TEST_VSOP87_H
+#define TEST_VSOP87_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#define UNIT_TEST
+
+#include "skyobjects/vsop87.h"
+
+/**
+ * @class TestVSOP87
+ * @short Tests for the compiled in VSOP87 series
+ */
+
+class TestVSOP87 : public QObject {
+
+    Q_OBJECT
+
+public:
+
+    TestVSOP87() : QObject() {};
+    ~TestVSOP87() {};
+
+private slots:
+    void testPosition();
+    void testTruncation();
+};
+
+#endif
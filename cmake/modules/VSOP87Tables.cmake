@@ -0,0 +1,87 @@
+# Generates a header with the VSOP87 coefficients of the planets, so that they are
+# compiled in rather than parsed from the data files at run time.
+#
+# Run in script mode:
+#   cmake -DDATA_DIR=<directory of the .vsop files> -DOUTPUT=<header> -P VSOP87Tables.cmake
+#
+# Each data file holds one series, "name.[LBR][0-5].vsop", with one term A B C
+# per line, the term being A*cos(B + C*T). The terms of all series are written
+# into three arrays, one for each of A, B and C, and VSOP87_START holds the first
+# term of each series. Missing files are empty series.
+
+set(PLANETS mercury venus earth mars jupiter saturn uranus neptune)
+set(COORDINATES L B R)
+
+set(NUMBER "[-+]?[0-9.]+([eE][-+]?[0-9]+)?")
+
+set(A_VALUES "")
+set(B_VALUES "")
+set(C_VALUES "")
+set(START "")
+set(TERMS 0)
+
+foreach(PLANET ${PLANETS})
+    foreach(COORDINATE ${COORDINATES})
+        foreach(POWER RANGE 5)
+            list(APPEND START ${TERMS})
+
+            set(FILE "${DATA_DIR}/${PLANET}.${COORDINATE}${POWER}.vsop")
+            if (EXISTS ${FILE})
+                file(READ ${FILE} CONTENT)
+                # Lines that do not hold three numbers are skipped
+                string(REGEX MATCHALL "${NUMBER}[ \t]+${NUMBER}[ \t]+${NUMBER}" LINES "${CONTENT}")
+                list(LENGTH LINES COUNT)
+
+                if (COUNT GREATER 0)
+                    math(EXPR TERMS "${TERMS} + ${COUNT}")
+
+                    string(REGEX REPLACE "(${NUMBER})[ \t]+(${NUMBER})[ \t]+(${NUMBER})" "\\1" A "${LINES}")
+                    string(REGEX REPLACE "(${NUMBER})[ \t]+(${NUMBER})[ \t]+(${NUMBER})" "\\3" B "${LINES}")
+                    string(REGEX REPLACE "(${NUMBER})[ \t]+(${NUMBER})[ \t]+(${NUMBER})" "\\5" C "${LINES}")
+
+                    string(REPLACE ";" ",\n" A "${A}")
+                    string(REPLACE ";" ",\n" B "${B}")
+                    string(REPLACE ";" ",\n" C "${C}")
+
+                    set(A_VALUES "${A_VALUES}// ${PLANET}.${COORDINATE}${POWER}\n${A},\n")
+                    set(B_VALUES "${B_VALUES}// ${PLANET}.${COORDINATE}${POWER}\n${B},\n")
+                    set(C_VALUES "${C_VALUES}// ${PLANET}.${COORDINATE}${POWER}\n${C},\n")
+                endif()
+            endif()
+        endforeach()
+    endforeach()
+endforeach()
+
+list(APPEND START ${TERMS})
+string(REPLACE ";" ", " START "${START}")
+string(REPLACE ";" "\", \"" PLANET_NAMES "${PLANETS}")
+list(LENGTH PLANETS PLANET_COUNT)
+
+file(WRITE ${OUTPUT}.tmp
+"/* Generated by VSOP87Tables.cmake from the VSOP87 data files. Do not edit. */
+
+#ifndef VSOP87TABLES_H_
+#define VSOP87TABLES_H_
+
+// Planets in the order of the tables
+static const char * const VSOP87_PLANETS[] = { \"${PLANET_NAMES}\" };
+static constexpr int VSOP87_PLANET_COUNT = ${PLANET_COUNT};
+
+// First term of each series, at (planet * 3 + coordinate) * 6 + power, followed by the number of terms
+static constexpr int VSOP87_START[] = { ${START} };
+
+static constexpr double VSOP87_A[] = {
+${A_VALUES}};
+
+static constexpr double VSOP87_B[] = {
+${B_VALUES}};
+
+static constexpr double VSOP87_C[] = {
+${C_VALUES}};
+
+#endif
+")
+
+# Only touch the header when it changes, so that it is not compiled again for nothing
+configure_file(${OUTPUT}.tmp ${OUTPUT} COPYONLY)
+file(REMOVE ${OUTPUT}.tmp)
@@ -18,6 +18,7 @@
 
 #include "binfilehelper.h"
 
+#include <QFile>
 #include <QStandardPaths>
 #include "byteorder.h"
 #include "auxiliary/kspaths.h"
@@ -26,6 +27,9 @@ class BinFileHelper;
 
 BinFileHelper::BinFileHelper() {
     fileHandle = NULL;
+    mappedFile = NULL;
+    mappedData = NULL;
+    mappedSize = 0;
     init();
 }
 
@@ -33,12 +37,15 @@ BinFileHelper::~BinFileHelper() {
     qDeleteAll( fields );
     if( fileHandle )
         closeFile();
+    unmapFile();
 }
 
 void BinFileHelper::init() {
+    unmapFile();
     if(fileHandle)
         fclose(fileHandle);
     fileHandle = NULL;
+    filePath.clear();
     indexUpdated = false;
     FDUpdated = false;
     RSUpdated = false;
@@ -78,9 +85,52 @@ FILE *BinFileHelper::openFile(const QString &fileName) {
         errnum = ERR_FILEOPEN;
         return NULL;
     }
+    filePath = FilePath;
     return fileHandle;
 }
 
+bool BinFileHelper::mapFile() {
+    if( mappedData )
+        return true;
+    if( !fileHandle || filePath.isEmpty() )
+        return false;
+
+    mappedFile = new QFile( filePath );
+    if( mappedFile->open( QIODevice::ReadOnly ) ) {
+        mappedSize = mappedFile->size();
+        if( mappedSize > 0 )
+            mappedData = mappedFile->map( 0, mappedSize );
+    }
+
+    if( !mappedData ) {
+        delete mappedFile;
+        mappedFile = NULL;
+        mappedSize = 0;
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    mappedFile->close();
+    return true;
+}
+
+void BinFileHelper::unmapFile() {
+    if( mappedFile ) {
+        if( mappedData )
+            mappedFile->unmap( mappedData );
+        delete mappedFile;
+    }
+    mappedFile = NULL;
+    mappedData = NULL;
+    mappedSize = 0;
+}
+
+const char *BinFileHelper::getMappedData( quint32 offset, quint32 length ) const {
+    if( !mappedData || (qint64) offset + length > mappedSize )
+        return NULL;
+    return reinterpret_cast<const char *>( mappedData + offset );
+}
+
 enum BinFileHelper::Errors BinFileHelper::__readHeader() {
     qint16 endian_id, i;
     char ASCII_text[125];
@@ -224,6 +274,7 @@ bool BinFileHelper::readHeader() {
 }
 
 void BinFileHelper::closeFile() {
+    unmapFile();
     fclose(fileHandle);
     fileHandle = NULL;
 }
@@ -26,6 +26,7 @@
 #include <cstdio>
 
 class QString;
+class QFile;
 
 /**
  *@short   A structure describing a data field in the file
@@ -92,6 +93,45 @@ class BinFileHelper {
 
     void closeFile();
 
+    /**
+     *@short  Map the currently open file into memory for zero-copy access to the records
+     *@note   The file must have been opened with openFile() first. The mapping is released
+     *        by closeFile() or when another file is opened.
+     *@return true if the file could be mapped, false if mapping is unsupported or failed, in
+     *        which case the caller should keep reading records through the file handle
+     */
+    bool mapFile();
+
+    /**
+     *@short  Release the memory mapping of the file, if any
+     */
+    void unmapFile();
+
+    /**
+     *@short  Check whether the file is currently memory-mapped
+     *@return true if mapFile() succeeded and the mapping has not been released
+     */
+    inline bool isMapped() const { return mappedData != NULL; }
+
+    /**
+     *@short  Returns a pointer into the mapped file
+     *@param  offset  Offset in the file at which the requested data begins
+     *@param  length  Number of bytes that the caller intends to read from there
+     *@return Pointer to the data at offset, or NULL if the file is not mapped or the
+     *        requested range lies beyond the end of the file
+     *@note   The returned data is not byte-swapped and need not be aligned
+     */
+    const char *getMappedData( quint32 offset, quint32 length ) const;
+
+    /**
+     *@short  Returns a pointer to the records stored under the given index ID in the mapped file
+     *@param  id  ID of the index entry
+     *@return Pointer to the first of getRecordCount( id ) records, or NULL if unavailable
+     */
+    inline const char *getMappedRecords( int id ) const {
+        return ( indexUpdated ? getMappedData( indexOffset.at( id ), indexCount.at( id ) * recordSize ) : NULL );
+    }
+
     /**
      *@short   Get error number
      *@return  A number corresponding to the error
@@ -131,6 +171,12 @@ class BinFileHelper {
      */
     inline FILE *getFileHandle() const { return fileHandle; }
 
+    /**
+     *@short  Get the full path of the currently open file
+     *@return The path if a file is open, an empty QString otherwise
+     */
+    inline QString getFilePath() const { return filePath; }
+
     /**
      *@short  Returns the offset in the file corresponding to the given index ID
      *@param  id  ID of the index entry whose offset is required
@@ -266,6 +312,10 @@ class BinFileHelper {
     void init();
 
     FILE *fileHandle;                     // Handle to the file.
+    QString filePath;                     // Full path of the currently open file
+    QFile *mappedFile;                    // File object owning the memory mapping, if any
+    uchar *mappedData;                    // Start of the memory-mapped file, or NULL if not mapped
+    qint64 mappedSize;                    // Size of the memory-mapped region in bytes
     QVector<unsigned long> indexOffset;   // Stores offsets corresponding to each index table entry
     QVector<unsigned int> indexCount;     // Stores number of records under each index table entry
     bool indexUpdated;                    // True if the data from the index, and associated properties have been updated
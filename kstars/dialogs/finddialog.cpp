@@ -343,6 +343,7 @@ void FindDialog::finishProcessing( SkyObject *selObj, bool resolve ) {
         QString message = i18n( "No object named %1 found.", ui->SearchBox->text() );
         KMessageBox::sorry( 0, message, i18n( "Bad object name" ) );
     } else {
+        KStarsData::Instance()->skyComposite()->updateCulledBody( selObj );
         selObj->updateCoordsNow(KStarsData::Instance()->updateNum());
         accept();
     }
@@ -8,6 +8,7 @@
  */
 
 #include <QProcess>
+#include <QTemporaryFile>
 
 #include "kstars.h"
 #include "kstarsdata.h"
@@ -181,6 +182,7 @@ Align::Align()
 
 Align::~Align()
 {
+    removeTemporaryFile();
     delete(pi);
     delete(solverFOV);
     delete(parser);
@@ -680,14 +682,14 @@ void Align::newFITS(IBLOB *bp)
             targetChip->getBinning(&binx, &biny);
 
             FITSView *currentImage   = targetChip->getImage(FITS_ALIGN);
-            FITSData *darkData       = NULL;
+            QSharedPointer<FITSData> darkData;
 
             uint16_t offsetX = x / binx;
             uint16_t offsetY = y / biny;
 
             darkData = DarkLibrary::Instance()->getDarkFrame(targetChip, exposureIN->value());
 
-            connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(bool)), this, SLOT(setCaptureComplete()));
+            connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(FITSView*,bool)), this, SLOT(setDarkFrameComplete(FITSView*,bool)));
             connect(DarkLibrary::Instance(), SIGNAL(newLog(QString)), this, SLOT(appendLogText(QString)));
 
             if (darkData)
@@ -702,6 +704,16 @@ void Align::newFITS(IBLOB *bp)
     }
 }
 
+void Align::setDarkFrameComplete(FITSView *view, bool completed)
+{
+    INDI_UNUSED(completed);
+
+    if (view != currentCCD->getChip(useGuideHead ? ISD::CCDChip::GUIDE_CCD : ISD::CCDChip::PRIMARY_CCD)->getImage(FITS_ALIGN))
+        return;
+
+    setCaptureComplete();
+}
+
 void Align::setCaptureComplete()
 {
     DarkLibrary::Instance()->disconnect(this);
@@ -712,13 +724,56 @@ void Align::setCaptureComplete()
 
     QString filename = currentData->getFilename();
 
+    // Frames received from the camera are only held in memory, but the solver needs a file
+    if (filename.isEmpty())
+    {
+        removeTemporaryFile();
+
+        QTemporaryFile tmpFile(QDir::tempPath() + "/fitsXXXXXX");
+        tmpFile.setAutoRemove(false);
+        if (tmpFile.open() == false)
+        {
+            appendLogText(i18n("Error: Unable to create a temporary file for the solver."));
+            abort();
+            return;
+        }
+        filename = tmpFile.fileName();
+        tmpFile.close();
+        tmpSolverFile = filename;
+
+        // Write a copy only, so the image stays bound to its buffer for retries and dark frame reloads
+        bool saved = false;
+        if (alignDarkFrameCheck->isChecked() || currentData->getFITSBuffer().isEmpty())
+            saved = (currentData->exportFITS(filename) == 0);
+        else
+        {
+            QFile solverFile(filename);
+            saved = solverFile.open(QIODevice::WriteOnly) && solverFile.write(currentData->getFITSBuffer()) == currentData->getFITSBuffer().size();
+        }
+
+        if (saved == false)
+        {
+            appendLogText(i18n("Error: Unable to save %1 for the solver.", filename));
+            abort();
+            return;
+        }
+    }
     // Save frame after subtraction
-    if (alignDarkFrameCheck->isChecked())
+    else if (alignDarkFrameCheck->isChecked())
         currentImage->getImageData()->saveFITS(filename);
 
     startSolving(filename);
 }
 
+void Align::removeTemporaryFile()
+{
+    if (tmpSolverFile.isEmpty())
+        return;
+
+    QFile::remove(tmpSolverFile);
+    tmpSolverFile.clear();
+}
+
 void Align::setGOTOMode(int mode)
 {
     switch (mode)
@@ -789,6 +844,8 @@ void Align::startSolving(const QString &filename, bool isGenerated)
 
 void Align::solverFinished(double orientation, double ra, double dec, double pixscale)
 {
+    removeTemporaryFile();
+
     pi->stopAnimation();
     stopB->setEnabled(false);
     solveB->setEnabled(true);
@@ -892,6 +949,8 @@ void Align::solverFailed()
 {
     KNotification::event( QLatin1String( "AlignFailed"), i18n("Astrometry alignment failed with errors") );
 
+    removeTemporaryFile();
+
     pi->stopAnimation();
     stopB->setEnabled(false);
     solveB->setEnabled(true);
@@ -913,6 +972,7 @@ void Align::solverFailed()
 void Align::abort()
 {
     parser->stopSolver();
+    removeTemporaryFile();
     pi->stopAnimation();
     stopB->setEnabled(false);
     solveB->setEnabled(true);
@@ -937,6 +997,9 @@ void Align::abort()
 
     ISD::CCDChip *targetChip = currentCCD->getChip(useGuideHead ? ISD::CCDChip::GUIDE_CCD : ISD::CCDChip::PRIMARY_CCD);
 
+    // Frames that are still being loaded are not solved
+    targetChip->cancelFrames();
+
     // If capture is still in progress, let's stop that.
     if (targetChip->isCapturing())
     {
@@ -269,6 +269,9 @@ public slots:
     // Capture
     void setCaptureComplete();
 
+    /* The dark frame of view is subtracted. Views of the other modules are ignored. */
+    void setDarkFrameComplete(FITSView *view, bool completed);
+
 private slots:
     /* Solver Options */
     void checkLineEdits();
@@ -352,6 +355,11 @@ private:
      */
     QStringList getSolverOptionsFromFITS(const QString &filename);
 
+    /**
+     * @brief removeTemporaryFile Removes the file the last frame was saved to for the solver, if it was created by the Alignment module.
+     */
+    void removeTemporaryFile();
+
     // Which chip should we invoke in the current CCD?
     bool useGuideHead;
     // Can the mount sync its coordinates to those set by Ekos?
@@ -437,6 +445,9 @@ private:
     ISD::CCD::UploadMode rememberUploadMode;
 
     QString dirPath;
+
+    // Temporary file of the frame being solved, if it was only held in memory
+    QString tmpSolverFile;
 };
 
 }
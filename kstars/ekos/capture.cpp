@@ -33,6 +33,7 @@
 
 #include "fitsviewer/fitsviewer.h"
 #include "fitsviewer/fitsview.h"
+#include "fitsviewer/fitswriter.h"
 
 #include "darklibrary.h"
 #include "ekosmanager.h"
@@ -115,6 +116,7 @@ Capture::Capture()
     //seqWatcher		= new KDirWatch();
     seqTimer = new QTimer(this);
     connect(seqTimer, SIGNAL(timeout()), this, SLOT(captureImage()));
+    connect(FITSWriter::Instance(), SIGNAL(frameWritten(QString,bool)), this, SLOT(checkFrameWritten(QString,bool)));
 
     connect(startB, SIGNAL(clicked()), this, SLOT(toggleSequence()));
     connect(pauseB, SIGNAL(clicked()), this, SLOT(pause()));
@@ -442,6 +444,10 @@ void Capture::stop(bool abort)
 
     if (abort)
     {
+        // Frames that are still being loaded are not wanted anymore
+        if (targetChip)
+            targetChip->cancelFrames();
+
         startB->setIcon(QIcon::fromTheme("media-playback-start", QIcon(":/icons/breeze/default/media-playback-start.svg") ));
         startB->setToolTip(i18n("Start Sequence"));
         pauseB->setEnabled(false);
@@ -451,6 +457,8 @@ void Capture::stop(bool abort)
         button->setEnabled(true);
 
     seqTimer->stop();
+    disconnect(FITSWriter::Instance(), SIGNAL(ready()), this, SLOT(resumeAfterWrite()));
+    writingFile.clear();
 
 }
 
@@ -872,6 +880,15 @@ bool Capture::startNextExposure()
         return false;
     }
 
+    // Images are written in the background. If they pile up, the disk is slower than the exposures, so wait for it.
+    if (FITSWriter::Instance()->isBusy())
+    {
+        secondsLabel->setText(i18n("Writing..."));
+        appendLogText(i18np("Waiting for an image to be written to disk...", "Waiting for %1 images to be written to disk...", FITSWriter::Instance()->pendingFrames()));
+        connect(FITSWriter::Instance(), SIGNAL(ready()), this, SLOT(resumeAfterWrite()), Qt::UniqueConnection);
+        return true;
+    }
+
     if (seqDelay > 0)
     {
         secondsLabel->setText(i18n("Waiting..."));
@@ -884,6 +901,25 @@ bool Capture::startNextExposure()
     return true;
 }
 
+void Capture::resumeAfterWrite()
+{
+    disconnect(FITSWriter::Instance(), SIGNAL(ready()), this, SLOT(resumeAfterWrite()));
+
+    startNextExposure();
+}
+
+void Capture::checkFrameWritten(const QString &filename, bool success)
+{
+    if (success == false)
+        appendLogText(i18n("Failed to save image to %1", filename));
+
+    if (writingFile.isEmpty() || filename != writingFile)
+        return;
+
+    writingFile.clear();
+    processCapturedImage();
+}
+
 void Capture::newFITS(IBLOB *bp)
 {
     ISD::CCDChip *tChip = NULL;
@@ -892,6 +928,8 @@ void Capture::newFITS(IBLOB *bp)
     if (activeJob == NULL || meridianFlipStage >= MF_ALIGNING)
         return;
 
+    capturedFile.clear();
+
     if (currentCCD->getUploadMode() != ISD::CCD::UPLOAD_LOCAL)
     {
         if (bp == NULL)
@@ -924,16 +962,19 @@ void Capture::newFITS(IBLOB *bp)
         disconnect(currentCCD, SIGNAL(BLOBUpdated(IBLOB*)), this, SLOT(newFITS(IBLOB*)));
         disconnect(currentCCD, SIGNAL(newImage(QImage*, ISD::CCDChip*)), this, SLOT(sendNewImage(QImage*, ISD::CCDChip*)));
 
+        // Name of the file the image is saved to, which may still be queued for writing
+        capturedFile = bp->aux2 ? QString(static_cast<char *>(bp->aux2)) : QString();
+
         if (useGuideHead == false && darkSubCheck->isChecked() && activeJob->isPreview())
         {
             FITSView *currentImage   = targetChip->getImage(FITS_NORMAL);
-            FITSData *darkData       = NULL;
+            QSharedPointer<FITSData> darkData;
             uint16_t offsetX = activeJob->getSubX() / activeJob->getXBin();
             uint16_t offsetY = activeJob->getSubY() / activeJob->getYBin();
 
             darkData = DarkLibrary::Instance()->getDarkFrame(targetChip, activeJob->getExposure());
 
-            connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(bool)), this, SLOT(setCaptureComplete()));
+            connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(FITSView*,bool)), this, SLOT(setDarkFrameComplete(FITSView*,bool)));
             connect(DarkLibrary::Instance(), SIGNAL(newLog(QString)), this, SLOT(appendLogText(QString)));
 
             if (darkData)
@@ -949,6 +990,16 @@ void Capture::newFITS(IBLOB *bp)
 
 }
 
+void Capture::setDarkFrameComplete(FITSView *view, bool completed)
+{
+    INDI_UNUSED(completed);
+
+    if (view != targetChip->getImage(FITS_NORMAL))
+        return;
+
+    setCaptureComplete();
+}
+
 bool Capture::setCaptureComplete()
 {
     disconnect(currentCCD, SIGNAL(newExposureValue(ISD::CCDChip*,double,IPState)), this, SLOT(updateCaptureProgress(ISD::CCDChip*,double,IPState)));
@@ -994,6 +1045,21 @@ bool Capture::setCaptureComplete()
 
     currentImgCountOUT->setText( QString::number(seqCurrentCount));
 
+    // The job completion and the post capture script may use the file, so wait until it is written.
+    // Otherwise the next exposure starts while the image is still being written.
+    bool needsFile = seqCurrentCount >= seqTotalCount || Options::postCaptureScript().isEmpty() == false;
+    if (needsFile && capturedFile.isEmpty() == false && FITSWriter::Instance()->isPending(capturedFile))
+    {
+        secondsLabel->setText(i18n("Writing..."));
+        writingFile = capturedFile;
+        return true;
+    }
+
+    return processCapturedImage();
+}
+
+bool Capture::processCapturedImage()
+{
     // if we're done
     if (seqCurrentCount >= seqTotalCount)
     {
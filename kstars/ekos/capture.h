@@ -449,6 +449,10 @@ private slots:
 
     // Capture
     bool setCaptureComplete();
+    /* The dark frame of view is subtracted. Views of the other modules are ignored. */
+    void setDarkFrameComplete(FITSView *view, bool completed);
+    void resumeAfterWrite();
+    void checkFrameWritten(const QString &filename, bool success);
 
     // Temporary for post capture script
     void postScriptFinished(int exitCode);
@@ -475,6 +479,8 @@ private:
     void syncGUIToJob(SequenceJob *job);
     bool processJobInfo(XMLEle *root);
     void processJobCompletion();
+    /* Move on with the sequence once the captured image is on disk */
+    bool processCapturedImage();
     bool saveSequenceQueue(const QString &path);
     void constructPrefix(QString &imagePrefix);
     double setCurrentADU(double value);
@@ -587,6 +593,9 @@ private:
     // Temporary Only
     QProcess postCaptureScript;
 
+    // File of the last captured image, and the file the sequence waits for to be written
+    QString capturedFile, writingFile;
+
 
 };
 
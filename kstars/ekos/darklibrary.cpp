@@ -8,6 +8,7 @@
  */
 
 #include <QVariantMap>
+#include <QtConcurrent>
 
 #include "darklibrary.h"
 #include "Options.h"
@@ -34,8 +35,10 @@ DarkLibrary * DarkLibrary::Instance()
 
 DarkLibrary::DarkLibrary(QObject *parent) : QObject(parent)
 {
-    KStarsData::Instance()->userdb()->GetAllDarkFrames(darkFrames);
-
+    QList<QVariantMap> frames;
+    KStarsData::Instance()->userdb()->GetAllDarkFrames(frames);
+    foreach(const QVariantMap &map, frames)
+        addToIndex(map);
 
     subtractParams.duration=0;
     subtractParams.offsetX=0;
@@ -49,82 +52,101 @@ DarkLibrary::DarkLibrary(QObject *parent) : QObject(parent)
 
 DarkLibrary::~DarkLibrary()
 {
-    qDeleteAll(darkFiles);
+    foreach(QFutureWatcher<bool> *watcher, subtractJobs.keys())
+        watcher->waitForFinished();
+}
+
+QString DarkLibrary::indexKey(const QString &ccd, int chip, int binX, int binY)
+{
+    return QString("%1/%2/%3x%4").arg(ccd).arg(chip).arg(binX).arg(binY);
+}
+
+void DarkLibrary::addToIndex(const QVariantMap &map)
+{
+    DarkFrameInfo info;
+    info.filename    = map["filename"].toString();
+    info.temperature = map["temperature"].toDouble();
+    info.timestamp   = map.contains("timestamp") ? QDateTime::fromString(map["timestamp"].toString(), Qt::ISODate) : QDateTime::currentDateTime();
+
+    QString key = indexKey(map["ccd"].toString(), map["chip"].toInt(), map["binX"].toInt(), map["binY"].toInt());
+    darkFrames[key].insert(map["duration"].toDouble(), info);
 }
 
-FITSData * DarkLibrary::getDarkFrame(ISD::CCDChip *targetChip, double duration)
+QSharedPointer<FITSData> DarkLibrary::getDarkFrame(ISD::CCDChip *targetChip, double duration)
 {
-    foreach(QVariantMap map, darkFrames)
+    int binX, binY;
+    targetChip->getBinning(&binX, &binY);
+
+    QString key = indexKey(targetChip->getCCD()->getDeviceName(), static_cast<int>(targetChip->getType()), binX, binY);
+    if (darkFrames.contains(key) == false)
+        return QSharedPointer<FITSData>();
+
+    bool hasCooler = targetChip->getCCD()->hasCooler();
+    double temperature=0;
+    if (hasCooler)
+        targetChip->getCCD()->getTemperature(&temperature);
+
+    QDateTime now = QDateTime::currentDateTime();
+    const DarkFrameInfo *best = NULL;
+    double bestDiff = 0;
+
+    // Only the frames within the duration tolerance are looked at
+    // TODO make this value configurable
+    const QMultiMap<double, DarkFrameInfo> &frames = darkFrames[key];
+    for (QMultiMap<double, DarkFrameInfo>::const_iterator it = frames.lowerBound(duration - 0.05); it != frames.end() && it.key() <= duration + 0.05; ++it)
     {
-        // First check CCD name matches
-        if (map["ccd"].toString() == targetChip->getCCD()->getDeviceName())
+        const DarkFrameInfo &info = it.value();
+
+        double diff = hasCooler ? fabs(info.temperature - temperature) : 0;
+        if (diff > Options::maxDarkTemperatureDiff())
+            continue;
+
+        // Check if the age of the frame is acceptable
+        if (info.timestamp.daysTo(now) > Options::darkLibraryDuration())
+            continue;
+
+        // Prefer the closest temperature, then the most recent frame
+        if (best == NULL || diff < bestDiff || (diff == bestDiff && info.timestamp > best->timestamp))
         {
-            // Then check we are on the correct chip
-            if (map["chip"].toInt() == static_cast<int>(targetChip->getType()))
-            {
-                int binX, binY;
-                targetChip->getBinning(&binX, &binY);
-
-                // Then check if binning is the same
-                if (map["binX"].toInt() == binX && map["binY"].toInt() == binY)
-                {
-                    // Then check for temperature
-                    if (targetChip->getCCD()->hasCooler())
-                    {
-                        double temperature=0;
-                        targetChip->getCCD()->getTemperature(&temperature);
-                        // TODO make this configurable value, the threshold
-                        if (fabs(map["temperature"].toDouble()-temperature) > Options::maxDarkTemperatureDiff())
-                            continue;
-                    }
-
-                    // Then check for duration
-                    // TODO make this value configurable
-                    if (fabs(map["duration"].toDouble() - duration) > 0.05)
-                        continue;
-
-                    // Finaly check if the duration is acceptable
-                    QDateTime frameTime = QDateTime::fromString(map["timestamp"].toString(), Qt::ISODate);
-                    if (frameTime.daysTo(QDateTime::currentDateTime()) > Options::darkLibraryDuration())
-                        continue;
-
-                    QString filename = map["filename"].toString();
-
-                    if (darkFiles.contains(filename))
-                        return darkFiles[filename];
-
-                    // Finally we made it, let's put it in the hash
-                    bool rc = loadDarkFile(filename);
-                    if (rc)
-                        return darkFiles[filename];
-                    else
-                        return NULL;
-                }
-            }
+            best     = &info;
+            bestDiff = diff;
         }
     }
 
-    return NULL;
+    if (best == NULL)
+        return QSharedPointer<FITSData>();
+
+    if (QSharedPointer<FITSData> *cached = darkFiles.object(best->filename))
+        return *cached;
+
+    return loadDarkFile(best->filename);
 }
 
-bool DarkLibrary::loadDarkFile(const QString &filename)
+void DarkLibrary::cacheDarkFile(const QString &filename, QSharedPointer<FITSData> darkData)
 {
-    FITSData *darkData = new FITSData();
+    darkFiles.setMaxCost(Options::darkLibraryCacheSize() * 1024);
 
-    bool rc = darkData->loadFITS(filename);
+    int cost = darkData->getSize() * darkData->getNumOfChannels() * darkData->getBytesPerPixel() / 1024 + 1;
+    // Frames larger than the whole cache are not kept, the cache deletes the pointer then
+    darkFiles.insert(filename, new QSharedPointer<FITSData>(darkData), cost);
+}
 
-    if (rc)
-        darkFiles[filename] = darkData;
-    else
+QSharedPointer<FITSData> DarkLibrary::loadDarkFile(const QString &filename)
+{
+    QSharedPointer<FITSData> darkData(new FITSData());
+
+    if (darkData->loadFITS(filename) == false)
     {
         emit newLog(i18n("Failed to load dark frame file %1", filename));
-        delete (darkData);
+        return QSharedPointer<FITSData>();
     }
 
-    return rc;
+    cacheDarkFile(filename, darkData);
+
+    return darkData;
 }
 
-bool DarkLibrary::saveDarkFile(FITSData *darkData)
+bool DarkLibrary::saveDarkFile(QSharedPointer<FITSData> darkData)
 {
     QDateTime ts = QDateTime::currentDateTime();
 
@@ -133,7 +155,7 @@ bool DarkLibrary::saveDarkFile(FITSData *darkData)
     if (darkData->saveFITS(path) != 0)
         return false;
 
-    darkFiles[path] = darkData;
+    cacheDarkFile(path, darkData);
 
     QVariantMap map;
     int binX, binY;
@@ -150,7 +172,7 @@ bool DarkLibrary::saveDarkFile(FITSData *darkData)
     map["duration"] = subtractParams.duration;
     map["filename"] = path;
 
-    darkFrames.append(map);
+    addToIndex(map);
 
     emit newLog(i18n("Dark frame saved to %1", path));
 
@@ -159,45 +181,84 @@ bool DarkLibrary::saveDarkFile(FITSData *darkData)
     return true;
 }
 
-bool DarkLibrary::subtract(FITSData *darkData, FITSView *lightImage, FITSScale filter, uint16_t offsetX, uint16_t offsetY)
+bool DarkLibrary::subtract(QSharedPointer<FITSData> darkData, FITSView *lightImage, FITSScale filter, uint16_t offsetX, uint16_t offsetY)
 {
    Q_ASSERT(darkData);
    Q_ASSERT(lightImage);
 
-   FITSData *lightData = lightImage->getImageData();
+   QSharedPointer<FITSData> lightData = lightImage->getSharedImageData();
 
-   float *darkBuffer     = darkData->getImageBuffer();
-   float *lightBuffer    = lightData->getImageBuffer();
-
-   int darkoffset   = offsetX + offsetY * darkData->getWidth();
-   int darkW        = darkData->getWidth();
-
-   int lightOffset  = 0;
-   int lightW       = lightData->getWidth();
-   int lightH       = lightData->getHeight();
-
-   for (int i=0; i < lightH; i++)
+   // The light frame must lie within the dark frame
+   if (offsetX + lightData->getWidth() > darkData->getWidth() || offsetY + lightData->getHeight() > darkData->getHeight()
+           || darkData->getNumOfChannels() != lightData->getNumOfChannels())
    {
-       for (int j=0; j < lightW; j++)
-       {
-           lightBuffer[j+lightOffset] -= darkBuffer[j+darkoffset];
-           if (lightBuffer[j+lightOffset] < 0)
-               lightBuffer[j+lightOffset] = 0;
-       }
-
-       lightOffset += lightW;
-       darkoffset  += darkW;
+       emit newLog(i18n("Dark frame does not match the light frame."));
+       emit darkFrameCompleted(lightImage, false);
+       return false;
    }
 
-   lightData->applyFilter(filter);
-   lightImage->rescale(ZOOM_KEEP_LEVEL);
-   lightImage->updateFrame();
-
-   emit darkFrameCompleted(true);
+   // The view keeps painting and analysing the light frame meanwhile, so the subtraction runs on a copy
+   // that replaces the image buffer once it is done
+   SubtractJob job;
+   job.darkData   = darkData;
+   job.lightData  = lightData;
+   job.lightImage = lightImage;
+   job.view       = lightImage;
+   job.loadCount  = lightImage->getLoadCount();
+   job.filter     = filter;
+   job.source     = lightData->getDisplayBuffer();
+   job.orientation= lightData->getOrientation();
+   job.buffer     = lightData->copyImageBuffer();
+
+   uint8_t *light      = job.buffer;
+   int lightType       = lightData->getDataType();
+   int width           = lightData->getWidth();
+   int height          = lightData->getHeight();
+   const uint8_t *dark = darkData->getImageBuffer();
+   int darkType        = darkData->getDataType();
+   int darkWidth       = darkData->getWidth();
+   long darkOffset     = offsetX + offsetY * darkWidth;
+
+   // Runs on a worker thread, and only touches the copy. The job holds on to the dark frame until it is done.
+   QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+   subtractJobs[watcher] = job;
+   connect(watcher, SIGNAL(finished()), this, SLOT(subtractFinished()));
+   watcher->setFuture(QtConcurrent::run([=]()
+   {
+       FITSData::subtractBuffer(light, lightType, width, height, dark, darkType, darkOffset, darkWidth);
+       return true;
+   }));
 
    return true;
 }
 
+void DarkLibrary::subtractFinished()
+{
+    QFutureWatcher<bool> *watcher = static_cast<QFutureWatcher<bool> *>(sender());
+    SubtractJob job = subtractJobs.take(watcher);
+    bool rc = watcher->result();
+    watcher->deleteLater();
+
+    // The view was closed, shows another frame by now, or the frame was rotated meanwhile
+    if (job.lightImage.isNull() || job.lightImage->getLoadCount() != job.loadCount
+            || job.lightData->getDisplayBuffer() != job.source || job.lightData->getOrientation() != job.orientation)
+    {
+        delete[] job.buffer;
+        rc = false;
+    }
+    else
+    {
+        job.lightData->setImageBuffer(job.buffer);
+        job.lightData->calculateStats(true);
+        // Filters are not meant to run off the GUI thread
+        job.lightData->applyFilter(job.filter);
+        job.lightImage->rescale(ZOOM_KEEP_LEVEL);
+        job.lightImage->updateFrame();
+    }
+
+    emit darkFrameCompleted(job.view, rc);
+}
+
 void DarkLibrary::captureAndSubtract(ISD::CCDChip *targetChip, FITSView*targetImage, double duration, uint16_t offsetX, uint16_t offsetY)
 {
     QStringList shutterfulCCDs  = Options::shutterfulCCDs();
@@ -260,17 +321,18 @@ void DarkLibrary::newFITS(IBLOB *bp)
 
     emit newLog(i18n("Dark frame received."));
 
-    FITSData *calibrationData = new FITSData();
+    QSharedPointer<FITSData> calibrationData(new FITSData());
 
     // Deep copy of the data
-    if (calibrationData->loadFITS(calibrationView->getImageData()->getFilename()))
+    FITSData *sourceData = calibrationView->getImageData();
+    if (calibrationData->loadFITS(sourceData->getFilename(), true, sourceData->getFITSBuffer()))
     {
         saveDarkFile(calibrationData);
         subtract(calibrationData, subtractParams.targetImage, subtractParams.targetChip->getCaptureFilter(), subtractParams.offsetX, subtractParams.offsetY);
     }
     else
     {
-        emit darkFrameCompleted(false);
+        emit darkFrameCompleted(subtractParams.targetImage, false);
         emit newLog(i18n("Warning: Cannot load calibration file %1", calibrationView->getImageData()->getFilename()));
     }
 }
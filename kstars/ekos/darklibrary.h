@@ -11,6 +11,14 @@
 #define DARKLIBRARY_H
 
 #include <QObject>
+#include <QCache>
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QMultiMap>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QTransform>
+
 #include "indi/indiccd.h"
 
 namespace Ekos
@@ -20,6 +28,11 @@ namespace Ekos
  *@class DarkLibrary
  *@short Handles aquisition & loading of dark frames for cameras. If a suitable dark frame exists, it is loaded from disk, otherwise it gets captured and saved
  * for later use.
+ *
+ * The dark frames of the user database are indexed by camera, chip and binning, and ordered by duration within each of them. Loaded dark frames
+ * are kept in a cache that drops the least recently used ones once they exceed the memory set in the options. Subtraction runs on a worker thread,
+ * and darkFrameCompleted() is emitted with the view of the light frame once it is updated. Several modules may subtract at once, so each of them
+ * must only handle the completion of its own view.
  *@author Jasem Mutlaq
  *@version 1.0
  */
@@ -32,12 +45,13 @@ public:
 
     static DarkLibrary *Instance();
 
-    FITSData * getDarkFrame(ISD::CCDChip *targetChip, double duration);
-    bool subtract(FITSData *darkData, FITSView *lightImage, FITSScale filter, uint16_t offsetX, uint16_t offsetY);
+    QSharedPointer<FITSData> getDarkFrame(ISD::CCDChip *targetChip, double duration);
+    bool subtract(QSharedPointer<FITSData> darkData, FITSView *lightImage, FITSScale filter, uint16_t offsetX, uint16_t offsetY);
     void captureAndSubtract(ISD::CCDChip *targetChip, FITSView*targetImage, double duration, uint16_t offsetX, uint16_t offsetY);
 
 signals:
-    void darkFrameCompleted(bool);
+    /* The dark frame is subtracted from the light frame of view, or failed to */
+    void darkFrameCompleted(FITSView *view, bool completed);
     void newLog(const QString &message);
 
 public slots:
@@ -47,16 +61,46 @@ public slots:
      */
     void newFITS(IBLOB *bp);
 
+private slots:
+    void subtractFinished();
+
 private:
   DarkLibrary(QObject *parent);
   ~DarkLibrary();
   static DarkLibrary * _DarkLibrary;
 
-  bool loadDarkFile(const QString &filename);
-  bool saveDarkFile(FITSData *darkData);
+  struct DarkFrameInfo
+  {
+      QString filename;
+      double temperature;
+      QDateTime timestamp;
+  };
+
+  static QString indexKey(const QString &ccd, int chip, int binX, int binY);
+  void addToIndex(const QVariantMap &map);
 
-  QList<QVariantMap> darkFrames;
-  QHash<QString, FITSData *> darkFiles;
+  QSharedPointer<FITSData> loadDarkFile(const QString &filename);
+  bool saveDarkFile(QSharedPointer<FITSData> darkData);
+  void cacheDarkFile(const QString &filename, QSharedPointer<FITSData> darkData);
+
+  // Dark frames of each camera, chip and binning, by duration
+  QHash<QString, QMultiMap<double, DarkFrameInfo> > darkFrames;
+  // Loaded dark frames by file name, costing their size in kilobytes
+  QCache<QString, QSharedPointer<FITSData> > darkFiles;
+
+  struct SubtractJob
+  {
+      QSharedPointer<FITSData> darkData;
+      QSharedPointer<FITSData> lightData;
+      QPointer<FITSView> lightImage;
+      FITSView *view;
+      int loadCount;
+      FITSScale filter;
+      const uint8_t *source;    // Image buffer of the light frame when the job started
+      QTransform orientation;   // and its orientation
+      uint8_t *buffer;          // Copy of it that the dark frame is subtracted from
+  };
+  QHash<QFutureWatcher<bool> *, SubtractJob> subtractJobs;
 
   struct
   {
@@ -28,6 +28,7 @@
 #include "fitsviewer/fitsviewer.h"
 #include "fitsviewer/fitstab.h"
 #include "fitsviewer/fitsview.h"
+#include "fitsviewer/fitsanalyzer.h"
 #include "ekosmanager.h"
 #include "darklibrary.h"
 
@@ -72,6 +73,9 @@ Focus::Focus()
     m_autoFocusSuccesful = false;
     filterPositionPending= false;
 
+    analyzer = new FITSAnalyzer(this);
+    connect(analyzer, SIGNAL(measured(int,double,QPointF)), this, SLOT(processFrame(int,double,QPointF)));
+
     rememberUploadMode = ISD::CCD::UPLOAD_CLIENT;
     HFRInc =0;
     noStarCount=0;
@@ -92,6 +96,7 @@ Focus::Focus()
     minPos=1e6;
     maxPos=0;
     frameNum=0;
+    HFRStarSequence=-1;
 
     connect(startFocusB, SIGNAL(clicked()), this, SLOT(start()));
     connect(stopFocusB, SIGNAL(clicked()), this, SLOT(checkStopFocus()));
@@ -749,12 +754,15 @@ void Focus::abort()
     frameNum=0;
     //maxHFR=1;
 
+    analyzer->cancel();
+
     disconnect(currentCCD, SIGNAL(BLOBUpdated(IBLOB*)), this, SLOT(newFITS(IBLOB*)));
 
     if (rememberUploadMode != currentCCD->getUploadMode())
         currentCCD->setUploadMode(rememberUploadMode);
 
     targetChip->abortExposure();
+    targetChip->cancelFrames();
 
     //resetFrame();
 
@@ -954,14 +962,14 @@ void Focus::newFITS(IBLOB *bp)
     if (darkFrameCheck->isChecked())
     {
         FITSView *currentImage   = targetChip->getImage(FITS_FOCUS);
-        FITSData *darkData       = NULL;
+        QSharedPointer<FITSData> darkData;
         QVariantMap settings = frameSettings[targetChip];
         uint16_t offsetX = settings["x"].toInt() / settings["binx"].toInt();
         uint16_t offsetY = settings["y"].toInt() / settings["biny"].toInt();
 
         darkData = DarkLibrary::Instance()->getDarkFrame(targetChip, exposureIN->value());
 
-        connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(bool)), this, SLOT(setCaptureComplete()));
+        connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(FITSView*,bool)), this, SLOT(setDarkFrameComplete(FITSView*,bool)));
         connect(DarkLibrary::Instance(), SIGNAL(newLog(QString)), this, SLOT(appendLogText(QString)));
 
         if (darkData)
@@ -975,6 +983,16 @@ void Focus::newFITS(IBLOB *bp)
     setCaptureComplete();
 }
 
+void Focus::setDarkFrameComplete(FITSView *view, bool completed)
+{
+    INDI_UNUSED(completed);
+
+    if (view != currentCCD->getChip(ISD::CCDChip::PRIMARY_CCD)->getImage(FITS_FOCUS))
+        return;
+
+    setCaptureComplete();
+}
+
 void Focus::setCaptureComplete()
 {
     DarkLibrary::Instance()->disconnect(this);
@@ -1029,18 +1047,41 @@ void Focus::setCaptureComplete()
     starPixmap = targetImage->getTrackingBoxPixmap();
     emit newStarPixmap(starPixmap);
 
-    // If we're not framing, let's try to detect stars
-    if (inFocusLoop == false || (inFocusLoop && targetImage->isTrackingBoxEnabled()))
+    // If we're not framing, let's try to detect stars. They are searched on a worker thread, and the frame is processed once they are found.
+    if ((inFocusLoop == false || targetImage->isTrackingBoxEnabled()) && image_data->areStarsSearched() == false)
     {
-        if (image_data->areStarsSearched() == false)
+        int sequence;
+        if (targetImage->isTrackingBoxEnabled())
         {
-            if (targetImage->isTrackingBoxEnabled())
-                image_data->findStars(targetImage->getTrackingBox());
-            else
-                image_data->findStars();
+            // Only the box around the star is searched, so the frames to average at this position are queued.
+            // The next one is exposed while the ones before are measured.
+            sequence = analyzer->analyze(targetImage, FITSAnalyzer::ANALYZE_STAR_IN_BOX, targetImage->getTrackingBox(), inFocusLoop);
+
+            if (sequence != -1 && inFocusLoop == false && frameNum + analyzer->pendingFrames() < focusFramesSpin->value())
+                capture();
         }
+        else
+            sequence = analyzer->analyze(targetImage);
 
-        currentHFR= image_data->getHFR(HFR_MAX);
+        if (sequence != -1)
+            return;
+    }
+
+    Edge *maxStar = image_data->getMaxHFRStar();
+    processFrame(-1, image_data->getHFR(HFR_MAX), maxStar ? QPointF(maxStar->x, maxStar->y) : QPointF(-1, -1));
+}
+
+void Focus::processFrame(int sequence, double HFR, const QPointF &star)
+{
+    ISD::CCDChip *targetChip = currentCCD->getChip(ISD::CCDChip::PRIMARY_CCD);
+    FITSView *targetImage = targetChip->getImage(FITS_FOCUS);
+
+    int subBinX=1, subBinY=1;
+    targetChip->getBinning(&subBinX, &subBinY);
+
+    if (inFocusLoop == false || (inFocusLoop && targetImage->isTrackingBoxEnabled()))
+    {
+        currentHFR= HFR;
 
         /*if (currentHFR == -1)
         {
@@ -1050,6 +1091,18 @@ void Focus::setCaptureComplete()
         if (Options::focusLogging())
             qDebug() << "Focus newFITS #" << frameNum+1 << ": Current HFR " << currentHFR;
 
+        if (frameNum == 0)
+        {
+            HFRStar = QPointF(-1, -1);
+            HFRStarSequence = -1;
+        }
+
+        if (sequence >= HFRStarSequence)
+        {
+            HFRStar = star;
+            HFRStarSequence = sequence;
+        }
+
         HFRFrames[frameNum++] = currentHFR;
 
         if (frameNum >= focusFramesSpin->value())
@@ -1063,7 +1116,9 @@ void Focus::setCaptureComplete()
         }
         else
         {
-            capture();
+            // The next frame may be exposing already
+            if (captureInProgress == false && frameNum + analyzer->pendingFrames() < focusFramesSpin->value())
+                capture();
             return;
         }
 
@@ -1080,16 +1135,14 @@ void Focus::setCaptureComplete()
             //if (starSelected && inAutoFocus)
             if (starCenter.isNull() == false && inAutoFocus)
             {
-                Edge *maxStarHFR = image_data->getMaxHFRStar();
-
-                if (maxStarHFR)
+                if (HFRStar.x() >= 0)
                 {
                     //int x = qMax(0, static_cast<int>(maxStarHFR->x-focusBoxSize->value()/(2*subBinX)));
                     //int y = qMax(0, static_cast<int>(maxStarHFR->y-focusBoxSize->value()/(2*subBinY)));
 
                     //targetImage->setTrackingBox(QRect(x, y, focusBoxSize->value(), focusBoxSize->value()));
-                    starCenter.setX(qMax(0, static_cast<int>(maxStarHFR->x)));
-                    starCenter.setY(qMax(0, static_cast<int>(maxStarHFR->y)));
+                    starCenter.setX(qMax(0, static_cast<int>(HFRStar.x())));
+                    starCenter.setY(qMax(0, static_cast<int>(HFRStar.y())));
                     targetImage->setTrackingBox(QRect( (starCenter.x()-focusBoxSize->value()/(2*subBinX)), starCenter.y()-focusBoxSize->value()/(2*subBinY), focusBoxSize->value()/subBinX, focusBoxSize->value()/subBinY));
                 }
             }
@@ -1133,8 +1186,9 @@ void Focus::setCaptureComplete()
 
         if (kcfg_autoSelectStar->isEnabled() && kcfg_autoSelectStar->isChecked() && focusType == FOCUS_AUTO)
         {
-            Edge *maxStar = image_data->getMaxHFRStar();
-            if (maxStar == NULL)
+            // The star of the frame that was measured, which the view may not show anymore
+            const QPointF maxStar = HFRStar;
+            if (maxStar.x() < 0)
             {
                 appendLogText(i18n("Failed to automatically select a star. Please select a star manually."));
 
@@ -1156,8 +1210,8 @@ void Focus::setCaptureComplete()
             if (subFramed == false && kcfg_subFrame->isEnabled() && kcfg_subFrame->isChecked())
             {
                 int offset = focusBoxSize->value();
-                int subX=(maxStar->x - offset) * subBinX;
-                int subY=(maxStar->y - offset) * subBinY;
+                int subX=(maxStar.x() - offset) * subBinX;
+                int subY=(maxStar.y() - offset) * subBinY;
                 int subW=offset*2*subBinX;
                 int subH=offset*2*subBinY;
 
@@ -1203,8 +1257,8 @@ void Focus::setCaptureComplete()
             }
             else
             {
-                starCenter.setX(maxStar->x);
-                starCenter.setY(maxStar->y);
+                starCenter.setX(maxStar.x());
+                starCenter.setY(maxStar.y());
             }
 
             starCenter.setZ(subBinX);
@@ -20,6 +20,7 @@
 #include "indi/indistd.h"
 #include "indi/indifocuser.h"
 
+class FITSAnalyzer;
 
 namespace Ekos
 {
@@ -326,6 +327,12 @@ private slots:
 
     void setCaptureComplete();
 
+    /* The dark frame of view is subtracted. Views of the other modules are ignored. */
+    void setDarkFrameComplete(FITSView *view, bool completed);
+
+    /* Carry on focusing with the HFR and the star measured in a frame. Sequence is the one of the analysis, or -1 if there was none. */
+    void processFrame(int sequence, double HFR, const QPointF &star);
+
 signals:
         void newLog();
         void autoFocusFinished(bool status, double finalHFR);
@@ -436,6 +443,12 @@ private:
     int activeBin;
     // HFR values for captured frames before averages
     double HFRFrames[5];
+    // Brightest star of the newest frame of the average, and the sequence of its analysis.
+    // Frames may be measured out of order, so the one the view shows is not necessarily the newest.
+    QPointF HFRStar;
+    int HFRStarSequence;
+    // Searches the frames for stars on a worker thread
+    FITSAnalyzer *analyzer;
 
     QStringList logText;
     ITextVectorProperty *filterName;
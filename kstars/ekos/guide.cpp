@@ -29,6 +29,7 @@
 
 #include "fitsviewer/fitsviewer.h"
 #include "fitsviewer/fitsview.h"
+#include "fitsviewer/fitsanalyzer.h"
 
 #include "guide/rcalibration.h"
 #include "guideadaptor.h"
@@ -83,6 +84,10 @@ Guide::Guide() : QWidget()
 
     connect(calibration, SIGNAL(newStatus(Ekos::GuideState)), this, SLOT(setStatus(Ekos::GuideState)));
 
+    // Frames for auto star selection are searched on a worker thread, then processed again
+    analyzer = new FITSAnalyzer(this);
+    connect(analyzer, SIGNAL(analyzed(int,FITSView*)), this, SLOT(setCaptureComplete()));
+
     guider = new internalGuider(pmath, this);
 
     connect(guider, SIGNAL(ditherToggled(bool)), this, SIGNAL(ditherToggled(bool)));
@@ -491,13 +496,13 @@ void Guide::newFITS(IBLOB *bp)
         targetChip->getBinning(&binx,&biny);
 
         FITSView *currentImage   = targetChip->getImage(FITS_GUIDE);
-        FITSData *darkData       = NULL;
+        QSharedPointer<FITSData> darkData;
         uint16_t offsetX = x / binx;
         uint16_t offsetY = y / biny;
 
         darkData = DarkLibrary::Instance()->getDarkFrame(targetChip, exposureIN->value());
 
-        connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(bool)), this, SLOT(setCaptureComplete()));
+        connect(DarkLibrary::Instance(), SIGNAL(darkFrameCompleted(FITSView*,bool)), this, SLOT(setDarkFrameComplete(FITSView*,bool)));
         connect(DarkLibrary::Instance(), SIGNAL(newLog(QString)), this, SLOT(appendLogText(QString)));
 
         if (darkData)
@@ -515,6 +520,16 @@ void Guide::newFITS(IBLOB *bp)
     setCaptureComplete();
 }
 
+void Guide::setDarkFrameComplete(FITSView *view, bool completed)
+{
+    INDI_UNUSED(completed);
+
+    if (view != currentCCD->getChip(useGuideHead ? ISD::CCDChip::GUIDE_CCD : ISD::CCDChip::PRIMARY_CCD)->getImage(FITS_GUIDE))
+        return;
+
+    setCaptureComplete();
+}
+
 void Guide::setCaptureComplete()
 {
 
@@ -545,6 +560,12 @@ void Guide::setCaptureComplete()
     int subBinX=1, subBinY=1;
     targetChip->getBinning(&subBinX, &subBinY);
 
+    // Auto star selection needs the stars of the whole frame. Look for them first.
+    if (calibration->useAutoStar() && image_data->areStarsSearched() == false
+            && (calibration->getCalibrationStage() == internalCalibration::CAL_CAPTURE_IMAGE || calibration->getCalibrationStage() == internalCalibration::CAL_SELECT_STAR)
+            && analyzer->analyze(targetImage) != -1)
+        return;
+
     // It should be false in case we do not need to process the image for motion
     // which happens when we take an image for auto star selection.
     if (calibration->setImageView(targetImage) == false)
@@ -838,6 +859,8 @@ bool Guide::startCalibration()
 
 bool Guide::stopCalibration()
 {
+    analyzer->cancel();
+
     if (Options::useEkosGuider())
         return calibration->stopCalibration();
     else
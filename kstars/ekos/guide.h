@@ -26,6 +26,7 @@ class cgmath;
 class internalCalibration;
 class internalGuider;
 class FITSData;
+class FITSAnalyzer;
 
 namespace Ekos
 {
@@ -277,6 +278,8 @@ public slots:
 
      // Capture
      void setCaptureComplete();
+     /* The dark frame of view is subtracted. Views of the other modules are ignored. */
+     void setDarkFrameComplete(FITSView *view, bool completed);
 
 protected slots:
         void updateCCDBin(int index);
@@ -328,6 +331,7 @@ private:
     internalCalibration *calibration;
     internalGuider *guider;
     PHD2 *phd2;
+    FITSAnalyzer *analyzer;
 
     bool useGuideHead;
     bool isSuspended;
@@ -18,6 +18,7 @@
 
 #include "vect.h"
 #include "matr.h"
+#include "starlocator.h"
 
 #include "fitsviewer/fitsview.h"
 
@@ -129,7 +130,7 @@ void cgmath::setImageView(FITSView *image)
     if (guideView)
     {
         FITSData *image_data = guideView->getImageData();
-        setDataBuffer(image_data->getImageBuffer());
+        setDataBuffer(image_data->getFloatBuffer());
         setVideoParameters(image_data->getWidth(), image_data->getHeight());
     }
 }
@@ -597,8 +598,6 @@ void cgmath::setLostStar(bool is_lost)
 
 Vector cgmath::findLocalStarPosition( void ) const
 {
-    static double P0 = 0.906, P1 = 0.584, P2 = 0.365, P3 = 0.117, P4 = 0.049, P5 = -0.05, P6 = -0.064, P7 = -0.074, P8 = -0.094;
-
     Vector ret;
     int i, j;
     double resx, resy, mass, threshold, pval;
@@ -629,66 +628,8 @@ Vector cgmath::findLocalStarPosition( void ) const
     switch( square_alg_idx )
     {
     case CENTROID_THRESHOLD:
-    {
-        int width = trackingBox.width();
-        int height = trackingBox.width();
-        float i0, i1, i2, i3, i4, i5, i6, i7, i8;
-        int ix = 0, iy = 0;
-        int xM4;
-        float *p;
-        double average, fit, bestFit = 0;
-        int minx = 0;
-        int maxx = width;
-        int miny = 0;
-        int maxy = height;
-        for (int x = minx; x < maxx; x++)
-            for (int y = miny; y < maxy; y++)
-            {
-                i0 = i1 = i2 = i3 = i4 = i5 = i6 = i7 = i8 = 0;
-                xM4 = x - 4;
-                p = psrc + (y - 4) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y - 3) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i7 += *p++; i6 += *p++; i7 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y - 2) * video_width + xM4; i8 += *p++; i8 += *p++; i5 += *p++; i4 += *p++; i3 += *p++; i4 += *p++; i5 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y - 1) * video_width + xM4; i8 += *p++; i7 += *p++; i4 += *p++; i2 += *p++; i1 += *p++; i2 += *p++; i4 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y + 0) * video_width + xM4; i8 += *p++; i6 += *p++; i3 += *p++; i1 += *p++; i0 += *p++; i1 += *p++; i3 += *p++; i6 += *p++; i8 += *p++;
-                p = psrc + (y + 1) * video_width + xM4; i8 += *p++; i7 += *p++; i4 += *p++; i2 += *p++; i1 += *p++; i2 += *p++; i4 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y + 2) * video_width + xM4; i8 += *p++; i8 += *p++; i5 += *p++; i4 += *p++; i3 += *p++; i4 += *p++; i5 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y + 3) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i7 += *p++; i6 += *p++; i7 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
-                p = psrc + (y + 4) * video_width + xM4; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++; i8 += *p++;
-                average = (i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7 + i8) / 85.0;
-                fit = P0 * (i0 - average) + P1 * (i1 - 4 * average) + P2 * (i2 - 4 * average) + P3 * (i3 - 4 * average) + P4 * (i4 - 8 * average) + P5 * (i5 - 4 * average) + P6 * (i6 - 4 * average) + P7 * (i7 - 8 * average) + P8 * (i8 - 48 * average);
-                if (bestFit < fit)
-                {
-                    bestFit = fit;
-                    ix = x;
-                    iy = y;
-                }
-            }
+        return StarLocator::findCentroid(pdata, video_width, video_height, trackingBox);
 
-        if (bestFit > 50)
-        {
-            double sumX = 0;
-            double sumY = 0;
-            double total = 0;
-            for (int y = iy - 4; y <= iy + 4; y++) {
-                p = psrc + y * width + ix - 4;
-                for (int x = ix - 4; x <= ix + 4; x++) {
-                    double w = *p++;
-                    sumX += x * w;
-                    sumY += y * w;
-                    total += w;
-                }
-            }
-            if (total > 0)
-            {
-                ret = (Vector(trackingBox.x(), trackingBox.y(), 0) + Vector(sumX/total , sumY/total, 0));
-                return ret;
-            }
-        }
-
-       return Vector(-1,-1,-1);
-    }
-        break;
         // Alexander's Stepanenko smart threshold algorithm
     case SMART_THRESHOLD:
     {
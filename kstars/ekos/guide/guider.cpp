@@ -454,6 +454,7 @@ bool internalGuider::stop()
     logFile.close();
 
     targetChip->abortExposure();
+    targetChip->cancelFrames();
 
     if (m_useRapidGuide)
         guideModule->stopRapidGuide();
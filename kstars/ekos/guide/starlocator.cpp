@@ -0,0 +1,142 @@
+/*  Ekos guide tool
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "starlocator.h"
+
+#include <QVector>
+
+// The fit covers the pixels up to this distance around a position
+#define LOCATOR_RADIUS	4
+// Fits below this are noise
+#define LOCATOR_MIN_FIT	50
+
+namespace
+{
+
+// Sum of the pixels dx0..dx1, dy0..dy1 around the position at index of the integral image
+inline double boxSum(const double *sat, int stride, int index, int dx0, int dx1, int dy0, int dy1)
+{
+    return sat[index + (dy1+1)*stride + dx1+1] - sat[index + dy0*stride + dx1+1]
+         - sat[index + (dy1+1)*stride + dx0]   + sat[index + dy0*stride + dx0];
+}
+
+// Fit of the star profile at the position at index. Ring k holds the pixels at the k-th distance from the position,
+// with the irregular ring 7 and the remaining ring 8 as the profile expects them.
+inline double fitAt(const double *sat, int stride, int index)
+{
+    static const double P0 = 0.906, P1 = 0.584, P2 = 0.365, P3 = 0.117, P4 = 0.049, P5 = -0.05, P6 = -0.064, P7 = -0.074, P8 = -0.094;
+
+    const double r00 = boxSum(sat, stride, index,  0, 0,  0, 0);
+    const double r10 = boxSum(sat, stride, index, -1, 1,  0, 0);
+    const double r01 = boxSum(sat, stride, index,  0, 0, -1, 1);
+    const double r11 = boxSum(sat, stride, index, -1, 1, -1, 1);
+    const double r20 = boxSum(sat, stride, index, -2, 2,  0, 0);
+    const double r02 = boxSum(sat, stride, index,  0, 0, -2, 2);
+    const double r21 = boxSum(sat, stride, index, -2, 2, -1, 1);
+    const double r12 = boxSum(sat, stride, index, -1, 1, -2, 2);
+    const double r22 = boxSum(sat, stride, index, -2, 2, -2, 2);
+    const double r30 = boxSum(sat, stride, index, -3, 3,  0, 0);
+    const double r03 = boxSum(sat, stride, index,  0, 0, -3, 3);
+    const double r13 = boxSum(sat, stride, index, -1, 1, -3, 3);
+    const double r44 = boxSum(sat, stride, index, -4, 4, -4, 4);
+    // Ring 7 also holds the two pixels left of the position, one row above and below it
+    const double left = boxSum(sat, stride, index, -3, -3, -1, 1) - boxSum(sat, stride, index, -3, -3, 0, 0);
+
+    const double i0 = r00;
+    const double i1 = r10 + r01 - 2*r00;
+    const double i2 = r11 - r10 - r01 + r00;
+    const double i3 = r20 + r02 - r10 - r01;
+    const double i4 = r21 + r12 - 2*r11 - r20 - r02 + r10 + r01;
+    const double i5 = r22 - r21 - r12 + r11;
+    const double i6 = r30 + r03 - r20 - r02;
+    const double i7 = r13 - r12 - r03 + r02 + left;
+    const double i8 = r44 - r22 - r30 + r20 - r13 + r12 - left;
+
+    const double average = r44 / 85.0;
+    return P0 * (i0 - average) + P1 * (i1 - 4 * average) + P2 * (i2 - 4 * average) + P3 * (i3 - 4 * average) + P4 * (i4 - 8 * average)
+         + P5 * (i5 - 4 * average) + P6 * (i6 - 4 * average) + P7 * (i7 - 8 * average) + P8 * (i8 - 48 * average);
+}
+
+}
+
+Vector StarLocator::findCentroid(const float *frame, int frameWidth, int frameHeight, const QRect &box)
+{
+    const int R = LOCATOR_RADIUS;
+
+    // Positions too close to the edges of the frame for a fit are left out
+    QRect positions = box.intersected(QRect(R, R, frameWidth - 2*R, frameHeight - 2*R));
+    if (frame == NULL || positions.isEmpty())
+        return Vector(-1,-1,-1);
+
+    QRect region = positions.adjusted(-R, -R, R, R);
+
+    // Integral image of the region, with a row and a column of zeros ahead of it
+    const int stride = region.width() + 1;
+    QVector<double> sat(stride * (region.height() + 1), 0);
+    for (int y=0; y < region.height(); y++)
+    {
+        const float *row = frame + (region.y() + y) * frameWidth + region.x();
+        const double *above = sat.constData() + y * stride;
+        double *current = sat.data() + (y+1) * stride;
+        double rowSum = 0;
+
+        for (int x=0; x < region.width(); x++)
+        {
+            rowSum += row[x];
+            current[x+1] = above[x+1] + rowSum;
+        }
+    }
+
+    // Evaluate a row of positions at a time, so the fits vectorize, then pick the best
+    const double *s = sat.constData();
+    QVector<double> fits(positions.width());
+    double bestFit = 0;
+    int ix = 0, iy = 0;
+
+    for (int y=positions.top(); y <= positions.bottom(); y++)
+    {
+        const int rowIndex = (y - region.y()) * stride - region.x();
+        double *f = fits.data();
+
+        for (int x=positions.left(); x <= positions.right(); x++)
+            f[x - positions.left()] = fitAt(s, stride, rowIndex + x);
+
+        for (int x=0; x < fits.size(); x++)
+        {
+            // Ties go to the leftmost position, then to the topmost
+            if (bestFit < f[x] || (bestFit == f[x] && bestFit > 0 && positions.left() + x < ix))
+            {
+                bestFit = f[x];
+                ix = positions.left() + x;
+                iy = y;
+            }
+        }
+    }
+
+    if (bestFit <= LOCATOR_MIN_FIT)
+        return Vector(-1,-1,-1);
+
+    double sumX = 0, sumY = 0, total = 0;
+    for (int y = iy - R; y <= iy + R; y++)
+    {
+        const float *p = frame + y * frameWidth;
+        for (int x = ix - R; x <= ix + R; x++)
+        {
+            double w = p[x];
+            sumX += x * w;
+            sumY += y * w;
+            total += w;
+        }
+    }
+
+    if (total > 0)
+        return Vector(sumX/total, sumY/total, 0);
+
+    return Vector(-1,-1,-1);
+}
@@ -0,0 +1,41 @@
+/*  Ekos guide tool
+    Copyright (C) 2026 KStars Team <kstars-devel@kde.org>
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef STARLOCATOR_H_
+#define STARLOCATOR_H_
+
+#include <QRect>
+
+#include "vect.h"
+
+/**
+ * @class StarLocator
+ * @short Finds the guide star in the tracking box, for the CENTROID_THRESHOLD algorithm.
+ *
+ * A star profile is fitted to the 9x9 pixels around each position of the
+ * box, from the sums of the rings of pixels at increasing distances. The
+ * rings are combined from rectangles of an integral image of the box, so a
+ * fit costs the same few lookups whatever the size of the box. The position
+ * that fits best is refined to the centroid of the pixels around it.
+ */
+class StarLocator
+{
+public:
+    /**
+     * @short Find the guide star.
+     * @param frame the pixels of the guide frame
+     * @param frameWidth the width of the frame
+     * @param frameHeight the height of the frame
+     * @param box the tracking box, in frame pixels
+     * @return the centroid of the star in frame pixels, or (-1,-1,-1) if no star was found.
+     */
+    static Vector findCentroid(const float *frame, int frameWidth, int frameHeight, const QRect &box);
+};
+
+#endif
@@ -115,7 +115,7 @@ bool OnlineAstrometryParser::startSovler(const QString &in_filename, const QStri
                 display_image->setColor(i, qRgb(i,i,i));
 
             image_data->getMinMax(&min, &max);
-            float *image_buffer = image_data->getImageBuffer();
+            float *image_buffer = image_data->getFloatBuffer();
 
             bscale = 255. / (max - min);
             bzero  = (-min) * (255. / (max - min));
@@ -29,6 +29,7 @@
 #include "skymapcomposite.h"
 #include "kstarsdata.h"
 #include "ksmoon.h"
+#include "ksephemeris.h"
 #include "ksalmanac.h"
 #include "ksutils.h"
 #include "mosaic.h"
@@ -1012,6 +1013,11 @@ void Scheduler::pause()
 
 void Scheduler::evaluateJobs()
 {
+    // The moon separation is scored at many times of the coming day
+    KSEphemeris::Scope ephemeris;
+    KStarsDateTime ut = KStarsData::Instance()->ut();
+    KSEphemeris::Instance()->prepare(ut.djd(), ut.djd() + 2.0, QList<int>() << KSEphemeris::MOON << KSEphemeris::EARTH);
+
     foreach(SchedulerJob *job, jobs)
     {
         if (job->getState() > SchedulerJob::JOB_SCHEDULED)
@@ -720,13 +720,14 @@ dc1394error_t
 dc1394_bayer_VNG_float(const float * bayer, float * dst, int sx, int sy, int offsetX, int offsetY, dc1394color_filter_t pattern)
 {
     const int height = sy, width = sx;
-    static const signed char *cp;
+    const signed char *cp;
     /* the following has the same type as the image */
     float (*brow[5])[3], *pix;          /* [FD] */
     int code[8][2][320], *ip, gval[8], gmin, gmax, sum[4];
     int row, col, x, y, x1, x2, y1, y2, t, weight, grads, diag;
     int g, diff, thold, num;
-    uint32_t c, color;
+    int c;                                /* signed, as it is added to negative offsets */
+    uint32_t color;
     uint32_t filters;                     /* [FD] */
 
     /* first, use bilinear bayer decoding */
@@ -0,0 +1,200 @@
+/***************************************************************************
+                          fitsanalyzer.cpp  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fitsanalyzer.h"
+
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include "fitsdata.h"
+#include "fitsview.h"
+
+// Worker threads shared by all analyzers. The star detector spreads its own work over the global pool.
+#define ANALYSIS_THREADS    2
+
+FITSAnalyzer::FITSAnalyzer(QObject *parent) : QObject(parent)
+{
+    lastSequence = 0;
+    firstSequence.store(0);
+}
+
+FITSAnalyzer::~FITSAnalyzer()
+{
+    cancel();
+
+    // The workers read firstSequence, so they must be done before it goes away
+    foreach (QFutureWatcher<bool> *watcher, jobs.keys())
+    {
+        watcher->waitForFinished();
+        delete jobs[watcher].copy;
+        delete watcher;
+    }
+}
+
+QThreadPool * FITSAnalyzer::threadPool()
+{
+    static QThreadPool *pool = NULL;
+
+    if (pool == NULL)
+    {
+        pool = new QThreadPool(qApp);
+        pool->setMaxThreadCount(ANALYSIS_THREADS);
+    }
+
+    return pool;
+}
+
+int FITSAnalyzer::analyze(FITSView *view, Analysis analysis, const QRectF &boundary, bool supersede)
+{
+    if (view == NULL || view->getImageData() == NULL)
+        return -1;
+
+    Job job;
+    QRectF box;
+
+    if (analysis == ANALYZE_STAR_IN_BOX)
+    {
+        job.copy = view->getImageData()->createAnalysisCopy(boundary.toAlignedRect());
+        if (job.copy)
+            box = boundary.translated(-job.copy->getOrigin());
+    }
+    else
+        job.copy = view->getImageData()->createAnalysisCopy();
+
+    if (job.copy == NULL)
+        return -1;
+
+    job.sequence  = ++lastSequence;
+    job.loadCount = view->getLoadCount();
+    job.view      = view;
+    job.data      = view->getImageData();
+
+    if (supersede)
+        firstSequence.store(job.sequence);
+
+    QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+    jobs[watcher] = job;
+    connect(watcher, SIGNAL(finished()), this, SLOT(analysisFinished()));
+
+    watcher->setFuture(QtConcurrent::run(threadPool(), analyzeJob, job.copy, box, job.sequence, &firstSequence));
+
+    return job.sequence;
+}
+
+int FITSAnalyzer::load(QSharedPointer<FITSData> data, const QString &filename, const QByteArray &buffer, bool supersede)
+{
+    Job job;
+    job.sequence  = ++lastSequence;
+    job.loadCount = 0;
+    job.data      = NULL;
+    job.copy      = NULL;
+    job.loading   = data;
+
+    if (supersede)
+        firstSequence.store(job.sequence);
+
+    QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+    jobs[watcher] = job;
+    connect(watcher, SIGNAL(finished()), this, SLOT(analysisFinished()));
+
+    watcher->setFuture(QtConcurrent::run(threadPool(), loadJob, data, filename, buffer, job.sequence, &firstSequence));
+
+    return job.sequence;
+}
+
+void FITSAnalyzer::cancel()
+{
+    firstSequence.store(lastSequence + 1);
+}
+
+int FITSAnalyzer::pendingFrames() const
+{
+    int count=0;
+
+    // Dropped frames wait for their worker too, but are not counted
+    foreach (const Job &job, jobs)
+    {
+        if (job.sequence >= firstSequence.load())
+            count++;
+    }
+
+    return count;
+}
+
+// Runs on a worker thread, so it must not touch anything but the copy.
+bool FITSAnalyzer::analyzeJob(FITSData *copy, QRectF boundary, int sequence, QAtomicInt *first)
+{
+    if (sequence < first->load())
+        return false;
+
+    if (boundary.isNull() == false)
+        copy->estimateBackground(boundary.toAlignedRect());
+
+    copy->findStars(boundary);
+
+    return true;
+}
+
+// Runs on a worker thread. Nothing else refers to the data until it is loaded.
+bool FITSAnalyzer::loadJob(QSharedPointer<FITSData> data, QString filename, QByteArray buffer, int sequence, QAtomicInt *first)
+{
+    if (sequence < first->load())
+        return false;
+
+    return data->loadFITS(filename, true, buffer);
+}
+
+void FITSAnalyzer::analysisFinished()
+{
+    QFutureWatcher<bool> *watcher = static_cast<QFutureWatcher<bool> *>(sender());
+    Job job = jobs.take(watcher);
+    bool rc = watcher->result();
+
+    watcher->deleteLater();
+
+    if (job.loading)
+    {
+        if (job.sequence >= firstSequence.load())
+            emit loaded(job.sequence, rc ? job.loading : QSharedPointer<FITSData>());
+        return;
+    }
+
+    if (rc == false || job.sequence < firstSequence.load())
+    {
+        delete job.copy;
+        return;
+    }
+
+    double HFR = job.copy->getHFR(HFR_MAX);
+
+    // The copy may hold only a box of the image
+    QPointF star(-1, -1);
+    if (Edge *maxStar = job.copy->getMaxHFRStar())
+        star = QPointF(maxStar->x + job.copy->getOrigin().x(), maxStar->y + job.copy->getOrigin().y());
+
+    // The frame must still be shown, and must be the one that was copied
+    if (job.view && job.view->getLoadCount() == job.loadCount && job.view->getImageData() == job.data)
+    {
+        job.data->takeStars(job.copy);
+        emit analyzed(job.sequence, job.view);
+    }
+
+    delete job.copy;
+
+    emit measured(job.sequence, HFR, star);
+}
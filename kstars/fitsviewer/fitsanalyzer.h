@@ -0,0 +1,127 @@
+/***************************************************************************
+                          fitsanalyzer.h  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FITSANALYZER_H_
+#define FITSANALYZER_H_
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QPointer>
+#include <QPointF>
+#include <QRectF>
+#include <QSharedPointer>
+
+class QThreadPool;
+class FITSData;
+class FITSView;
+
+/**
+ * @class FITSAnalyzer
+ * @short Loads FITS frames, and searches them for stars and their HFR, on a worker thread.
+ *
+ * Each Ekos module that analyzes its frames owns an analyzer, and so does each
+ * chip of a CCD to load the frames it receives. All analyzers share a small pool
+ * of worker threads, so that the GUI and INDI stay responsive while large frames
+ * are decoded, their statistics calculated and their stars searched.
+ *
+ * A frame is loaded with load(), which decodes it into new image data together
+ * with its statistics, and emits loaded() on the GUI thread once it is done.
+ *
+ * The view may load the next frame at any time, so the worker searches a copy of
+ * the pixels. To search the star within a box, only the box and a border around
+ * it are copied, and the background is estimated from the border rather than from
+ * the whole frame. When the search is done, measured() is emitted on the GUI thread
+ * with the sequence number that analyze() returned. If the view still shows the
+ * frame, the stars are handed to its image and analyzed() is emitted as well.
+ *
+ * A frame is dropped, without a signal, if it was cancelled or if a newer frame
+ * superseded it. Frames that are dropped before the worker gets to them are not
+ * searched at all. Frames that do not supersede the ones before them are queued,
+ * so that several frames can be measured while the next ones are exposed.
+ */
+class FITSAnalyzer : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef enum { ANALYZE_STARS, ANALYZE_STAR_IN_BOX } Analysis;
+
+    FITSAnalyzer(QObject *parent=NULL);
+    ~FITSAnalyzer();
+
+    /**
+     * @short Analyze the image that view shows.
+     * @param view view of the frame, which must have stars searched only through this analyzer until it is done
+     * @param analysis search all stars of the frame, or the single star within boundary
+     * @param boundary area of the star, in image pixels, for ANALYZE_STAR_IN_BOX
+     * @param supersede drop the frames that are not analyzed yet
+     * @return sequence number of the frame, or -1 if there is no image to analyze
+     */
+    int analyze(FITSView *view, Analysis analysis=ANALYZE_STARS, const QRectF &boundary=QRectF(), bool supersede=true);
+
+    /**
+     * @short Load a frame, and calculate its statistics.
+     * @param data image data to load the frame into, which nothing else may use until loaded() is emitted
+     * @param filename name of the frame, see FITSData::loadFITS()
+     * @param buffer FITS file in memory, or empty to read filename
+     * @param supersede drop the frames that are not done yet
+     * @return sequence number of the frame
+     */
+    int load(QSharedPointer<FITSData> data, const QString &filename, const QByteArray &buffer=QByteArray(), bool supersede=false);
+
+    /* Drop all frames that are not analyzed yet */
+    void cancel();
+
+    /* Number of frames that are still to be analyzed */
+    int pendingFrames() const;
+
+signals:
+    /* The stars of the frame are found. HFR is the one of the brightest star, or -1 if there is none.
+       Star is the position of that star in the pixels of the whole image, or (-1,-1). */
+    void measured(int sequence, double HFR, const QPointF &star);
+    /* The stars of the frame are found, and the image of view has them */
+    void analyzed(int sequence, FITSView *view);
+    /* The frame is loaded into data, or failed to load, in which case data is null */
+    void loaded(int sequence, QSharedPointer<FITSData> data);
+
+private slots:
+    void analysisFinished();
+
+private:
+    struct Job
+    {
+        int sequence;
+        int loadCount;
+        QPointer<FITSView> view;
+        FITSData *data;
+        FITSData *copy;
+        QSharedPointer<FITSData> loading;  // Data that a frame is loaded into, for load()
+    };
+
+    static bool analyzeJob(FITSData *copy, QRectF boundary, int sequence, QAtomicInt *first);
+    static bool loadJob(QSharedPointer<FITSData> data, QString filename, QByteArray buffer, int sequence, QAtomicInt *first);
+    static QThreadPool *threadPool();
+
+    QHash<QFutureWatcher<bool> *, Job> jobs;
+    int lastSequence;
+    // First frame that is still wanted. Read by the workers to skip frames that are superseded.
+    QAtomicInt firstSequence;
+};
+
+#endif
@@ -23,11 +23,14 @@
 #include <cmath>
 #include <cstdlib>
 #include <climits>
+#include <algorithm>
 
 #include <QApplication>
 #include <QLocale>
 #include <QFile>
 #include <QProgressDialog>
+#include <QThread>
+#include <QtConcurrent>
 
 #ifndef KSTARS_LITE
 #include <KMessageBox>
@@ -40,6 +43,7 @@
 #include <wcs.h>
 #endif
 
+#include "fitsstardetector.h"
 #include "ksutils.h"
 #include "Options.h"
 
@@ -49,29 +53,34 @@
 #define ZOOM_LOW_INCR	10
 #define ZOOM_HIGH_INCR	50
 
-const int MINIMUM_ROWS_PER_CENTER=3;
+#define SMALL_SCALE_SQUARE  256
 
-#define DIFFUSE_THRESHOLD       0.15
+// Rows and columns around a strip that the bayer decoders interpolate from, and the smallest strip worth a thread
+#define DEBAYER_HALO        4
+#define DEBAYER_MIN_STRIP   64
 
-#define MAX_EDGE_LIMIT  10000
-#define LOW_EDGE_CUTOFF_1   50
-#define LOW_EDGE_CUTOFF_2   10
-#define MINIMUM_EDGE_LIMIT  2
-#define SMALL_SCALE_SQUARE  256
+// Pixels around the box of a star that are copied along to estimate the background from
+#define ANALYSIS_BORDER     16
 
-bool greaterThan(Edge *s1, Edge *s2)
-{
-    //return s1->width > s2->width;
-    return s1->sum > s2->sum;
-}
+// Interpolated sky coordinates are checked against exact ones at the center of each grid cell.
+// The grid is refined until they agree to within WCS_GRID_TOLERANCE arcseconds, down to WCS_GRID_MIN_STEP pixels.
+#define WCS_GRID_MAX_STEP   64
+#define WCS_GRID_MIN_STEP   4
+#define WCS_GRID_TOLERANCE  0.1
 
 FITSData::FITSData(FITSMode fitsMode)
 {
     channels = 0;
     image_buffer = NULL;
+    float_buffer = NULL;
     bayer_buffer = NULL;
-    wcs_coord    = NULL;
+    wcs          = NULL;
+    nwcs         = 0;
+    wcsGridCols  = 0;
+    wcsGridStep  = 0;
     fptr = NULL;
+    fitsMemory = NULL;
+    fitsMemorySize = 0;
     maxHFRStar = NULL;
     darkFrame = NULL;
     tempFile  = false;
@@ -94,7 +103,7 @@ FITSData::~FITSData()
     if (starCenters.count() > 0)
         qDeleteAll(starCenters);
 
-    delete[] wcs_coord;
+    clearWCS();
 
     if (fptr)
     {
@@ -106,7 +115,7 @@ FITSData::~FITSData()
     }
 }
 
-bool FITSData::loadFITS (const QString &inFilename, bool silent)
+bool FITSData::loadFITS (const QString &inFilename, bool silent, const QByteArray &buffer)
 {
     int status=0, anynull=0;
     long naxes[3];
@@ -124,14 +133,29 @@ bool FITSData::loadFITS (const QString &inFilename, bool silent)
             QFile::remove(filename);
     }
 
-    filename = inFilename;
+    filename   = inFilename;
+    fitsBuffer = buffer;
 
-    if (filename.startsWith("/tmp/") || filename.contains("/Temp"))
-        tempFile = true;
+    if (fitsBuffer.isEmpty() == false)
+    {
+        // Read only, so the memory is never reallocated and fitsBuffer is never detached
+        tempFile       = false;
+        fitsMemory     = const_cast<char *>(fitsBuffer.constData());
+        fitsMemorySize = fitsBuffer.size();
+        fits_open_memfile(&fptr, filename.isEmpty() ? "memory" : filename.toLatin1().constData(), READONLY,
+                          &fitsMemory, &fitsMemorySize, 0, NULL, &status);
+    }
     else
-        tempFile = false;
+    {
+        if (filename.startsWith("/tmp/") || filename.contains("/Temp"))
+            tempFile = true;
+        else
+            tempFile = false;
+
+        fits_open_image(&fptr, filename.toLatin1(), READONLY, &status);
+    }
 
-    if (fits_open_image(&fptr, filename.toLatin1(), READONLY, &status))
+    if (status)
     {
         fits_report_error(stderr, status);
         fits_get_errstatus(status, error_status);
@@ -165,25 +189,44 @@ bool FITSData::loadFITS (const QString &inFilename, bool silent)
         return false;
     }
 
-    switch (stats.bitpix)
+    // Keep the pixels in the narrowest type that holds them once BZERO and BSCALE are applied,
+    // so that signed and unsigned 16 bit camera frames take two bytes per pixel.
+    int equivType=0;
+    if (fits_get_img_equivtype(fptr, &equivType, &status))
+    {
+        fits_report_error(stderr, status);
+        fits_get_errstatus(status, error_status);
+        errMessage = i18n("FITS file open error (fits_get_img_equivtype): %1", QString::fromUtf8(error_status));
+        if (silent == false)
+            KMessageBox::error(0, errMessage, i18n("FITS Open"));
+        if (Options::fITSLogging())
+            qDebug() << errMessage;
+        return false;
+    }
+
+    switch (equivType)
     {
-    case 8:
+    case BYTE_IMG:
         data_type = TBYTE;
         break;
-    case 16:
+    case USHORT_IMG:
         data_type = TUSHORT;
         break;
-    case 32:
+    case SBYTE_IMG:
+    case SHORT_IMG:
+        data_type = TSHORT;
+        break;
+    case LONG_IMG:
         data_type = TINT;
         break;
-    case -32:
+    case FLOAT_IMG:
         data_type = TFLOAT;
         break;
-    case 64:
-        data_type = TLONGLONG;
-        break;
-    case -64:
+    case ULONG_IMG:
+    case LONGLONG_IMG:
+    case DOUBLE_IMG:
         data_type = TDOUBLE;
+        break;
     default:
         errMessage = i18n("Bit depth %1 is not supported.", stats.bitpix);
         if (silent == false)
@@ -215,10 +258,10 @@ bool FITSData::loadFITS (const QString &inFilename, bool silent)
 
     channels = naxes[2];
 
-    image_buffer = new float[stats.samples_per_channel * channels];
+    image_buffer = new uint8_t[stats.samples_per_channel * channels * getBytesPerPixel()];
     if (image_buffer == NULL)
     {
-        qDebug() << "FITSData: Not enough memory for image_buffer channel. Requested: " << stats.samples_per_channel * channels * sizeof(float) << " bytes.";
+        qDebug() << "FITSData: Not enough memory for image_buffer channel. Requested: " << stats.samples_per_channel * channels * getBytesPerPixel() << " bytes.";
         clearImageBuffers();
         return false;
     }
@@ -226,9 +269,11 @@ bool FITSData::loadFITS (const QString &inFilename, bool silent)
     rotCounter=0;
     flipHCounter=0;
     flipVCounter=0;
+    orientation.reset();
+    savedOrientation.reset();
     long nelements = stats.samples_per_channel * channels;
 
-    if (fits_read_img(fptr, TFLOAT, 1, nelements, 0, image_buffer, &anynull, &status))
+    if (fits_read_img(fptr, data_type, 1, nelements, 0, image_buffer, &anynull, &status))
     {
         char errmsg[512];
         fits_get_errstatus(status, errmsg);
@@ -251,7 +296,7 @@ bool FITSData::loadFITS (const QString &inFilename, bool silent)
         checkWCS();
 
     if (checkDebayer())
-        debayer();
+        debayer(debayerRegion);
 
     starsSearched = false;
 
@@ -301,6 +346,7 @@ int FITSData::saveFITS( const QString &newFilename )
         }
 
         filename = newFilename;
+        fitsBuffer.clear();
 
         fptr = new_fptr;
 
@@ -323,6 +369,7 @@ int FITSData::saveFITS( const QString &newFilename )
     }
 
     filename = newFilename;
+    fitsBuffer.clear();
 
     fptr = new_fptr;
 
@@ -333,7 +380,7 @@ int FITSData::saveFITS( const QString &newFilename )
     }
 
     /* Write Data */
-    if (fits_write_img(fptr, TFLOAT, 1, nelements, image_buffer, &status))
+    if (fits_write_img(fptr, data_type, 1, nelements, image_buffer, &status))
     {
         fits_report_error(stderr, status);
         return status;
@@ -384,105 +431,101 @@ int FITSData::saveFITS( const QString &newFilename )
         return status;
     }
 
-    int rot=0, mirror=0;
-    if (rotCounter > 0)
+    // The header was copied as it was last written
+    if (orientation != savedOrientation)
+        rotWCSFITS(orientation * savedOrientation.inverted());
+
+    savedOrientation = orientation;
+    rotCounter=flipHCounter=flipVCounter=0;
+
+    return status;
+}
+
+int FITSData::exportFITS(const QString &newFilename)
+{
+    int status=0, exttype=0;
+    long nelements = stats.samples_per_channel * channels;
+    fitsfile *new_fptr;
+
+    /* Create a new File, overwriting existing*/
+    if (fits_create_file(&new_fptr, newFilename.toLatin1(), &status))
+    {
+        fits_report_error(stderr, status);
+        return status;
+    }
+
+    if (fits_movabs_hdu(fptr, 1, &exttype, &status))
+    {
+        fits_report_error(stderr, status);
+        fits_close_file(new_fptr, &status);
+        return status;
+    }
+
+    // A debayered buffer no longer matches the header, so the mosaic is written as it was received
+    if (HasDebayer)
+        fits_copy_file(fptr, new_fptr, 1, 1, 1, &status);
+    else if (fits_copy_header(fptr, new_fptr, &status) == 0 && fits_write_img(new_fptr, data_type, 1, nelements, image_buffer, &status) == 0)
     {
-        rot = (90 * rotCounter) % 360;
-        if (rot < 0)
-            rot += 360;
+        fits_update_key(new_fptr, TDOUBLE, "DATAMIN", &(stats.min), "Minimum value", &status);
+        fits_update_key(new_fptr, TDOUBLE, "DATAMAX", &(stats.max), "Maximum value", &status);
+        fits_update_key(new_fptr, TUSHORT, "NAXIS1", &(stats.width), "length of data axis 1", &status);
+        fits_update_key(new_fptr, TUSHORT, "NAXIS2", &(stats.height), "length of data axis 2", &status);
     }
-    if (flipHCounter %2 !=0 || flipVCounter % 2 != 0)
-        mirror = 1;
 
-    if (rot || mirror)
-        rotWCSFITS(rot, mirror);
+    if (status)
+        fits_report_error(stderr, status);
 
-    rotCounter=flipHCounter=flipVCounter=0;
+    int closeStatus=0;
+    fits_close_file(new_fptr, &closeStatus);
 
-    return status;
+    return status ? status : closeStatus;
 }
 
 void FITSData::clearImageBuffers()
 {
     delete[] image_buffer;
     image_buffer=NULL;
+    delete[] float_buffer;
+    float_buffer=NULL;
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
     delete [] bayer_buffer;
     bayer_buffer=NULL;
 }
 
-int FITSData::calculateMinMax(bool refresh)
+void FITSData::calculateStats(bool refresh)
 {
-    int status, nfound=0;
+    FITSStatistics::Channel results[3];
+    calculateStatistics(results);
 
-    status = 0;
+    for (int i=0; i < qMin(channels, 3); i++)
+    {
+        stats.min[i]    = results[i].min;
+        stats.max[i]    = results[i].max;
+        stats.mean[i]   = results[i].mean;
+        stats.stddev[i] = results[i].stddev;
+        stats.median[i] = results[i].median;
+    }
 
     if (refresh == false)
     {
-        if (fits_read_key_dbl(fptr, "DATAMIN", &(stats.min[0]), NULL, &status) ==0)
-            nfound++;
+        int status=0, nfound=0;
+        double dataMin=0, dataMax=0;
 
-        if (fits_read_key_dbl(fptr, "DATAMAX", &(stats.max[0]), NULL, &status) == 0)
+        if (fits_read_key_dbl(fptr, "DATAMIN", &dataMin, NULL, &status) ==0)
             nfound++;
 
-        // If we found both keywords, no need to calculate them, unless they are both zeros
-        if (nfound == 2 && !(stats.min[0] == 0 && stats.max[0] ==0))
-            return 0;
-    }
-
-    stats.min[0]= 1.0E30;
-    stats.max[0]= -1.0E30;
-
-    stats.min[1]= 1.0E30;
-    stats.max[1]= -1.0E30;
-
-    stats.min[2]= 1.0E30;
-    stats.max[2]= -1.0E30;
-
-    if (channels == 1)
-    {
-        for (unsigned int i=0; i < stats.samples_per_channel; i++)
-        {
-            if (image_buffer[i] < stats.min[0]) stats.min[0] = image_buffer[i];
-            else if (image_buffer[i] > stats.max[0]) stats.max[0] = image_buffer[i];
-        }
-    }
-    else
-    {
-        int g_offset = stats.samples_per_channel;
-        int b_offset = stats.samples_per_channel*2;
+        if (fits_read_key_dbl(fptr, "DATAMAX", &dataMax, NULL, &status) == 0)
+            nfound++;
 
-        for (unsigned int i=0; i < stats.samples_per_channel; i++)
+        // If we found both keywords, they take precedence, unless they are both zeros
+        if (nfound == 2 && !(dataMin == 0 && dataMax ==0))
         {
-            if (image_buffer[i] < stats.min[0])
-                stats.min[0] = image_buffer[i];
-            else if (image_buffer[i] > stats.max[0])
-                stats.max[0] = image_buffer[i];
-
-            if (image_buffer[i+g_offset] < stats.min[1])
-                stats.min[1] = image_buffer[i+g_offset];
-            else if (image_buffer[i+g_offset] > stats.max[1])
-                stats.max[1] = image_buffer[i+g_offset];
-
-            if (image_buffer[i+b_offset] < stats.min[2])
-                stats.min[2] = image_buffer[i+b_offset];
-            else if (image_buffer[i+b_offset] > stats.max[2])
-                stats.max[2] = image_buffer[i+b_offset];
+            stats.min[0] = dataMin;
+            stats.max[0] = dataMax;
         }
     }
 
-    //qDebug() << "DATAMIN: " << stats.min << " - DATAMAX: " << stats.max;
-    return 0;
-}
-
-
-void FITSData::calculateStats(bool refresh)
-{
-    // Calculate min max
-    calculateMinMax(refresh);
-
-    // Get standard deviation and mean in one run
-    runningAverageStdDev();
-
     stats.SNR = stats.mean[0] / stats.stddev[0];
 
     if (refresh && markStars)
@@ -493,24 +536,71 @@ void FITSData::calculateStats(bool refresh)
 
 void FITSData::runningAverageStdDev()
 {
-    int m_n = 2;
-    double m_oldM=0, m_newM=0, m_oldS=0, m_newS=0;
-    m_oldM = m_newM = image_buffer[0];
+    FITSStatistics::Channel results[3];
+    calculateStatistics(results);
 
-    for (unsigned int i=1; i < stats.samples_per_channel; i++)
-    {
-        m_newM = m_oldM + (image_buffer[i] - m_oldM)/m_n;
-        m_newS = m_oldS + (image_buffer[i] - m_oldM) * (image_buffer[i] - m_newM);
+    stats.mean[0]   = results[0].mean;
+    stats.stddev[0] = results[0].stddev;
+    stats.median[0] = results[0].median;
+}
+
+void FITSData::calculateStatistics(FITSStatistics::Channel *results)
+{
+    completeDebayer();
+
+    int nchannels = qMin(channels, 3);
 
-        m_oldM = m_newM;
-        m_oldS = m_newS;
-        m_n++;
+    switch (data_type)
+    {
+    case TBYTE:
+        FITSStatistics::calculate(reinterpret_cast<uint8_t *>(image_buffer), stats.samples_per_channel, nchannels, results, valueCounts);
+        break;
+    case TUSHORT:
+        FITSStatistics::calculate(reinterpret_cast<uint16_t *>(image_buffer), stats.samples_per_channel, nchannels, results, valueCounts);
+        break;
+    case TSHORT:
+        FITSStatistics::calculate(reinterpret_cast<int16_t *>(image_buffer), stats.samples_per_channel, nchannels, results, valueCounts);
+        break;
+    case TINT:
+        FITSStatistics::calculate(reinterpret_cast<int32_t *>(image_buffer), stats.samples_per_channel, nchannels, results);
+        break;
+    case TFLOAT:
+        FITSStatistics::calculate(reinterpret_cast<float *>(image_buffer), stats.samples_per_channel, nchannels, results);
+        break;
+    case TDOUBLE:
+        FITSStatistics::calculate(reinterpret_cast<double *>(image_buffer), stats.samples_per_channel, nchannels, results);
+        break;
     }
+}
+
+void FITSData::getHistogram(double min, double binWidth, QVector<double> *frequencies)
+{
+    completeDebayer();
 
-    double variance = m_newS / (m_n -2);
+    int nchannels = qMin(channels, 3);
+    const QVector<uint32_t> *counts = valueCounts[0].isEmpty() ? NULL : valueCounts;
 
-    stats.mean[0] = m_newM;
-    stats.stddev[0]  = sqrt(variance);
+    switch (data_type)
+    {
+    case TBYTE:
+        FITSStatistics::histogram(reinterpret_cast<uint8_t *>(image_buffer), stats.samples_per_channel, nchannels, min, binWidth, counts, frequencies);
+        break;
+    case TUSHORT:
+        FITSStatistics::histogram(reinterpret_cast<uint16_t *>(image_buffer), stats.samples_per_channel, nchannels, min, binWidth, counts, frequencies);
+        break;
+    case TSHORT:
+        FITSStatistics::histogram(reinterpret_cast<int16_t *>(image_buffer), stats.samples_per_channel, nchannels, min, binWidth, counts, frequencies);
+        break;
+    case TINT:
+        FITSStatistics::histogram(reinterpret_cast<int32_t *>(image_buffer), stats.samples_per_channel, nchannels, min, binWidth, counts, frequencies);
+        break;
+    case TFLOAT:
+        FITSStatistics::histogram(reinterpret_cast<float *>(image_buffer), stats.samples_per_channel, nchannels, min, binWidth, counts, frequencies);
+        break;
+    case TDOUBLE:
+        FITSStatistics::histogram(reinterpret_cast<double *>(image_buffer), stats.samples_per_channel, nchannels, min, binWidth, counts, frequencies);
+        break;
+    }
 }
 
 void FITSData::setMinMax(double newMin,  double newMax, uint8_t channel)
@@ -538,26 +628,33 @@ int FITSData::getFITSRecord(QString &recordList, int &nkeys)
     return 0;
 }
 
-bool FITSData::checkCollision(Edge* s1, Edge*s2)
+int FITSData::findOneStar(const QRectF &boundary)
 {
-    int dis; //distance
-
-    int diff_x=s1->x - s2->x;
-    int diff_y=s1->y - s2->y;
+    completeDebayer();
 
-    dis = std::abs( sqrt( diff_x*diff_x + diff_y*diff_y));
-    dis -= s1->width/2;
-    dis -= s2->width/2;
-
-    if (dis<=0) //collision
-        return true;
+    switch (data_type)
+    {
+    case TBYTE:
+        return findOneStar<uint8_t>(boundary);
+    case TUSHORT:
+        return findOneStar<uint16_t>(boundary);
+    case TSHORT:
+        return findOneStar<int16_t>(boundary);
+    case TINT:
+        return findOneStar<int32_t>(boundary);
+    case TFLOAT:
+        return findOneStar<float>(boundary);
+    case TDOUBLE:
+        return findOneStar<double>(boundary);
+    }
 
-    //no collision
-    return false;
+    return 0;
 }
 
-int FITSData::findOneStar(const QRectF &boundary)
+template<typename T> int FITSData::findOneStar(const QRectF &boundary)
 {
+    T *buffer = reinterpret_cast<T *>(image_buffer);
+
     int subX = boundary.x();
     int subY = boundary.y();
     int subW = subX + boundary.width();
@@ -572,7 +669,7 @@ int FITSData::findOneStar(const QRectF &boundary)
     {
         for (int x=subX; x < subW; x++)
         {
-            float pixel = image_buffer[x+y*stats.width];
+            float pixel = buffer[x+y*stats.width];
             if (pixel > threshold)
             {
                 //pixel     *= pow(1000, pixel/stats.max[0]);
@@ -613,7 +710,7 @@ int FITSData::findOneStar(const QRectF &boundary)
                 if (testX < subX || testX > subW || testY < subY || testY > subH)
                     break;
 
-                if (image_buffer[testX + testY * stats.width] > running_threshold)
+                if (buffer[testX + testY * stats.width] > running_threshold)
                     pass++;
             }
 
@@ -655,8 +752,8 @@ int FITSData::findOneStar(const QRectF &boundary)
 
     for (double x=leftEdge; x <= rightEdge; x += resolution)
     {
-        //subPixels[x] = resolution * (image_buffer[static_cast<int>(floor(x)) + cen_y * stats.width] - min);
-        double slice = resolution * (image_buffer[static_cast<int>(floor(x)) + cen_y * stats.width] - min);
+        //subPixels[x] = resolution * (buffer[static_cast<int>(floor(x)) + cen_y * stats.width] - min);
+        double slice = resolution * (buffer[static_cast<int>(floor(x)) + cen_y * stats.width] - min);
         FSum += slice;
         subPixels.append(slice);
     }
@@ -701,340 +798,52 @@ int FITSData::findOneStar(const QRectF &boundary)
 /*** Find center of stars and calculate Half Flux Radius */
 void FITSData::findCentroid(const QRectF &boundary, int initStdDev, int minEdgeWidth)
 {
-    double threshold=0,sum=0,avg=0,min=0;
-    int starDiameter=0;
-    int pixVal=0;
-    int minimumEdgeCount = MINIMUM_EDGE_LIMIT;
-
-    double JMIndex = histogram->getJMIndex();
-    float dispersion_ratio=1.5;
-
-    QList<Edge*> edges;
-
-    if (JMIndex < DIFFUSE_THRESHOLD)
-    {
-        minEdgeWidth = JMIndex*35+1;
-        minimumEdgeCount=minEdgeWidth-1;
-    }
-    else
-    {
-        minEdgeWidth =6;
-        minimumEdgeCount=4;
-    }
+    completeDebayer();
 
-    while (initStdDev >= 1)
+    // Only find a single star within the boundary
+    if (boundary.isNull() == false)
     {
-        minEdgeWidth--;
-        minimumEdgeCount--;
-
-        minEdgeWidth     = qMax(3, minEdgeWidth);
-        minimumEdgeCount = qMax(3, minimumEdgeCount);
-
-        if (JMIndex < DIFFUSE_THRESHOLD)
-        {
-            // Taking the average out seems to have better result for noisy images
-            threshold = stats.max[0] - stats.mean[0] * ( (MINIMUM_STDVAR - initStdDev)*0.5 +1);
-
-            min =stats.min[0];
-            if (threshold-min < 0)
-            {
-                threshold=stats.mean[0]* ( (MINIMUM_STDVAR - initStdDev)*0.5 +1);
-                min=0;
-            }
-
-            dispersion_ratio=1.4 - (MINIMUM_STDVAR - initStdDev)*0.08;
-        }
-        else
-        {
-            threshold = stats.mean[0]+stats.stddev[0]*initStdDev*(0.3 - (MINIMUM_STDVAR - initStdDev) * 0.05);
-            min = stats.min[0];
-            // Ratio between centeroid center and edge
-            dispersion_ratio=1.8 - (MINIMUM_STDVAR - initStdDev)*0.2;
-        }
-
-        if (Options::fITSLogging())
-        {
-            qDebug() << "SNR: " << stats.SNR;
-            qDebug() << "The threshold level is " << threshold << "(actual " << threshold-min << ")  minimum edge width" << minEdgeWidth << " minimum edge limit " << minimumEdgeCount;
-        }
-
-        threshold -= min;
-
-        int subX, subY, subW, subH;
-
-        if (boundary.isNull())
-        {
-            if (mode == FITS_GUIDE)
-            {
-                subX = stats.width/10;
-                subY = stats.height/10;
-                subW = stats.width - subX;
-                subH = stats.height - subY;
-            }
-            else
-            {
-                subX = 0;
-                subY = 0;
-                subW = stats.width;
-                subH = stats.height;
-            }
-        }
-        else
-        {
-            // Only find a single star within the boundary
-            findOneStar(boundary);
-            return;
-
-            subX = boundary.x();
-            subY = boundary.y();
-            subW = subX + boundary.width();
-            subH = subY + boundary.height();
-        }
-
-       // Detect "edges" that are above threshold
-        for (int i=subY; i < subH; i++)
-        {
-            starDiameter = 0;
-
-            for(int j=subX; j < subW; j++)
-            {
-                pixVal = image_buffer[j+(i*stats.width)] - min;
-
-                // If pixel value > threshold, let's get its weighted average
-                if ( pixVal >= threshold )
-                {
-                    avg += j * pixVal;
-                    sum += pixVal;
-                    starDiameter++;
-                }
-                // Value < threshold but avg exists
-                else if (sum > 0)
-                {
-                    // We found a potential centroid edge
-                    if (starDiameter >= minEdgeWidth)
-                    {
-                        float center = avg/sum + 0.5;
-                        if (center > 0)
-                        {
-                            int i_center = floor(center);
-
-                            // Check if center is 10% or more brighter than edge, if not skip
-                            if ( ((image_buffer[i_center+(i*stats.width)]-min) / (image_buffer[i_center+(i*stats.width)-starDiameter/2]-min) >= dispersion_ratio) &&
-                                 ((image_buffer[i_center+(i*stats.width)]-min) / (image_buffer[i_center+(i*stats.width)+starDiameter/2]-min) >= dispersion_ratio))
-                            {
-                                if (Options::fITSLogging())
-                                {
-                                    qDebug() << "Edge center is " << image_buffer[i_center+(i*stats.width)]-min << " Edge is " << image_buffer[i_center+(i*stats.width)-starDiameter/2]-min
-                                             << " and ratio is " << ((image_buffer[i_center+(i*stats.width)]-min) / (image_buffer[i_center+(i*stats.width)-starDiameter/2]-min))
-                                             << " located at X: " << center << " Y: " << i+0.5;
-                                }
-
-                                Edge *newEdge = new Edge();
-
-                                newEdge->x          = center;
-                                newEdge->y          = i + 0.5;
-                                newEdge->scanned    = 0;
-                                newEdge->val        = image_buffer[i_center+(i*stats.width)] - min;
-                                newEdge->width      = starDiameter;
-                                newEdge->HFR        = 0;
-                                newEdge->sum        = sum;
-
-                                edges.append(newEdge);
-
-                            }
-                        }
-                    }
-
-                    // Reset
-                    avg= sum = starDiameter=0;
-                }
-            }
-        }
-
-        if (Options::fITSLogging())
-            qDebug() << "Total number of edges found is: " << edges.count();
-
-        // In case of hot pixels
-        if (edges.count() == 1 && initStdDev > 1)
-        {
-            initStdDev--;
-            continue;
-        }
-
-        if (edges.count() >= MAX_EDGE_LIMIT)
-        {
-            if (Options::fITSLogging())
-                qDebug() << "Too many edges, aborting... " << edges.count();
-
-            qDeleteAll(edges);
-            return;
-        }
-
-        if (edges.count() >= minimumEdgeCount)
-            break;
-
-        qDeleteAll(edges);
-        edges.clear();
-        initStdDev--;
+        findOneStar(boundary);
+        return;
     }
 
-    int cen_count=0;
-    int cen_x=0;
-    int cen_y=0;
-    int cen_v=0;
-    int cen_w=0;
-    int width_sum=0;
+    QRect area(0, 0, stats.width, stats.height);
+    if (mode == FITS_GUIDE)
+        area.adjust(stats.width/10, stats.height/10, -stats.width/10, -stats.height/10);
 
-    // Let's sort edges, starting with widest
-    qSort(edges.begin(), edges.end(), greaterThan);
+    // Faint stars are narrower above the noise than the edge width, but not below 3 pixels
+    int minWidth = qMax(3, minEdgeWidth - 2);
 
-    // Now, let's scan the edges and find the maximum centroid vertically
-    for (int i=0; i < edges.count(); i++)
+    switch (data_type)
     {
-        if (Options::fITSLogging())
-        {
-            qDebug() << "# " << i << " Edge at (" << edges[i]->x << "," << edges[i]->y << ") With a value of " << edges[i]->val  << " and width of "
-                     << edges[i]->width << " pixels. with sum " << edges[i]->sum;
-        }
-
-        // If edge scanned already, skip
-        if (edges[i]->scanned == 1)
-        {
-            if (Options::fITSLogging())
-                qDebug() << "Skipping check for center " << i << " because it was already counted";
-            continue;
-        }
-
-        if (Options::fITSLogging())
-            qDebug() << "Invetigating edge # " << i << " now ...";
-
-        // Get X, Y, and Val of edge
-        cen_x = edges[i]->x;
-        cen_y = edges[i]->y;
-        cen_v = edges[i]->sum;
-        cen_w = edges[i]->width;
-
-        float avg_x = 0;
-        float avg_y = 0;
-
-        sum = 0;
-        cen_count=0;
-
-        // Now let's compare to other edges until we hit a maxima
-        for (int j=0; j < edges.count();j++)
-        {
-            if (edges[j]->scanned)
-                continue;
-
-            if (checkCollision(edges[j], edges[i]))
-            {
-                if (edges[j]->sum >= cen_v)
-                {
-                    cen_v = edges[j]->sum;
-                    cen_w = edges[j]->width;
-                }
-
-                edges[j]->scanned = 1;
-                cen_count++;
-
-                avg_x += edges[j]->x * edges[j]->val;
-                avg_y += edges[j]->y * edges[j]->val;
-                sum += edges[j]->val;
-
-                continue;
-            }
-
-        }
-
-        int cen_limit = (MINIMUM_ROWS_PER_CENTER - (MINIMUM_STDVAR - initStdDev));
-
-        if (edges.count() < LOW_EDGE_CUTOFF_1)
-        {
-            if (edges.count() < LOW_EDGE_CUTOFF_2)
-                cen_limit = 1;
-            else
-                cen_limit = 2;
-        }
-
-        if (Options::fITSLogging())
-            qDebug() << "center_count: " << cen_count << " and initstdDev= " << initStdDev << " and limit is " << cen_limit;
-
-        if (cen_limit < 1)
-            continue;
-
-        // If centroid count is within acceptable range
-        //if (cen_limit >= 2 && cen_count >= cen_limit)
-        if (cen_count >= cen_limit)
-        {
-            // We detected a centroid, let's init it
-            Edge *rCenter = new Edge();
-
-            rCenter->x = avg_x/sum;
-            rCenter->y = avg_y/sum;
-            width_sum += rCenter->width;
-            rCenter->width = cen_w;
-
-            if (Options::fITSLogging())
-                qDebug() << "Found a real center with number with (" << rCenter->x << "," << rCenter->y << ")";
-
-            // Calculate Total Flux From Center, Half Flux, Full Summation
-            double TF=0;
-            double HF=0;
-            double FSum=0;
-
-            cen_x = (int) floor(rCenter->x);
-            cen_y = (int) floor(rCenter->y);
-
-            if (cen_x < 0 || cen_x > stats.width || cen_y < 0 || cen_y > stats.height)
-                continue;
-
-
-            // Complete sum along the radius
-            //for (int k=0; k < rCenter->width; k++)
-            for (int k=rCenter->width/2; k >= -(rCenter->width/2) ; k--)
-            {
-                FSum += image_buffer[cen_x-k+(cen_y*stats.width)] - min;
-                //qDebug() << image_buffer[cen_x-k+(cen_y*stats.width)] - min;
-            }
-
-            // Half flux
-            HF = FSum / 2.0;
-
-            // Total flux starting from center
-            TF = image_buffer[cen_y * stats.width + cen_x] - min;
-
-            int pixelCounter = 1;
-
-            // Integrate flux along radius axis until we reach half flux
-            for (int k=1; k < rCenter->width/2; k++)
-            {
-                if (TF >= HF)
-                {
-                    if (Options::fITSLogging())
-                        qDebug() << "Stopping at TF " << TF << " after #" << k << " pixels.";
-                    break;
-                }
-
-                TF += image_buffer[cen_y * stats.width + cen_x + k] - min;
-                TF += image_buffer[cen_y * stats.width + cen_x - k] - min;
-
-                pixelCounter++;
-            }
-
-            // Calculate weighted Half Flux Radius
-            rCenter->HFR = pixelCounter * (HF / TF);
-            // Store full flux
-            rCenter->val = FSum;
-
-            if (Options::fITSLogging())
-                qDebug() << "HFR for this center is " << rCenter->HFR << " pixels and the total flux is " << FSum;
-
-            starCenters.append(rCenter);
-        }
+    case TBYTE:
+        starCenters = FITSStarDetector::findStars(reinterpret_cast<uint8_t *>(image_buffer), stats.width, stats.height, area, initStdDev, minWidth);
+        break;
+    case TUSHORT:
+        starCenters = FITSStarDetector::findStars(reinterpret_cast<uint16_t *>(image_buffer), stats.width, stats.height, area, initStdDev, minWidth);
+        break;
+    case TSHORT:
+        starCenters = FITSStarDetector::findStars(reinterpret_cast<int16_t *>(image_buffer), stats.width, stats.height, area, initStdDev, minWidth);
+        break;
+    case TINT:
+        starCenters = FITSStarDetector::findStars(reinterpret_cast<int32_t *>(image_buffer), stats.width, stats.height, area, initStdDev, minWidth);
+        break;
+    case TFLOAT:
+        starCenters = FITSStarDetector::findStars(reinterpret_cast<float *>(image_buffer), stats.width, stats.height, area, initStdDev, minWidth);
+        break;
+    case TDOUBLE:
+        starCenters = FITSStarDetector::findStars(reinterpret_cast<double *>(image_buffer), stats.width, stats.height, area, initStdDev, minWidth);
+        break;
     }
 
+    if (Options::fITSLogging())
+        qDebug() << "FITSData: found " << starCenters.count() << " stars.";
+
     if (starCenters.count() > 1 && mode != FITS_FOCUS)
     {
+        float width_sum=0;
+        foreach(Edge *center, starCenters)
+            width_sum += center->width;
         float width_avg = width_sum / starCenters.count();
 
         float lsum =0, sdev=0;
@@ -1044,19 +853,16 @@ void FITSData::findCentroid(const QRectF &boundary, int initStdDev, int minEdgeW
 
         sdev = (sqrt(lsum/(starCenters.count() - 1))) * 4;
 
-        // Reject stars > 4 * stddev
+        // Reject stars wider than 4 * stddev from the average
         foreach(Edge *center, starCenters)
-            if (center->width > sdev)
+        {
+            if (center->width > width_avg + sdev)
+            {
                 starCenters.removeOne(center);
-
-        //foreach(Edge *center, starCenters)
-        //qDebug() << center->x << "," << center->y << "," << center->width << "," << center->val << endl;
-
+                delete center;
+            }
+        }
     }
-
-    // Release memory
-    qDeleteAll(edges);
-
 }
 
 double FITSData::getHFR(HFRType type)
@@ -1124,19 +930,53 @@ double FITSData::getHFR(int x, int y)
     return -1;
 }
 
-void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
+void FITSData::applyFilter(FITSScale type, uint8_t *image, float min, float max)
 {
     if (type == FITS_NONE /* || histogram == NULL*/)
         return;
 
-    double coeff=0;
-    float val=0,bufferVal =0;
-    int offset=0, row=0;
-
-
     if (image == NULL)
         image = image_buffer;
 
+    // Filters that change the values count them again with the statistics
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
+
+    switch (data_type)
+    {
+    case TBYTE:
+        applyFilter<uint8_t>(type, image, min, max);
+        break;
+    case TUSHORT:
+        applyFilter<uint16_t>(type, reinterpret_cast<uint16_t *>(image), min, max);
+        break;
+    case TSHORT:
+        applyFilter<int16_t>(type, reinterpret_cast<int16_t *>(image), min, max);
+        break;
+    case TINT:
+        applyFilter<int32_t>(type, reinterpret_cast<int32_t *>(image), min, max);
+        break;
+    case TFLOAT:
+        applyFilter<float>(type, reinterpret_cast<float *>(image), min, max);
+        break;
+    case TDOUBLE:
+        applyFilter<double>(type, reinterpret_cast<double *>(image), min, max);
+        break;
+    }
+
+    // The image changed, so does its float copy
+    delete[] float_buffer;
+    float_buffer = NULL;
+}
+
+template<typename T> void FITSData::applyFilter(FITSScale type, T *image, float min, float max)
+{
+    T *buffer = reinterpret_cast<T *>(image_buffer);
+
+    double coeff=0;
+    float val=0,bufferVal =0;
+    int offset=0, row=0;
+
     int width = stats.width;
     int height = stats.height;
 
@@ -1166,7 +1006,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                     bufferVal = image[index];
                     if (bufferVal < min) bufferVal = min;
                     else if (bufferVal > max) bufferVal = max;
-                    image_buffer[index] = bufferVal;
+                    buffer[index] = bufferVal;
                 }
             }
         }
@@ -1193,8 +1033,8 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                     bufferVal = image[index];
                     if (bufferVal < min) bufferVal = min;
                     else if (bufferVal > max) bufferVal = max;
-                    val = (coeff * log(1 + qBound(min, image[index], max)));
-                    image_buffer[index] = qBound(min, val, max);
+                    val = (coeff * log(1 + qBound(min, static_cast<float>(image[index]), max)));
+                    buffer[index] = qBound(min, val, max);
                 }
             }
 
@@ -1219,8 +1059,8 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                 for (int k=0; k < width; k++)
                 {
                     index=k + row;
-                    val = (int) (coeff * sqrt(qBound(min, image[index], max)));
-                    image_buffer[index] = val;
+                    val = (int) (coeff * sqrt(qBound(min, static_cast<float>(image[index]), max)));
+                    buffer[index] = val;
                 }
             }
         }
@@ -1245,7 +1085,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                 for (int k=0; k < width; k++)
                 {
                     index=k + row;
-                    image_buffer[index] = qBound(min, image[index], max);
+                    buffer[index] = qBound(min, static_cast<float>(image[index]), max);
                 }
             }
         }
@@ -1272,7 +1112,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                 for (int k=0; k < width; k++)
                 {
                     index=k + row;
-                    image_buffer[index] = qBound(min, image[index], max);
+                    buffer[index] = qBound(min, static_cast<float>(image[index]), max);
                 }
             }
         }
@@ -1305,7 +1145,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
 
                     val = (int) (coeff * cumulativeFreq[bufferVal]);
 
-                    image_buffer[index] = val;
+                    buffer[index] = val;
                 }
             }
         }
@@ -1325,7 +1165,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                 for (int k=0; k < width; k++)
                 {
                     index=k + row;
-                    image_buffer[index] = qBound(min, image[index], max);
+                    buffer[index] = qBound(min, static_cast<float>(image[index]), max);
                 }
             }
         }
@@ -1339,7 +1179,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
     // Based on http://www.librow.com/articles/article-1
     case FITS_MEDIAN:
     {
-        float* extension = new float[(width + 2) * (height + 2)];
+        T* extension = new T[(width + 2) * (height + 2)];
         //   Check memory allocation
         if (!extension)
             return;
@@ -1351,14 +1191,14 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
 
             for (int i = 0; i < M; ++i)
             {
-                memcpy(extension + (N + 2) * (i + 1) + 1, image_buffer + N * i + offset, N * sizeof(float));
-                extension[(N + 2) * (i + 1)] = image_buffer[N * i + offset];
-                extension[(N + 2) * (i + 2) - 1] = image_buffer[N * (i + 1) - 1 + offset];
+                memcpy(extension + (N + 2) * (i + 1) + 1, buffer + N * i + offset, N * sizeof(T));
+                extension[(N + 2) * (i + 1)] = buffer[N * i + offset];
+                extension[(N + 2) * (i + 2) - 1] = buffer[N * (i + 1) - 1 + offset];
             }
             //   Fill first line of image extension
-            memcpy(extension, extension + N + 2, (N + 2) * sizeof(float));
+            memcpy(extension, extension + N + 2, (N + 2) * sizeof(T));
             //   Fill last line of image extension
-            memcpy(extension + (N + 2) * (M + 1), extension + (N + 2) * M, (N + 2) * sizeof(float));
+            memcpy(extension + (N + 2) * (M + 1), extension + (N + 2) * M, (N + 2) * sizeof(T));
             //   Call median filter implementation
 
             N=width+2;
@@ -1369,7 +1209,7 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                 {
                     //   Pick up window elements
                     int k = 0;
-                    float window[9];
+                    T window[9];
                     for (int j = m - 1; j < m + 2; ++j)
                         for (int i = n - 1; i < n + 2; ++i)
                             window[k++] = extension[j * N + i];
@@ -1382,12 +1222,12 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
                             if (window[l] < window[mine])
                                 mine = l;
                         //   Put found minimum element in its place
-                        const float temp = window[j];
+                        const T temp = window[j];
                         window[j] = window[mine];
                         window[mine] = temp;
                     }
                     //   Get result - the middle element
-                    image_buffer[(m - 1) * (N - 2) + n - 1 + offset] = window[4];
+                    buffer[(m - 1) * (N - 2) + n - 1 + offset] = window[4];
                 }
         }
 
@@ -1399,22 +1239,22 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
 
 
     case FITS_ROTATE_CW:
-        rotFITS(90, 0);
+        rotFITS<T>(90, 0);
         rotCounter++;
         break;
 
     case FITS_ROTATE_CCW:
-        rotFITS(270, 0);
+        rotFITS<T>(270, 0);
         rotCounter--;
         break;
 
     case FITS_FLIP_H:
-        rotFITS(0, 1);
+        rotFITS<T>(0, 1);
         flipHCounter++;
         break;
 
     case FITS_FLIP_V:
-        rotFITS(0, 2);
+        rotFITS<T>(0, 2);
         flipVCounter++;
         break;
 
@@ -1426,18 +1266,118 @@ void FITSData::applyFilter(FITSScale type, float *image, float min, float max)
 
 }
 
-void FITSData::subtract(float *dark_buffer)
+// Subtract the dark frame from the light frame, clamping at zero. Rows of the dark frame are darkWidth pixels long,
+// and the light frame starts at darkOffset within it. The rows are split in bands over the threads, and each row is a
+// select without branches so that it vectorizes.
+template<typename T, typename D> static void subtractDark(T *light, int width, int height, const D *dark, long darkOffset, int darkWidth)
+{
+    // The difference is taken in the promoted type of both pixels, as the comparison used to be
+    typedef decltype(T() - D()) V;
+
+    QVector<int> bands;
+    int bandHeight = qMax(1, height / QThread::idealThreadCount());
+    for (int y=0; y < height; y += bandHeight)
+        bands.append(y);
+
+    QtConcurrent::blockingMap(bands, [=](int top)
+    {
+        const int bottom = qMin(top + bandHeight, height);
+
+        for (int i=top; i < bottom; i++)
+        {
+            T *l       = light + static_cast<long>(i) * width;
+            const D *d = dark + darkOffset + static_cast<long>(i) * darkWidth;
+
+            for (int j=0; j < width; j++)
+            {
+                V v = l[j] - d[j];
+                l[j] = static_cast<T>(v > 0 ? v : 0);
+            }
+        }
+    });
+}
+
+template<typename D> static void subtractDark(uint8_t *light, int lightType, int width, int height, const D *dark, long darkOffset, int darkWidth)
 {
-    for (int i=0; i < stats.width*stats.height; i++)
+    switch (lightType)
     {
-        image_buffer[i] -= dark_buffer[i];
-        if (image_buffer[i] < 0)
-            image_buffer[i] = 0;
+    case TBYTE:
+        subtractDark(light, width, height, dark, darkOffset, darkWidth);
+        break;
+    case TUSHORT:
+        subtractDark(reinterpret_cast<uint16_t *>(light), width, height, dark, darkOffset, darkWidth);
+        break;
+    case TSHORT:
+        subtractDark(reinterpret_cast<int16_t *>(light), width, height, dark, darkOffset, darkWidth);
+        break;
+    case TINT:
+        subtractDark(reinterpret_cast<int32_t *>(light), width, height, dark, darkOffset, darkWidth);
+        break;
+    case TFLOAT:
+        subtractDark(reinterpret_cast<float *>(light), width, height, dark, darkOffset, darkWidth);
+        break;
+    case TDOUBLE:
+        subtractDark(reinterpret_cast<double *>(light), width, height, dark, darkOffset, darkWidth);
+        break;
     }
+}
+
+void FITSData::subtract(float *dark_buffer)
+{
+    completeDebayer();
+
+    subtractDark(image_buffer, data_type, stats.width, stats.height, dark_buffer, 0, stats.width);
+
+    delete[] float_buffer;
+    float_buffer = NULL;
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
+
+    calculateStats(true);
+}
+
+void FITSData::subtract(FITSData *darkData, uint16_t offsetX, uint16_t offsetY)
+{
+    completeDebayer();
+
+    long darkOffset = offsetX + offsetY * darkData->getWidth();
+    subtractBuffer(image_buffer, data_type, stats.width, stats.height, darkData->getImageBuffer(), darkData->getDataType(),
+                   darkOffset, darkData->getWidth());
+
+    delete[] float_buffer;
+    float_buffer = NULL;
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
 
     calculateStats(true);
 }
 
+void FITSData::subtractBuffer(uint8_t *light, int lightType, int width, int height, const uint8_t *dark, int darkType,
+                              long darkOffset, int darkWidth)
+{
+    switch (darkType)
+    {
+    case TBYTE:
+        subtractDark(light, lightType, width, height, dark, darkOffset, darkWidth);
+        break;
+    case TUSHORT:
+        subtractDark(light, lightType, width, height, reinterpret_cast<const uint16_t *>(dark), darkOffset, darkWidth);
+        break;
+    case TSHORT:
+        subtractDark(light, lightType, width, height, reinterpret_cast<const int16_t *>(dark), darkOffset, darkWidth);
+        break;
+    case TINT:
+        subtractDark(light, lightType, width, height, reinterpret_cast<const int32_t *>(dark), darkOffset, darkWidth);
+        break;
+    case TFLOAT:
+        subtractDark(light, lightType, width, height, reinterpret_cast<const float *>(dark), darkOffset, darkWidth);
+        break;
+    case TDOUBLE:
+        subtractDark(light, lightType, width, height, reinterpret_cast<const double *>(dark), darkOffset, darkWidth);
+        break;
+    }
+}
+
 int FITSData::findStars(const QRectF &boundary, bool force)
 {
     if (histogram == NULL)
@@ -1458,6 +1398,136 @@ int FITSData::findStars(const QRectF &boundary, bool force)
 
 }
 
+FITSData * FITSData::createAnalysisCopy(const QRect &box)
+{
+    completeDebayer();
+
+    if (image_buffer == NULL)
+        return NULL;
+
+    QRect region(0, 0, stats.width, stats.height);
+    if (box.isNull() == false)
+        region &= box.adjusted(-ANALYSIS_BORDER, -ANALYSIS_BORDER, ANALYSIS_BORDER, ANALYSIS_BORDER);
+
+    if (region.isEmpty())
+        return NULL;
+
+    FITSData *copy = new FITSData(mode);
+
+    copy->stats     = stats;
+    copy->data_type = data_type;
+    copy->channels  = 1;
+    copy->origin    = region.topLeft();
+    // Only checked for, the copy never filters
+    copy->histogram = histogram;
+
+    copy->stats.width  = region.width();
+    copy->stats.height = region.height();
+    copy->stats.samples_per_channel = region.width() * region.height();
+
+    const int bpp = getBytesPerPixel();
+    const long rowSize = static_cast<long>(region.width()) * bpp;
+    copy->image_buffer = new uint8_t[rowSize * region.height()];
+
+    for (int y=0; y < region.height(); y++)
+        memcpy(copy->image_buffer + y * rowSize, image_buffer + ((static_cast<long>(region.y()) + y) * stats.width + region.x()) * bpp, rowSize);
+
+    return copy;
+}
+
+template<typename T> static QVector<T> pixelsAround(const T *buffer, int width, int height, const QRect &box)
+{
+    QVector<T> pixels;
+    pixels.reserve(width * height);
+
+    for (int y=0; y < height; y++)
+    {
+        const T *row = buffer + static_cast<long>(y) * width;
+
+        if (y < box.top() || y > box.bottom())
+        {
+            for (int x=0; x < width; x++)
+                pixels.append(row[x]);
+        }
+        else
+        {
+            for (int x=0; x < qMin(box.left(), width); x++)
+                pixels.append(row[x]);
+            for (int x=qMax(box.right() + 1, 0); x < width; x++)
+                pixels.append(row[x]);
+        }
+    }
+
+    return pixels;
+}
+
+template<typename T> static void backgroundStatistics(const T *buffer, int width, int height, const QRect &box,
+                                                      FITSStatistics::Channel *region, FITSStatistics::Channel *background)
+{
+    FITSStatistics::calculate(buffer, width * height, 1, region);
+
+    QVector<T> around = pixelsAround(buffer, width, height, box);
+    if (around.isEmpty())
+        *background = *region;
+    else
+        FITSStatistics::calculate(around.constData(), around.size(), 1, background);
+}
+
+void FITSData::estimateBackground(const QRect &box)
+{
+    FITSStatistics::Channel region, background;
+
+    switch (data_type)
+    {
+    case TBYTE:
+        backgroundStatistics(reinterpret_cast<uint8_t *>(image_buffer), stats.width, stats.height, box, &region, &background);
+        break;
+    case TUSHORT:
+        backgroundStatistics(reinterpret_cast<uint16_t *>(image_buffer), stats.width, stats.height, box, &region, &background);
+        break;
+    case TSHORT:
+        backgroundStatistics(reinterpret_cast<int16_t *>(image_buffer), stats.width, stats.height, box, &region, &background);
+        break;
+    case TINT:
+        backgroundStatistics(reinterpret_cast<int32_t *>(image_buffer), stats.width, stats.height, box, &region, &background);
+        break;
+    case TFLOAT:
+        backgroundStatistics(reinterpret_cast<float *>(image_buffer), stats.width, stats.height, box, &region, &background);
+        break;
+    case TDOUBLE:
+        backgroundStatistics(reinterpret_cast<double *>(image_buffer), stats.width, stats.height, box, &region, &background);
+        break;
+    default:
+        return;
+    }
+
+    stats.min[0]    = region.min;
+    stats.max[0]    = region.max;
+    stats.mean[0]   = background.mean;
+    stats.stddev[0] = background.stddev;
+    stats.median[0] = background.median;
+    stats.SNR       = stats.mean[0] / stats.stddev[0];
+}
+
+void FITSData::takeStars(FITSData *other)
+{
+    qDeleteAll(starCenters);
+
+    starCenters   = other->starCenters;
+    maxHFRStar    = other->maxHFRStar;
+    starsSearched = other->starsSearched;
+
+    // Back to the pixels of this image
+    foreach (Edge *center, starCenters)
+    {
+        center->x += other->origin.x() - origin.x();
+        center->y += other->origin.y() - origin.y();
+    }
+
+    other->starCenters.clear();
+    other->maxHFRStar = NULL;
+}
+
 void FITSData::getCenterSelection(int *x, int *y)
 {
     if (starCenters.count() == 0)
@@ -1485,11 +1555,9 @@ void FITSData::checkWCS()
 
     int status=0;
     char *header;
-    int nkeyrec, nreject, nwcs, stat[2];
-    double imgcrd[2], phi, pixcrd[2], theta, world[2];
-    struct wcsprm *wcs=0;
-    int width=getWidth();
-    int height=getHeight();
+    int nkeyrec, nreject;
+
+    clearWCS();
 
     if (fits_hdr2str(fptr, 1, NULL, 0, &header, &nkeyrec, &status))
     {
@@ -1500,6 +1568,9 @@ void FITSData::checkWCS()
     if ((status = wcspih(header, nkeyrec, WCSHDR_all, -3, &nreject, &nwcs, &wcs)))
     {
         fprintf(stderr, "wcspih ERROR %d: %s.\n", status, wcshdr_errmsg[status]);
+        free(header);
+        wcs  = NULL;
+        nwcs = 0;
         return;
     }
 
@@ -1513,46 +1584,192 @@ void FITSData::checkWCS()
 
     // FIXME: Call above goes through EVEN if no WCS is present, so we're adding this to return for now.
     if (wcs->crpix[0] == 0)
+    {
+        clearWCS();
         return;
-
-    HasWCS = true;
+    }
 
     if ((status = wcsset(wcs)))
     {
         fprintf(stderr, "wcsset ERROR %d: %s.\n", status, wcs_errmsg[status]);
+        clearWCS();
         return;
     }
 
-    delete[] wcs_coord;
+    // Coordinates are only evaluated when asked for, see pixelToWCS()
+    HasWCS = true;
+
+#endif
+
+}
+
+void FITSData::clearWCS()
+{
+#ifdef HAVE_WCSLIB
+    if (wcs)
+        wcsvfree(&nwcs, &wcs);
+#endif
+
+    wcs  = NULL;
+    nwcs = 0;
+
+    wcsGrid.clear();
+    wcsGridCols = 0;
+    wcsGridStep = 0;
+
+    HasWCS = false;
+}
+
+bool FITSData::evaluateWCS(double x, double y, wcs_point &coord)
+{
+#ifdef HAVE_WCSLIB
+    int status=0, stat[2];
+    double imgcrd[2], phi, pixcrd[2], theta, world[2];
+
+    pixcrd[0]=x;
+    pixcrd[1]=y;
+
+    if ((status = wcsp2s(wcs, 1, 2, &pixcrd[0], &imgcrd[0], &phi, &theta, &world[0], &stat[0])))
+    {
+        fprintf(stderr, "wcsp2s ERROR %d: %s.\n", status, wcs_errmsg[status]);
+        return false;
+    }
+
+    coord.ra  = world[0];
+    coord.dec = world[1];
+
+    return true;
+#else
+    Q_UNUSED(x);
+    Q_UNUSED(y);
+    Q_UNUSED(coord);
+    return false;
+#endif
+}
+
+// Bilinear interpolation within the grid cell whose top left point is p. RA is unwrapped in the grid.
+static wcs_point interpolateWCSCell(const wcs_point *p, int cols, double tx, double ty)
+{
+    const wcs_point &p00 = p[0], &p10 = p[1], &p01 = p[cols], &p11 = p[cols+1];
+    wcs_point coord;
+
+    coord.ra  = (p00.ra  * (1-tx) + p10.ra  * tx) * (1-ty) + (p01.ra  * (1-tx) + p11.ra  * tx) * ty;
+    coord.dec = (p00.dec * (1-tx) + p10.dec * tx) * (1-ty) + (p01.dec * (1-tx) + p11.dec * tx) * ty;
 
-    wcs_coord = new wcs_point[width*height];
+    return coord;
+}
 
-    wcs_point *p = wcs_coord;
+bool FITSData::buildWCSGrid()
+{
+    // The grid covers the image as it was loaded
+    int width=getWidth();
+    int height=getHeight();
+    if (orientation.m11() == 0)
+        std::swap(width, height);
 
-    for (int i=0; i < height; i++)
+    for (int step=WCS_GRID_MAX_STEP; step >= WCS_GRID_MIN_STEP; step /= 2)
     {
-        for (int j=0; j < width; j++)
-        {
-            pixcrd[0]=j;
-            pixcrd[1]=i;
+        // The last row and column of points may lie outside the image, so that it is fully covered
+        int cols = (width  - 1 + step - 1) / step + 1;
+        int rows = (height - 1 + step - 1) / step + 1;
+
+        if (cols < 2 || rows < 2)
+            continue;
 
-            if ((status = wcsp2s(wcs, 1, 2, &pixcrd[0], &imgcrd[0], &phi, &theta, &world[0], &stat[0])))
+        QVector<wcs_point> grid(cols * rows);
+        bool valid = true;
+
+        for (int i=0; i < rows && valid; i++)
+        {
+            for (int j=0; j < cols && valid; j++)
             {
-                fprintf(stderr, "wcsp2s ERROR %d: %s.\n", status,
-                        wcs_errmsg[status]);
+                wcs_point &p = grid[j + i * cols];
+                valid = evaluateWCS(j * step, i * step, p);
+
+                // Unwrap RA so that cells crossing 0h interpolate correctly
+                if (valid && (i > 0 || j > 0))
+                {
+                    double ref = (j > 0) ? grid[j - 1 + i * cols].ra : grid[(i - 1) * cols].ra;
+                    while (p.ra - ref > 180)
+                        p.ra -= 360;
+                    while (p.ra - ref < -180)
+                        p.ra += 360;
+                }
             }
-            else
+        }
+
+        if (valid == false)
+            break;
+
+        // Compare with the exact coordinates at the center of every cell, where the error is largest
+        double maxError=0;
+        for (int i=0; i < rows - 1; i++)
+        {
+            for (int j=0; j < cols - 1; j++)
             {
-                p->ra  = world[0];
-                p->dec = world[1];
+                wcs_point exact;
+                if (evaluateWCS((j + 0.5) * step, (i + 0.5) * step, exact) == false)
+                {
+                    valid = false;
+                    break;
+                }
+
+                wcs_point approx = interpolateWCSCell(grid.constData() + j + i * cols, cols, 0.5, 0.5);
+
+                double dRA = fmod(approx.ra - exact.ra + 540.0, 360.0) - 180.0;
+                double dDE = approx.dec - exact.dec;
+                dRA *= cos(exact.dec * dms::DegToRad);
 
-                p++;
+                maxError = qMax(maxError, sqrt(dRA * dRA + dDE * dDE) * 3600.0);
             }
+
+            if (valid == false)
+                break;
+        }
+
+        if (valid == false)
+            break;
+
+        if (maxError <= WCS_GRID_TOLERANCE)
+        {
+            wcsGrid     = grid;
+            wcsGridCols = cols;
+            wcsGridStep = step;
+            return true;
         }
     }
-#endif
 
+    // Too distorted, too close to a pole, or partly off the projection for the grid. Evaluate every pixel exactly instead.
+    wcsGridStep = -1;
+    return false;
+}
+
+bool FITSData::pixelToWCS(double x, double y, wcs_point &coord, bool interpolate)
+{
+    if (HasWCS == false || wcs == NULL)
+        return false;
+
+    // The WCS describes the image as it was loaded, before any rotation or flip
+    orientation.map(x, y, &x, &y);
+
+    if (interpolate == false || wcsGridStep < 0 || (wcsGridStep == 0 && buildWCSGrid() == false))
+        return evaluateWCS(x, y, coord);
+
+    int rows = wcsGrid.size() / wcsGridCols;
+    double fx = x / wcsGridStep;
+    double fy = y / wcsGridStep;
+    int j = qBound(0, static_cast<int>(floor(fx)), wcsGridCols - 2);
+    int i = qBound(0, static_cast<int>(floor(fy)), rows - 2);
+
+    coord = interpolateWCSCell(wcsGrid.constData() + j + i * wcsGridCols, wcsGridCols, fx - j, fy - i);
+
+    coord.ra = fmod(coord.ra, 360.0);
+    if (coord.ra < 0)
+        coord.ra += 360.0;
+
+    return true;
 }
+
 float *FITSData::getDarkFrame() const
 {
     return darkFrame;
@@ -1601,521 +1818,303 @@ void FITSData::setRotCounter(int value)
  */
 bool FITSData::rotFITS (int rotate, int mirror)
 {
-    int ny, nx;
-    int x1, y1, x2, y2;
-    float *rotimage = NULL;
-    int offset=0;
-
-    if (rotate == 1)
-        rotate = 90;
-    else if (rotate == 2)
-        rotate = 180;
-    else if (rotate == 3)
-        rotate = 270;
-    else if (rotate < 0)
-        rotate = rotate + 360;
+    completeDebayer();
 
-    nx = stats.width;
-    ny = stats.height;
+    bool rc = false;
 
-    /* Allocate buffer for rotated image */
-    rotimage = new float[stats.samples_per_channel*channels];
-    if (rotimage == NULL)
+    switch (data_type)
     {
-        qWarning() << "Unable to allocate memory for rotated image buffer!";
-        return false;
+    case TBYTE:
+        rc = rotFITS<uint8_t>(rotate, mirror);
+        break;
+    case TUSHORT:
+        rc = rotFITS<uint16_t>(rotate, mirror);
+        break;
+    case TSHORT:
+        rc = rotFITS<int16_t>(rotate, mirror);
+        break;
+    case TINT:
+        rc = rotFITS<int32_t>(rotate, mirror);
+        break;
+    case TFLOAT:
+        rc = rotFITS<float>(rotate, mirror);
+        break;
+    case TDOUBLE:
+        rc = rotFITS<double>(rotate, mirror);
+        break;
     }
 
-    /* Mirror image without rotation */
+    delete[] float_buffer;
+    float_buffer = NULL;
+
+    return rc;
+}
+
+// Side of the tiles that rotations and flips go through at once, so that the rows read and written stay in cache
+#define ROTATION_TILE   64
+
+// The transpose and the flips, applied in this order, that rotate by rotate degrees an image mirrored
+// horizontally (1) or vertically (2) first.
+static void rotationSteps(int rotate, int mirror, bool *transpose, bool *flipX, bool *flipY)
+{
+    *transpose = *flipX = *flipY = false;
+
     if (rotate < 45 && rotate > -45)
     {
-        if (mirror == 1)
-        {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (x1 = 0; x1 < nx; x1++)
-                {
-                    x2 = nx - x1 - 1;
-                    for (y1 = 0; y1 < ny; y1++)
-                        rotimage[(y1*nx) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
-            }
+        *flipX = (mirror == 1);
+        *flipY = (mirror == 2);
+    }
+    else if (rotate >= 45 && rotate < 135)
+    {
+        *transpose = true;
+        *flipX = (mirror != 2);
+        *flipY = (mirror == 1);
+    }
+    else if (rotate >= 135 && rotate < 225)
+    {
+        *flipX = (mirror != 1);
+        *flipY = (mirror != 2);
+    }
+    else if (rotate >= 225 && rotate < 315)
+    {
+        *transpose = true;
+        *flipX = (mirror == 2);
+        *flipY = (mirror != 1);
+    }
+    /* If rotating by more than 315 degrees, assume top-bottom reflection */
+    else if (rotate >= 315 && mirror)
+        *transpose = true;
+}
 
-        }
-        else if (mirror == 2)
+// Top left corners of the tiles of a width x height image
+static QVector<QPoint> rotationTiles(int width, int height)
+{
+    QVector<QPoint> tiles;
+    for (int y=0; y < height; y += ROTATION_TILE)
+        for (int x=0; x < width; x += ROTATION_TILE)
+            tiles.append(QPoint(x, y));
+    return tiles;
+}
+
+// Copy the transpose of a width x height channel into a height x width one, flipped as asked
+template<typename T> static void transposeChannel(const T *source, T *target, int width, int height, bool flipX, bool flipY)
+{
+    const int targetWidth = height, targetHeight = width;
+    QVector<QPoint> tiles = rotationTiles(targetWidth, targetHeight);
+
+    QtConcurrent::blockingMap(tiles, [=](const QPoint &tile)
+    {
+        const int xEnd = qMin(tile.x() + ROTATION_TILE, targetWidth), yEnd = qMin(tile.y() + ROTATION_TILE, targetHeight);
+
+        for (int y=tile.y(); y < yEnd; y++)
         {
-            for (int i=0; i < channels; i++)
+            T *row = target + static_cast<long>(y) * targetWidth;
+            const int sx = flipY ? targetHeight - 1 - y : y;
+
+            for (int x=tile.x(); x < xEnd; x++)
             {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    y2 = ny - y1 - 1;
-                    for (x1 = 0; x1 < nx; x1++)
-                        rotimage[(y2*nx) + x1 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
+                const int sy = flipX ? targetWidth - 1 - x : x;
+                row[x] = source[static_cast<long>(sy) * width + sx];
             }
-
         }
-        else
-        {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    for (x1 = 0; x1 < nx; x1++)
-                        rotimage[(y1*nx) + x1 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
-            }
+    });
+}
 
-        }
-    }
+// Transpose a square channel in place, swapping each tile above the diagonal with the one below it
+template<typename T> static void transposeSquare(T *buffer, int size)
+{
+    QVector<QPoint> tiles;
+    foreach (const QPoint &tile, rotationTiles(size, size))
+        if (tile.y() <= tile.x())
+            tiles.append(tile);
 
-    /* Rotate by 90 degrees */
-    else if (rotate >= 45 && rotate < 135)
+    QtConcurrent::blockingMap(tiles, [=](const QPoint &tile)
     {
-        if (mirror == 1)
-        {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    x2 = ny - y1 - 1;
-                    for (x1 = 0; x1 < nx; x1++)
-                    {
-                        y2 = nx - x1 - 1;
-                        rotimage[(y2*ny) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                    }
-                }
-            }
-
-        }
-        else if (mirror == 2)
-        {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    for (x1 = 0; x1 < nx; x1++)
-                        rotimage[(x1*ny) + y1 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
-            }
+        const int xEnd = qMin(tile.x() + ROTATION_TILE, size), yEnd = qMin(tile.y() + ROTATION_TILE, size);
 
-        }
-        else
-        {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    x2 = ny - y1 - 1;
-                    for (x1 = 0; x1 < nx; x1++)
-                    {
-                        y2 = x1;
-                        rotimage[(y2*ny) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                    }
-                }
-            }
+        for (int y=tile.y(); y < yEnd; y++)
+            for (int x=qMax(tile.x(), y + 1); x < xEnd; x++)
+                std::swap(buffer[static_cast<long>(y) * size + x], buffer[static_cast<long>(x) * size + y]);
+    });
+}
 
-        }
+// Flip a channel in place. Rows are reversed, and swapped with the opposite row when flipping vertically.
+template<typename T> static void flipChannel(T *buffer, int width, int height, bool flipX, bool flipY)
+{
+    if (flipX == false && flipY == false)
+        return;
 
-        stats.width = ny;
-        stats.height = nx;
-    }
+    const int rows = flipY ? (height + 1) / 2 : height;
+    const int bandHeight = qMax(1, rows / QThread::idealThreadCount());
+    QVector<int> bands;
+    for (int y=0; y < rows; y += bandHeight)
+        bands.append(y);
 
-    /* Rotate by 180 degrees */
-    else if (rotate >= 135 && rotate < 225)
+    QtConcurrent::blockingMap(bands, [=](int top)
     {
-        if (mirror == 1)
+        for (int y=top; y < qMin(top + bandHeight, rows); y++)
         {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    y2 = ny - y1 - 1;
-                    for (x1 = 0; x1 < nx; x1++)
-                        rotimage[(y2*nx) + x1 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
-            }
+            T *row = buffer + static_cast<long>(y) * width;
+            T *opposite = buffer + static_cast<long>(height - 1 - y) * width;
 
-        }
-        else if (mirror == 2)
-        {
-            for (int i=0; i < channels; i++)
+            if (flipY == false || row == opposite)
             {
-                offset = stats.samples_per_channel * i;
-                for (x1 = 0; x1 < nx; x1++)
-                {
-                    x2 = nx - x1 - 1;
-                    for (y1 = 0; y1 < ny; y1++)
-                        rotimage[(y1*nx) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
+                if (flipX)
+                    std::reverse(row, row + width);
             }
-        }
-        else
-        {
-            for (int i=0; i < channels; i++)
+            else if (flipX)
             {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    y2 = ny - y1 - 1;
-                    for (x1 = 0; x1 < nx; x1++)
-                    {
-                        x2 = nx - x1 - 1;
-                        rotimage[(y2*nx) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                    }
-                }
+                for (int x=0; x < width; x++)
+                    std::swap(row[x], opposite[width - 1 - x]);
             }
+            else
+                std::swap_ranges(row, row + width, opposite);
         }
-    }
+    });
+}
 
-    /* Rotate by 270 degrees */
-    else if (rotate >= 225 && rotate < 315)
+template<typename T> bool FITSData::rotFITS (int rotate, int mirror)
+{
+    const int nx = stats.width, ny = stats.height;
+    T *buffer = reinterpret_cast<T *>(image_buffer);
+    bool transpose, flipX, flipY;
+
+    if (rotate == 1)
+        rotate = 90;
+    else if (rotate == 2)
+        rotate = 180;
+    else if (rotate == 3)
+        rotate = 270;
+    else if (rotate < 0)
+        rotate = rotate + 360;
+
+    rotationSteps(rotate, mirror, &transpose, &flipX, &flipY);
+
+    if (transpose && nx != ny)
     {
-        if (mirror == 1)
-        {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    for (x1 = 0; x1 < nx; x1++)
-                        rotimage[(x1*ny) + y1 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
-            }
-        }
-        else if (mirror == 2)
+        /* Only images that change shape need a scratch channel */
+        T *scratch = new T[stats.samples_per_channel];
+        if (scratch == NULL)
         {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    x2 = ny - y1 - 1;
-                    for (x1 = 0; x1 < nx; x1++)
-                    {
-                        y2 = nx - x1 - 1;
-                        rotimage[(y2*ny) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                    }
-                }
-            }
+            qWarning() << "Unable to allocate memory for rotated image buffer!";
+            return false;
         }
-        else
+
+        for (int i=0; i < channels; i++)
         {
-            for (int i=0; i < channels; i++)
-            {
-                offset = stats.samples_per_channel * i;
-                for (y1 = 0; y1 < ny; y1++)
-                {
-                    x2 = y1;
-                    for (x1 = 0; x1 < nx; x1++)
-                    {
-                        y2 = nx - x1 - 1;
-                        rotimage[(y2*ny) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                    }
-                }
-            }
+            T *channel = buffer + static_cast<long>(stats.samples_per_channel) * i;
+            transposeChannel(channel, scratch, nx, ny, flipX, flipY);
+            memcpy(channel, scratch, stats.samples_per_channel * sizeof(T));
         }
 
-        stats.width = ny;
-        stats.height = nx;
+        delete[] scratch;
     }
-
-    /* If rotating by more than 315 degrees, assume top-bottom reflection */
-    else if (rotate >= 315 && mirror)
+    else
     {
         for (int i=0; i < channels; i++)
         {
-            offset = stats.samples_per_channel * i;
-            for (y1 = 0; y1 < ny; y1++)
-            {
-                for (x1 = 0; x1 < nx; x1++)
-                {
-                    x2 = y1;
-                    y2 = x1;
-                    rotimage[(y2*ny) + x2 + offset] = image_buffer[(y1*nx) + x1 + offset];
-                }
-            }
+            T *channel = buffer + static_cast<long>(stats.samples_per_channel) * i;
+            if (transpose)
+                transposeSquare(channel, nx);
+            flipChannel(channel, nx, ny, flipX, flipY);
         }
     }
 
-    delete[] image_buffer;
-    image_buffer = rotimage;
+    if (transpose)
+    {
+        stats.width  = ny;
+        stats.height = nx;
+    }
+
+    // Pixels of the rotated image map to pixels before the rotation with the same steps backwards
+    const int sx = flipX ? -1 : 1, ox = flipX ? stats.width - 1 : 0;
+    const int sy = flipY ? -1 : 1, oy = flipY ? stats.height - 1 : 0;
+    QTransform step = transpose ? QTransform(0, sx, sy, 0, oy, ox) : QTransform(sx, 0, 0, sy, ox, oy);
+    orientation = step * orientation;
 
     return true;
 }
 
-void FITSData::rotWCSFITS (int angle, int mirror)
+void FITSData::rotWCSFITS (const QTransform &toHeader)
 {
     int status=0;
-    char comment[100];
-    double ctemp1, ctemp2, ctemp3, ctemp4, naxis1, naxis2;
-    int WCS_DECIMALS=6;
-
-    naxis1=stats.width;
-    naxis2=stats.height;
+    char comment[100], comment2[100];
+    double crpix1, crpix2;
+    int WCS_DECIMALS=10;
 
-    if (fits_read_key_dbl(fptr, "CD1_1", &ctemp1, comment, &status ))
+    if (fits_read_key_dbl(fptr, "CRPIX1", &crpix1, comment, &status) || fits_read_key_dbl(fptr, "CRPIX2", &crpix2, comment2, &status))
     {
         // No WCS keywords
         return;
     }
 
-    /* Reset CROTAn and CD matrix if axes have been exchanged */
-    if (angle == 90)
-    {
-        if (!fits_read_key_dbl(fptr, "CROTA1", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CROTA1", ctemp1+90.0, WCS_DECIMALS, comment, &status );
+    /* Reference pixel. Header pixels start at 1, toHeader maps pixels starting at 0. */
+    toHeader.inverted().map(crpix1 - 1, crpix2 - 1, &crpix1, &crpix2);
+    fits_update_key_dbl(fptr, "CRPIX1", crpix1 + 1, WCS_DECIMALS, comment, &status);
+    fits_update_key_dbl(fptr, "CRPIX2", crpix2 + 1, WCS_DECIMALS, comment2, &status);
 
-        if (!fits_read_key_dbl(fptr, "CROTA2", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CROTA2", ctemp1+90.0, WCS_DECIMALS, comment, &status );
-    }
+    /* The linear part of the transformation is multiplied by the rotation, whichever form it takes */
+    static const char *cdKeys[4] = { "CD1_1", "CD1_2", "CD2_1", "CD2_2" };
+    static const char *pcKeys[4] = { "PC1_1", "PC1_2", "PC2_1", "PC2_2" };
+    const char **keywords = cdKeys;
+    double m[4];
 
     status=0;
-
-    /* Negate rotation angle if mirrored */
-    if (mirror)
-    {
-        if (!fits_read_key_dbl(fptr, "CROTA1", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CROTA1", -ctemp1, WCS_DECIMALS, comment, &status );
-
-        if (!fits_read_key_dbl(fptr, "CROTA2", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CROTA2", -ctemp1, WCS_DECIMALS, comment, &status );
-
-        status=0;
-
-        if (!fits_read_key_dbl(fptr, "LTM1_1", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "LTM1_1", -ctemp1, WCS_DECIMALS, comment, &status );
-
-        status=0;
-
-        if (!fits_read_key_dbl(fptr, "CD1_1", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CD1_1", -ctemp1, WCS_DECIMALS, comment, &status );
-
-        if (!fits_read_key_dbl(fptr, "CD1_2", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CD1_2", -ctemp1, WCS_DECIMALS, comment, &status );
-
-        if (!fits_read_key_dbl(fptr, "CD2_1", &ctemp1, comment, &status ))
-            fits_update_key_dbl(fptr, "CD2_1", -ctemp1, WCS_DECIMALS, comment, &status );
-    }
-
+    bool hasCD = (fits_read_key_dbl(fptr, "CD1_1", &m[0], comment, &status) == 0);
     status=0;
+    bool hasPC = (hasCD == false && fits_read_key_dbl(fptr, "PC1_1", &m[0], comment, &status) == 0);
 
-    /* Unbin CRPIX and CD matrix */
-    if (!fits_read_key_dbl(fptr, "LTM1_1", &ctemp1, comment, &status ))
+    if (hasCD || hasPC)
     {
-        if (ctemp1 != 1.0)
+        /* Missing terms are those of the identity matrix for PC, and zero for CD */
+        keywords = hasCD ? cdKeys : pcKeys;
+        for (int i=1; i < 4; i++)
         {
-            if (!fits_read_key_dbl(fptr, "LTM2_2", &ctemp2, comment, &status ))
-                if (ctemp1 == ctemp2)
-                {
-                    double ltv1 = 0.0;
-                    double ltv2 = 0.0;
-                    status=0;
-                    if (!fits_read_key_dbl(fptr, "LTV1", &ltv1, comment, &status))
-                        fits_delete_key(fptr, "LTV1", &status);
-                    if (!fits_read_key_dbl(fptr, "LTV2", &ltv2, comment, &status))
-                        fits_delete_key(fptr, "LTV2", &status);
-
-                    status=0;
-
-                    if (!fits_read_key_dbl(fptr, "CRPIX1", &ctemp3, comment, &status ))
-                        fits_update_key_dbl(fptr, "CRPIX1", (ctemp3-ltv1)/ctemp1, WCS_DECIMALS, comment, &status );
-
-                    if (!fits_read_key_dbl(fptr, "CRPIX2", &ctemp3, comment, &status ))
-                        fits_update_key_dbl(fptr, "CRPIX2", (ctemp3-ltv2)/ctemp1, WCS_DECIMALS, comment, &status );
-
-                    status=0;
-
-                    if (!fits_read_key_dbl(fptr, "CD1_1", &ctemp3, comment, &status ))
-                        fits_update_key_dbl(fptr, "CD1_1", ctemp3/ctemp1, WCS_DECIMALS, comment, &status );
-
-                    if (!fits_read_key_dbl(fptr, "CD1_2", &ctemp3, comment, &status ))
-                        fits_update_key_dbl(fptr, "CD1_2", ctemp3/ctemp1, WCS_DECIMALS, comment, &status );
-
-                    if (!fits_read_key_dbl(fptr, "CD2_1", &ctemp3, comment, &status ))
-                        fits_update_key_dbl(fptr, "CD2_1", ctemp3/ctemp1, WCS_DECIMALS, comment, &status );
-
-                    if (!fits_read_key_dbl(fptr, "CD2_2", &ctemp3, comment, &status ))
-                        fits_update_key_dbl(fptr, "CD2_2", ctemp3/ctemp1, WCS_DECIMALS, comment, &status );
-
-                    status=0;
-
-                    fits_delete_key(fptr, "LTM1_1", &status);
-                    fits_delete_key(fptr, "LTM1_2", &status);
-                }
+            status=0;
+            if (fits_read_key_dbl(fptr, keywords[i], &m[i], comment, &status))
+                m[i] = (hasPC && i == 3) ? 1 : 0;
         }
     }
-
-    status=0;
-
-    /* Reset CRPIXn */
-    if ( !fits_read_key_dbl(fptr, "CRPIX1", &ctemp1, comment, &status ) && !fits_read_key_dbl(fptr, "CRPIX2", &ctemp2, comment, &status ) )
+    else
     {
-        if (mirror)
-        {
-            if (angle == 0)
-                fits_update_key_dbl(fptr, "CRPIX1", naxis1-ctemp1, WCS_DECIMALS, comment, &status );
-            else if (angle == 90)
-            {
-                fits_update_key_dbl(fptr, "CRPIX1", naxis2-ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CRPIX2", naxis1-ctemp1, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 180)
-            {
-                fits_update_key_dbl(fptr, "CRPIX1", ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CRPIX2", naxis2-ctemp2, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 270)
-            {
-                fits_update_key_dbl(fptr, "CRPIX1", ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CRPIX2", ctemp1, WCS_DECIMALS, comment, &status );
-            }
-        }
-        else
-        {
-            if (angle == 90)
-            {
-                fits_update_key_dbl(fptr, "CRPIX1", naxis2-ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CRPIX2", ctemp1, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 180)
-            {
-                fits_update_key_dbl(fptr, "CRPIX1", naxis1-ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CRPIX2", naxis2-ctemp2, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 270)
-            {
-                fits_update_key_dbl(fptr, "CRPIX1", ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CRPIX2", naxis1-ctemp1, WCS_DECIMALS, comment, &status );
-            }
-        }
-    }
+        /* CDELTn and CROTA2 are written as a CD matrix, which can hold any rotation and flip */
+        double cdelt1=1, cdelt2=1, crota=0;
+        status=0;
+        fits_read_key_dbl(fptr, "CDELT1", &cdelt1, comment, &status);
+        status=0;
+        fits_read_key_dbl(fptr, "CDELT2", &cdelt2, comment, &status);
+        status=0;
+        fits_read_key_dbl(fptr, "CROTA2", &crota, comment, &status);
 
-    status=0;
+        double angle = crota * dms::DegToRad;
+        m[0] = cdelt1 * cos(angle);
+        m[1] = -cdelt2 * sin(angle);
+        m[2] = cdelt1 * sin(angle);
+        m[3] = cdelt2 * cos(angle);
 
-    /* Reset CDELTn (degrees per pixel) */
-    if ( !fits_read_key_dbl(fptr, "CDELT1", &ctemp1, comment, &status ) && !fits_read_key_dbl(fptr, "CDELT2", &ctemp2, comment, &status ) )
-    {
-        if (mirror)
+        const char *obsolete[4] = { "CDELT1", "CDELT2", "CROTA1", "CROTA2" };
+        for (int i=0; i < 4; i++)
         {
-            if (angle == 0)
-                fits_update_key_dbl(fptr, "CDELT1", -ctemp1, WCS_DECIMALS, comment, &status );
-            else if (angle == 90)
-            {
-                fits_update_key_dbl(fptr, "CDELT1", -ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CDELT2", -ctemp1, WCS_DECIMALS, comment, &status );
-
-            }
-            else if (angle == 180)
-            {
-                fits_update_key_dbl(fptr, "CDELT1", ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CDELT2", -ctemp2, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 270)
-            {
-                fits_update_key_dbl(fptr, "CDELT1", ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CDELT2", ctemp1, WCS_DECIMALS, comment, &status );
-            }
-        }
-        else
-        {
-            if (angle == 90)
-            {
-                fits_update_key_dbl(fptr, "CDELT1", -ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CDELT2", ctemp1, WCS_DECIMALS, comment, &status );
-
-            }
-            else if (angle == 180)
-            {
-                fits_update_key_dbl(fptr, "CDELT1", -ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CDELT2", -ctemp2, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 270)
-            {
-                fits_update_key_dbl(fptr, "CDELT1", ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CDELT2", -ctemp1, WCS_DECIMALS, comment, &status );
-            }
+            status=0;
+            fits_delete_key(fptr, obsolete[i], &status);
         }
     }
 
-    /* Reset CD matrix, if present */
-    ctemp1 = 0.0;
-    ctemp2 = 0.0;
-    ctemp3 = 0.0;
-    ctemp4 = 0.0;
-    status=0;
-    if ( !fits_read_key_dbl(fptr, "CD1_1", &ctemp1, comment, &status ) )
-    {
-        fits_read_key_dbl(fptr, "CD1_2", &ctemp2, comment, &status );
-        fits_read_key_dbl(fptr, "CD2_1", &ctemp3, comment, &status );
-        fits_read_key_dbl(fptr, "CD2_2", &ctemp4, comment, &status );
-        status=0;
-        if (mirror)
-        {
-            if (angle == 0)
-            {
-                fits_update_key_dbl(fptr, "CD1_2", -ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", -ctemp3, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 90)
-            {
-                fits_update_key_dbl(fptr, "CD1_1", -ctemp4, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD1_2", -ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", -ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_2", -ctemp1, WCS_DECIMALS, comment, &status );
+    /* Header pixels are toHeader applied to pixels of the image, so the matrix is multiplied by its linear part */
+    double r[4];
+    r[0] = m[0] * toHeader.m11() + m[1] * toHeader.m12();
+    r[1] = m[0] * toHeader.m21() + m[1] * toHeader.m22();
+    r[2] = m[2] * toHeader.m11() + m[3] * toHeader.m12();
+    r[3] = m[2] * toHeader.m21() + m[3] * toHeader.m22();
 
-            }
-            else if (angle == 180)
-            {
-                fits_update_key_dbl(fptr, "CD1_1", ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD1_2", ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", -ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_2", -ctemp4, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 270)
-            {
-                fits_update_key_dbl(fptr, "CD1_1", ctemp4, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD1_2", ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_2", ctemp1, WCS_DECIMALS, comment, &status );
-            }
-        }
-        else {
-            if (angle == 90)
-            {
-                fits_update_key_dbl(fptr, "CD1_1", -ctemp4, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD1_2", -ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_2", ctemp1, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 180)
-            {
-                fits_update_key_dbl(fptr, "CD1_1", -ctemp1, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD1_2", -ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", -ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_2", -ctemp4, WCS_DECIMALS, comment, &status );
-            }
-            else if (angle == 270)
-            {
-                fits_update_key_dbl(fptr, "CD1_1", ctemp4, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD1_2", ctemp3, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_1", -ctemp2, WCS_DECIMALS, comment, &status );
-                fits_update_key_dbl(fptr, "CD2_2", -ctemp1, WCS_DECIMALS, comment, &status );
-            }
-        }
-    }
+    status=0;
+    for (int i=0; i < 4; i++)
+        fits_update_key_dbl(fptr, keywords[i], r[i], WCS_DECIMALS, "", &status);
 
     /* Delete any polynomial solution */
     /* (These could maybe be switched, but I don't want to work them out yet */
     status=0;
-    if ( !fits_read_key_dbl(fptr, "CO1_1", &ctemp1, comment, &status ) )
+    if ( !fits_read_key_dbl(fptr, "CO1_1", &crpix1, comment, &status ) )
     {
         int i;
         char keyword[16];
@@ -2135,15 +2134,124 @@ void FITSData::rotWCSFITS (int angle, int mirror)
     return;
 }
 
-float * FITSData::getImageBuffer()
+uint8_t * FITSData::getImageBuffer()
 {
+    completeDebayer();
+
     return image_buffer;
 }
 
-void FITSData::setImageBuffer(float *buffer)
+uint8_t * FITSData::copyImageBuffer()
+{
+    completeDebayer();
+
+    if (image_buffer == NULL)
+        return NULL;
+
+    long size = stats.samples_per_channel * channels * getBytesPerPixel();
+    uint8_t *copy = new uint8_t[size];
+    memcpy(copy, image_buffer, size);
+
+    return copy;
+}
+
+void FITSData::setImageBuffer(uint8_t *buffer)
 {
     delete[] image_buffer;
     image_buffer = buffer;
+
+    delete[] float_buffer;
+    float_buffer = NULL;
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
+}
+
+int FITSData::getBytesPerPixel()
+{
+    switch (data_type)
+    {
+    case TBYTE:
+        return sizeof(uint8_t);
+    case TUSHORT:
+        return sizeof(uint16_t);
+    case TSHORT:
+        return sizeof(int16_t);
+    case TINT:
+        return sizeof(int32_t);
+    case TDOUBLE:
+        return sizeof(double);
+    case TFLOAT:
+    default:
+        return sizeof(float);
+    }
+}
+
+template<typename T> static void convertToFloat(const T *buffer, float *float_buffer, long size)
+{
+    for (long i=0; i < size; i++)
+        float_buffer[i] = buffer[i];
+}
+
+float * FITSData::getFloatBuffer()
+{
+    completeDebayer();
+
+    if (data_type == TFLOAT || image_buffer == NULL)
+        return reinterpret_cast<float *>(image_buffer);
+
+    if (float_buffer == NULL)
+    {
+        long size = stats.samples_per_channel * channels;
+
+        float_buffer = new float[size];
+        if (float_buffer == NULL)
+        {
+            qWarning() << "Unable to allocate memory for float image buffer!";
+            return NULL;
+        }
+
+        switch (data_type)
+        {
+        case TBYTE:
+            convertToFloat(image_buffer, float_buffer, size);
+            break;
+        case TUSHORT:
+            convertToFloat(reinterpret_cast<uint16_t *>(image_buffer), float_buffer, size);
+            break;
+        case TSHORT:
+            convertToFloat(reinterpret_cast<int16_t *>(image_buffer), float_buffer, size);
+            break;
+        case TINT:
+            convertToFloat(reinterpret_cast<int32_t *>(image_buffer), float_buffer, size);
+            break;
+        case TDOUBLE:
+            convertToFloat(reinterpret_cast<double *>(image_buffer), float_buffer, size);
+            break;
+        }
+    }
+
+    return float_buffer;
+}
+
+double FITSData::getPixelValue(long index)
+{
+    switch (data_type)
+    {
+    case TBYTE:
+        return image_buffer[index];
+    case TUSHORT:
+        return reinterpret_cast<uint16_t *>(image_buffer)[index];
+    case TSHORT:
+        return reinterpret_cast<int16_t *>(image_buffer)[index];
+    case TINT:
+        return reinterpret_cast<int32_t *>(image_buffer)[index];
+    case TFLOAT:
+        return reinterpret_cast<float *>(image_buffer)[index];
+    case TDOUBLE:
+        return reinterpret_cast<double *>(image_buffer)[index];
+    }
+
+    return 0;
 }
 
 bool FITSData::checkDebayer()
@@ -2180,13 +2288,13 @@ bool FITSData::checkDebayer()
     fits_read_key(fptr, TINT, "YBAYROFF", &debayerParams.offsetY, NULL, &status);
 
     delete[] bayer_buffer;
-    bayer_buffer = new float[stats.samples_per_channel * channels];
+    bayer_buffer = new uint8_t[stats.samples_per_channel * channels * getBytesPerPixel()];
     if (bayer_buffer == NULL)
     {
         KMessageBox::error(NULL, i18n("Unable to allocate memory for bayer buffer."), i18n("Open FITS"));
         return false;
     }
-    memcpy(bayer_buffer, image_buffer, stats.samples_per_channel * channels * sizeof(float));
+    memcpy(bayer_buffer, image_buffer, stats.samples_per_channel * channels * getBytesPerPixel());
 
     HasDebayer = true;
 
@@ -2210,61 +2318,235 @@ void FITSData::setBayerParams(BayerParams *param)
     debayerParams.offsetY  = param->offsetY;
 }
 
-bool FITSData::debayer()
+bool FITSData::debayer(const QRect &region)
 {
-    dc1394error_t error_code;
+    bool rc = false;
 
-    int rgb_size = stats.samples_per_channel*3;
-    float * dst = new float[rgb_size];
-    if (dst == NULL)
+    switch (data_type)
     {
-        KMessageBox::error(NULL, i18n("Unable to allocate memory for temporary bayer buffer."), i18n("Debayer Error"));
+    case TBYTE:
+        rc = debayer<uint8_t>(region);
+        break;
+    case TUSHORT:
+        rc = debayer<uint16_t>(region);
+        break;
+    case TSHORT:
+        rc = debayer<int16_t>(region);
+        break;
+    case TINT:
+        rc = debayer<int32_t>(region);
+        break;
+    case TFLOAT:
+        rc = debayer<float>(region);
+        break;
+    case TDOUBLE:
+        rc = debayer<double>(region);
+        break;
+    }
+
+    delete[] float_buffer;
+    float_buffer = NULL;
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
+
+    return rc;
+}
+
+namespace
+{
+
+struct DebayerStrip
+{
+    QRect rect;
+    dc1394error_t error;
+};
+
+}
+
+/* Debayer the pixels of one strip into the red, green and blue planes. The bayer decoders work on interleaved floats,
+   so the strip and the rows and columns around it that they interpolate from are converted for their sake only. */
+template<typename T> static void debayerStrip(const T *bayer, T *red, T *green, T *blue, int width, int height,
+                                              const BayerParams &params, DebayerStrip &strip)
+{
+    // Start on an even row and column, so the pattern keeps its phase
+    int x0 = qMax(0, strip.rect.left() - DEBAYER_HALO) & ~1;
+    int y0 = qMax(0, strip.rect.top() - DEBAYER_HALO) & ~1;
+    int x1 = qMin(width, strip.rect.right() + 1 + DEBAYER_HALO);
+    int y1 = qMin(height, strip.rect.bottom() + 1 + DEBAYER_HALO);
+    int sx = x1 - x0, sy = y1 - y0;
+
+    // With an offset the decoders read up to a row past the strip, and some of them leave the borders unwritten
+    float *src = new float[sx * (sy + 1) + 2];
+    float *dst = new float[sx * sy * 3]();
+    memset(src + sx * sy, 0, (sx + 2) * sizeof(float));
+
+    for (int y=0; y < sy; y++)
+    {
+        const T *in = bayer + (y0 + y) * width + x0;
+        float *out  = src + y * sx;
+        for (int x=0; x < sx; x++)
+            out[x] = in[x];
+    }
+
+    strip.error = dc1394_bayer_decoding_float(src, dst, sx, sy, params.offsetX, params.offsetY, params.filter, params.method);
+
+    if (strip.error == DC1394_SUCCESS)
+    {
+        // Data in R1G1B1, we need to copy them into 3 layers for FITS
+        for (int y=strip.rect.top(); y <= strip.rect.bottom(); y++)
+        {
+            const float *in = dst + ((y - y0) * sx + strip.rect.left() - x0) * 3;
+            long offset = y * width + strip.rect.left();
+            T *r = red + offset, *g = green + offset, *b = blue + offset;
+
+            for (int x=0; x < strip.rect.width(); x++)
+            {
+                r[x] = in[x*3];
+                g[x] = in[x*3+1];
+                b[x] = in[x*3+2];
+            }
+        }
+    }
+
+    delete[] src;
+    delete[] dst;
+}
+
+template<typename T> bool FITSData::debayer(const QRect &region)
+{
+    QRect frame(0, 0, stats.width, stats.height);
+    QRect area = region.isNull() ? frame : region.intersected(frame);
+    if (area.isEmpty())
+        area = frame;
+
+    T *bayer = reinterpret_cast<T *>(bayer_buffer);
+
+    uint8_t *rgb_buffer = new uint8_t[stats.samples_per_channel * 3 * sizeof(T)];
+    if (rgb_buffer == NULL)
+    {
+        KMessageBox::error(NULL, i18n("Unable to allocate memory for debayerd buffer."), i18n("Debayer Error"));
         return false;
     }
 
-    if ( (error_code = dc1394_bayer_decoding_float(bayer_buffer, dst, stats.width, stats.height, debayerParams.offsetX, debayerParams.offsetY,
-                                                   debayerParams.filter, debayerParams.method)) != DC1394_SUCCESS)
+    T * rBuff = reinterpret_cast<T *>(rgb_buffer);
+    T * gBuff = rBuff + stats.samples_per_channel;
+    T * bBuff = rBuff + stats.samples_per_channel * 2;
+
+    // Pixels outside of the region keep the bayer values in all three layers until completeDebayer()
+    if (area != frame)
     {
-        KMessageBox::error(NULL, i18n("Debayer failed (%1)", error_code), i18n("Debayer error"));
-        channels=1;
-        delete[] dst;
-        //Restore buffer
-        delete[] image_buffer;
-        image_buffer = new float[stats.samples_per_channel];
-        memcpy(image_buffer, bayer_buffer, stats.samples_per_channel * sizeof(float));
+        memcpy(rBuff, bayer, stats.samples_per_channel * sizeof(T));
+        memcpy(gBuff, bayer, stats.samples_per_channel * sizeof(T));
+        memcpy(bBuff, bayer, stats.samples_per_channel * sizeof(T));
+    }
+
+    if (debayerArea(area, rBuff, gBuff, bBuff) == false)
+    {
+        delete[] rgb_buffer;
         return false;
     }
 
-    if (channels == 1)
+    delete[] image_buffer;
+    image_buffer = rgb_buffer;
+    channels=3;
+    debayeredArea = (area == frame) ? QRect() : area;
+    return true;
+
+}
+
+template<typename T> bool FITSData::debayerArea(const QRect &area, T *rBuff, T *gBuff, T *bBuff)
+{
+    T *bayer = reinterpret_cast<T *>(bayer_buffer);
+
+    // Several strips per thread, so that the temporary buffers of the strips in progress stay small
+    int nStrips = qBound(1, QThread::idealThreadCount() * 4, area.height() / DEBAYER_MIN_STRIP);
+    int stripRows = ((area.height() + nStrips - 1) / nStrips + 1) & ~1;
+
+    QVector<DebayerStrip> strips;
+    for (int top=area.top(); top <= area.bottom(); top += stripRows)
+    {
+        DebayerStrip strip;
+        strip.rect  = QRect(area.left(), top, area.width(), qMin(stripRows, area.bottom() + 1 - top));
+        strip.error = DC1394_SUCCESS;
+        strips.append(strip);
+    }
+
+    int width = stats.width, height = stats.height;
+    const BayerParams &params = debayerParams;
+    QtConcurrent::blockingMap(strips, [=, &params](DebayerStrip &strip)
     {
-        delete[] image_buffer;
-        image_buffer = new float[rgb_size];
+        debayerStrip(bayer, rBuff, gBuff, bBuff, width, height, params, strip);
+    });
 
-        if (image_buffer == NULL)
+    foreach (const DebayerStrip &strip, strips)
+    {
+        if (strip.error != DC1394_SUCCESS)
         {
-            delete[] dst;
-            KMessageBox::error(NULL, i18n("Unable to allocate memory for debayerd buffer."), i18n("Debayer Error"));
+            KMessageBox::error(NULL, i18n("Debayer failed (%1)", strip.error), i18n("Debayer error"));
             return false;
         }
     }
 
-    // Data in R1G1B1, we need to copy them into 3 layers for FITS
-    float * rBuff = image_buffer;
-    float * gBuff = image_buffer + (stats.width * stats.height);
-    float * bBuff = image_buffer + (stats.width * stats.height * 2);
+    return true;
+}
 
-    int imax = stats.samples_per_channel*3 - 3;
-    for (int i=0; i <= imax; i += 3)
+void FITSData::completeDebayer()
+{
+    if (debayeredArea.isNull() || bayer_buffer == NULL || channels != 3)
     {
-        *rBuff++ = dst[i];
-        *gBuff++ = dst[i+1];
-        *bBuff++ = dst[i+2];
+        debayeredArea = QRect();
+        return;
     }
 
-    channels=3;
-    delete[] dst;
-    return true;
+    switch (data_type)
+    {
+    case TBYTE:
+        completeDebayer<uint8_t>();
+        break;
+    case TUSHORT:
+        completeDebayer<uint16_t>();
+        break;
+    case TSHORT:
+        completeDebayer<int16_t>();
+        break;
+    case TINT:
+        completeDebayer<int32_t>();
+        break;
+    case TFLOAT:
+        completeDebayer<float>();
+        break;
+    case TDOUBLE:
+        completeDebayer<double>();
+        break;
+    }
+
+    debayeredArea = QRect();
 
+    delete[] float_buffer;
+    float_buffer = NULL;
+    for (int i=0; i < 3; i++)
+        valueCounts[i].clear();
+}
+
+template<typename T> void FITSData::completeDebayer()
+{
+    T * rBuff = reinterpret_cast<T *>(image_buffer);
+    T * gBuff = rBuff + stats.samples_per_channel;
+    T * bBuff = rBuff + stats.samples_per_channel * 2;
+
+    // The bands above and below the debayered area, and the parts left and right of it
+    const QRect &area = debayeredArea;
+    QList<QRect> remaining;
+    remaining << QRect(0, 0, stats.width, area.top())
+              << QRect(0, area.bottom() + 1, stats.width, stats.height - area.bottom() - 1)
+              << QRect(0, area.top(), area.left(), area.height())
+              << QRect(area.right() + 1, area.top(), stats.width - area.right() - 1, area.height());
+
+    foreach (const QRect &rect, remaining)
+    {
+        if (rect.isEmpty() == false)
+            debayerArea(rect, rBuff, gBuff, bBuff);
+    }
 }
 
 double FITSData::getADU()
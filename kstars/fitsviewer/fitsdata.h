@@ -28,6 +28,8 @@
 #include <QPaintEvent>
 #include <QScrollArea>
 #include <QLabel>
+#include <QVector>
+#include <QTransform>
 
 #ifndef KSTARS_LITE
 #include <kxmlguiwindow.h>
@@ -41,6 +43,7 @@
 #include <fitsio.h>
 #include "fitshistogram.h"
 #include "fitscommon.h"
+#include "fitsstatistics.h"
 
 #include "skypoint.h"
 #include "dms.h"
@@ -53,6 +56,7 @@
 #define MINIMUM_STDVAR  5
 
 class QProgressDialog;
+struct wcsprm;
 
 typedef struct
 {
@@ -81,15 +85,19 @@ public:
     FITSData(FITSMode mode=FITS_NORMAL);
     ~FITSData();
 
-    /* Loads FITS image, scales it, and displays it in the GUI */
-    bool  loadFITS(const QString &filename, bool silent=true);
+    /* Loads FITS image, scales it, and displays it in the GUI. If buffer holds a complete FITS file,
+       e.g. an INDI BLOB, the image is read from it without touching the disk, and filename only names it.
+       The buffer is shared, not copied, and may be retrieved with getFITSBuffer(). */
+    bool  loadFITS(const QString &filename, bool silent=true, const QByteArray &buffer=QByteArray());
     /* Save FITS */
     int saveFITS(const QString &filename);
+    /* Write a copy of the image as it is held in memory, leaving this data bound to its current file or buffer */
+    int exportFITS(const QString &filename);
     /* Rescale image lineary from image_buffer, fit to window if desired */
     int rescale(FITSZoom type);
     /* Calculate stats */
     void calculateStats(bool refresh=false);
-    /* Calculate running average & standard deviation using Welford’s method for computing variance */
+    /* Calculate mean, standard deviation and median of the image, keeping the current min and max */
     void runningAverageStdDev();
 
     // Access functions
@@ -98,11 +106,23 @@ public:
     //double getValue(int i);
     //void setValue(int i, float value);
     void clearImageBuffers();
-    void setImageBuffer(float *buffer);
-    float * getImageBuffer();
+    /* Image buffer holds the pixels in their native type, see getDataType() */
+    void setImageBuffer(uint8_t *buffer);
+    uint8_t * getImageBuffer();
+    /* A copy of the image buffer that the caller owns, to process and hand back with setImageBuffer() */
+    uint8_t * copyImageBuffer();
+    /* The image buffer as it is, for display only. It may be debayered in part, see debayer(). */
+    uint8_t * getDisplayBuffer() { return image_buffer; }
+    /* Float copy of the image buffer, made when first requested and kept until the image changes.
+       For float images, this is the image buffer itself. Otherwise changes to it are not kept. */
+    float * getFloatBuffer();
+    /* Value of the pixel at index in the image buffer */
+    double getPixelValue(long index);
 
     // Stats
+    /* CFITSIO type of the pixels in the image buffer: TBYTE, TUSHORT, TSHORT, TINT, TFLOAT or TDOUBLE */
     int getDataType() { return data_type; }
+    int getBytesPerPixel();
     unsigned int getSize() { return stats.samples_per_channel; }
     void getDimensions(double *w, double *h) { *w = stats.width; *h = stats.height; }
     void setWidth(long w) { stats.width = w;}
@@ -122,6 +142,9 @@ public:
     double getMean(uint8_t channel=0) { return stats.mean[channel]; }
     void setMedian(double val, uint8_t channel=0) { stats.median[channel] = val;}
     double getMedian(uint8_t channel=0) { return stats.median[channel];}
+    /* Count the pixels of each channel in frequencies[c].size() bins of binWidth, centered from min upwards.
+       8 and 16 bit images reuse the value counts of the last statistics, if the pixels did not change since. */
+    void getHistogram(double min, double binWidth, QVector<double> *frequencies);
 
     void setSNR(double val) { stats.SNR = val;}
     double getSNR() { return stats.SNR;}
@@ -137,6 +160,15 @@ public:
     void findCentroid(const QRectF &boundary = QRectF(), int initStdDev=MINIMUM_STDVAR, int minEdgeWidth=MINIMUM_PIXEL_RANGE);
     void getCenterSelection(int *x, int *y);
     int findOneStar(const QRectF &boundary);
+    /* Copy of the first channel and the statistics that star detection needs, to search it on another thread.
+       If box is not null, only the box and a border around it are copied. */
+    FITSData * createAnalysisCopy(const QRect &box=QRect());
+    /* Position of a copy within the image it was made from */
+    const QPoint & getOrigin() { return origin; }
+    /* Take the minimum and maximum from the whole image, and the background level and noise from the pixels outside of box */
+    void estimateBackground(const QRect &box);
+    /* Take over the stars found in other, a copy of this image */
+    void takeStars(FITSData *other);
 
     // Half Flux Radius
     Edge * getMaxHFRStar() { return maxHFRStar;}
@@ -148,11 +180,19 @@ public:
 
     // WCS
     bool hasWCS() { return HasWCS; }
-    wcs_point *getWCSCoord()  { return wcs_coord; }
+    /* Get the sky coordinates of pixel x,y. They are evaluated when asked for, or if interpolate is true, interpolated
+       between exact coordinates on a coarse grid that is built on first use. Returns false if there is no WCS. */
+    bool pixelToWCS(double x, double y, wcs_point &coord, bool interpolate=false);
 
     // Debayer
     bool hasDebayer() { return HasDebayer; }
-    bool debayer();
+    /* Debayer the image. If region is not null, only the pixels within it get colours, and the rest stay monochrome
+       for display until completeDebayer() is called. Statistics, star detection and all other analysis call it first. */
+    bool debayer(const QRect &region=QRect());
+    /* Debayer the pixels left out by a debayer of a region only */
+    void completeDebayer();
+    /* Region of the image to debayer when it is loaded, or null for the whole image */
+    void setDebayerRegion(const QRect &region) { debayerRegion = region; }
     void getBayerParams(BayerParams *param);
     void setBayerParams(BayerParams *param);
 
@@ -163,15 +203,22 @@ public:
     void setHistogram(FITSHistogram *inHistogram) { histogram = inHistogram; }
 
     // Filter
-    void applyFilter(FITSScale type, float *image=NULL, float min=-1, float max=-1);
+    /* Apply filter to image, a buffer of the same size and type as the image buffer. The result goes to the image buffer. */
+    void applyFilter(FITSScale type, uint8_t *image=NULL, float min=-1, float max=-1);
 
     // Rotation counter. We keep count to rotate WCS keywords on save
     int getRotCounter() const;
     void setRotCounter(int value);
 
-    // Filename
+    // Maps pixels of the image as it is to pixels of the image as loaded, after any rotation or flip
+    const QTransform & getOrientation() const { return orientation; }
+
+    // Filename. Empty if the image was loaded from memory and never saved.
     const QString & getFilename() { return filename; }
 
+    // FITS file the image was loaded from, if it was loaded from memory
+    const QByteArray & getFITSBuffer() { return fitsBuffer; }
+
     // Horizontal flip counter. We keep count to rotate WCS keywords on save
     int getFlipHCounter() const;
     void setFlipHCounter(int value);
@@ -184,6 +231,12 @@ public:
     float *getDarkFrame() const;
     void setDarkFrame(float *value);
     void subtract(float *darkFrame);
+    /* Subtract darkData, starting at offsetX,offsetY within it */
+    void subtract(FITSData *darkData, uint16_t offsetX=0, uint16_t offsetY=0);
+    /* Subtract the pixels of dark, which rows are darkWidth long, from those of light, starting at darkOffset within dark.
+       It touches no FITSData, so it may run on a copy of the image buffer off the GUI thread. */
+    static void subtractBuffer(uint8_t *light, int lightType, int width, int height, const uint8_t *dark, int darkType,
+                               long darkOffset, int darkWidth);
 
     /* stats struct to hold statisical data about the FITS data */
     struct
@@ -203,10 +256,21 @@ public:
 private:
 
     bool rotFITS (int rotate, int mirror);
-    void rotWCSFITS (int angle, int mirror);
-    bool checkCollision(Edge* s1, Edge*s2);
-    int calculateMinMax(bool refresh=false);
+    void rotWCSFITS (const QTransform &toHeader);
+    /* Statistics of up to three channels of the image buffer */
+    void calculateStatistics(FITSStatistics::Channel *results);
+
+    // The same, for the type T of the pixels in the image buffer
+    template<typename T> void applyFilter(FITSScale type, T *image, float min, float max);
+    template<typename T> bool rotFITS(int rotate, int mirror);
+    template<typename T> int findOneStar(const QRectF &boundary);
+    template<typename T> bool debayer(const QRect &region);
+    template<typename T> bool debayerArea(const QRect &area, T *red, T *green, T *blue);
+    template<typename T> void completeDebayer();
     void checkWCS();
+    void clearWCS();
+    bool evaluateWCS(double x, double y, wcs_point &coord);
+    bool buildWCSGrid();
     bool checkDebayer();
     void readWCSKeys();
 
@@ -215,7 +279,9 @@ private:
 
     int data_type;                      // FITS image data type    
     int channels;                       // Number of channels    
-    float *image_buffer;         		// Current image buffer
+    uint8_t *image_buffer;              // Current image buffer, in the FITS image data type
+    float *float_buffer;                // Float copy of image_buffer, if requested
+    QVector<uint32_t> valueCounts[3];   // Pixels of each value of 8 and 16 bit images, per channel, from the statistics
     float *darkFrame;                    // Optional dark frame pointer
 
 
@@ -226,18 +292,30 @@ private:
     bool HasDebayer;                    // Is the image debayarable?
 
     QString filename;                   // Our very own file name
+    QByteArray fitsBuffer;              // FITS file in memory, if not loaded from disk
+    void *fitsMemory;                   // Address and size of fitsBuffer, which CFITSIO refers to while fptr is open
+    size_t fitsMemorySize;
     FITSMode mode;                      // FITS Mode (Normal, WCS, Guide, Focus..etc)
 
     int rotCounter;                     // How many times the image was rotated? Useful for WCS keywords rotation on save.
     int flipHCounter;                   // How many times the image was flipped horizontally?
     int flipVCounter;                   // How many times the image was flipped vertically?
-
-    wcs_point *wcs_coord;               // Pointer to WCS coordinate data, if any.
+    QTransform orientation;             // Maps pixels of the image as it is to pixels of the image as loaded, which the WCS describes
+    QTransform savedOrientation;        // Orientation when the header was last written
+
+    struct wcsprm *wcs;                 // WCS parameters read from the header, if any.
+    int nwcs;                           // Number of coordinate systems in wcs
+    QVector<wcs_point> wcsGrid;         // Exact sky coordinates every wcsGridStep pixels, for interpolation
+    int wcsGridCols;                    // Number of grid points per row
+    int wcsGridStep;                    // Grid spacing in pixels, 0 if not built yet, -1 if interpolation is not accurate enough
+    QPoint origin;                      // Position of the pixels within the image they were copied from, if this is a copy
     QList<Edge*> starCenters;           // All the stars we detected, if any.
     Edge* maxHFRStar;                   // The biggest fattest star in the image.
 
-    float *bayer_buffer;                // Bayer buffer
+    uint8_t *bayer_buffer;              // Bayer buffer, in the FITS image data type
     BayerParams debayerParams;          // Bayer parameters
+    QRect debayerRegion;                // Region to debayer on load, null for the whole image
+    QRect debayeredArea;                // Only part of image_buffer that is debayered yet, null if all of it or none
 
 };
 
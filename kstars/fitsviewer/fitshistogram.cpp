@@ -30,6 +30,8 @@
 
 #include <QUndoStack>
 #include <QDebug>
+#include <QAtomicInt>
+#include <QtConcurrent>
 //#include <klineedit.h>
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -39,6 +41,9 @@
 #define LOW_PASS_MARGIN 0.01
 #define LOW_PASS_LIMIT  .05
 
+// Undo deltas are compressed and restored in blocks of this many bytes
+#define DELTA_BLOCK     (4 << 20)
+
 histogramUI::histogramUI(QDialog *parent) : QDialog(parent)
 {
     setupUi(parent);
@@ -103,7 +108,6 @@ void FITSHistogram::constructHistogram()
     double fits_w=0, fits_h=0;
 
     FITSData *image_data = tab->getView()->getImageData();
-    float *buffer = image_data->getImageBuffer();
 
     image_data->getDimensions(&fits_w, &fits_h);
     image_data->getMinMax(&fits_min, &fits_max);
@@ -113,7 +117,6 @@ void FITSHistogram::constructHistogram()
     binCount = sqrt(samples);
 
     intensity.fill(0, binCount);
-    r_frequency.fill(0, binCount);
     cumulativeFrequency.fill(0, binCount);
 
     double pixel_range = fits_max - fits_min;
@@ -125,41 +128,29 @@ void FITSHistogram::constructHistogram()
     for (int i=0; i < binCount; i++)
         intensity[i] = fits_min + (binWidth * i);
 
-    uint16_t r_id=0, g_id=0, b_id=0;
+    int channels = image_data->getNumOfChannels();
 
-    if (image_data->getNumOfChannels() == 1)
-    {
-        for (uint32_t i=0; i < samples ; i++)
-        {
-            r_id = round((buffer[i] - fits_min) / binWidth);
-            r_frequency[r_id >= binCount ? binCount - 1 : r_id]++;
-        }
-    }
-    else
-    {
-        g_frequency.fill(0, binCount);
-        b_frequency.fill(0, binCount);
+    // Counted on all threads, or from the value counts of the statistics for 8 and 16 bit images
+    QVector<double> frequencies[3];
+    for (int i=0; i < qMin(channels, 3); i++)
+        frequencies[i].fill(0, binCount);
 
-        int g_offset = samples;
-        int b_offset = samples*2;
-        for (uint32_t i=0; i < samples ; i++)
-        {
-            r_id = round((buffer[i] - fits_min) / binWidth);
-            r_frequency[r_id >= binCount ? binCount - 1 : r_id]++;
+    image_data->getHistogram(fits_min, binWidth, frequencies);
 
-            g_id = round((buffer[i+g_offset] - fits_min) / binWidth);
-            g_frequency[g_id >= binCount ? binCount - 1 : g_id]++;
-
-            b_id = round((buffer[i+b_offset] - fits_min) / binWidth);
-            b_frequency[b_id >= binCount ? binCount - 1 : b_id]++;
-        }
+    r_frequency = frequencies[0];
+    if (channels > 1)
+    {
+        g_frequency = frequencies[1];
+        b_frequency = frequencies[2];
     }
 
-
     // Cumuliative Frequency
+    double cumulative=0;
     for (int i=0; i < binCount; i++)
-        for (int j=0; j <= i; j++)
-            cumulativeFrequency[i] += r_frequency[j];
+    {
+        cumulative += r_frequency[i];
+        cumulativeFrequency[i] = cumulative;
+    }
 
     int maxFrequency=0;
     if (image_data->getNumOfChannels() == 1)
@@ -183,26 +174,13 @@ void FITSHistogram::constructHistogram()
         }
     }
 
-    double median=0;
-    int halfCumulative = cumulativeFrequency[binCount - 1]/2;
-    for (int i=0; i < binCount; i++)
-    {
-        if (cumulativeFrequency[i] >= halfCumulative)
-        {
-            median = i * binWidth + fits_min;
-            break;
-        }
-    }
-
     // Custom index to indicate the overall constrast of the image
     JMIndex = cumulativeFrequency[binCount/8]/cumulativeFrequency[binCount/4];
     if (Options::fITSLogging())
         qDebug() << "FITHistogram: JMIndex " << JMIndex;
 
-    image_data->setMedian(median);
-
     ui->meanEdit->setText(QString::number(image_data->getMean()));
-    ui->medianEdit->setText(QString::number(median));
+    ui->medianEdit->setText(QString::number(image_data->getMedian()));
 
     ui->minEdit->setMinimum(fits_min);
     ui->minEdit->setMaximum(fits_max-1);
@@ -345,8 +323,8 @@ FITSHistogramCommand::FITSHistogramCommand(QWidget * parent, FITSHistogram *inHi
     tab         = (FITSTab *) parent;
     type        = newType;
     histogram   = inHisto;
-    delta  = NULL;
-    original_buffer = NULL;
+    raw_delta   = NULL;
+    totalBytes  = 0;
 
     min = lmin;
     max = lmax;
@@ -354,65 +332,88 @@ FITSHistogramCommand::FITSHistogramCommand(QWidget * parent, FITSHistogram *inHi
 
 FITSHistogramCommand::~FITSHistogramCommand()
 {
-    delete(delta);
+    compression.waitForFinished();
+    delete[] raw_delta;
 }
 
-bool FITSHistogramCommand::calculateDelta(unsigned char *buffer)
+// Offsets of the blocks of a delta of size bytes
+static QVector<unsigned long> deltaBlocks(unsigned long size)
 {
-    FITSData *image_data = tab->getView()->getImageData();
+    QVector<unsigned long> blocks;
+    for (unsigned long offset=0; offset < size; offset += DELTA_BLOCK)
+        blocks.append(offset);
+    return blocks;
+}
 
-    unsigned char *image_buffer = (unsigned char *) image_data->getImageBuffer();
-    int totalPixels = image_data->getSize() * image_data->getNumOfChannels();
-    unsigned long totalBytes = totalPixels * sizeof(float);
-    //qDebug() << "raw total bytes " << totalBytes << " bytes" << endl;
+// XOR source into target, one block per thread at a time
+static void xorBlocks(uint8_t *target, const uint8_t *source, unsigned long size)
+{
+    QVector<unsigned long> blocks = deltaBlocks(size);
 
-    unsigned char *raw_delta = new unsigned char[totalBytes];
-    if (raw_delta == NULL)
+    QtConcurrent::blockingMap(blocks, [=](unsigned long offset)
     {
-        qWarning() << "Error! not enough memory to create image delta" << endl;
-        return false;
-    }
+        unsigned long end = qMin(offset + DELTA_BLOCK, size);
+        for (unsigned long i=offset; i < end; i++)
+            target[i] ^= source[i];
+    });
+}
 
-    for (unsigned int i=0; i < totalBytes; i++)
-        raw_delta[i] = buffer[i] ^ image_buffer[i];
+bool FITSHistogramCommand::calculateDelta(uint8_t *buffer)
+{
+    FITSData *image_data = tab->getView()->getImageData();
 
-    compressedBytes = sizeof(char) * totalBytes + totalBytes / 64 + 16 + 3;
-    delete(delta);
-    delta = new unsigned char[compressedBytes];
+    totalBytes = image_data->getSize() * image_data->getNumOfChannels() * image_data->getBytesPerPixel();
 
-    if (delta == NULL)
-    {
-        delete(raw_delta);
-        qDebug() << "FITSHistogram Error: Ran out of memory compressing delta" << endl;
-        return false;
-    }
+    // The copy of the image before the filter becomes the delta, so nothing else is allocated here
+    xorBlocks(buffer, image_data->getImageBuffer(), totalBytes);
+
+    delete[] raw_delta;
+    raw_delta = buffer;
+    delta.clear();
+
+    compression = QtConcurrent::run(this, &FITSHistogramCommand::compressDelta);
 
-    int r = compress2(delta, &compressedBytes, raw_delta, totalBytes, 5);
-    if (r != Z_OK)
+    return true;
+}
+
+void FITSHistogramCommand::compressDelta()
+{
+    QVector<QByteArray> blocks;
+
+    foreach (unsigned long offset, deltaBlocks(totalBytes))
     {
-        /* this should NEVER happen */
-        qDebug() << "FITSHistogram Error: Failed to compress raw_delta" << endl;
-        return false;
-    }
+        uLong size = qMin<unsigned long>(DELTA_BLOCK, totalBytes - offset);
+        uLongf compressedBytes = compressBound(size);
+        QByteArray block(compressedBytes, Qt::Uninitialized);
 
-    //qDebug() << "compressed bytes size " << compressedBytes << " bytes" << endl;
+        int r = compress2(reinterpret_cast<Bytef *>(block.data()), &compressedBytes, raw_delta + offset, size, Z_BEST_SPEED);
+        if (r != Z_OK)
+        {
+            /* this should NEVER happen. The raw delta is kept instead. */
+            qDebug() << "FITSHistogram Error: Failed to compress raw_delta" << endl;
+            return;
+        }
 
-    delete(raw_delta);
+        block.resize(compressedBytes);
+        blocks.append(block);
+    }
 
-    return true;
+    delta = blocks;
+    delete[] raw_delta;
+    raw_delta = NULL;
 }
 
 bool FITSHistogramCommand::reverseDelta()
 {
     FITSView *image = tab->getView();
     FITSData *image_data = image->getImageData();
-    unsigned char *image_buffer = (unsigned char *) (image_data->getImageBuffer());
-
-    unsigned int size = image_data->getSize();
-    int channels = image_data->getNumOfChannels();
+    unsigned char *image_buffer = image_data->getImageBuffer();
 
-    int totalPixels = size * channels;
-    unsigned long totalBytes = totalPixels * sizeof(float);
+    if (totalBytes != image_data->getSize() * image_data->getNumOfChannels() * image_data->getBytesPerPixel())
+    {
+        qWarning() << "Error! image delta does not match the image" << endl;
+        return false;
+    }
 
     unsigned char *output_image = new unsigned char[totalBytes];
     if (output_image == NULL)
@@ -421,28 +422,51 @@ bool FITSHistogramCommand::reverseDelta()
         return false;
     }
 
-    unsigned char *raw_delta = new unsigned char[totalBytes];
-    if (raw_delta == NULL)
+    if (raw_delta != NULL)
     {
-        delete(output_image);
-        qWarning() << "Error! not enough memory to create image delta" << endl;
-        return false;
+        memcpy(output_image, raw_delta, totalBytes);
+        xorBlocks(output_image, image_buffer, totalBytes);
     }
-
-    int r = uncompress(raw_delta, &totalBytes, delta, compressedBytes);
-    if (r != Z_OK)
+    else
     {
-        qDebug() << "FITSHistogram compression error in reverseDelta()" << endl;
-        delete(raw_delta);
-        return false;
-    }
+        QVector<unsigned long> blocks = deltaBlocks(totalBytes);
+        if (blocks.size() != delta.size())
+        {
+            delete[] output_image;
+            return false;
+        }
+
+        // Each block is uncompressed straight into the output image, and combined with the current image there
+        QVector<int> indexes(blocks.size());
+        for (int i=0; i < indexes.size(); i++)
+            indexes[i] = i;
+
+        QAtomicInt failures;
+        QtConcurrent::blockingMap(indexes, [&](int i)
+        {
+            unsigned long offset = blocks[i];
+            uLongf size = qMin<unsigned long>(DELTA_BLOCK, totalBytes - offset);
 
-    for (unsigned int i=0; i < totalBytes; i++)
-        output_image[i] = raw_delta[i] ^ image_buffer[i];
+            int r = uncompress(output_image + offset, &size, reinterpret_cast<const Bytef *>(delta[i].constData()), delta[i].size());
+            if (r != Z_OK)
+            {
+                failures.ref();
+                return;
+            }
 
-    image_data->setImageBuffer((float *)output_image);
+            for (unsigned long j=offset; j < offset + size; j++)
+                output_image[j] ^= image_buffer[j];
+        });
 
-    delete(raw_delta);
+        if (failures.load() > 0)
+        {
+            qDebug() << "FITSHistogram compression error in reverseDelta()" << endl;
+            delete[] output_image;
+            return false;
+        }
+    }
+
+    image_data->setImageBuffer(output_image);
 
     return true;
 }
@@ -452,13 +476,15 @@ void FITSHistogramCommand::redo()
     FITSView *image = tab->getView();
     FITSData *image_data = image->getImageData();
 
-    float *image_buffer = image_data->getImageBuffer();    
+    uint8_t *image_buffer = image_data->getImageBuffer();
     unsigned int size = image_data->getSize();
     int channels = image_data->getNumOfChannels();   
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    if (delta != NULL)
+    compression.waitForFinished();
+
+    if (raw_delta != NULL || delta.isEmpty() == false)
     {
         double min,max,stddev,average,median,snr;
         min      = image_data->getMin();
@@ -485,7 +511,8 @@ void FITSHistogramCommand::redo()
         }
         else
         {
-            float *buffer = new float[size * channels];
+            unsigned long totalBytes = size * channels * image_data->getBytesPerPixel();
+            uint8_t *buffer = new uint8_t[totalBytes];
             if (buffer == NULL)
             {
                 qWarning() << "Error! not enough memory to create image buffer in redo()" << endl;
@@ -493,7 +520,7 @@ void FITSHistogramCommand::redo()
                 return;
             }
 
-            memcpy(buffer, image_buffer, size * channels * sizeof(float));
+            memcpy(buffer, image_buffer, totalBytes);
 
             switch (type)
             {
@@ -515,8 +542,8 @@ void FITSHistogramCommand::redo()
                break;
             }
 
-            calculateDelta( (unsigned char *) buffer);
-            delete (buffer);
+            // The command keeps the buffer as the delta
+            calculateDelta(buffer);
         }
     }
 
@@ -542,7 +569,9 @@ void FITSHistogramCommand::undo()
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
-    if (delta != NULL)
+    compression.waitForFinished();
+
+    if (raw_delta != NULL || delta.isEmpty() == false)
     {
        double min,max,stddev,average,median,snr;
        min      = image_data->getMin();
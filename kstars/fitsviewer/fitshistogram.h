@@ -15,6 +15,7 @@
 #include "fitscommon.h"
 
 #include <QUndoCommand>
+#include <QFuture>
 #include <QPixmap>
 #include <QMouseEvent>
 #include <QPaintEvent>
@@ -122,7 +123,8 @@ private:
         long dim[2];
     } stats;
 
-    bool calculateDelta(unsigned char *buffer);
+    bool calculateDelta(uint8_t *buffer);
+    void compressDelta();
     bool reverseDelta();
     void saveStats(double min, double max, double stddev, double mean, double median, double SNR);
     void restoreStats();
@@ -132,9 +134,12 @@ private:
     double min, max;
     int gamma;
 
-    unsigned char *delta;
-    unsigned long compressedBytes;
-    float *original_buffer;
+    /* The image before the filter is kept as the XOR with the image after it, in blocks that are compressed in the
+       background. The uncompressed XOR is kept until then, or if compression fails. */
+    QVector<QByteArray> delta;
+    uint8_t *raw_delta;
+    unsigned long totalBytes;
+    QFuture<void> compression;
     FITSTab *tab;
 };
 
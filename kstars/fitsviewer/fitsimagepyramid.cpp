@@ -0,0 +1,422 @@
+/***************************************************************************
+                          fitsimagepyramid.cpp  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fitsimagepyramid.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <QPainter>
+#include <QtConcurrent>
+
+#include <fitsio.h>
+
+// Side of the tiles that are converted at once
+#define PYRAMID_TILE    256
+
+namespace
+{
+
+struct Stretch
+{
+    double min, max;
+    double scale, offset;
+    const uint8_t *lut;
+};
+
+// Map a pixel linearly from min..max to 0..255
+template<typename T> inline uint8_t displayValue(T value, const Stretch &s)
+{
+    double v = qBound(s.min, static_cast<double>(value), s.max);
+    return static_cast<uint8_t>(v * s.scale + s.offset);
+}
+
+template<> inline uint8_t displayValue(uint8_t value, const Stretch &s) { return s.lut[value]; }
+template<> inline uint8_t displayValue(uint16_t value, const Stretch &s) { return s.lut[value]; }
+
+template<typename T> void convertTile(const T *buffer, int width, int height, int channels, uchar *bits, int bytesPerLine,
+                                      const QRect &tile, const Stretch &s)
+{
+    const long size = static_cast<long>(width) * height;
+
+    for (int y=tile.top(); y <= tile.bottom(); y++)
+    {
+        const T *row = buffer + static_cast<long>(y) * width;
+        uchar *line  = bits + static_cast<long>(y) * bytesPerLine;
+
+        if (s.max <= s.min)
+        {
+            // Saturated, everything is white
+            if (channels == 1)
+                memset(line + tile.left(), 255, tile.width());
+            else
+                std::fill_n(reinterpret_cast<QRgb*>(line) + tile.left(), tile.width(), qRgb(255, 255, 255));
+        }
+        else if (channels == 1)
+        {
+            for (int x=tile.left(); x <= tile.right(); x++)
+                line[x] = displayValue(row[x], s);
+        }
+        else
+        {
+            QRgb *scanLine = reinterpret_cast<QRgb*>(line);
+            for (int x=tile.left(); x <= tile.right(); x++)
+                scanLine[x] = qRgb(displayValue(row[x], s), displayValue(row[x + size], s), displayValue(row[x + size * 2], s));
+        }
+    }
+}
+
+template<typename T> void convertTiles(QVector<QRect> &tiles, const uint8_t *buffer, int channels, QImage &image, const Stretch &s)
+{
+    const T *pixels = reinterpret_cast<const T *>(buffer);
+    const int width = image.width(), height = image.height();
+    // Taken once, as bits() may detach the image and must not be called from several threads
+    uchar *bits = image.bits();
+    const int bytesPerLine = image.bytesPerLine();
+
+    QtConcurrent::blockingMap(tiles, [=, &s](const QRect &tile)
+    {
+        convertTile(pixels, width, height, channels, bits, bytesPerLine, tile, s);
+    });
+}
+
+// Average each 2x2 block of source into a pixel of the tile. The last row and column of an odd source are repeated.
+void averageTile(const uchar *source, int sourceBytesPerLine, int sourceWidth, int sourceHeight, uchar *bits, int bytesPerLine,
+                 bool color, const QRect &tile)
+{
+    for (int y=tile.top(); y <= tile.bottom(); y++)
+    {
+        const uchar *top    = source + static_cast<long>(2*y) * sourceBytesPerLine;
+        const uchar *bottom = source + static_cast<long>(qMin(2*y + 1, sourceHeight - 1)) * sourceBytesPerLine;
+        uchar *line = bits + static_cast<long>(y) * bytesPerLine;
+
+        for (int x=tile.left(); x <= tile.right(); x++)
+        {
+            const int x0 = 2*x, x1 = qMin(2*x + 1, sourceWidth - 1);
+
+            if (color)
+            {
+                const QRgb *t = reinterpret_cast<const QRgb*>(top), *b = reinterpret_cast<const QRgb*>(bottom);
+                reinterpret_cast<QRgb*>(line)[x] =
+                        qRgb((qRed(t[x0]) + qRed(t[x1]) + qRed(b[x0]) + qRed(b[x1]) + 2) / 4,
+                             (qGreen(t[x0]) + qGreen(t[x1]) + qGreen(b[x0]) + qGreen(b[x1]) + 2) / 4,
+                             (qBlue(t[x0]) + qBlue(t[x1]) + qBlue(b[x0]) + qBlue(b[x1]) + 2) / 4);
+            }
+            else
+                line[x] = (top[x0] + top[x1] + bottom[x0] + bottom[x1] + 2) / 4;
+        }
+    }
+}
+
+// Average each step x step block of the source pixels into a pixel of the preview, then map it for display
+template<typename T> void previewRows(const T *buffer, int width, int height, int channels, int step, QImage &image,
+                                       const Stretch &s)
+{
+    const long size = static_cast<long>(width) * height;
+    uchar *bits = image.bits();
+    const int bytesPerLine = image.bytesPerLine(), previewWidth = image.width();
+
+    QVector<int> rows(image.height());
+    for (int i=0; i < rows.size(); i++)
+        rows[i] = i;
+
+    QtConcurrent::blockingMap(rows, [=, &s](int py)
+    {
+        uchar *line = bits + static_cast<long>(py) * bytesPerLine;
+        const int y0 = py * step, y1 = qMin(y0 + step, height);
+
+        for (int px=0; px < previewWidth; px++)
+        {
+            const int x0 = px * step, x1 = qMin(x0 + step, width);
+            double sum[3] = { 0, 0, 0 };
+
+            for (int c=0; c < channels; c++)
+                for (int y=y0; y < y1; y++)
+                {
+                    const T *row = buffer + c * size + static_cast<long>(y) * width;
+                    for (int x=x0; x < x1; x++)
+                        sum[c] += row[x];
+                }
+
+            const double n = (y1 - y0) * (x1 - x0);
+            if (s.max <= s.min)
+                sum[0] = sum[1] = sum[2] = 255;
+            else
+            {
+                for (int c=0; c < channels; c++)
+                    sum[c] = qBound(s.min, sum[c] / n, s.max) * s.scale + s.offset;
+            }
+
+            if (channels == 1)
+                line[px] = static_cast<uchar>(sum[0]);
+            else
+                reinterpret_cast<QRgb*>(line)[px] = qRgb(sum[0], sum[1], sum[2]);
+        }
+    });
+}
+
+}
+
+FITSImagePyramid::FITSImagePyramid()
+{
+    buffer   = NULL;
+    dataType = TBYTE;
+    channels = 1;
+    min = max = 0;
+}
+
+void FITSImagePyramid::setSource(const uint8_t *buffer, int dataType, int width, int height, int channels, double min, double max)
+{
+    this->buffer   = buffer;
+    this->dataType = dataType;
+    this->min      = min;
+    this->max      = max;
+    previewImage   = QImage();
+
+    if (levels.isEmpty() || levels[0].image.width() != width || levels[0].image.height() != height || this->channels != channels)
+    {
+        this->channels = channels;
+        levels.clear();
+
+        addLevel(width, height);
+        // Halve the image until it fits in a tile
+        while (width > PYRAMID_TILE || height > PYRAMID_TILE)
+        {
+            width  = (width + 1) / 2;
+            height = (height + 1) / 2;
+            addLevel(width, height);
+        }
+    }
+    else
+    {
+        for (int i=0; i < levels.size(); i++)
+            levels[i].ready.fill(false);
+    }
+
+    lut.clear();
+    if ((dataType == TBYTE || dataType == TUSHORT) && max > min)
+    {
+        lut.resize(dataType == TBYTE ? 256 : 65536);
+
+        double bscale = 255. / (max - min);
+        double bzero  = (-min) * (255. / (max - min));
+        for (int i=0; i < lut.size(); i++)
+            lut[i] = static_cast<uint8_t>(qBound(min, static_cast<double>(i), max) * bscale + bzero);
+    }
+}
+
+void FITSImagePyramid::clear()
+{
+    levels.clear();
+    previewImage = QImage();
+    buffer = NULL;
+}
+
+void FITSImagePyramid::addLevel(int width, int height)
+{
+    Level level;
+
+    if (channels == 1)
+    {
+        level.image = QImage(width, height, QImage::Format_Indexed8);
+
+        level.image.setColorCount(256);
+        for (int i=0; i < 256; i++)
+            level.image.setColor(i, qRgb(i,i,i));
+    }
+    else
+        level.image = QImage(width, height, QImage::Format_RGB32);
+
+    level.tilesX = (width + PYRAMID_TILE - 1) / PYRAMID_TILE;
+    level.tilesY = (height + PYRAMID_TILE - 1) / PYRAMID_TILE;
+    level.ready.fill(false, level.tilesX * level.tilesY);
+
+    levels.append(level);
+}
+
+void FITSImagePyramid::prepare(int level, const QRect &rect)
+{
+    Level &current = levels[level];
+    QRect area = rect.intersected(current.image.rect());
+
+    if (area.isEmpty())
+        return;
+
+    QVector<QRect> tiles;
+    for (int ty = area.top() / PYRAMID_TILE; ty <= area.bottom() / PYRAMID_TILE; ty++)
+    {
+        for (int tx = area.left() / PYRAMID_TILE; tx <= area.right() / PYRAMID_TILE; tx++)
+        {
+            bool &ready = current.ready[ty * current.tilesX + tx];
+            if (ready == false)
+            {
+                tiles.append(QRect(tx * PYRAMID_TILE, ty * PYRAMID_TILE, PYRAMID_TILE, PYRAMID_TILE).intersected(current.image.rect()));
+                ready = true;
+            }
+        }
+    }
+
+    if (tiles.isEmpty())
+        return;
+
+    if (level == 0)
+    {
+        Stretch s;
+        s.min    = min;
+        s.max    = max;
+        s.scale  = 255. / (max - min);
+        s.offset = (-min) * (255. / (max - min));
+        s.lut    = lut.constData();
+
+        switch (dataType)
+        {
+        case TBYTE:
+            convertTiles<uint8_t>(tiles, buffer, channels, current.image, s);
+            break;
+        case TUSHORT:
+            convertTiles<uint16_t>(tiles, buffer, channels, current.image, s);
+            break;
+        case TSHORT:
+            convertTiles<int16_t>(tiles, buffer, channels, current.image, s);
+            break;
+        case TINT:
+            convertTiles<int32_t>(tiles, buffer, channels, current.image, s);
+            break;
+        case TFLOAT:
+            convertTiles<float>(tiles, buffer, channels, current.image, s);
+            break;
+        case TDOUBLE:
+            convertTiles<double>(tiles, buffer, channels, current.image, s);
+            break;
+        }
+
+        return;
+    }
+
+    // The part of the level above that the tiles are averaged from
+    QRect source;
+    foreach (const QRect &tile, tiles)
+        source |= QRect(tile.x() * 2, tile.y() * 2, tile.width() * 2, tile.height() * 2);
+    prepare(level - 1, source);
+
+    const QImage &above = levels[level - 1].image;
+    const uchar *sourceBits = above.constBits();
+    const int sourceBytesPerLine = above.bytesPerLine(), sourceWidth = above.width(), sourceHeight = above.height();
+    uchar *bits = current.image.bits();
+    const int bytesPerLine = current.image.bytesPerLine();
+    const bool color = channels != 1;
+
+    QtConcurrent::blockingMap(tiles, [=](const QRect &tile)
+    {
+        averageTile(sourceBits, sourceBytesPerLine, sourceWidth, sourceHeight, bits, bytesPerLine, color, tile);
+    });
+}
+
+QImage * FITSImagePyramid::image()
+{
+    if (levels.isEmpty())
+        return NULL;
+
+    prepare(0, levels[0].image.rect());
+    return &levels[0].image;
+}
+
+QImage * FITSImagePyramid::preview(int maxSize)
+{
+    if (levels.isEmpty() || buffer == NULL)
+        return NULL;
+
+    const int width = levels[0].image.width(), height = levels[0].image.height();
+    const int step  = qMax(1, (qMax(width, height) + maxSize - 1) / maxSize);
+    const int previewWidth = (width + step - 1) / step, previewHeight = (height + step - 1) / step;
+
+    if (previewImage.isNull() == false && previewImage.width() == previewWidth && previewImage.height() == previewHeight)
+        return &previewImage;
+
+    // The full image is smaller, or already converted anyway
+    if (step == 1)
+        return image();
+
+    if (channels == 1)
+    {
+        previewImage = QImage(previewWidth, previewHeight, QImage::Format_Indexed8);
+        previewImage.setColorCount(256);
+        for (int i=0; i < 256; i++)
+            previewImage.setColor(i, qRgb(i,i,i));
+    }
+    else
+        previewImage = QImage(previewWidth, previewHeight, QImage::Format_RGB32);
+
+    Stretch s;
+    s.min    = min;
+    s.max    = max;
+    s.scale  = 255. / (max - min);
+    s.offset = (-min) * (255. / (max - min));
+    s.lut    = lut.constData();
+
+    switch (dataType)
+    {
+    case TBYTE:
+        previewRows(buffer, width, height, channels, step, previewImage, s);
+        break;
+    case TUSHORT:
+        previewRows(reinterpret_cast<const uint16_t *>(buffer), width, height, channels, step, previewImage, s);
+        break;
+    case TSHORT:
+        previewRows(reinterpret_cast<const int16_t *>(buffer), width, height, channels, step, previewImage, s);
+        break;
+    case TINT:
+        previewRows(reinterpret_cast<const int32_t *>(buffer), width, height, channels, step, previewImage, s);
+        break;
+    case TFLOAT:
+        previewRows(reinterpret_cast<const float *>(buffer), width, height, channels, step, previewImage, s);
+        break;
+    case TDOUBLE:
+        previewRows(reinterpret_cast<const double *>(buffer), width, height, channels, step, previewImage, s);
+        break;
+    }
+
+    return &previewImage;
+}
+
+void FITSImagePyramid::draw(QPainter *painter, const QRect &exposed, double zoom)
+{
+    if (levels.isEmpty() || zoom <= 0)
+        return;
+
+    // The smallest level that is still at least as large as it is shown
+    int level = 0;
+    while (level + 1 < levels.size() && zoom * (2 << level) <= 1)
+        level++;
+
+    const double scale = zoom * (1 << level);
+
+    // One more pixel around, for the smooth transformation to blend with
+    QRect source = QRectF(exposed.x() / scale, exposed.y() / scale, exposed.width() / scale, exposed.height() / scale).toAlignedRect();
+    source = source.adjusted(-1, -1, 1, 1).intersected(levels[level].image.rect());
+    if (source.isEmpty())
+        return;
+
+    prepare(level, source);
+
+    // Only the visible part is handed to the painter, so that it never converts or scales the whole level
+    QImage visible = levels[level].image.copy(source);
+    QRectF target(source.x() * scale, source.y() * scale, source.width() * scale, source.height() * scale);
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, scale != 1);
+    painter->drawImage(target, visible);
+}
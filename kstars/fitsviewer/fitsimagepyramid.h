@@ -0,0 +1,101 @@
+/***************************************************************************
+                          fitsimagepyramid.h  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FITSIMAGEPYRAMID_H_
+#define FITSIMAGEPYRAMID_H_
+
+#include <stdint.h>
+
+#include <QImage>
+#include <QRect>
+#include <QVector>
+
+class QPainter;
+
+/**
+ * @class FITSImagePyramid
+ * @short The 8 bit image of a FITS frame that is displayed, converted only where it is shown.
+ *
+ * The image is divided in tiles of 256x256 pixels. A tile is converted from
+ * the FITS pixels the first time it is drawn, in a single pass that maps each
+ * pixel linearly from min..max to 0..255. 8 and 16 bit pixels go through a
+ * lookup table. The tiles that are exposed together are converted in parallel.
+ *
+ * For zoom levels below 100% the image is drawn from a pyramid of levels, each
+ * half the size of the previous one. A level is averaged from the tiles of the
+ * level above it, again only for the tiles that are shown, so that zooming out
+ * of a large frame never scales the full image down.
+ */
+class FITSImagePyramid
+{
+public:
+    FITSImagePyramid();
+
+    /**
+     * @short Set the pixels to display. Nothing is converted until it is drawn.
+     * @param buffer the pixels of the image, one channel after the other. It must remain valid until the next call.
+     * @param dataType the FITS data type of the pixels, TBYTE, TUSHORT, TSHORT, TINT, TFLOAT or TDOUBLE
+     * @param width the width of the image
+     * @param height the height of the image
+     * @param channels 1 for a grayscale image, or 3 for a colour one
+     * @param min pixel value shown as black
+     * @param max pixel value shown as white. If it is not above min, the image is white.
+     */
+    void setSource(const uint8_t *buffer, int dataType, int width, int height, int channels, double min, double max);
+
+    /* Forget the pixels, for instance when the image is unloaded */
+    void clear();
+
+    /* The full resolution image, with every tile converted */
+    QImage *image();
+
+    /* A small copy of the image, no larger than maxSize on either side, averaged straight from the pixels.
+       Nothing is converted at full resolution for it. */
+    QImage *preview(int maxSize);
+
+    /**
+     * @short Draw part of the image.
+     * @param painter painter of the widget that shows the image
+     * @param exposed the part of the widget to draw
+     * @param zoom scale of the image in the widget, 1 being 100%
+     */
+    void draw(QPainter *painter, const QRect &exposed, double zoom);
+
+    bool isNull() const { return levels.isEmpty(); }
+
+private:
+    struct Level
+    {
+        QImage image;
+        QVector<bool> ready;    // Tiles that are converted
+        int tilesX, tilesY;
+    };
+
+    void addLevel(int width, int height);
+    void prepare(int level, const QRect &rect);
+
+    QVector<Level> levels;
+    QImage previewImage;        // Cached result of preview()
+
+    const uint8_t *buffer;
+    int dataType;
+    int channels;
+    double min, max;
+    QVector<uint8_t> lut;       // Display values of 8 and 16 bit pixels
+};
+
+#endif
@@ -113,7 +113,7 @@ void FITSOverlay::openImage()
 
     QImage image(image_width, image_height, QImage::Format_Indexed8);
 
-    image_buffer = newFO->image_data->getImageBuffer();
+    image_buffer = newFO->image_data->getFloatBuffer();
 
     bscale = 255. / (max - min);
     bzero  = (-min) * (255. / (max - min));
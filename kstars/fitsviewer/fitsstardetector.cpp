@@ -0,0 +1,554 @@
+/***************************************************************************
+                          fitsstardetector.cpp  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fitsstardetector.h"
+#include "fitsdata.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+// Side of the tiles of the background model, and the spacing of the pixels sampled in each
+#define DETECT_TILE         64
+#define DETECT_TILE_STEP    2
+// Smallest band of rows worth a thread of its own
+#define DETECT_MIN_BAND     64
+// Stars larger than this fraction of the searched area are nebulae or gradients
+#define DETECT_MAX_FRACTION 4
+
+namespace
+{
+
+struct Tile
+{
+    QRect rect;
+    double background;
+    double noise;
+};
+
+struct BackgroundModel
+{
+    QRect area;
+    int cols;
+    QVector<double> background;
+    QVector<double> threshold;
+
+    inline int tileOf(int x, int y) const
+    {
+        return ((y - area.y()) / DETECT_TILE) * cols + (x - area.x()) / DETECT_TILE;
+    }
+};
+
+// A horizontal run of pixels above the threshold
+struct Run
+{
+    int y, x0, x1;
+    int label;
+};
+
+struct Blob
+{
+    double flux;
+    double sumX, sumY;
+    int pixels;
+    int left, top, right, bottom;
+};
+
+struct Band
+{
+    int top, bottom;
+    QVector<Run> runs;
+    int firstRowEnd;        // Runs before this one are on the top row
+    int lastRowBegin;       // Runs from this one on are on the bottom row
+    QVector<Blob> blobs;
+};
+
+struct Star
+{
+    double x, y;            // Centroid, in pixels from the image origin
+    double flux;
+    double width;
+    double background;
+    float HFR;
+};
+
+inline int findRoot(QVector<int> &parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+inline void unite(QVector<int> &parent, int a, int b)
+{
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a != b)
+        parent[qMax(a, b)] = qMin(a, b);
+}
+
+// Joins the runs of one row with the 8-connected runs of the row above. Both lists are ordered by x.
+template<typename F> void joinRows(const QVector<Run> &above, int aboveBegin, int aboveEnd,
+                                   const QVector<Run> &below, int belowBegin, int belowEnd, F join)
+{
+    int first = aboveBegin;
+    for (int r=belowBegin; r < belowEnd; r++)
+    {
+        while (first < aboveEnd && above[first].x1 < below[r].x0 - 1)
+            first++;
+
+        for (int q=first; q < aboveEnd && above[q].x0 <= below[r].x1 + 1; q++)
+            join(q, r);
+    }
+}
+
+void mergeBlob(Blob &into, const Blob &blob)
+{
+    into.flux   += blob.flux;
+    into.sumX   += blob.sumX;
+    into.sumY   += blob.sumY;
+    into.pixels += blob.pixels;
+    into.left    = qMin(into.left, blob.left);
+    into.top     = qMin(into.top, blob.top);
+    into.right   = qMax(into.right, blob.right);
+    into.bottom  = qMax(into.bottom, blob.bottom);
+}
+
+template<typename T> void estimateTile(const T *buffer, int width, Tile &tile)
+{
+    QVector<double> samples;
+    samples.reserve((tile.rect.width() / DETECT_TILE_STEP + 1) * (tile.rect.height() / DETECT_TILE_STEP + 1));
+
+    for (int y=tile.rect.top(); y <= tile.rect.bottom(); y += DETECT_TILE_STEP)
+    {
+        const T *row = buffer + static_cast<long>(y) * width;
+        for (int x=tile.rect.left(); x <= tile.rect.right(); x += DETECT_TILE_STEP)
+        {
+            double value = row[x];
+            // Leave out NaN
+            if (value == value)
+                samples.append(value);
+        }
+    }
+
+    tile.background = tile.noise = 0;
+    if (samples.isEmpty())
+        return;
+
+    QVector<double>::iterator middle = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), middle, samples.end());
+    tile.background = *middle;
+
+    // Median absolute deviation, scaled to the standard deviation of gaussian noise
+    QVector<double> deviations(samples.size());
+    for (int i=0; i < samples.size(); i++)
+        deviations[i] = fabs(samples[i] - tile.background);
+    middle = deviations.begin() + deviations.size() / 2;
+    std::nth_element(deviations.begin(), middle, deviations.end());
+    tile.noise = 1.4826 * *middle;
+
+    // Noise below the quantization of the image leaves the deviation at zero
+    if (tile.noise == 0)
+    {
+        double sum=0;
+        foreach (double value, samples)
+            sum += (value - tile.background) * (value - tile.background);
+        tile.noise = sqrt(sum / samples.size());
+    }
+}
+
+// Replaces each tile by the median of it and its neighbours, so tiles covered by a bright star do not stand out
+void smoothTiles(QVector<double> &values, int cols, int rows)
+{
+    QVector<double> smoothed(values.size());
+    double window[9];
+
+    for (int ty=0; ty < rows; ty++)
+    {
+        for (int tx=0; tx < cols; tx++)
+        {
+            int count=0;
+            for (int j=qMax(0, ty-1); j <= qMin(rows-1, ty+1); j++)
+                for (int i=qMax(0, tx-1); i <= qMin(cols-1, tx+1); i++)
+                    window[count++] = values[j * cols + i];
+
+            std::nth_element(window, window + count / 2, window + count);
+            smoothed[ty * cols + tx] = window[count / 2];
+        }
+    }
+
+    values = smoothed;
+}
+
+template<typename T> BackgroundModel buildBackground(const T *buffer, int width, const QRect &area, double sigma)
+{
+    BackgroundModel model;
+    model.area = area;
+    model.cols = (area.width() + DETECT_TILE - 1) / DETECT_TILE;
+    int rows   = (area.height() + DETECT_TILE - 1) / DETECT_TILE;
+
+    QVector<Tile> tiles;
+    for (int ty=0; ty < rows; ty++)
+    {
+        for (int tx=0; tx < model.cols; tx++)
+        {
+            Tile tile;
+            tile.rect = QRect(area.x() + tx * DETECT_TILE, area.y() + ty * DETECT_TILE, DETECT_TILE, DETECT_TILE).intersected(area);
+            tiles.append(tile);
+        }
+    }
+
+    QtConcurrent::blockingMap(tiles, [buffer, width](Tile &tile) { estimateTile(buffer, width, tile); });
+
+    QVector<double> noise(tiles.size());
+    model.background.resize(tiles.size());
+    for (int i=0; i < tiles.size(); i++)
+    {
+        model.background[i] = tiles[i].background;
+        noise[i] = tiles[i].noise;
+    }
+
+    smoothTiles(model.background, model.cols, rows);
+    smoothTiles(noise, model.cols, rows);
+
+    model.threshold.resize(tiles.size());
+    for (int i=0; i < tiles.size(); i++)
+        model.threshold[i] = model.background[i] + sigma * noise[i];
+
+    return model;
+}
+
+template<typename T> void labelBand(const T *buffer, int width, const BackgroundModel &model, Band &band)
+{
+    const QRect &area = model.area;
+    QVector<int> parent;
+    int previousBegin=0, previousEnd=0;
+
+    band.firstRowEnd = band.lastRowBegin = 0;
+
+    for (int y=band.top; y < band.bottom; y++)
+    {
+        const T *row = buffer + static_cast<long>(y) * width;
+        const double *threshold = model.threshold.constData() + model.tileOf(area.x(), y);
+        int rowBegin = band.runs.size();
+
+        for (int x=area.left(); x <= area.right(); x++)
+        {
+            if (row[x] > threshold[(x - area.x()) / DETECT_TILE])
+            {
+                Run run;
+                run.y  = y;
+                run.x0 = x;
+                while (x < area.right() && row[x+1] > threshold[(x + 1 - area.x()) / DETECT_TILE])
+                    x++;
+                run.x1 = x;
+                run.label = band.runs.size();
+
+                parent.append(run.label);
+                band.runs.append(run);
+            }
+        }
+
+        joinRows(band.runs, previousBegin, previousEnd, band.runs, rowBegin, band.runs.size(),
+                 [&parent](int above, int below) { unite(parent, above, below); });
+
+        if (y == band.top)
+            band.firstRowEnd = band.runs.size();
+        band.lastRowBegin = rowBegin;
+
+        previousBegin = rowBegin;
+        previousEnd   = band.runs.size();
+    }
+
+    // Gather the pixels of each connected group of runs
+    QVector<int> blobOf(band.runs.size(), -1);
+    for (int r=0; r < band.runs.size(); r++)
+    {
+        Run &run = band.runs[r];
+        int root = findRoot(parent, r);
+
+        if (blobOf[root] < 0)
+        {
+            Blob blob;
+            blob.flux = blob.sumX = blob.sumY = 0;
+            blob.pixels = 0;
+            blob.left   = run.x0;
+            blob.right  = run.x1;
+            blob.top    = blob.bottom = run.y;
+            blobOf[root] = band.blobs.size();
+            band.blobs.append(blob);
+        }
+
+        run.label = blobOf[root];
+        Blob &blob = band.blobs[run.label];
+
+        const T *row = buffer + static_cast<long>(run.y) * width;
+        const double background = model.background[model.tileOf(run.x0, run.y)];
+        for (int x=run.x0; x <= run.x1; x++)
+        {
+            double value = row[x] - background;
+            blob.flux += value;
+            blob.sumX += value * x;
+            blob.sumY += value * run.y;
+        }
+
+        blob.pixels += run.x1 - run.x0 + 1;
+        blob.left    = qMin(blob.left, run.x0);
+        blob.right   = qMax(blob.right, run.x1);
+        blob.top     = qMin(blob.top, run.y);
+        blob.bottom  = qMax(blob.bottom, run.y);
+    }
+}
+
+struct RadialSample
+{
+    double r;
+    double flux;
+
+    bool operator<(const RadialSample &other) const { return r < other.r; }
+};
+
+// Radius of the circle around the centroid that holds half of the flux of the star. The pixels
+// are accumulated outwards by distance, and the radius is interpolated between the two pixels
+// where the cumulative flux crosses the half.
+template<typename T> void measureHFR(const T *buffer, int width, const QRect &area, Star &star)
+{
+    const double radius = star.width;
+    const int size = 2 * radius + 2;
+    QRect box = QRect(static_cast<int>(floor(star.x - radius)), static_cast<int>(floor(star.y - radius)), size, size).intersected(area);
+
+    QVector<RadialSample> samples;
+    samples.reserve(box.width() * box.height());
+
+    double flux=0;
+    for (int y=box.top(); y <= box.bottom(); y++)
+    {
+        const T *row = buffer + static_cast<long>(y) * width;
+        const double dy = y - star.y;
+
+        for (int x=box.left(); x <= box.right(); x++)
+        {
+            double value = row[x] - star.background;
+            if (!(value > 0))
+                continue;
+
+            const double dx = x - star.x;
+            RadialSample sample;
+            sample.r = sqrt(dx * dx + dy * dy);
+            if (sample.r > radius)
+                continue;
+
+            sample.flux = value;
+            samples.append(sample);
+            flux += value;
+        }
+    }
+
+    star.HFR = 0;
+    if (!(flux > 0))
+        return;
+
+    std::sort(samples.begin(), samples.end());
+
+    const double halfFlux = flux / 2;
+    double cumulative=0, lastRadius=0;
+    foreach (const RadialSample &sample, samples)
+    {
+        if (cumulative + sample.flux >= halfFlux)
+        {
+            star.HFR = lastRadius + (sample.r - lastRadius) * (halfFlux - cumulative) / sample.flux;
+            return;
+        }
+
+        cumulative += sample.flux;
+        lastRadius  = sample.r;
+    }
+}
+
+bool brighterThan(const Star &s1, const Star &s2)
+{
+    return s1.flux > s2.flux;
+}
+
+}
+
+template<typename T> QList<Edge*> FITSStarDetector::findStars(const T *buffer, int width, int height, const QRect &searchArea, double sigma, int minWidth)
+{
+    QList<Edge*> edges;
+
+    QRect area = searchArea.intersected(QRect(0, 0, width, height));
+    if (buffer == NULL || area.isEmpty())
+        return edges;
+
+    BackgroundModel model = buildBackground(buffer, width, area, sigma);
+
+    int nBands = qMax(1, qMin(QThread::idealThreadCount(), area.height() / DETECT_MIN_BAND));
+    int bandRows = (area.height() + nBands - 1) / nBands;
+
+    QVector<Band> bands;
+    for (int top=area.top(); top <= area.bottom(); top += bandRows)
+    {
+        Band band;
+        band.top    = top;
+        band.bottom = qMin(top + bandRows, area.bottom() + 1);
+        bands.append(band);
+    }
+
+    QtConcurrent::blockingMap(bands, [buffer, width, &model](Band &band) { labelBand(buffer, width, model, band); });
+
+    // Join the stars that continue from the bottom row of one band into the top row of the next
+    QVector<int> offsets(bands.size(), 0);
+    int totalBlobs=0;
+    for (int b=0; b < bands.size(); b++)
+    {
+        offsets[b] = totalBlobs;
+        totalBlobs += bands[b].blobs.size();
+    }
+
+    QVector<int> parent(totalBlobs);
+    for (int i=0; i < totalBlobs; i++)
+        parent[i] = i;
+
+    for (int b=1; b < bands.size(); b++)
+    {
+        const Band &above = bands[b-1];
+        const Band &below = bands[b];
+        joinRows(above.runs, above.lastRowBegin, above.runs.size(), below.runs, 0, below.firstRowEnd,
+                 [&](int a, int r) { unite(parent, offsets[b-1] + above.runs[a].label, offsets[b] + below.runs[r].label); });
+    }
+
+    QVector<Blob> blobs(totalBlobs);
+    QVector<bool> isRoot(totalBlobs, false);
+    for (int b=0; b < bands.size(); b++)
+    {
+        for (int i=0; i < bands[b].blobs.size(); i++)
+        {
+            int index = offsets[b] + i;
+            int root  = findRoot(parent, index);
+            if (root == index)
+            {
+                blobs[root]  = bands[b].blobs[i];
+                isRoot[root] = true;
+            }
+            else
+                mergeBlob(blobs[root], bands[b].blobs[i]);
+        }
+    }
+
+    // Leave out hot pixels, bad columns and anything too large to be a star
+    QVector<Star> stars;
+    double maxWidth=1;
+    for (int i=0; i < totalBlobs; i++)
+    {
+        if (isRoot[i] == false)
+            continue;
+
+        const Blob &blob = blobs[i];
+        int blobWidth  = blob.right - blob.left + 1;
+        int blobHeight = blob.bottom - blob.top + 1;
+
+        if (qMax(blobWidth, blobHeight) < minWidth || qMin(blobWidth, blobHeight) < 2)
+            continue;
+        if (blobWidth > area.width() / DETECT_MAX_FRACTION || blobHeight > area.height() / DETECT_MAX_FRACTION)
+            continue;
+        if (blob.flux <= 0)
+            continue;
+
+        Star star;
+        star.x     = blob.sumX / blob.flux;
+        star.y     = blob.sumY / blob.flux;
+        star.flux  = blob.flux;
+        star.width = qMax(blobWidth, blobHeight);
+        star.background = model.background[model.tileOf(qBound(area.left(), static_cast<int>(star.x), area.right()),
+                                                        qBound(area.top(), static_cast<int>(star.y), area.bottom()))];
+        star.HFR   = 0;
+
+        maxWidth = qMax(maxWidth, star.width);
+        stars.append(star);
+    }
+
+    // Merge overlapping stars into the brightest. Overlapping stars are at most maxWidth apart, so they are in neighbouring cells.
+    std::sort(stars.begin(), stars.end(), brighterThan);
+
+    int gridCols = area.width() / maxWidth + 1;
+    int gridRows = area.height() / maxWidth + 1;
+    QVector< QVector<int> > grid(gridCols * gridRows);
+    QVector<Star> accepted;
+
+    foreach (const Star &star, stars)
+    {
+        int cx = (star.x - area.x()) / maxWidth;
+        int cy = (star.y - area.y()) / maxWidth;
+        bool overlaps=false;
+
+        for (int j=qMax(0, cy-1); j <= qMin(gridRows-1, cy+1) && overlaps == false; j++)
+        {
+            for (int i=qMax(0, cx-1); i <= qMin(gridCols-1, cx+1) && overlaps == false; i++)
+            {
+                foreach (int k, grid[j * gridCols + i])
+                {
+                    double dx = star.x - accepted[k].x;
+                    double dy = star.y - accepted[k].y;
+                    if (sqrt(dx * dx + dy * dy) <= (star.width + accepted[k].width) / 2)
+                    {
+                        overlaps = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (overlaps)
+            continue;
+
+        grid[qBound(0, cy, gridRows-1) * gridCols + qBound(0, cx, gridCols-1)].append(accepted.size());
+        accepted.append(star);
+    }
+
+    QtConcurrent::blockingMap(accepted, [buffer, width, &area](Star &star) { measureHFR(buffer, width, area, star); });
+
+    foreach (const Star &star, accepted)
+    {
+        Edge *center = new Edge();
+
+        // Edges are centered on pixels
+        center->x       = star.x + 0.5;
+        center->y       = star.y + 0.5;
+        center->val     = star.flux;
+        center->sum     = star.flux;
+        center->width   = star.width;
+        center->HFR     = star.HFR;
+        center->scanned = 0;
+
+        edges.append(center);
+    }
+
+    return edges;
+}
+
+template QList<Edge*> FITSStarDetector::findStars<uint8_t>(const uint8_t *, int, int, const QRect &, double, int);
+template QList<Edge*> FITSStarDetector::findStars<uint16_t>(const uint16_t *, int, int, const QRect &, double, int);
+template QList<Edge*> FITSStarDetector::findStars<int16_t>(const int16_t *, int, int, const QRect &, double, int);
+template QList<Edge*> FITSStarDetector::findStars<int32_t>(const int32_t *, int, int, const QRect &, double, int);
+template QList<Edge*> FITSStarDetector::findStars<float>(const float *, int, int, const QRect &, double, int);
+template QList<Edge*> FITSStarDetector::findStars<double>(const double *, int, int, const QRect &, double, int);
@@ -0,0 +1,57 @@
+/***************************************************************************
+                          fitsstardetector.h  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FITSSTARDETECTOR_H_
+#define FITSSTARDETECTOR_H_
+
+#include <QList>
+#include <QRect>
+
+class Edge;
+
+/**
+ * @class FITSStarDetector
+ * @short Finds the stars of an image in a single pass.
+ *
+ * The sky background and its noise are estimated in tiles of 64x64 pixels,
+ * from the median and the median absolute deviation of each tile. Pixels
+ * brighter than their local background by the given number of standard
+ * deviations are grouped into stars by connected component labelling. Each
+ * band of rows is labelled on its own thread, and the stars that cross from
+ * one band into the next are joined afterwards.
+ *
+ * Stars that overlap one another are merged into the brightest one, looking
+ * only at the neighbouring cells of a grid. The half flux radius of each star
+ * is calculated from all the pixels around its centroid.
+ */
+class FITSStarDetector
+{
+public:
+    /**
+     * @short Find the stars of an image.
+     * @param buffer the pixels of the image, or of its first channel
+     * @param width the width of the image
+     * @param height the height of the image
+     * @param area the part of the image to search
+     * @param sigma how many standard deviations of the noise a pixel must be above the background
+     * @param minWidth the minimum width of a star in pixels
+     * @return the stars found, brightest first. The caller owns them.
+     */
+    template<typename T> static QList<Edge*> findStars(const T *buffer, int width, int height, const QRect &area, double sigma, int minWidth);
+};
+
+#endif
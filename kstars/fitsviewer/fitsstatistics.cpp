@@ -0,0 +1,436 @@
+/***************************************************************************
+                          fitsstatistics.cpp  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fitsstatistics.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+
+// Independent accumulators per band. They do not depend on one another, so they fit in vector registers.
+#define STATS_LANES         8
+// Smallest band worth a thread of its own
+#define STATS_MIN_BAND      (1 << 16)
+// Bins for the median of images whose values are not counted one by one
+#define STATS_MEDIAN_BINS   65536
+
+namespace
+{
+
+// 8 and 16 bit values are counted one by one in the first pass
+template<typename T> struct ValueBins { static const int count = 0; };
+template<> struct ValueBins<uint8_t> { static const int count = 256; };
+template<> struct ValueBins<uint16_t> { static const int count = 65536; };
+
+template<typename T> inline void countValue(uint32_t *, T) {}
+inline void countValue(uint32_t *bins, uint8_t value) { bins[value]++; }
+inline void countValue(uint32_t *bins, uint16_t value) { bins[value]++; }
+
+template<typename T> struct Band
+{
+    const T *data;
+    uint32_t size;
+    int channel;
+
+    T min, max;
+    double mean;
+    double m2;                  // Sum of the squared deviations from the mean
+    QVector<uint32_t> bins;     // Values, or median bins
+    QVector<T> candidates;      // Pixels in the median bins
+};
+
+template<typename T> void reduceBand(Band<T> &band)
+{
+    const T *p = band.data;
+    const uint32_t n = band.size;
+
+    // Sums are taken about the first pixel, so that the squares stay small when the background is high
+    const double shift = p[0];
+
+    T lmin[STATS_LANES], lmax[STATS_LANES];
+    double lsum[STATS_LANES], lsq[STATS_LANES];
+    for (int l=0; l < STATS_LANES; l++)
+    {
+        lmin[l] = lmax[l] = p[0];
+        lsum[l] = lsq[l] = 0;
+    }
+
+    uint32_t *bins = NULL;
+    if (ValueBins<T>::count)
+    {
+        band.bins.fill(0, ValueBins<T>::count);
+        bins = band.bins.data();
+    }
+
+    uint32_t i=0;
+    for (; i + STATS_LANES <= n; i += STATS_LANES)
+    {
+        for (int l=0; l < STATS_LANES; l++)
+        {
+            const T v = p[i+l];
+            lmin[l] = v < lmin[l] ? v : lmin[l];
+            lmax[l] = v > lmax[l] ? v : lmax[l];
+            const double d = v - shift;
+            lsum[l] += d;
+            lsq[l]  += d * d;
+        }
+
+        if (bins)
+        {
+            for (int l=0; l < STATS_LANES; l++)
+                countValue(bins, p[i+l]);
+        }
+    }
+
+    for (; i < n; i++)
+    {
+        const T v = p[i];
+        lmin[0] = v < lmin[0] ? v : lmin[0];
+        lmax[0] = v > lmax[0] ? v : lmax[0];
+        const double d = v - shift;
+        lsum[0] += d;
+        lsq[0]  += d * d;
+
+        if (bins)
+            countValue(bins, v);
+    }
+
+    double sum=0, sq=0;
+    band.min = lmin[0];
+    band.max = lmax[0];
+    for (int l=0; l < STATS_LANES; l++)
+    {
+        band.min = lmin[l] < band.min ? lmin[l] : band.min;
+        band.max = lmax[l] > band.max ? lmax[l] : band.max;
+        sum += lsum[l];
+        sq  += lsq[l];
+    }
+
+    band.mean = shift + sum / n;
+    band.m2   = std::max(0.0, sq - sum * sum / n);
+}
+
+inline int medianBin(double value, double min, double scale)
+{
+    return static_cast<int>((value - min) * scale);
+}
+
+template<typename T> void binBand(Band<T> &band, double min, double max, double scale)
+{
+    band.bins.fill(0, STATS_MEDIAN_BINS);
+    uint32_t *bins = band.bins.data();
+
+    for (uint32_t i=0; i < band.size; i++)
+    {
+        const double v = band.data[i];
+        // Also leaves out NaN
+        if (v >= min && v <= max)
+            bins[medianBin(v, min, scale)]++;
+    }
+}
+
+template<typename T> void gatherBand(Band<T> &band, double min, double max, double scale, int firstBin, int lastBin)
+{
+    band.candidates.clear();
+
+    for (uint32_t i=0; i < band.size; i++)
+    {
+        const double v = band.data[i];
+        if (v >= min && v <= max)
+        {
+            int bin = medianBin(v, min, scale);
+            if (bin >= firstBin && bin <= lastBin)
+                band.candidates.append(band.data[i]);
+        }
+    }
+}
+
+// Bin that holds the pixel of the given rank, counting from 0. Below receives the number of pixels in the bins before it.
+int findRank(const QVector<uint32_t> &bins, uint64_t rank, uint64_t *below=NULL)
+{
+    uint64_t cumulative=0;
+
+    for (int i=0; i < bins.size(); i++)
+    {
+        if (cumulative + bins[i] > rank)
+        {
+            if (below)
+                *below = cumulative;
+            return i;
+        }
+        cumulative += bins[i];
+    }
+
+    if (below)
+        *below = cumulative;
+    return bins.size() - 1;
+}
+
+// Histogram bin whose center is nearest to value
+inline int histogramBin(double value, double min, double binWidth, int lastBin)
+{
+    double bin = binWidth > 0 ? (value - min) / binWidth + 0.5 : 0;
+
+    // Also puts NaN in the first bin
+    if (!(bin >= 1))
+        return 0;
+    if (bin >= lastBin)
+        return lastBin;
+    return static_cast<int>(bin);
+}
+
+}
+
+template<typename T> void FITSStatistics::calculate(const T *buffer, uint32_t samples, int channels, Channel *results,
+                                                    QVector<uint32_t> *valueCounts)
+{
+    for (int c=0; c < channels; c++)
+        results[c].min = results[c].max = results[c].mean = results[c].stddev = results[c].median = 0;
+
+    if (buffer == NULL || samples == 0)
+        return;
+
+    int bandsPerChannel = qMax(1, qMin(QThread::idealThreadCount(), static_cast<int>(samples / STATS_MIN_BAND)));
+    uint32_t bandSize = (samples + bandsPerChannel - 1) / bandsPerChannel;
+
+    QVector< Band<T> > bands;
+    for (int c=0; c < channels; c++)
+    {
+        for (uint32_t start=0; start < samples; start += bandSize)
+        {
+            Band<T> band;
+            band.data    = buffer + static_cast<uint64_t>(c) * samples + start;
+            band.size    = qMin(bandSize, samples - start);
+            band.channel = c;
+            bands.append(band);
+        }
+    }
+
+    // Min, max, mean, variance, and 8 and 16 bit values
+    QtConcurrent::blockingMap(bands, reduceBand<T>);
+
+    QVector<double> counts(channels, 0), m2(channels, 0);
+    QVector< QVector<uint32_t> > bins(channels);
+
+    for (int i=0; i < bands.size(); i++)
+    {
+        const Band<T> &band = bands[i];
+        Channel &result = results[band.channel];
+        double &n = counts[band.channel];
+
+        if (n == 0)
+        {
+            result.min  = band.min;
+            result.max  = band.max;
+            result.mean = band.mean;
+            m2[band.channel] = band.m2;
+        }
+        else
+        {
+            // Chan et al. pairwise combination of means and variances
+            double total = n + band.size;
+            double delta = band.mean - result.mean;
+            result.min  = qMin(result.min, static_cast<double>(band.min));
+            result.max  = qMax(result.max, static_cast<double>(band.max));
+            result.mean += delta * band.size / total;
+            m2[band.channel] += band.m2 + delta * delta * n * band.size / total;
+        }
+        n += band.size;
+
+        if (ValueBins<T>::count)
+        {
+            QVector<uint32_t> &channelBins = bins[band.channel];
+            if (channelBins.isEmpty())
+                channelBins = band.bins;
+            else
+            {
+                for (int j=0; j < channelBins.size(); j++)
+                    channelBins[j] += band.bins[j];
+            }
+        }
+    }
+
+    for (int c=0; c < channels; c++)
+        results[c].stddev = counts[c] > 1 ? sqrt(m2[c] / (counts[c] - 1)) : 0;
+
+    if (ValueBins<T>::count)
+    {
+        for (int c=0; c < channels; c++)
+        {
+            uint64_t total = samples;
+            results[c].median = (findRank(bins[c], (total - 1) / 2) + findRank(bins[c], total / 2)) / 2.0;
+
+            if (valueCounts)
+                valueCounts[c] = bins[c];
+        }
+
+        return;
+    }
+
+    // Count the other types in bins between min and max, and select among the pixels in the bins of the median only
+    QVector<double> scale(channels, 0);
+    for (int c=0; c < channels; c++)
+    {
+        if (results[c].max > results[c].min)
+            scale[c] = (STATS_MEDIAN_BINS - 1) / (results[c].max - results[c].min);
+        else
+            results[c].median = results[c].min;
+    }
+
+    QtConcurrent::blockingMap(bands, [results, &scale](Band<T> &band) {
+        if (scale[band.channel] > 0)
+            binBand(band, results[band.channel].min, results[band.channel].max, scale[band.channel]);
+    });
+
+    for (int i=0; i < bands.size(); i++)
+    {
+        const Band<T> &band = bands[i];
+        if (scale[band.channel] == 0)
+            continue;
+
+        QVector<uint32_t> &channelBins = bins[band.channel];
+        if (channelBins.isEmpty())
+            channelBins = band.bins;
+        else
+        {
+            for (int j=0; j < channelBins.size(); j++)
+                channelBins[j] += band.bins[j];
+        }
+    }
+
+    QVector<uint64_t> lowRank(channels), highRank(channels), below(channels);
+    QVector<int> firstBin(channels, 0), lastBin(channels, -1);
+    for (int c=0; c < channels; c++)
+    {
+        if (scale[c] == 0)
+            continue;
+
+        uint64_t total=0;
+        foreach (uint32_t count, bins[c])
+            total += count;
+        if (total == 0)
+            continue;
+
+        lowRank[c]  = (total - 1) / 2;
+        highRank[c] = total / 2;
+        firstBin[c] = findRank(bins[c], lowRank[c], &below[c]);
+        lastBin[c]  = findRank(bins[c], highRank[c]);
+    }
+
+    QtConcurrent::blockingMap(bands, [results, &scale, &firstBin, &lastBin](Band<T> &band) {
+        int c = band.channel;
+        if (lastBin[c] >= firstBin[c])
+            gatherBand(band, results[c].min, results[c].max, scale[c], firstBin[c], lastBin[c]);
+    });
+
+    for (int c=0; c < channels; c++)
+    {
+        if (lastBin[c] < firstBin[c])
+            continue;
+
+        QVector<T> candidates;
+        for (int i=0; i < bands.size(); i++)
+        {
+            if (bands[i].channel == c)
+                candidates += bands[i].candidates;
+        }
+
+        // The two middle pixels, which are the same one for an odd number of pixels
+        typename QVector<T>::iterator low = candidates.begin() + (lowRank[c] - below[c]);
+        std::nth_element(candidates.begin(), low, candidates.end());
+        double median = *low;
+        if (highRank[c] != lowRank[c])
+            median = (median + *std::min_element(low + 1, candidates.end())) / 2.0;
+
+        results[c].median = median;
+    }
+}
+
+template<typename T> void FITSStatistics::histogram(const T *buffer, uint32_t samples, int channels, double min, double binWidth,
+                                                    const QVector<uint32_t> *valueCounts, QVector<double> *frequencies)
+{
+    for (int c=0; c < channels; c++)
+        frequencies[c].fill(0);
+
+    const int lastBin = frequencies[0].size() - 1;
+    if (buffer == NULL || samples == 0 || lastBin < 0)
+        return;
+
+    // 8 and 16 bit values that were counted already only need to be put in their bins
+    if (ValueBins<T>::count && valueCounts && valueCounts[0].size() == ValueBins<T>::count)
+    {
+        for (int c=0; c < channels; c++)
+        {
+            const QVector<uint32_t> &counts = valueCounts[c];
+            for (int value=0; value < counts.size(); value++)
+            {
+                if (counts[value])
+                    frequencies[c][histogramBin(value, min, binWidth, lastBin)] += counts[value];
+            }
+        }
+
+        return;
+    }
+
+    int bandsPerChannel = qMax(1, qMin(QThread::idealThreadCount(), static_cast<int>(samples / STATS_MIN_BAND)));
+    uint32_t bandSize = (samples + bandsPerChannel - 1) / bandsPerChannel;
+
+    QVector< Band<T> > bands;
+    for (int c=0; c < channels; c++)
+    {
+        for (uint32_t start=0; start < samples; start += bandSize)
+        {
+            Band<T> band;
+            band.data    = buffer + static_cast<uint64_t>(c) * samples + start;
+            band.size    = qMin(bandSize, samples - start);
+            band.channel = c;
+            bands.append(band);
+        }
+    }
+
+    QtConcurrent::blockingMap(bands, [=](Band<T> &band) {
+        band.bins.fill(0, lastBin + 1);
+        uint32_t *bins = band.bins.data();
+
+        for (uint32_t i=0; i < band.size; i++)
+            bins[histogramBin(band.data[i], min, binWidth, lastBin)]++;
+    });
+
+    foreach (const Band<T> &band, bands)
+    {
+        double *bins = frequencies[band.channel].data();
+        for (int i=0; i <= lastBin; i++)
+            bins[i] += band.bins[i];
+    }
+}
+
+template void FITSStatistics::calculate<uint8_t>(const uint8_t *, uint32_t, int, Channel *, QVector<uint32_t> *);
+template void FITSStatistics::calculate<uint16_t>(const uint16_t *, uint32_t, int, Channel *, QVector<uint32_t> *);
+template void FITSStatistics::calculate<int16_t>(const int16_t *, uint32_t, int, Channel *, QVector<uint32_t> *);
+template void FITSStatistics::calculate<int32_t>(const int32_t *, uint32_t, int, Channel *, QVector<uint32_t> *);
+template void FITSStatistics::calculate<float>(const float *, uint32_t, int, Channel *, QVector<uint32_t> *);
+template void FITSStatistics::calculate<double>(const double *, uint32_t, int, Channel *, QVector<uint32_t> *);
+
+template void FITSStatistics::histogram<uint8_t>(const uint8_t *, uint32_t, int, double, double, const QVector<uint32_t> *, QVector<double> *);
+template void FITSStatistics::histogram<uint16_t>(const uint16_t *, uint32_t, int, double, double, const QVector<uint32_t> *, QVector<double> *);
+template void FITSStatistics::histogram<int16_t>(const int16_t *, uint32_t, int, double, double, const QVector<uint32_t> *, QVector<double> *);
+template void FITSStatistics::histogram<int32_t>(const int32_t *, uint32_t, int, double, double, const QVector<uint32_t> *, QVector<double> *);
+template void FITSStatistics::histogram<float>(const float *, uint32_t, int, double, double, const QVector<uint32_t> *, QVector<double> *);
+template void FITSStatistics::histogram<double>(const double *, uint32_t, int, double, double, const QVector<uint32_t> *, QVector<double> *);
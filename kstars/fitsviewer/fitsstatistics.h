@@ -0,0 +1,82 @@
+/***************************************************************************
+                          fitsstatistics.h  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FITSSTATISTICS_H_
+#define FITSSTATISTICS_H_
+
+#include <stdint.h>
+
+#include <QVector>
+
+/**
+ * @class FITSStatistics
+ * @short Minimum, maximum, mean, standard deviation and median of image channels.
+ *
+ * All of them are calculated together. A first pass over the pixels gathers
+ * the minimum, maximum and sums. Each channel is split into bands that are
+ * processed on all available threads. Within a band the pixels are reduced in
+ * several independent lanes that the compiler turns into SIMD instructions.
+ *
+ * The median is exact, and is found without sorting. 8 and 16 bit images
+ * count every value in the first pass. Other types count pixels in 65536
+ * bins between the minimum and the maximum in a second pass. Then only the
+ * pixels of the bin that holds the median are kept and selected from.
+ *
+ * The histogram of the image is counted in the same way, in bands with bins of
+ * their own that are added up at the end. The value counts of 8 and 16 bit
+ * images that calculate() keeps for the median are reused, so that for them
+ * the histogram needs no pass over the pixels at all.
+ */
+class FITSStatistics
+{
+public:
+    /** Statistics of one channel */
+    struct Channel
+    {
+        double min, max;
+        double mean;
+        double stddev;      ///< Sample standard deviation
+        double median;
+    };
+
+    /**
+     * @short Calculate the statistics of an image.
+     * @param buffer the pixels of the image, one channel after the other
+     * @param samples the number of pixels in each channel
+     * @param channels the number of channels
+     * @param results receives the statistics of each channel
+     * @param valueCounts if not NULL, receives for 8 and 16 bit images the number of pixels of each value in each channel
+     */
+    template<typename T> static void calculate(const T *buffer, uint32_t samples, int channels, Channel *results,
+                                               QVector<uint32_t> *valueCounts=NULL);
+
+    /**
+     * @short Count the pixels of each channel in bins.
+     * @param buffer the pixels of the image, one channel after the other
+     * @param samples the number of pixels in each channel
+     * @param channels the number of channels
+     * @param min the value at the center of the first bin
+     * @param binWidth the width of the bins
+     * @param valueCounts the value counts of each channel from calculate(), or NULL to count the pixels instead
+     * @param frequencies receives the bins of each channel. Their size sets the number of bins. Pixels below the
+     * first bin or above the last one are counted in it.
+     */
+    template<typename T> static void histogram(const T *buffer, uint32_t samples, int channels, double min, double binWidth,
+                                               const QVector<uint32_t> *valueCounts, QVector<double> *frequencies);
+};
+
+#endif
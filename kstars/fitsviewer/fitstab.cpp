@@ -89,7 +89,8 @@ void FITSTab::setPreviewText(const QString &value)
 }
 
 
-bool FITSTab::loadFITS(const QUrl *imageURL, FITSMode mode, FITSScale filter, bool silent)
+bool FITSTab::loadFITS(const QUrl *imageURL, FITSMode mode, FITSScale filter, bool silent, const QByteArray &buffer,
+                       QSharedPointer<FITSData> loadedData)
 {
     if (view == NULL)
     {
@@ -108,7 +109,7 @@ bool FITSTab::loadFITS(const QUrl *imageURL, FITSMode mode, FITSScale filter, bo
 
     view->setFilter(filter);
 
-    bool imageLoad = view->loadFITS(imageURL->url(), silent);
+    bool imageLoad = view->loadFITS(imageURL->url(), silent, buffer, loadedData);
 
     if (imageLoad)
     {
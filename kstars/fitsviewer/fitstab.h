@@ -19,11 +19,13 @@
 
 #include <QWidget>
 #include <QUrl>
+#include <QSharedPointer>
 
 #include "fitscommon.h"
 
 class QUndoStack;
 class FITSView;
+class FITSData;
 class FITSHistogram;
 class FITSViewer;
 
@@ -40,7 +42,8 @@ public:
 
    FITSTab(FITSViewer *parent);
    ~FITSTab();
-   bool loadFITS(const QUrl *imageURL, FITSMode mode = FITS_NORMAL, FITSScale filter=FITS_NONE, bool silent=true);
+   bool loadFITS(const QUrl *imageURL, FITSMode mode = FITS_NORMAL, FITSScale filter=FITS_NONE, bool silent=true,
+                 const QByteArray &buffer=QByteArray(), QSharedPointer<FITSData> loadedData=QSharedPointer<FITSData>());
    int saveFITS(const QString &filename);
 
    inline QUndoStack *getUndoStack() { return undoStack; }
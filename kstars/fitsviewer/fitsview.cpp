@@ -27,6 +27,7 @@
 #include <QApplication>
 #include <QPaintEvent>
 #include <QScrollArea>
+#include <QScrollBar>
 #include <QFile>
 #include <QCursor>
 #include <QToolTip>
@@ -84,9 +85,7 @@ void FITSLabel::mouseMoveEvent(QMouseEvent *e)
     double x,y;
     FITSData *image_data = image->getImageData();
 
-    float *buffer = image_data->getImageBuffer();
-
-    if (buffer == NULL)
+    if (image_data->getDisplayBuffer() == NULL)
         return;
 
     x = round(e->x() / (image->getCurrentZoom() / ZOOM_DEFAULT));
@@ -102,24 +101,19 @@ void FITSLabel::mouseMoveEvent(QMouseEvent *e)
     y -= 1;
 
     if (image_data->getBPP() == -32 || image_data->getBPP() == 32)
-        emit newStatus(QLocale().toString(buffer[(int) (y * width + x)], 'f', 4), FITS_VALUE);
+        emit newStatus(QLocale().toString(image_data->getPixelValue((int) (y * width + x)), 'f', 4), FITS_VALUE);
     else
-        emit newStatus(QLocale().toString(buffer[(int) (y * width + x)], 'f', 2), FITS_VALUE);
+        emit newStatus(QLocale().toString(image_data->getPixelValue((int) (y * width + x)), 'f', 2), FITS_VALUE);
 
 
     if (image_data->hasWCS())
     {
-        int index = x + y * width;
-
-        wcs_point * wcs_coord = image_data->getWCSCoord();
+        wcs_point wcs_coord;
 
-        if (wcs_coord)
+        if (image_data->pixelToWCS(x, y, wcs_coord))
         {
-            if (index > size)
-                return;
-
-            ra.setD(wcs_coord[index].ra);
-            dec.setD(wcs_coord[index].dec);
+            ra.setD(wcs_coord.ra);
+            dec.setD(wcs_coord.dec);
 
             emit newStatus(QString("%1 , %2").arg( ra.toHMSString()).arg(dec.toDMSString()), FITS_WCS);
         }
@@ -150,16 +144,11 @@ void FITSLabel::mousePressEvent(QMouseEvent *e)
 
       if (fitspopup.exec(e->globalPos()) == trackAction)
       {
-          int index = x + y * width;
+          wcs_point wcs_coord;
 
-          wcs_point * wcs_coord = image_data->getWCSCoord();
-
-          if (wcs_coord)
+          if (image_data->pixelToWCS(x, y, wcs_coord))
           {
-              if (index > size)
-                  return;
-
-              centerTelescope(wcs_coord[index].ra/15.0, wcs_coord[index].dec);
+              centerTelescope(wcs_coord.ra/15.0, wcs_coord.dec);
 
               return;
           }
@@ -176,6 +165,15 @@ void FITSLabel::mousePressEvent(QMouseEvent *e)
 
 }
 
+void FITSLabel::paintEvent(QPaintEvent *e)
+{
+    QPainter painter(this);
+
+    // Only the tiles of the image under the exposed area are converted and drawn
+    image->display_image->draw(&painter, e->rect(), image->getCurrentZoom() / ZOOM_DEFAULT);
+    image->drawOverlay(&painter);
+}
+
 void FITSLabel::mouseDoubleClickEvent(QMouseEvent *e)
 {
     double x,y;
@@ -245,9 +243,9 @@ void FITSLabel::centerTelescope(double raJ2000, double decJ2000)
 FITSView::FITSView(QWidget * parent, FITSMode fitsMode, FITSScale filterType) : QScrollArea(parent) , zoomFactor(1.2)
 {
     image_frame = new FITSLabel(this);
-    image_data  = NULL;
-    display_image = NULL;
+    display_image = new FITSImagePyramid();
     firstLoad = true;
+    loadCount = 0;
     trackingBoxEnabled=false;
     trackingBoxUpdated=false;
     filter = filterType;
@@ -277,42 +275,58 @@ FITSView::FITSView(QWidget * parent, FITSMode fitsMode, FITSScale filterType) :
 FITSView::~FITSView()
 {
     delete(image_frame);
-    delete(image_data);
     delete(display_image);
 }
 
-bool FITSView::loadFITS (const QString &inFilename , bool silent)
+FITSData * FITSView::createImageData()
 {
-    QProgressDialog fitsProg(this);
-
-    bool setBayerParams=false;
+    FITSData *data = new FITSData(mode);
 
     BayerParams param;
     if (image_data && image_data->hasDebayer())
     {
-        setBayerParams=true;
         image_data->getBayerParams(&param);
+        data->setBayerParams(&param);
     }
 
-    delete (image_data);
-    image_data = NULL;
+    // When zoomed in, only the part of the image that is shown needs colours
+    if (Options::debayerVisibleRegion() && firstLoad == false && currentZoom > ZOOM_DEFAULT)
+    {
+        double scale = ZOOM_DEFAULT / currentZoom;
+        QRect visible(floor(horizontalScrollBar()->value() * scale), floor(verticalScrollBar()->value() * scale),
+                      ceil(viewport()->width() * scale) + 1, ceil(viewport()->height() * scale) + 1);
+        data->setDebayerRegion(visible);
+    }
 
-    image_data = new FITSData(mode);
+    return data;
+}
 
-    if (setBayerParams)
-        image_data->setBayerParams(&param);
+bool FITSView::loadFITS (const QString &inFilename , bool silent, const QByteArray &buffer, QSharedPointer<FITSData> loadedData)
+{
+    QProgressDialog fitsProg(this);
 
-    if (mode == FITS_NORMAL)
+    QSharedPointer<FITSData> data = loadedData ? loadedData : QSharedPointer<FITSData>(createImageData());
+
+    // The displayed image refers to the pixels of the old data. The data itself goes away
+    // once the workers that still process it let go of it.
+    display_image->clear();
+    image_data = data;
+    loadCount++;
+
+    if (loadedData.isNull())
     {
-        fitsProg.setWindowModality(Qt::WindowModal);
-        fitsProg.setLabelText(i18n("Please hold while loading FITS file..."));
-        fitsProg.setWindowTitle(i18n("Loading FITS"));
-        fitsProg.setValue(10);
-        qApp->processEvents();
-    }
+        if (mode == FITS_NORMAL)
+        {
+            fitsProg.setWindowModality(Qt::WindowModal);
+            fitsProg.setLabelText(i18n("Please hold while loading FITS file..."));
+            fitsProg.setWindowTitle(i18n("Loading FITS"));
+            fitsProg.setValue(10);
+            qApp->processEvents();
+        }
 
-    if (image_data->loadFITS(inFilename, silent) == false)
-        return false;
+        if (image_data->loadFITS(inFilename, silent, buffer) == false)
+            return false;
+    }
 
 
     if (mode == FITS_NORMAL)
@@ -351,8 +365,6 @@ bool FITSView::loadFITS (const QString &inFilename , bool silent)
         }
     }
 
-    initDisplayImage();
-
     // Rescale to fits window
     if (firstLoad)
     {
@@ -396,116 +408,40 @@ int FITSView::saveFITS( const QString &newFilename )
 
 int FITSView::rescale(FITSZoom type)
 {
-    double val=0;
-    double bscale, bzero;
     double min, max;
-    float *image_buffer = image_data->getImageBuffer();
-    float *display_buffer = image_buffer;
-    unsigned int size = image_data->getSize();
 
+    // Pixels are clamped to min..max as they are drawn, so there is no need for a stretched copy of the image
     if (Options::autoStretch() && filter == FITS_NONE)
     {
-        display_buffer = new float[image_data->getSize() * image_data->getNumOfChannels()];
-        memset(display_buffer, 0, image_data->getSize() * image_data->getNumOfChannels() * sizeof(float));
-
-        float data_min   = image_data->getMean(0) - image_data->getStdDev(0);
-        float data_max   = image_data->getMean(0) + image_data->getStdDev(0) * 3;
-        int   data_w     = image_data->getWidth();
-        int   data_h     = image_data->getHeight();
-
-        for (int i=0; i < image_data->getNumOfChannels(); i++)
-        {
-            int offset = i*size;
-            for (int j=0; j < data_h; j++)
-            {
-                int row = offset + j * data_w;
-                for (int k=0; k < data_w; k++)
-                {
-                    int index=k + row;
-                    display_buffer[index] = qBound(data_min, image_buffer[index], data_max);
-                }
-            }
-        }
-
-        min = data_min;
-        max = data_max;
+        min = image_data->getMean(0) - image_data->getStdDev(0);
+        max = image_data->getMean(0) + image_data->getStdDev(0) * 3;
     }
     else
         image_data->getMinMax(&min, &max);
 
-    if (min == max)
+    if (image_height != image_data->getHeight() || image_width != image_data->getWidth())
     {
-        display_image->fill(Qt::white);
-        emit newStatus(i18n("Image is saturated!"), FITS_MESSAGE);
-    }
-    else
-    {
-        bscale = 255. / (max - min);
-        bzero  = (-min) * (255. / (max - min));
-
-        if (image_height != image_data->getHeight() || image_width != image_data->getWidth())
-        {
-            image_width  = image_data->getWidth();
-            image_height = image_data->getHeight();
-
-            initDisplayImage();
+        image_width  = image_data->getWidth();
+        image_height = image_data->getHeight();
 
-            if (isVisible())
-                emit newStatus(QString("%1x%2").arg(image_width).arg(image_height), FITS_RESOLUTION);
-        }
-
-        image_frame->setScaledContents(true);
-        currentWidth  = display_image->width();
-        currentHeight = display_image->height();
-
-        if (image_data->getNumOfChannels() == 1)
-        {
-            /* Fill in pixel values using indexed map, linear scale */
-            for (int j = 0; j < image_height; j++)
-            {
-                unsigned char *scanLine = display_image->scanLine(j);
-
-                for (int i = 0; i < image_width; i++)
-                {
-                    val = display_buffer[j * image_width + i];
-                    scanLine[i]= (val * bscale + bzero);
-                }
-            }
-        }
-        else
-        {
-            double rval=0,gval=0,bval=0;
-            QRgb value;
-            /* Fill in pixel values using indexed map, linear scale */
-            for (int j = 0; j < image_height; j++)
-            {
-                QRgb *scanLine = reinterpret_cast<QRgb*>((display_image->scanLine(j)));
-
-                for (int i = 0; i < image_width; i++)
-                {
-                    rval = display_buffer[j * image_width + i];
-                    gval = display_buffer[j * image_width + i + size];
-                    bval = display_buffer[j * image_width + i + size * 2];
-
-                    value = qRgb(rval* bscale + bzero, gval* bscale + bzero, bval* bscale + bzero);
-
-                    //display_image->setPixel(i, j, value);
-                    scanLine[i] = value;
-
-                }
-            }
+        if (isVisible())
+            emit newStatus(QString("%1x%2").arg(image_width).arg(image_height), FITS_RESOLUTION);
+    }
 
-        }
+    // Nothing is converted here. The tiles that are shown are converted as they are painted.
+    display_image->setSource(image_data->getDisplayBuffer(), image_data->getDataType(), image_width, image_height,
+                             image_data->getNumOfChannels(), min, max);
 
-    }
+    if (min == max)
+        emit newStatus(i18n("Image is saturated!"), FITS_MESSAGE);
 
-    if (display_buffer != image_buffer)
-        delete [] display_buffer;
+    currentWidth  = image_width;
+    currentHeight = image_height;
 
     switch (type)
     {
     case ZOOM_FIT_WINDOW:
-        if ((display_image->width() > width() || display_image->height() > height()))
+        if ((image_width > width() || image_height > height()))
         {
             // Find the zoom level which will enclose the current FITS in the default window size (640x480)
             currentZoom = floor( (INITIAL_W / currentWidth) * 10.) * 10.;
@@ -605,28 +541,12 @@ void FITSView::ZoomOut()
 
 void FITSView::updateFrame()
 {
-
-    QPixmap displayPixmap;
-    bool ok=false;
-
-    if (display_image == NULL)
+    if (display_image->isNull())
         return;
 
-    if (currentZoom != ZOOM_DEFAULT)
-            ok = displayPixmap.convertFromImage(display_image->scaled( (int) currentWidth, (int) currentHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation));
-        else
-            ok = displayPixmap.convertFromImage(*display_image);
-
-
-    if (ok == false)
-        return;
-
-    QPainter painter(&displayPixmap);
-
-    drawOverlay(&painter);
-
-    image_frame->setPixmap(displayPixmap);
+    // The frame paints the part of the image that is visible, with the overlay on top
     image_frame->resize( (int) currentWidth, (int) currentHeight);
+    image_frame->update();
 }
 
 void FITSView::ZoomDefault()
@@ -817,22 +737,3 @@ void FITSView::wheelEvent(QWheelEvent* event)
 
     event->accept();
 }
-
-void FITSView::initDisplayImage()
-{
-    delete (display_image);
-    display_image = NULL;
-
-    if (image_data->getNumOfChannels() == 1)
-    {
-        display_image = new QImage(image_width, image_height, QImage::Format_Indexed8);
-
-        display_image->setColorCount(256);
-        for (int i=0; i < 256; i++)
-            display_image->setColor(i, qRgb(i,i,i));
-    }
-    else
-    {
-        display_image = new QImage(image_width, image_height, QImage::Format_RGB32);
-    }
-}
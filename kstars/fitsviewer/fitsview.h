@@ -28,6 +28,7 @@
 #include <QPaintEvent>
 #include <QScrollArea>
 #include <QLabel>
+#include <QSharedPointer>
 
 #include <kxmlguiwindow.h>
 
@@ -42,12 +43,14 @@
 
 #include "dms.h"
 #include "fitsdata.h"
+#include "fitsimagepyramid.h"
 
 #define INITIAL_W	640
 #define INITIAL_H	480
 
 #define MINIMUM_PIXEL_RANGE 5
 #define MINIMUM_STDVAR  5
+#define PREVIEW_SIZE    1024    // Largest side of preview images
 
 class FITSView;
 
@@ -65,6 +68,7 @@ protected:
     virtual void mouseMoveEvent(QMouseEvent *e);
     virtual void mousePressEvent(QMouseEvent *e);
     virtual void mouseDoubleClickEvent(QMouseEvent *e);
+    virtual void paintEvent(QPaintEvent *e);
 
 private:
     FITSView *image;
@@ -87,19 +91,29 @@ public:
     FITSView(QWidget *parent = 0, FITSMode mode=FITS_NORMAL, FITSScale filter=FITS_NONE);
     ~FITSView();
 
-    /* Loads FITS image, scales it, and displays it in the GUI */
-    bool  loadFITS(const QString &filename, bool silent=true);
+    /* Loads FITS image, scales it, and displays it in the GUI. See FITSData::loadFITS() for buffer.
+       If loadedData is set, it is displayed instead, as it was loaded already. */
+    bool  loadFITS(const QString &filename, bool silent=true, const QByteArray &buffer=QByteArray(),
+                   QSharedPointer<FITSData> loadedData=QSharedPointer<FITSData>());
+    /* New image data with the debayer settings of this view, to be loaded elsewhere and then shown with loadFITS() */
+    FITSData * createImageData();
     /* Save FITS */
     int saveFITS(const QString &filename);
     /* Rescale image lineary from image_buffer, fit to window if desired */
     int rescale(FITSZoom type);
 
-    void setImageData(FITSData *d) { image_data = d; }
+    void setImageData(FITSData *d) { image_data = QSharedPointer<FITSData>(d); }
 
     // Access functions
-    FITSData *getImageData() { return image_data; }
+    FITSData *getImageData() { return image_data.data(); }
+    /* The image data, kept alive for as long as the caller holds it even if the view loads another frame */
+    QSharedPointer<FITSData> getSharedImageData() { return image_data; }
+    /* Number of images loaded so far, which tells frames apart */
+    int getLoadCount() { return loadCount; }
     double getCurrentZoom() { return currentZoom; }
-    QImage * getDisplayImage() { return display_image; }    
+    QImage * getDisplayImage() { return display_image->image(); }
+    /* A reduced copy of the displayed image, for previews that do not need the full resolution */
+    QImage * getPreviewImage() { return display_image->preview(PREVIEW_SIZE); }
 
     // Tracking square
     void setTrackingBoxEnabled(bool enable);
@@ -140,10 +154,9 @@ private:
     double average();
     double stddev();
     void calculateMaxPixel(double min, double max);
-    void initDisplayImage();
 
     FITSLabel *image_frame;
-    FITSData *image_data;
+    QSharedPointer<FITSData> image_data;
     int image_width, image_height;
 
     double currentWidth,currentHeight; /* Current width and height due to zoom */
@@ -151,12 +164,13 @@ private:
     double currentZoom;                /* Current Zoom level */
 
     int data_type;                     /* FITS data type when opened */
-    QImage  *display_image;            /* FITS image that is displayed in the GUI */
+    FITSImagePyramid *display_image;   /* FITS image that is displayed in the GUI, converted as it is shown */
     FITSHistogram *histogram;
 
     double maxPixel, minPixel;
 
     bool firstLoad;
+    int loadCount;
     bool markStars;
     bool starsSearched;
     bool hasWCS;
@@ -262,14 +262,15 @@ void FITSViewer::showEvent(QShowEvent * /*event*/)
     }
 }
 
-int FITSViewer::addFITS(const QUrl *imageName, FITSMode mode, FITSScale filter, const QString &previewText, bool silent)
+int FITSViewer::addFITS(const QUrl *imageName, FITSMode mode, FITSScale filter, const QString &previewText, bool silent, const QByteArray &buffer,
+                        QSharedPointer<FITSData> loadedData)
 {
     FITSTab *tab = new FITSTab(this);
 
     led.setColor(Qt::yellow);
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
-    if (tab->loadFITS(imageName,mode, filter, silent) == false)
+    if (tab->loadFITS(imageName,mode, filter, silent, buffer, loadedData) == false)
     {
         QApplication::restoreOverrideCursor();
         led.setColor(Qt::red);
@@ -284,7 +285,8 @@ int FITSViewer::addFITS(const QUrl *imageName, FITSMode mode, FITSScale filter,
         return -1;
     }
 
-    lastURL = QUrl(imageName->url(QUrl::RemoveFilename));
+    if (imageName->isEmpty() == false)
+        lastURL = QUrl(imageName->url(QUrl::RemoveFilename));
 
     QApplication::restoreOverrideCursor();
     tab->setPreviewText(previewText);
@@ -292,7 +294,10 @@ int FITSViewer::addFITS(const QUrl *imageName, FITSMode mode, FITSScale filter,
     switch (mode)
     {
       case FITS_NORMAL:
-        fitsTab->addTab(tab, previewText.isEmpty() ? imageName->fileName() : previewText);
+        if (previewText.isEmpty() == false)
+            fitsTab->addTab(tab, previewText);
+        else
+            fitsTab->addTab(tab, imageName->isEmpty() ? i18n("Preview") : imageName->fileName());
         break;
 
        case FITS_CALIBRATE:
@@ -367,7 +372,8 @@ bool FITSViewer::removeFITS(int fitsUID)
 
 }
 
-bool FITSViewer::updateFITS(const QUrl *imageName, int fitsUID, FITSScale filter, bool silent)
+bool FITSViewer::updateFITS(const QUrl *imageName, int fitsUID, FITSScale filter, bool silent, const QByteArray &buffer,
+                            QSharedPointer<FITSData> loadedData)
 {
     FITSTab *tab = fitsMap.value(fitsUID);
 
@@ -384,14 +390,15 @@ bool FITSViewer::updateFITS(const QUrl *imageName, int fitsUID, FITSScale filter
 
     if (tab)
     {
-        rc = tab->loadFITS(imageName, tab->getView()->getMode(), filter, silent);
+        rc = tab->loadFITS(imageName, tab->getView()->getMode(), filter, silent, buffer, loadedData);
 
         if (rc)
         {
             int tabIndex = fitsTab->indexOf(tab);
             if (tabIndex != -1 && tab->getView()->getMode() == FITS_NORMAL)
             {
-                if ( (imageName->path().startsWith("/tmp") || imageName->path().contains("/Temp")) && Options::singlePreviewFITS())
+                // Images loaded from memory have no file name
+                if ( imageName->isEmpty() || ((imageName->path().startsWith("/tmp") || imageName->path().contains("/Temp")) && Options::singlePreviewFITS()))
                     fitsTab->setTabText(tabIndex, tab->getPreviewText().isEmpty()? i18n("Preview") : tab->getPreviewText());
                 else
                     fitsTab->setTabText(tabIndex, imageName->fileName());
@@ -22,6 +22,7 @@
 
 #include <QList>
 #include <QMap>
+#include <QSharedPointer>
 
 #include <QDialog>
 #include <QUrl>
@@ -46,6 +47,7 @@ class QTabWidget;
 class QUrl;
 
 class FITSView;
+class FITSData;
 class FITSTab;
 class FITSDebayer;
 
@@ -67,9 +69,13 @@ public:
     FITSViewer (QWidget *parent);
     ~FITSViewer();
 
-    int addFITS(const QUrl *imageName, FITSMode mode=FITS_NORMAL, FITSScale filter=FITS_NONE, const QString &previewText = QString(), bool silent=true);
+    /* Adds a tab for the FITS image. If buffer is not empty, the image is loaded from it and imageName,
+       which may be empty, only names it. If loadedData is set, the image was loaded already, e.g. on a worker thread. */
+    int addFITS(const QUrl *imageName, FITSMode mode=FITS_NORMAL, FITSScale filter=FITS_NONE, const QString &previewText = QString(), bool silent=true,
+                const QByteArray &buffer=QByteArray(), QSharedPointer<FITSData> loadedData=QSharedPointer<FITSData>());
 
-    bool updateFITS(const QUrl *imageName, int fitsUID, FITSScale filter=FITS_NONE, bool silent=true);
+    bool updateFITS(const QUrl *imageName, int fitsUID, FITSScale filter=FITS_NONE, bool silent=true, const QByteArray &buffer=QByteArray(),
+                    QSharedPointer<FITSData> loadedData=QSharedPointer<FITSData>());
     bool removeFITS(int fitsUID);
 
     void toggleMarkStars(bool enable) { markStars = enable; }
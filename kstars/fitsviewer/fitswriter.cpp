@@ -0,0 +1,190 @@
+/***************************************************************************
+                          fitswriter.cpp  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "fitswriter.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QtConcurrent>
+
+#include <fitsio.h>
+
+#include "Options.h"
+
+FITSWriter * FITSWriter::_FITSWriter = NULL;
+
+FITSWriter * FITSWriter::Instance()
+{
+    if (_FITSWriter == NULL)
+        _FITSWriter = new FITSWriter(qApp);
+
+    return _FITSWriter;
+}
+
+FITSWriter::FITSWriter(QObject *parent) : QObject(parent)
+{
+    writing      = false;
+    pendingBytes = 0;
+
+    connect(&watcher, SIGNAL(finished()), this, SLOT(writeFinished()));
+}
+
+FITSWriter::~FITSWriter()
+{
+    // Frames still waiting are written before quitting, they are the only copy
+    watcher.waitForFinished();
+    while (queue.isEmpty() == false)
+        writeJob(queue.dequeue());
+
+    _FITSWriter = NULL;
+}
+
+void FITSWriter::write(const QString &filename, const QByteArray &fitsBuffer, const QList<Keyword> &keywords)
+{
+    Job job;
+    job.filename   = filename;
+    job.fitsBuffer = fitsBuffer;
+    job.keywords   = keywords;
+    job.compress   = Options::compressFITS();
+
+    queue.enqueue(job);
+    pendingBytes += fitsBuffer.size();
+
+    if (writing == false)
+        startNext();
+}
+
+bool FITSWriter::isBusy() const
+{
+    return pendingBytes > static_cast<qint64>(Options::maxFITSWriteQueue()) * 1024 * 1024;
+}
+
+bool FITSWriter::isPending(const QString &filename) const
+{
+    if (writing && current.filename == filename)
+        return true;
+
+    foreach (const Job &job, queue)
+    {
+        if (job.filename == filename)
+            return true;
+    }
+
+    return false;
+}
+
+void FITSWriter::startNext()
+{
+    if (queue.isEmpty())
+        return;
+
+    current = queue.dequeue();
+    writing = true;
+    watcher.setFuture(QtConcurrent::run(writeJob, current));
+}
+
+void FITSWriter::writeFinished()
+{
+    bool rc = watcher.result();
+
+    writing = false;
+    pendingBytes -= current.fitsBuffer.size();
+    QString filename = current.filename;
+    current = Job();
+
+    startNext();
+
+    emit frameWritten(filename, rc);
+
+    if (isBusy() == false)
+        emit ready();
+}
+
+// Runs on a worker thread, so it must not touch anything but the job.
+bool FITSWriter::writeJob(const Job &job)
+{
+    if (job.keywords.isEmpty() && job.compress == false)
+    {
+        QFile file(job.filename);
+        if (!file.open(QIODevice::WriteOnly) || file.write(job.fitsBuffer) != job.fitsBuffer.size())
+        {
+            qDebug() << "FITSWriter Error: Unable to write " << job.filename << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    int status=0, bitpix=0;
+    fitsfile *fptr=NULL, *new_fptr=NULL;
+    // CFITSIO only reads the frame, it is opened read only
+    void *fitsMemory = const_cast<char *>(job.fitsBuffer.constData());
+    size_t fitsMemorySize = job.fitsBuffer.size();
+
+    if (fits_open_memfile(&fptr, "frame", READONLY, &fitsMemory, &fitsMemorySize, 0, NULL, &status))
+    {
+        fits_report_error(stderr, status);
+        return false;
+    }
+
+    // A leading ! replaces the file if it exists
+    if (fits_create_file(&new_fptr, QString("!" + job.filename).toLocal8Bit().constData(), &status))
+    {
+        fits_report_error(stderr, status);
+        status=0;
+        fits_close_file(fptr, &status);
+        return false;
+    }
+
+    if (job.compress)
+    {
+        // Rice is lossless for integers only. Floating point pixels would be quantized, so they are shuffled and zipped instead.
+        fits_get_img_type(fptr, &bitpix, &status);
+        fits_set_compression_type(new_fptr, bitpix < 0 ? GZIP_2 : RICE_1, &status);
+        fits_set_quantize_level(new_fptr, 0, &status);
+        fits_img_compress(fptr, new_fptr, &status);
+    }
+    else
+        fits_copy_file(fptr, new_fptr, 1, 1, 1, &status);
+
+    foreach (const Keyword &keyword, job.keywords)
+        fits_update_key_str(new_fptr, keyword.name.toLatin1().data(), keyword.value.toLatin1().data(), keyword.comment.toLatin1().data(), &status);
+
+    if (status)
+    {
+        fits_report_error(stderr, status);
+        qDebug() << "FITSWriter Error: Unable to write " << job.filename << endl;
+        status=0;
+        fits_delete_file(new_fptr, &status);
+        status=0;
+        fits_close_file(fptr, &status);
+        return false;
+    }
+
+    fits_close_file(new_fptr, &status);
+    int closeStatus=0;
+    fits_close_file(fptr, &closeStatus);
+
+    if (status)
+    {
+        fits_report_error(stderr, status);
+        return false;
+    }
+
+    return true;
+}
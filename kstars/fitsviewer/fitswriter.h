@@ -0,0 +1,104 @@
+/***************************************************************************
+                          fitswriter.h  -  FITS Image
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef FITSWRITER_H_
+#define FITSWRITER_H_
+
+#include <QObject>
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QList>
+#include <QQueue>
+
+/**
+ * @class FITSWriter
+ * @short Writes captured FITS frames to disk on a worker thread, one after another.
+ *
+ * A frame is handed over with the keywords to add to its header. The writer
+ * keeps its own reference to the frame buffer, which is shared with the image
+ * that is displayed, so nothing is copied. Frames without keywords are written
+ * as they are. Otherwise the header is updated as the frame is copied to disk,
+ * optionally compressed without loss into tiles as fpack does: Rice for integer
+ * pixels and shuffled GZIP for floating point ones.
+ *
+ * Frames waiting to be written count against the memory set in the options.
+ * Beyond it isBusy() is true until ready() is emitted, so that Capture can hold
+ * the next exposure back instead of piling frames up in memory.
+ */
+class FITSWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Keyword
+    {
+        QString name;
+        QString value;
+        QString comment;
+    };
+
+    static FITSWriter *Instance();
+
+    /**
+     * @short Queue a frame for writing.
+     * @param filename file to write, replaced if it exists
+     * @param fitsBuffer the FITS file as received from the camera
+     * @param keywords string keywords to add to the header, or to update if it has them
+     */
+    void write(const QString &filename, const QByteArray &fitsBuffer, const QList<Keyword> &keywords=QList<Keyword>());
+
+    /* Are more frames waiting than the options allow? */
+    bool isBusy() const;
+
+    /* Number of frames that are not written yet */
+    int pendingFrames() const { return queue.size() + (writing ? 1 : 0); }
+
+    /* Is the frame for filename queued or being written? frameWritten() follows once it is done. */
+    bool isPending(const QString &filename) const;
+
+signals:
+    void frameWritten(const QString &filename, bool success);
+    /* Emitted when a frame is written and the writer is not busy */
+    void ready();
+
+private slots:
+    void writeFinished();
+
+private:
+    FITSWriter(QObject *parent);
+    ~FITSWriter();
+    static FITSWriter * _FITSWriter;
+
+    struct Job
+    {
+        QString filename;
+        QByteArray fitsBuffer;
+        QList<Keyword> keywords;
+        bool compress;
+    };
+
+    static bool writeJob(const Job &job);
+    void startNext();
+
+    QQueue<Job> queue;
+    Job current;
+    bool writing;
+    qint64 pendingBytes;
+    QFutureWatcher<bool> watcher;
+};
+
+#endif
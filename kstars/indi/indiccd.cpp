@@ -23,6 +23,8 @@
 #include "fitsviewer/fitscommon.h"
 #include "fitsviewer/fitsview.h"
 #include "fitsviewer/fitsdata.h"
+#include "fitsviewer/fitswriter.h"
+#include "fitsviewer/fitsanalyzer.h"
 #endif
 
 #include "driverinfo.h"
@@ -120,7 +122,7 @@ void CCDChip::setImage(FITSView *image, FITSMode imageType)
      case FITS_ALIGN:
         alignImage = image;
         if (KStars::Instance()->ekosManager()->alignModule() && KStars::Instance()->ekosManager()->alignModule()->fov())
-            KStars::Instance()->ekosManager()->alignModule()->fov()->setImage(alignImage->getDisplayImage()->copy());
+            KStars::Instance()->ekosManager()->alignModule()->fov()->setImage(alignImage->getPreviewImage()->copy());
         break;
 
     default:
@@ -344,6 +346,11 @@ bool CCDChip::capture(double exposure)
     return true;
 }
 
+void CCDChip::cancelFrames()
+{
+    parentCCD->cancelFrames(this);
+}
+
 bool CCDChip::abortExposure()
 {
     ISwitchVectorProperty *abortProp = NULL;
@@ -791,6 +798,15 @@ CCD::CCD(GDInterface *iPtr) : DeviceDecorator(iPtr)
     normalTabID = calibrationTabID = focusTabID = guideTabID = alignTabID = -1;
     guideChip   = NULL;
 
+#ifdef HAVE_CFITSIO
+    for (int i=0; i < 2; i++)
+    {
+        frameLoader[i] = new FITSAnalyzer(this);
+        connect(frameLoader[i], SIGNAL(loaded(int,QSharedPointer<FITSData>)), this, SLOT(frameLoaded(int,QSharedPointer<FITSData>)));
+    }
+#else
+    frameLoader[0] = frameLoader[1] = NULL;
+#endif
 }
 
 CCD::~CCD()
@@ -1127,31 +1143,52 @@ void CCD::processBLOB(IBLOB* bp)
     if (filename.endsWith('/') == false)
         filename.append('/');
 
+    // FITS images are loaded straight from memory. The client reuses the BLOB
+    // buffer for the next image, so this is the only copy we make.
+    QByteArray fitsBuffer;
+#ifdef HAVE_CFITSIO
+    QList<FITSWriter::Keyword> keywords;
+    if (BType == BLOB_FITS)
+    {
+        fitsBuffer = QByteArray(static_cast<char *> (bp->blob), bp->size);
+        keywords   = takeFITSKeywords();
+    }
+#endif
+
     // Create temporary name if ANY of the following conditions are met:
     // 1. file is preview or batch mode is not enabled
     // 2. file type is not FITS_NORMAL (focus, guide..etc)
     if (targetChip->isBatchMode() == false || targetChip->getCaptureMode() != FITS_NORMAL)
     {
-
-        //tmpFile.setPrefix("fits");
-        tmpFile.setAutoRemove(false);
-
-        if (!tmpFile.open())
+        // Nobody asked to keep this image, so it never touches the disk
+        if (fitsBuffer.isEmpty() == false)
         {
-            qDebug() << "ISD:CCD Error: Unable to open " << filename << endl;
-            emit BLOBUpdated(NULL);
-            return;
+#ifdef HAVE_CFITSIO
+            addFITSKeywords(&fitsBuffer, keywords);
+#endif
+            filename.clear();
         }
+        else
+        {
+            //tmpFile.setPrefix("fits");
+            tmpFile.setAutoRemove(false);
 
-        QDataStream out(&tmpFile);
+            if (!tmpFile.open())
+            {
+                qDebug() << "ISD:CCD Error: Unable to open " << filename << endl;
+                emit BLOBUpdated(NULL);
+                return;
+            }
 
-        for (nr=0; nr < (int) bp->size; nr += n)
-            n = out.writeRawData( static_cast<char *> (bp->blob) + nr, bp->size - nr);
+            QDataStream out(&tmpFile);
 
-        tmpFile.close();
+            for (nr=0; nr < (int) bp->size; nr += n)
+                n = out.writeRawData( static_cast<char *> (bp->blob) + nr, bp->size - nr);
 
-        filename = tmpFile.fileName();
+            tmpFile.close();
 
+            filename = tmpFile.fileName();
+        }
     }
     // Create file name for others
     else
@@ -1163,26 +1200,35 @@ void CCD::processBLOB(IBLOB* bp)
         else
             filename += seqPrefix + (seqPrefix.isEmpty() ? "" : "_") + QString("%1_%2.%3").arg(QString().sprintf("%03d", nextSequenceID)).arg(ts).arg(QString(fmt));
 
-        QFile fits_temp_file(filename);
-        if (!fits_temp_file.open(QIODevice::WriteOnly))
+        // FITS images are saved in the background while we display them from memory. The keywords are added
+        // first, so that the image that is shown and analysed has them too.
+        if (fitsBuffer.isEmpty() == false)
         {
-            qDebug() << "ISD:CCD Error: Unable to open " << fits_temp_file.fileName() << endl;
-            emit BLOBUpdated(NULL);
-            return;
+#ifdef HAVE_CFITSIO
+            addFITSKeywords(&fitsBuffer, keywords);
+            FITSWriter::Instance()->write(filename, fitsBuffer);
+#endif
         }
+        else
+        {
+            QFile fits_temp_file(filename);
+            if (!fits_temp_file.open(QIODevice::WriteOnly))
+            {
+                qDebug() << "ISD:CCD Error: Unable to open " << fits_temp_file.fileName() << endl;
+                emit BLOBUpdated(NULL);
+                return;
+            }
 
-        QDataStream out(&fits_temp_file);
+            QDataStream out(&fits_temp_file);
 
-        for (nr=0; nr < (int) bp->size; nr += n)
-            n = out.writeRawData( static_cast<char *> (bp->blob) + nr, bp->size - nr);
+            for (nr=0; nr < (int) bp->size; nr += n)
+                n = out.writeRawData( static_cast<char *> (bp->blob) + nr, bp->size - nr);
 
-        fits_temp_file.close();
+            fits_temp_file.close();
+        }
     }
 
-    if (BType == BLOB_FITS)
-        addFITSKeywords(filename);
-
-    // store file name
+    // store file name, which is empty for images only kept in memory
     strncpy(BLOBFilename, filename.toLatin1(), MAXINDIFILENAME);
     bp->aux2 = BLOBFilename;
 
@@ -1236,208 +1282,293 @@ void CCD::processBLOB(IBLOB* bp)
 #ifdef HAVE_CFITSIO
     if (BType == BLOB_FITS)
     {
-        QUrl fileURL(filename);
+        PendingFrame frame;
+        frame.targetChip    = targetChip;
+        frame.bp            = bp;
+        frame.filename      = filename;
+        frame.captureMode   = targetChip->getCaptureMode();
+        frame.captureFilter = targetChip->getCaptureFilter();
+
+        // The frame is decoded and its statistics calculated on a worker thread, with the settings of the view that will show it
+        FITSView *view = targetChip->getImage(frame.captureMode);
+        QSharedPointer<FITSData> data(view ? view->createImageData() : new FITSData(frame.captureMode));
+
+        int sequence = frameLoader[targetChip->getType()]->load(data, QUrl(filename).url(), fitsBuffer);
+        pendingFrames[targetChip->getType()][sequence] = frame;
+        return;
+    }
+#endif
 
-        if (fv.isNull())
-        {
-            normalTabID = calibrationTabID = focusTabID = guideTabID = alignTabID = -1;
+    emit BLOBUpdated(bp);
 
-            if (Options::singleWindowCapturedFITS())
-                fv = KStars::Instance()->genericFITSViewer();
-            else
-                fv = new FITSViewer(Options::independentWindowFITS() ? NULL : KStars::Instance());
+}
 
-            //connect(fv, SIGNAL(destroyed()), this, SLOT(FITSViewerDestroyed()));
-            //connect(fv, SIGNAL(destroyed()), this, SIGNAL(FITSViewerClosed()));
-        }
+void CCD::frameLoaded(int sequence, QSharedPointer<FITSData> data)
+{
+#ifdef HAVE_CFITSIO
+    int chipType = (sender() == frameLoader[CCDChip::GUIDE_CCD]) ? CCDChip::GUIDE_CCD : CCDChip::PRIMARY_CCD;
+    if (pendingFrames[chipType].contains(sequence) == false)
+        return;
 
-        FITSScale captureFilter = targetChip->getCaptureFilter();
+    PendingFrame frame  = pendingFrames[chipType].take(sequence);
+    CCDChip *targetChip = frame.targetChip;
+    QString filename    = frame.filename;
+    IBLOB *bp           = frame.bp;
 
-        QString previewTitle;
+    // If opening file fails, we treat it the same as exposure failure and recapture again if possible
+    if (data.isNull())
+    {
+        emit newExposureValue(targetChip, 0, IPS_ALERT);
+        return;
+    }
+
+    QUrl fileURL(filename);
+
+    if (fv.isNull())
+    {
+        normalTabID = calibrationTabID = focusTabID = guideTabID = alignTabID = -1;
 
-        bool preview = !targetChip->isBatchMode() && Options::singlePreviewFITS();
-        if (preview)
+        if (Options::singleWindowCapturedFITS())
+            fv = KStars::Instance()->genericFITSViewer();
+        else
+            fv = new FITSViewer(Options::independentWindowFITS() ? NULL : KStars::Instance());
+
+        //connect(fv, SIGNAL(destroyed()), this, SLOT(FITSViewerDestroyed()));
+        //connect(fv, SIGNAL(destroyed()), this, SIGNAL(FITSViewerClosed()));
+    }
+
+    FITSScale captureFilter = frame.captureFilter;
+
+    QString previewTitle;
+
+    bool preview = !targetChip->isBatchMode() && Options::singlePreviewFITS();
+    if (preview)
+    {
+        if (Options::singleWindowCapturedFITS())
+            previewTitle = i18n("%1 Preview", getDeviceName());
+        else
+            previewTitle = i18n("Preview");
+    }
+
+    int tabRC = -1;
+
+    switch (frame.captureMode)
+    {
+    case FITS_NORMAL:
+    {
+        if (normalTabID == -1 || Options::singlePreviewFITS() == false)
+            tabRC = fv->addFITS(&fileURL, FITS_NORMAL, captureFilter, previewTitle, true, QByteArray(), data);
+        else if (fv->updateFITS(&fileURL, normalTabID, captureFilter, true, QByteArray(), data) == false)
         {
-            if (Options::singleWindowCapturedFITS())
-                previewTitle = i18n("%1 Preview", getDeviceName());
-            else
-                previewTitle = i18n("Preview");
+            fv->removeFITS(normalTabID);
+            tabRC = fv->addFITS(&fileURL, FITS_NORMAL, captureFilter, previewTitle, true, QByteArray(), data);
         }
+        else
+            tabRC = normalTabID;
 
-        int tabRC = -1;
+        if (tabRC >= 0)
+        {
+            normalTabID = tabRC;
+            targetChip->setImage(fv->getView(normalTabID), FITS_NORMAL);
 
-        switch (targetChip->getCaptureMode())
+            emit newImage(fv->getView(normalTabID)->getPreviewImage(), targetChip);
+        }
+        else
         {
-        case FITS_NORMAL:
+            // If opening file fails, we treat it the same as exposure failure and recapture again if possible
+            emit newExposureValue(targetChip, 0, IPS_ALERT);
+            return;
+        }
+    }
+        break;
+
+    case FITS_FOCUS:
+        if (focusTabID == -1)
+            tabRC = fv->addFITS(&fileURL, FITS_FOCUS, captureFilter, QString(), true, QByteArray(), data);
+        else if (fv->updateFITS(&fileURL, focusTabID, captureFilter, true, QByteArray(), data) == false)
         {
-            if (normalTabID == -1 || Options::singlePreviewFITS() == false)
-                tabRC = fv->addFITS(&fileURL, FITS_NORMAL, captureFilter, previewTitle);
-            else if (fv->updateFITS(&fileURL, normalTabID, captureFilter) == false)
-            {
-                fv->removeFITS(normalTabID);
-                tabRC = fv->addFITS(&fileURL, FITS_NORMAL, captureFilter, previewTitle);
-            }
-            else
-                tabRC = normalTabID;
+            fv->removeFITS(focusTabID);
+            tabRC = fv->addFITS(&fileURL, FITS_FOCUS, captureFilter, QString(), true, QByteArray(), data);
+        }
+        else
+            tabRC = focusTabID;
 
-            if (tabRC >= 0)
-            {
-                normalTabID = tabRC;
-                targetChip->setImage(fv->getView(normalTabID), FITS_NORMAL);
+        if (tabRC >= 0)
+        {
+            focusTabID = tabRC;
+            targetChip->setImage(fv->getView(focusTabID), FITS_FOCUS);
 
-                emit newImage(fv->getView(normalTabID)->getDisplayImage(), targetChip);
-            }
-            else
-            {
-                // If opening file fails, we treat it the same as exposure failure and recapture again if possible
-                emit newExposureValue(targetChip, 0, IPS_ALERT);
-                return;
-            }
+            emit newImage(fv->getView(focusTabID)->getPreviewImage(), targetChip);
         }
-            break;
-
-        case FITS_FOCUS:
-            if (focusTabID == -1)
-                tabRC = fv->addFITS(&fileURL, FITS_FOCUS, captureFilter);
-            else if (fv->updateFITS(&fileURL, focusTabID, captureFilter) == false)
-            {
-                fv->removeFITS(focusTabID);
-                tabRC = fv->addFITS(&fileURL, FITS_FOCUS, captureFilter);
-            }
-            else
-                tabRC = focusTabID;
+        else
+        {
+            emit newExposureValue(targetChip, 0, IPS_ALERT);
+            // If there is problem loading image then BLOB is not valid so let's return
+            return;
+        }
+        break;
 
-            if (tabRC >= 0)
-            {
-                focusTabID = tabRC;
-                targetChip->setImage(fv->getView(focusTabID), FITS_FOCUS);
+    case FITS_GUIDE:
+        if (guideTabID == -1)
+            tabRC = fv->addFITS(&fileURL, FITS_GUIDE, captureFilter, QString(), true, QByteArray(), data);
+        else if (fv->updateFITS(&fileURL, guideTabID, captureFilter, true, QByteArray(), data) == false)
+        {
+            fv->removeFITS(guideTabID);
+            tabRC = fv->addFITS(&fileURL, FITS_GUIDE, captureFilter, QString(), true, QByteArray(), data);
+        }
+        else
+            tabRC = guideTabID;
 
-                emit newImage(fv->getView(focusTabID)->getDisplayImage(), targetChip);
-            }
-            else
-            {
-                emit newExposureValue(targetChip, 0, IPS_ALERT);
-                // If there is problem loading image then BLOB is not valid so let's return
-                return;
-            }
-            break;
+        if (tabRC >= 0)
+        {
+            guideTabID = tabRC;
+            targetChip->setImage(fv->getView(guideTabID), FITS_GUIDE);
 
-        case FITS_GUIDE:
-            if (guideTabID == -1)
-                tabRC = fv->addFITS(&fileURL, FITS_GUIDE, captureFilter);
-            else if (fv->updateFITS(&fileURL, guideTabID, captureFilter) == false)
-            {
-                fv->removeFITS(guideTabID);
-                tabRC = fv->addFITS(&fileURL, FITS_GUIDE, captureFilter);
-            }
-            else
-                tabRC = guideTabID;
+            emit newImage(fv->getView(guideTabID)->getPreviewImage(), targetChip);
+        }
+        else
+        {
+            emit newExposureValue(targetChip, 0, IPS_ALERT);
+            return;
+        }
+        break;
 
-            if (tabRC >= 0)
-            {
-                guideTabID = tabRC;
-                targetChip->setImage(fv->getView(guideTabID), FITS_GUIDE);
+    case FITS_CALIBRATE:
+        if (calibrationTabID == -1)
+            tabRC = fv->addFITS(&fileURL, FITS_CALIBRATE, captureFilter, QString(), true, QByteArray(), data);
+        else if (fv->updateFITS(&fileURL, calibrationTabID, captureFilter, true, QByteArray(), data) == false)
+        {
+            fv->removeFITS(calibrationTabID);
+            tabRC = fv->addFITS(&fileURL, FITS_CALIBRATE, captureFilter, QString(), true, QByteArray(), data);
+        }
+        else
+            tabRC = calibrationTabID;
 
-                emit newImage(fv->getView(guideTabID)->getDisplayImage(), targetChip);
-            }
-            else
-            {
-                emit newExposureValue(targetChip, 0, IPS_ALERT);
-                return;
-            }
-            break;
+        if (tabRC >= 0)
+        {
+            calibrationTabID = tabRC;
+            targetChip->setImage(fv->getView(calibrationTabID), FITS_CALIBRATE);
+        }
+        else
+        {
+            emit newExposureValue(targetChip, 0, IPS_ALERT);
+            return;
+        }
+        break;
 
-        case FITS_CALIBRATE:
-            if (calibrationTabID == -1)
-                tabRC = fv->addFITS(&fileURL, FITS_CALIBRATE, captureFilter);
-            else if (fv->updateFITS(&fileURL, calibrationTabID, captureFilter) == false)
-            {
-                fv->removeFITS(calibrationTabID);
-                tabRC = fv->addFITS(&fileURL, FITS_CALIBRATE, captureFilter);
-            }
-            else
-                tabRC = calibrationTabID;
+     case FITS_ALIGN:
+        if (alignTabID == -1)
+            tabRC = fv->addFITS(&fileURL, FITS_ALIGN, captureFilter, QString(), true, QByteArray(), data);
+        else if (fv->updateFITS(&fileURL, alignTabID, captureFilter, true, QByteArray(), data) == false)
+        {
+            fv->removeFITS(alignTabID);
+            tabRC = fv->addFITS(&fileURL, FITS_ALIGN, captureFilter, QString(), true, QByteArray(), data);
+        }
+        else
+            tabRC = alignTabID;
 
-            if (tabRC >= 0)
-            {
-                calibrationTabID = tabRC;
-                targetChip->setImage(fv->getView(calibrationTabID), FITS_CALIBRATE);
-            }
-            else
-            {
-                emit newExposureValue(targetChip, 0, IPS_ALERT);
-                return;
-            }
-            break;
+        if (tabRC >= 0)
+        {
+            alignTabID = tabRC;
+            targetChip->setImage(fv->getView(alignTabID), FITS_ALIGN);
+        }
+        else
+        {
+            emit newExposureValue(targetChip, 0, IPS_ALERT);
+            return;
+        }
+        break;
 
-         case FITS_ALIGN:
-            if (alignTabID == -1)
-                tabRC = fv->addFITS(&fileURL, FITS_ALIGN, captureFilter);
-            else if (fv->updateFITS(&fileURL, alignTabID, captureFilter) == false)
-            {
-                fv->removeFITS(alignTabID);
-                tabRC = fv->addFITS(&fileURL, FITS_ALIGN, captureFilter);
-            }
-            else
-                tabRC = alignTabID;
 
-            if (tabRC >= 0)
-            {
-                alignTabID = tabRC;
-                targetChip->setImage(fv->getView(alignTabID), FITS_ALIGN);
-            }
-            else
-            {
-                emit newExposureValue(targetChip, 0, IPS_ALERT);
-                return;
-            }
-            break;
+    default:
+        break;
 
+    }
 
-        default:
-            break;
+    fv->show();
 
-        }
+    // The file name may have been overwritten by frames received meanwhile
+    strncpy(BLOBFilename, filename.toLatin1(), MAXINDIFILENAME);
+    bp->aux2 = BLOBFilename;
 
-        fv->show();
+    emit BLOBUpdated(bp);
+#else
+    Q_UNUSED(sequence);
+    Q_UNUSED(data);
+#endif
+}
 
-    }
+void CCD::cancelFrames(CCDChip *targetChip)
+{
+#ifdef HAVE_CFITSIO
+    frameLoader[targetChip->getType()]->cancel();
+    pendingFrames[targetChip->getType()].clear();
+#else
+    Q_UNUSED(targetChip);
 #endif
+}
 
-    emit BLOBUpdated(bp);
+#ifdef HAVE_CFITSIO
+QList<FITSWriter::Keyword> CCD::takeFITSKeywords()
+{
+    QList<FITSWriter::Keyword> keywords;
 
+    if (filter.isEmpty() == false)
+    {
+        FITSWriter::Keyword keyword;
+        keyword.name    = "FILTER";
+        keyword.value   = filter.replace(" ", "_");
+        keyword.comment = "Filter name";
+        keywords.append(keyword);
+
+        filter = "";
+    }
+
+    return keywords;
 }
 
-void CCD::addFITSKeywords(QString filename)
+void CCD::addFITSKeywords(QByteArray *fitsBuffer, const QList<FITSWriter::Keyword> &keywords)
 {
-#ifdef HAVE_CFITSIO
     int status=0;
 
-    if (filter.isEmpty() == false)
-    {
-        QString key_comment("Filter name");
-        filter.replace(" ", "_");
+    if (keywords.isEmpty())
+        return;
 
-        fitsfile* fptr=NULL;
+    // CFITSIO may have to grow the header, so it works on memory it can reallocate.
+    // A delta size of 0 keeps the memory exactly as large as the FITS file.
+    size_t fitsSize = fitsBuffer->size();
+    void *fitsMemory = malloc(fitsSize);
+    if (fitsMemory == NULL)
+        return;
+    memcpy(fitsMemory, fitsBuffer->constData(), fitsSize);
 
-        if (fits_open_image(&fptr, filename.toLatin1(), READWRITE, &status))
-        {
-            fits_report_error(stderr, status);
-            return;
-        }
+    fitsfile* fptr=NULL;
+
+    if (fits_open_memfile(&fptr, "blob", READWRITE, &fitsMemory, &fitsSize, 0, realloc, &status))
+    {
+        fits_report_error(stderr, status);
+        free(fitsMemory);
+        return;
+    }
 
-        if (fits_update_key_str(fptr, "FILTER", filter.toLatin1().data(), key_comment.toLatin1().data(), &status))
+    foreach (const FITSWriter::Keyword &keyword, keywords)
+    {
+        if (fits_update_key_str(fptr, keyword.name.toLatin1().data(), keyword.value.toLatin1().data(), keyword.comment.toLatin1().data(), &status))
         {
             fits_report_error(stderr, status);
+            status=0;
+            fits_close_file(fptr, &status);
+            free(fitsMemory);
             return;
         }
+    }
 
-        fits_close_file(fptr, &status);
+    fits_close_file(fptr, &status);
 
-        filter = "";
-    }
-#endif
+    *fitsBuffer = QByteArray(static_cast<char *>(fitsMemory), fitsSize);
+    free(fitsMemory);
 }
+#endif
 
 void CCD::FITSViewerDestroyed()
 {
@@ -13,15 +13,18 @@
 
 #include "indistd.h"
 
+#include <QHash>
 #include <QStringList>
 #include <QPointer>
 
 #include <fitsviewer/fitsviewer.h>
 #include <fitsviewer/fitsdata.h>
+#include <fitsviewer/fitswriter.h>
 
 #include <auxiliary/imageviewer.h>
 
 class FITSView;
+class FITSAnalyzer;
 
 class StreamWG;
 
@@ -74,6 +77,8 @@ public:
 
     bool isCapturing();
     bool abortExposure();
+    /* Drop the frames of this chip that are received but not loaded yet, so that BLOBUpdated() is not emitted for them */
+    void cancelFrames();
 
     FITSMode getCaptureMode() const { return captureMode;}
     FITSScale getCaptureFilter() const { return captureFilter; }
@@ -165,11 +170,15 @@ public:
     FITSViewer *getViewer() { return fv;}
     CCDChip * getChip(CCDChip::ChipType cType);
     void setFITSDir(const QString &dir) { fitsDir = dir;}
+    void cancelFrames(CCDChip *targetChip);
 
 public slots:
     void FITSViewerDestroyed();
     void StreamWindowHidden();
 
+private slots:
+    void frameLoaded(int sequence, QSharedPointer<FITSData> data);
+
 signals:
     //void FITSViewerClosed();
     void newTemperatureValue(double value);
@@ -179,9 +188,23 @@ signals:
     void newImage(QImage *image, ISD::CCDChip *targetChip);
 
 private:
-    void addFITSKeywords(QString filename);
+    /* Keywords for the header of the image being received, from the settings of the next exposure */
+    QList<FITSWriter::Keyword> takeFITSKeywords();
+    void addFITSKeywords(QByteArray *fitsBuffer, const QList<FITSWriter::Keyword> &keywords);
     QString filter;
 
+    /* FITS frames are loaded on a worker thread, and shown once they are loaded. Then BLOBUpdated() is emitted. */
+    struct PendingFrame
+    {
+        CCDChip *targetChip;
+        IBLOB *bp;
+        QString filename;
+        FITSMode captureMode;
+        FITSScale captureFilter;
+    };
+    FITSAnalyzer *frameLoader[2];                   // By chip type
+    QHash<int, PendingFrame> pendingFrames[2];      // By chip type and sequence number
+
     bool ISOMode;
     bool HasGuideHead;
     bool HasCooler;
@@ -157,12 +157,14 @@ public:
     Q_SCRIPTABLE QByteArray getBLOBData(const QString &device, const QString &property, const QString &blobName, QString &blobFormat, int & size);
 
     /** DBUS interface function. Returns INDI blob filename stored on the local file system.
+    * FITS images that are not saved by a batch capture (previews, focus, guide and alignment frames)
+    * are only kept in memory, so their file name is empty. Use getBLOBData to retrieve those.
     * @param device device name
     * @param property property name
     * @param blobName blob element name
     * @param blobFormat blob element format. It is usually the extension of a file.
     * @param size blob element size in bytes. If -1, then there is an error.
-    * @returns full file name
+    * @returns full file name, or an empty string if the blob was not written to disk
     */
     Q_SCRIPTABLE QString getBLOBFile(const QString &device, const QString &property, const QString &blobName, QString &blobFormat, int & size);
 
@@ -45,6 +45,14 @@ double AzimuthalEquidistantProjector::projectionK(double x) const
     return ( (crad != 0 ) ? crad/sin(crad) : 1 ); // This handles the 0/0 case. The limit of x / sin(x) is 1 as x -> 0.
 }
 
+void AzimuthalEquidistantProjector::projectionKBatch(const double *x, double *k, int n) const
+{
+    for ( int i = 0; i < n; ++i ) {
+        double crad = acos( x[i] );
+        k[i] = ( crad != 0 ) ? crad/sin( crad ) : 1;
+    }
+}
+
 double AzimuthalEquidistantProjector::projectionL(double x) const
 {
     return x;
@@ -37,6 +37,7 @@ public:
     virtual Projection type() const;
     virtual double radius() const;
     virtual double projectionK(double x) const;
+    virtual void projectionKBatch(const double *x, double *k, int n) const;
     virtual double projectionL(double x) const;
 };
 
@@ -19,6 +19,8 @@
 
 #include "equirectangularprojector.h"
 
+#include <QVarLengthArray>
+
 #include "ksutils.h"
 #include "kstarsdata.h"
 #include "skycomponents/skylabeler.h"
@@ -69,6 +71,33 @@ Vector2f EquirectangularProjector::toScreenVec(const SkyPoint* o, bool oRefract,
     return p;
 }
 
+void EquirectangularProjector::toScreenBatch(const double *lon, const double *lat, int n, bool oRefract,
+                                             float *x, float *y, bool *onVisibleHemisphere) const
+{
+    oRefract &= m_vp.useRefraction;
+
+    const double X0   = m_vp.useAltAz ? m_vp.focus->az().radians() : m_vp.focus->ra().radians();
+    const double Y0   = m_vp.useAltAz ? m_vp.focus->alt().radians() : m_vp.focus->dec().radians();
+    const double sign = m_vp.useAltAz ? -1.0 : 1.0;
+    const double zoom = m_vp.zoomFactor;
+
+    if ( oRefract && m_vp.useAltAz ) {
+        QVarLengthArray<double, 256> refracted( n );
+        refractBatch( lat, refracted.data(), n );
+        for ( int i = 0; i < n; ++i )
+            y[i] = 0.5*m_vp.height - zoom*( refracted[i] - Y0 );
+    } else {
+        for ( int i = 0; i < n; ++i )
+            y[i] = 0.5*m_vp.height - zoom*( lat[i] - Y0 );
+    }
+
+    for ( int i = 0; i < n; ++i ) {
+        double dX = KSUtils::reduceAngleBranchFree( sign * ( lon[i] - X0 ) );
+        x[i] = 0.5*m_vp.width - zoom*dX;
+        onVisibleHemisphere[i] = ( x[i] > 0 && x[i] < m_vp.width );
+    }
+}
+
 SkyPoint EquirectangularProjector::fromScreen(const QPointF& p, dms* LST, const dms* lat) const
 {
     SkyPoint result;
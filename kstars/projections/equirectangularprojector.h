@@ -36,6 +36,9 @@ public:
     virtual double radius() const;
     virtual bool unusablePoint( const QPointF& p) const;
     virtual Vector2f toScreenVec(const SkyPoint* o, bool oRefract = true, bool* onVisibleHemisphere = 0) const;
+    using Projector::toScreenBatch;
+    virtual void toScreenBatch(const double *lon, const double *lat, int n, bool oRefract,
+                               float *x, float *y, bool *onVisibleHemisphere) const;
     virtual SkyPoint fromScreen(const QPointF& p, dms* LST, const dms* lat) const;
     virtual QVector< Vector2f > groundPoly(SkyPoint* labelpoint = 0, bool* drawLabel = 0) const;
     virtual void updateClipPoly();
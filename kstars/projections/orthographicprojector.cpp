@@ -41,6 +41,13 @@ double OrthographicProjector::projectionK(double x) const
     return 1.0;
 }
 
+void OrthographicProjector::projectionKBatch(const double *x, double *k, int n) const
+{
+    Q_UNUSED(x);
+    for ( int i = 0; i < n; ++i )
+        k[i] = 1.0;
+}
+
 double OrthographicProjector::projectionL(double x) const
 {
     return asin(x);
@@ -21,11 +21,16 @@
 
 #include <cmath>
 
+#include <QVarLengthArray>
+
 #include "ksutils.h"
 #include "kstarsdata.h"
 #include "skycomponents/skylabeler.h"
 
 namespace {
+    // Number of points toScreenBatch() handles without allocating on the heap
+    const int BatchPrealloc = 256;
+
     void toXYZ(const SkyPoint* p, double *x, double *y, double *z) {
         double sinRa, sinDec, cosRa, cosDec;
 
@@ -502,3 +507,95 @@ Vector2f Projector::toScreenVec(const SkyPoint* o, bool oRefract, bool* onVisibl
     return Vector2f( 0.5*m_vp.width  - m_vp.zoomFactor*k*cosY*sindX,
                      0.5*m_vp.height - m_vp.zoomFactor*k*( m_cosY0*sinY - m_sinY0*cosY*cosdX ) );
 }
+
+void Projector::toScreenBatch( const double *lon, const double *lat, int n, bool oRefract,
+                               float *x, float *y, bool *onVisibleHemisphere ) const
+{
+    if ( n <= 0 )
+        return;
+
+    QVarLengthArray<double, BatchPrealloc> Y( n ), sinY( n ), cosY( n ), sindX( n ), cosdX( n ), c( n ), k( n );
+
+    const double *lat2 = lat;
+    if ( oRefract && m_vp.useRefraction && m_vp.useAltAz ) {
+        refractBatch( lat, Y.data(), n );
+        lat2 = Y.constData();
+    }
+
+    // Azimuth increases in the opposite direction to RA on the screen
+    const double X0   = m_vp.useAltAz ? m_vp.focus->az().radians() : m_vp.focus->ra().radians();
+    const double sign = m_vp.useAltAz ? -1.0 : 1.0;
+
+    for ( int i = 0; i < n; ++i ) {
+        double dX = KSUtils::reduceAngleBranchFree( sign * ( lon[i] - X0 ) );
+        KSUtils::sinCosBranchFree( dX, sindX[i], cosdX[i] );
+        KSUtils::sinCosBranchFree( lat2[i], sinY[i], cosY[i] );
+    }
+
+    //c is the cosine of the angular distance from the center
+    const double cosMax = cosMaxFieldAngle();
+    for ( int i = 0; i < n; ++i ) {
+        c[i] = m_sinY0*sinY[i] + m_cosY0*cosY[i]*cosdX[i];
+        onVisibleHemisphere[i] = ( c[i] > cosMax ); // false for NaN as well
+    }
+
+    projectionKBatch( c.constData(), k.data(), n );
+
+    const double zoom = m_vp.zoomFactor;
+    for ( int i = 0; i < n; ++i ) {
+        x[i] = 0.5*m_vp.width  - zoom*k[i]*cosY[i]*sindX[i];
+        y[i] = 0.5*m_vp.height - zoom*k[i]*( m_cosY0*sinY[i] - m_sinY0*cosY[i]*cosdX[i] );
+    }
+}
+
+void Projector::toScreenBatch( SkyPoint *const *points, int n, bool oRefract,
+                               QPointF *pos, bool *onVisibleHemisphere ) const
+{
+    if ( n <= 0 )
+        return;
+
+    QVarLengthArray<double, BatchPrealloc> lon( n ), lat( n );
+    QVarLengthArray<float, BatchPrealloc> x( n ), y( n );
+
+    if ( m_vp.useAltAz ) {
+        for ( int i = 0; i < n; ++i ) {
+            lon[i] = points[i]->az().radians();
+            lat[i] = points[i]->alt().radians();
+        }
+    } else {
+        for ( int i = 0; i < n; ++i ) {
+            lon[i] = points[i]->ra().radians();
+            lat[i] = points[i]->dec().radians();
+        }
+    }
+
+    toScreenBatch( lon.constData(), lat.constData(), n, oRefract, x.data(), y.data(), onVisibleHemisphere );
+
+    for ( int i = 0; i < n; ++i )
+        pos[i] = QPointF( x[i], y[i] );
+}
+
+void Projector::projectionKBatch( const double *x, double *k, int n ) const
+{
+    for ( int i = 0; i < n; ++i )
+        k[i] = projectionK( x[i] );
+}
+
+void Projector::refractBatch( const double *alt, double *refracted, int n )
+{
+    const double degToRad = dms::DegToRad;
+    const double altCrit  = SkyPoint::altCrit;
+    const double corrCrit = SkyPoint::refractionCorr( altCrit ) * degToRad;
+
+    for ( int i = 0; i < n; ++i ) {
+        double h = alt[i] / degToRad;
+        // SkyPoint::refractionCorr() above altCrit, in radians
+        double hAbove = ( h > altCrit ) ? h : altCrit;
+        double s, c;
+        KSUtils::sinCosBranchFree( degToRad * ( hAbove + 10.3/( hAbove + 5.11 ) ), s, c );
+        double corr = ( 1.02/60.0 ) * degToRad * c / s;
+        // Linear extrapolation from corrCrit at altCrit to 0 at -90 degrees below
+        double corrBelow = corrCrit * ( h + 90.0 ) / ( altCrit + 90.0 );
+        refracted[i] = alt[i] + ( ( h > altCrit ) ? corr : corrBelow );
+    }
+}
@@ -125,6 +125,43 @@ public:
                       bool oRefract = true,
                       bool* onVisibleHemisphere = 0) const;
 
+    /** @short Project an array of points in one call.
+     *
+     * This is the batch counterpart of toScreenVec(). The coordinates are read from
+     * contiguous arrays and processed in separate passes, with no virtual call and
+     * no branch per point, so that the compiler can vectorize the trigonometry and
+     * the projection-specific scaling (see projectionKBatch()).
+     *
+     * @param lon array of azimuths (if usesAltAz()) or right ascensions, in radians
+     * @param lat array of altitudes (if usesAltAz()) or declinations, in radians
+     * @param n the number of points
+     * @param oRefract true = use Options::useRefraction() value, as in toScreenVec()
+     * @param x array receiving the n screen pixel x coordinates
+     * @param y array receiving the n screen pixel y coordinates
+     * @param onVisibleHemisphere array receiving, for each point, whether it is on the
+     *   visible part of the Celestial Sphere. Points with non-finite coordinates are
+     *   reported as not visible, and their screen coordinates are meaningless.
+     */
+    virtual void toScreenBatch( const double *lon, const double *lat, int n, bool oRefract,
+                                float *x, float *y, bool *onVisibleHemisphere ) const;
+
+    /** Convenience overload of toScreenBatch() for an array of SkyPoints. The
+     * horizontal or equatorial coordinates of the points are gathered and
+     * projected together; they must already be synchronized.
+     * @param points array of n points
+     * @param n the number of points
+     * @param oRefract true = use Options::useRefraction() value
+     * @param pos array receiving the n screen positions
+     * @param onVisibleHemisphere array receiving the n visibility flags
+     */
+    void toScreenBatch( SkyPoint *const *points, int n, bool oRefract,
+                        QPointF *pos, bool *onVisibleHemisphere ) const;
+
+    /** @return true if this projector works in horizontal coordinates, i.e.
+     * toScreenBatch() expects arrays of azimuth and altitude.
+     */
+    inline bool usesAltAz() const { return m_vp.useAltAz; }
+
     /** @short Determine RA, Dec coordinates of the pixel at (dx, dy), which are the
      * screen pixel coordinate offsets from the center of the Sky pixmap.
      * @param the screen pixel position to convert
@@ -248,6 +285,19 @@ protected:
         */
     virtual double projectionL(double x) const { return x; }
 
+    /** Batch version of projectionK() used by toScreenBatch(): fills k[i]
+        with projectionK(x[i]) for the n elements. The default implementation
+        calls projectionK() for each element; projections reimplement it with
+        an inline loop that the compiler can vectorize.
+        */
+    virtual void projectionKBatch(const double *x, double *k, int n) const;
+
+    /** Batch version of SkyPoint::refract() used by toScreenBatch(), with
+        altitudes in radians. It uses the same closed form, without branches
+        or calls to the math library, so that the loop can be vectorized.
+        */
+    static void refractBatch(const double *alt, double *refracted, int n);
+
     /** This function returns the cosine of the maximum field angle,
         i.e., the maximum angular distance from the focus for
         which a point should be projected.
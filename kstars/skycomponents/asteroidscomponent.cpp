@@ -30,6 +30,7 @@
 #include "solarsystemcomposite.h"
 #include "skycomponent.h"
 #include "skylabeler.h"
+#include "skymesh.h"
 #ifndef KSTARS_LITE
 #include "skymap.h"
 #else
@@ -54,6 +55,18 @@ bool AsteroidsComponent::selected() {
     return Options::showAsteroids();
 }
 
+double AsteroidsComponent::magnitudeLimit() const {
+    return Options::magLimitAsteroid();
+}
+
+// The phase term of the magnitude only makes the asteroid fainter
+bool AsteroidsComponent::magnitudeElements( const SkyObject *o, double &q, double &H ) const {
+    const KSAsteroid *ast = static_cast<const KSAsteroid*>( o );
+    q = ast->getPerihelion();
+    H = ast->getAbsoluteMagnitude();
+    return true;
+}
+
 /*
  *@short Initialize the asteroids list.
  *Reads in the asteroids data from the asteroids.dat file.
@@ -192,6 +205,8 @@ void AsteroidsComponent::loadData()
         objectNames(SkyObject::ASTEROID).append(name);
         objectLists( SkyObject::ASTEROID ).append(QPair<QString, const SkyObject*>(name,new_asteroid));
     }
+
+    resetBodies();
 }
 
 
@@ -214,43 +229,31 @@ void AsteroidsComponent::draw( SkyPainter *skyp )
 
     skyp->setBrush( QBrush( QColor( "gray" ) ) );
 
-    foreach ( SkyObject *so, m_ObjectList ) {
-        // FIXME: God help us!
-        KSAsteroid *ast = (KSAsteroid*) so;
-
-        if ( ast->mag() > Options::magLimitAsteroid() || std::isnan(ast->mag()) != 0)
+    MeshIterator region( m_skyMesh, DRAW_BUF );
+    while ( region.hasNext() ) {
+        BodyIndex::const_iterator it = bodyIndex().constFind( region.next() );
+        if ( it == bodyIndex().constEnd() )
             continue;
 
-        bool drawn = false;
-
-        if (ast->image().isNull() == false)
-            drawn = skyp->drawPlanet(ast);
-        else
-            drawn = skyp->drawPointSource(ast,ast->mag());
+        foreach ( KSPlanetBase *so, it.value() ) {
+            // FIXME: God help us!
+            KSAsteroid *ast = (KSAsteroid*) so;
 
-        if ( drawn && !( hideLabels || ast->mag() >= labelMagLimit ) )
-            SkyLabeler::AddLabel( ast, SkyLabeler::ASTEROID_LABEL );
+            if ( ast->mag() > Options::magLimitAsteroid() || std::isnan(ast->mag()) != 0)
+                continue;
 
-    }
-#endif
-}
-
-SkyObject* AsteroidsComponent::objectNearest( SkyPoint *p, double &maxrad ) {
-    SkyObject *oBest = 0;
+            bool drawn = false;
 
-    if ( ! selected() ) return 0;
+            if (ast->image().isNull() == false)
+                drawn = skyp->drawPlanet(ast);
+            else
+                drawn = skyp->drawPointSource(ast,ast->mag());
 
-    foreach ( SkyObject *o, m_ObjectList ) {
-        if ( o->mag() > Options::magLimitAsteroid() ) continue;
-
-        double r = o->angularDistanceTo( p ).Degrees();
-        if ( r < maxrad ) {
-            oBest = o;
-            maxrad = r;
+            if ( drawn && !( hideLabels || ast->mag() >= labelMagLimit ) )
+                SkyLabeler::AddLabel( ast, SkyLabeler::ASTEROID_LABEL );
         }
     }
-
-    return oBest;
+#endif
 }
 
 void AsteroidsComponent::updateDataFile()
@@ -46,7 +46,6 @@ public:
     virtual ~AsteroidsComponent();
     virtual void draw( SkyPainter *skyp );
     virtual bool selected();
-    virtual SkyObject* objectNearest( SkyPoint *p, double &maxrad );
     void updateDataFile();
     QString ans();
 
@@ -54,6 +53,10 @@ protected slots:
     void downloadReady();
     void downloadError(const QString &errorString);
 
+protected:
+    virtual double magnitudeLimit() const;
+    virtual bool magnitudeElements( const SkyObject *o, double &q, double &H ) const;
+
 private:
     void loadData();
     FileDownloader* downloadJob;
@@ -56,6 +56,8 @@ public:
      */
     virtual void draw( SkyPainter *skyp );
 
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation; }
+
     virtual void update( KSNumbers *num );
 
     /** @return the name of the catalog */
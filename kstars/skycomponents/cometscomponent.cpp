@@ -37,6 +37,7 @@
 #include "kstarslite.h"
 #endif
 #include "skylabeler.h"
+#include "skymesh.h"
 #include "skypainter.h"
 #include "projections/projector.h"
 #include "auxiliary/filedownloader.h"
@@ -179,6 +180,8 @@ void CometsComponent::loadData() {
         objectNames( SkyObject::COMET ).append( com->name() );
         objectLists( SkyObject::COMET ).append(QPair<QString, const SkyObject*>(com->name(),com));
     }
+
+    resetBodies();
 }
 
 void CometsComponent::draw( SkyPainter *skyp )
@@ -197,14 +200,21 @@ void CometsComponent::draw( SkyPainter *skyp )
     skyp->setPen( QPen( QColor( "darkcyan" ) ) );
     skyp->setBrush( QBrush( QColor( "darkcyan" ) ) );
 
-    foreach ( SkyObject *so, m_ObjectList ) {
-        KSComet *com = (KSComet*)so;
-        double mag= com->mag();
-        if (std::isnan(mag) == 0)
-        {
-            bool drawn = skyp->drawPointSource(com,mag);
-            if ( drawn && !(hideLabels || com->rsun() >= rsunLabelLimit) )
-                SkyLabeler::AddLabel( com, SkyLabeler::COMET_LABEL );
+    MeshIterator region( m_skyMesh, DRAW_BUF );
+    while ( region.hasNext() ) {
+        BodyIndex::const_iterator it = bodyIndex().constFind( region.next() );
+        if ( it == bodyIndex().constEnd() )
+            continue;
+
+        foreach ( KSPlanetBase *so, it.value() ) {
+            KSComet *com = (KSComet*)so;
+            double mag= com->mag();
+            if (std::isnan(mag) == 0)
+            {
+                bool drawn = skyp->drawPointSource(com,mag);
+                if ( drawn && !(hideLabels || com->rsun() >= rsunLabelLimit) )
+                    SkyLabeler::AddLabel( com, SkyLabeler::COMET_LABEL );
+            }
         }
     }
 #endif
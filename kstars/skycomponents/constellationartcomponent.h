@@ -66,6 +66,7 @@ public:
     void showList();
 
     virtual void draw( SkyPainter *skyp );
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation; }
 
     QList<ConstellationsArt*> m_ConstList;
 
@@ -57,6 +57,7 @@ public:
     QString constellationName( SkyPoint *p );
 
     virtual bool selected();
+    virtual int drawDependencies() const { return DependsOnSkyRotation; }
 
     virtual void preDraw( SkyPainter *skyp );
 private:
@@ -51,6 +51,7 @@ public:
     void reindex( KSNumbers *num );
 
     virtual bool selected();
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation; }
 
 protected:
     const IndexHash& getIndexHash(LineList* lineList );
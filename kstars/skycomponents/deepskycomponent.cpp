@@ -19,6 +19,7 @@
 
 #include <QDir>
 #include <QFile>
+#include <QVarLengthArray>
 
 #include <KLocalizedString>
 #include <QStandardPaths>
@@ -378,6 +379,12 @@ void DeepSkyComponent::appendIndex( DeepSkyObject *o, DeepSkyIndex* dsIndex, Tri
 void DeepSkyComponent::draw( SkyPainter *skyp )
 {
 #ifndef KSTARS_LITE
+    // The labels are kept until the next draw() rather than cleared in
+    // drawLabels(), so that they can be drawn again when the sky map
+    // reuses a cached image of this component.
+    for ( int i = 0; i <= MAX_LINENUMBER_MAG; i++ )
+        m_labelList[ i ]->clear();
+
     if ( ! selected() ) return;
 
     bool drawFlag;
@@ -413,7 +420,6 @@ void DeepSkyComponent::drawDeepSkyCatalog( SkyPainter *skyp, bool drawObject,
     if ( ! ( drawObject || drawImage ) ) return;
 
     SkyMap *map = SkyMap::Instance();
-    const Projector *proj = map->projector();
     KStarsData *data = KStarsData::Instance();
 
     UpdateID updateID = data->updateID();
@@ -445,11 +451,19 @@ void DeepSkyComponent::drawDeepSkyCatalog( SkyPainter *skyp, bool drawObject,
     //DrawID drawID = m_skyMesh->drawID();
     MeshIterator region( m_skyMesh, DRAW_BUF );
 
+    // Objects passing the size and magnitude criteria are collected per trixel
+    // and drawn with a single drawDeepSkyObjects() call.
+    QVarLengthArray<DeepSkyObject*, 128> objs;
+    QVarLengthArray<QPointF, 128> screen;
+    QVarLengthArray<bool, 128> drawn;
+
     while ( region.hasNext() ) {
 
         Trixel trixel = region.next();
         DeepSkyList* dsList = dsIndex->value( trixel );
         if ( dsList == 0 ) continue;
+        objs.resize( dsList->size() );
+        int nObjs = 0;
         for (int j = 0; j < dsList->size(); j++ ) {
             DeepSkyObject *obj = dsList->at( j );
 
@@ -473,13 +487,19 @@ void DeepSkyComponent::drawDeepSkyCatalog( SkyPainter *skyp, bool drawObject,
             bool sizeCriterion = (size > 1.0 || Options::zoomFactor() > 2000.);
             bool magCriterion = ( mag < (float)maglim ) || ( showUnknownMagObjects && ( std::isnan( mag ) || mag > 36.0 ) );
             if ( sizeCriterion && magCriterion )
-            {
+                objs[ nObjs++ ] = obj;
+        }
 
-                bool drawn = skyp->drawDeepSkyObject(obj, drawImage);
-                if ( drawn  && !( m_hideLabels || mag > labelMagLim ) )
-                    addLabel( proj->toScreen(obj), obj );
-                    //FIXME: find a better way to do above
-            }
+        screen.resize( nObjs );
+        drawn.resize( nObjs );
+        skyp->drawDeepSkyObjects( objs.constData(), nObjs, drawImage, screen.data(), drawn.data() );
+
+        if ( m_hideLabels )
+            continue;
+        for ( int j = 0; j < nObjs; ++j ) {
+            //FIXME: find a better way to do this
+            if ( drawn[ j ] && !( objs[ j ]->mag() > labelMagLim ) )
+                addLabel( screen[ j ], objs[ j ] );
         }
     }
 #else
@@ -516,7 +536,6 @@ void DeepSkyComponent::drawLabels()
         for ( int j = 0; j < list->size(); j++ ) {
             labeler->drawNameLabel(list->at(j).obj, list->at(j).o);
         }
-        list->clear();
     }
 #endif
 }
@@ -70,8 +70,10 @@ public:
 
     virtual void draw( SkyPainter *skyp );
 
-    /** @short draw all the labels in the prioritized LabelLists and then
-     * clear the LabelLists.
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation; }
+
+    /** @short draw all the labels in the prioritized LabelLists. The
+     * LabelLists are cleared by the next call to draw().
      */
     void drawLabels();
 
@@ -24,6 +24,9 @@
 #include <QRectF>
 #include <QFontMetricsF>
 
+#include <cmath>
+#include <cstring>
+
 //NOTE Added this for QT_FSEEK, should we be including another file?
 #include <qplatformdefs.h>
 
@@ -37,18 +40,25 @@
 #include "binfilehelper.h"
 #include "starblockfactory.h"
 #include "starcomponent.h"
+#include "starblockprefetcher.h"
 #include "projections/projector.h"
 
 #include "skypainter.h"
 
 #include "byteorder.h"
 
+// How many draw cycles ahead the slew direction is extrapolated for prefetching
+#define PREFETCH_LEAD 3.0
+
 DeepStarComponent::DeepStarComponent( SkyComposite *parent, QString fileName, float trigMag, bool staticstars ) :
     ListComponent(parent),
     m_reindexNum( J2000 ),
     triggerMag( trigMag ),
     m_FaintMagnitude(-5.0),
     staticStars( staticstars ),
+    m_prefetcher( 0 ),
+    m_lastFocusRA( 0.0 ),
+    m_lastFocusDec( 0.0 ),
     dataFileName( fileName )
 {
     fileOpened = false;
@@ -101,6 +111,9 @@ bool DeepStarComponent::loadStaticStars() {
     if( htm_level != m_skyMesh->level() )
         qDebug() << "WARNING: HTM Level in shallow star data file and HTM Level in m_skyMesh do not match. EXPECT TROUBLE" << endl;
 
+    bool largeRecords = ( starReader.guessRecordSize() == 32 );
+    bool byteswap = starReader.getByteSwap();
+
     for(Trixel i = 0; i < (unsigned int)m_skyMesh->size(); ++i) {
 
         Trixel trixel = i;
@@ -109,39 +122,49 @@ bool DeepStarComponent::loadStaticStars() {
             qDebug() << "ERROR: Could not allocate new StarBlock to hold shallow unnamed stars for trixel " << trixel << endl;
         m_starBlockList.at( trixel )->setStaticBlock( SB );
 
+        // Use the records straight from the mapped file if we can; otherwise read them in one by one
+        const char *record = starReader.getMappedRecords( i );
+        if( !record && starReader.isMapped() )
+            BinFileHelper::unsigned_KDE_fseek( dataFile, starReader.getOffset( i ), SEEK_SET );
+
         for(unsigned long j = 0; j < (unsigned long) starReader.getRecordCount(i); ++j) {
-            bool fread_success = false;
-            if( starReader.guessRecordSize() == 32 )
-                fread_success = fread( &stardata, sizeof( starData ), 1, dataFile );
-            else if( starReader.guessRecordSize() == 16 )
-                fread_success = fread( &deepstardata, sizeof( deepStarData ), 1, dataFile );
-
-            if( !fread_success ) {
-                qDebug() << "ERROR: Could not read starData structure for star #" << j << " under trixel #" << trixel << endl;
-            }
+            const starData *sdata = &stardata;
+            const deepStarData *dsdata = &deepstardata;
 
-            /* Swap Bytes when required */
-            if( starReader.getByteSwap() ) {
-                if( starReader.guessRecordSize() == 32 )
-                    byteSwap( &stardata );
+            if( record ) {
+                if( largeRecords )
+                    sdata = mappedRecord( record, &stardata, byteswap );
                 else
-                    byteSwap( &deepstardata );
+                    dsdata = mappedRecord( record, &deepstardata, byteswap );
+                record += starReader.guessRecordSize();
+            }
+            else {
+                bool fread_success = false;
+                if( largeRecords )
+                    fread_success = fread( &stardata, sizeof( starData ), 1, dataFile );
+                else
+                    fread_success = fread( &deepstardata, sizeof( deepStarData ), 1, dataFile );
+
+                if( !fread_success ) {
+                    qDebug() << "ERROR: Could not read starData structure for star #" << j << " under trixel #" << trixel << endl;
+                }
+
+                /* Swap Bytes when required */
+                if( byteswap ) {
+                    if( largeRecords )
+                        byteSwap( &stardata );
+                    else
+                        byteSwap( &deepstardata );
+                }
             }
 
             /* Initialize star with data just read. */
+#ifdef KSTARS_LITE
             StarObject* star;
-            if( starReader.guessRecordSize() == 32 )
-        #ifdef KSTARS_LITE
-                star = &(SB->addStar( stardata )->star);
-        #else
-                star = SB->addStar( stardata );
-        #endif
+            if( largeRecords )
+                star = &(SB->addStar( *sdata )->star);
             else
-        #ifdef KSTARS_LITE
-                star = &(SB->addStar( stardata )->star);
-        #else
-                star = SB->addStar( deepstardata );
-        #endif
+                star = &(SB->addStar( *dsdata )->star);
             if( star ) {
                 KStarsData* data = KStarsData::Instance();
                 star->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
@@ -150,6 +173,18 @@ bool DeepStarComponent::loadStaticStars() {
             } else {
                 qDebug() << "CODE ERROR: More unnamed static stars in trixel " << trixel << " than we allocated space for!" << endl;
             }
+#else
+            // Only the stars that can be looked up by their HD number need a StarObject now
+            bool added = largeRecords ? SB->appendStar( *sdata ) : SB->appendStar( *dsdata );
+            if( !added )
+                qDebug() << "CODE ERROR: More unnamed static stars in trixel " << trixel << " than we allocated space for!" << endl;
+            else if( largeRecords && sdata->HD != 0 ) {
+                StarObject *star = SB->star( SB->getStarCount() - 1 );
+                KStarsData* data = KStarsData::Instance();
+                star->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
+                m_CatalogNumber.insert( star->getHDIndex(), star );
+            }
+#endif
         }
     }
 
@@ -157,6 +192,8 @@ bool DeepStarComponent::loadStaticStars() {
 }
 
 DeepStarComponent::~DeepStarComponent() {
+  // Stop reading ahead before the file goes away
+  delete m_prefetcher;
   if( fileOpened )
     starReader.closeFile();
   fileOpened = false;
@@ -197,8 +234,13 @@ void DeepStarComponent::draw( SkyPainter *skyp ) {
     StarObject::starsUpdated = 0;
 #endif
     SkyMap *map = SkyMap::Instance();
-    KStarsData* data = KStarsData::Instance();
-    UpdateID updateID = data->updateID();
+
+    // Scratch buffers used to hand the stars of one trixel to the painter at once
+    QVector<SkyPoint> starPoints;
+    QVector<SkyPoint*> starPointers;
+    QVector<float> starMags;
+    QVector<char> starSpTypes;
+    QVector<bool> starsDrawn;
 
     //FIXME_FOV -- maybe not clamp like that...
     float radius = map->projector()->fov();
@@ -284,7 +326,19 @@ void DeepStarComponent::draw( SkyPainter *skyp ) {
         // TODO: Is there a better way? We may have to change the magnitude tolerance if the catalog changes
         // Static stars need not execute fillToMag
 
-	if( !staticStars && !m_starBlockList.at( currentRegion )->fillToMag( maglim ) && maglim <= m_FaintMagnitude * ( 1 - 1.5/16 ) ) {
+        if( !staticStars && m_prefetcher ) {
+            // Never wait for the disk here: use what has been read ahead so far, and queue the rest
+            StarBlockList *sbl = m_starBlockList.at( currentRegion );
+            if( !sbl->isFilledToMag( maglim ) ) {
+                QByteArray records;
+                quint32 offset;
+                if( m_prefetcher->take( currentRegion, records, offset ) )
+                    sbl->fillToMag( maglim, records, offset );
+                if( !sbl->isFilledToMag( maglim ) )
+                    sbl->prefetch( m_prefetcher, maglim );
+            }
+        }
+	else if( !staticStars && !m_starBlockList.at( currentRegion )->fillToMag( maglim ) && maglim <= m_FaintMagnitude * ( 1 - 1.5/16 ) ) {
             qDebug() << "SBL::fillToMag( " << maglim << " ) failed for trixel "
                      << currentRegion << " !"<< endl;
 	}
@@ -294,35 +348,57 @@ void DeepStarComponent::draw( SkyPainter *skyp ) {
         //        qDebug() << "Drawing SBL for trixel " << currentRegion << ", SBL has "
         //                 <<  m_starBlockList[ currentRegion ]->getBlockCount() << " blocks" << endl;
 
-        for( int i = 0; i < m_starBlockList.at( currentRegion )->getBlockCount(); ++i ) {
-            StarBlock *block = m_starBlockList.at( currentRegion )->block( i );
+        StarBlockList *sbl = m_starBlockList.at( currentRegion );
+        int maxStars = 0;
+        for( int i = 0; i < sbl->getBlockCount(); ++i )
+            maxStars += sbl->block( i )->getStarCount();
+        if( starPoints.size() < maxStars ) {
+            starPoints.resize( maxStars );
+            starPointers.resize( maxStars );
+            starMags.resize( maxStars );
+            starSpTypes.resize( maxStars );
+            starsDrawn.resize( maxStars );
+        }
+
+        int nStars = 0;
+        for( int i = 0; i < sbl->getBlockCount(); ++i ) {
+            StarBlock *block = sbl->block( i );
             //            qDebug() << "---> Drawing stars from block " << i << " of trixel " <<
             //                currentRegion << ". SB has " << block->getStarCount() << " stars" << endl;
-            for( int j = 0; j < block->getStarCount(); j++ ) {
-
-                StarObject *curStar = block->star( j );
-
-                //                qDebug() << "We claim that he's from trixel " << currentRegion
-                //<< ", and indexStar says he's from " << m_skyMesh->indexStar( curStar );
+            // Update the whole block at once; StarObjects are only initialized when needed elsewhere
+            block->JITupdate();
 
-                if ( curStar->updateID != updateID )
-                    curStar->JITupdate();
+            for( int j = 0; j < block->getStarCount(); j++ ) {
 
-                float mag = curStar->mag();
+                float mag = block->mag( j );
 
                 if ( mag > maglim )
                     break;
 
-                if( skyp->drawPointSource(curStar, mag, curStar->spchar() ) )
-                    visibleStarCount++;
+                block->toSkyPoint( j, &starPoints[ nStars ] );
+                starPointers[ nStars ] = &starPoints[ nStars ];
+                starMags[ nStars ] = mag;
+                starSpTypes[ nStars ] = block->spchar( j );
+                ++nStars;
             }
         }
 
+        skyp->drawPointSources( starPointers.constData(), starMags.constData(), starSpTypes.constData(), nStars,
+                                0, starsDrawn.data() );
+        for( int j = 0; j < nStars; ++j ) {
+            if( starsDrawn[ j ] )
+                visibleStarCount++;
+        }
+
         // DEBUG: Uncomment to identify problems with Star Block Factory / preservation of Magnitude Order in the LRU Cache
         //        verifySBLIntegrity();
         t_drawUnnamed += t.restart();
 
     }
+
+    if( m_prefetcher )
+        prefetchAhead( focus, radius, maglim );
+
     m_skyMesh->inDraw( false );
 #ifdef PROFILE_SINCOS
     trig_calls_here += dms::trig_function_calls;
@@ -343,6 +419,52 @@ void DeepStarComponent::draw( SkyPainter *skyp ) {
 #endif
 }
 
+void DeepStarComponent::prefetchAhead( SkyPoint *focus, float radius, float maglim ) {
+    double ra = focus->ra().Degrees();
+    double dec = focus->dec().Degrees();
+    double dRA = ra - m_lastFocusRA;
+    double dDec = dec - m_lastFocusDec;
+
+    m_lastFocusRA = ra;
+    m_lastFocusDec = dec;
+
+    if( dRA > 180.0 )
+        dRA -= 360.0;
+    else if( dRA < -180.0 )
+        dRA += 360.0;
+
+    if( dRA == 0.0 && dDec == 0.0 )
+        return;
+
+    // After a jump (eg: centering on a new object), whatever was queued is of no use anymore
+    if( fabs( dRA ) * cos( dec * dms::DegToRad ) + fabs( dDec ) > 2.0 * radius ) {
+        m_prefetcher->clearPending();
+        return;
+    }
+
+    ra += PREFETCH_LEAD * dRA;
+    dec += PREFETCH_LEAD * dDec;
+    if( ra < 0.0 )
+        ra += 360.0;
+    else if( ra >= 360.0 )
+        ra -= 360.0;
+    if( dec > 90.0 )
+        dec = 90.0;
+    else if( dec < -90.0 )
+        dec = -90.0;
+
+    // NOTE: We use intersect() rather than aperture() so as to not bump the drawID
+    // in the middle of a draw. The extra degree covers the precession to J2000.
+    m_skyMesh->intersect( ra, dec, radius + 1.0, (BufNum) PREFETCH_BUF );
+
+    MeshIterator region( m_skyMesh, PREFETCH_BUF );
+    while( region.hasNext() ) {
+        StarBlockList *sbl = m_starBlockList.at( region.next() );
+        if( !sbl->isFilledToMag( maglim ) )
+            sbl->prefetch( m_prefetcher, maglim );
+    }
+}
+
 bool DeepStarComponent::openDataFile() {
 
     if( starReader.getFileHandle() )
@@ -377,6 +499,18 @@ bool DeepStarComponent::openDataFile() {
         fread( &MSpT, 2, 1, starReader.getFileHandle() );
         if( starReader.getByteSwap() )
             MSpT = bswap_16( MSpT );
+        if( !starReader.mapFile() )
+            qDebug() << "Could not memory-map " << dataFileName << ", falling back to buffered reads";
+#ifndef KSTARS_LITE
+        if( !staticStars ) {
+            m_prefetcher = new StarBlockPrefetcher( starReader.getFilePath(), starReader.guessRecordSize(), starReader.getByteSwap() );
+            // Redraw once the stars we could not draw for lack of data have been read
+            QObject::connect( m_prefetcher, &StarBlockPrefetcher::recordsReady, m_prefetcher, []() {
+                if( SkyMap::Instance() )
+                    SkyMap::Instance()->forceLayerUpdate( SkyComponent::DependsOnLoadedData );
+            } );
+        }
+#endif
         fileOpened = true;
         qDebug() << "  Sky Mesh Size: " << m_skyMesh->size();
         for (long int i = 0; i < m_skyMesh->size(); i++) {
@@ -423,12 +557,9 @@ SkyObject* DeepStarComponent::objectNearest( SkyPoint *p, double &maxrad )
         Trixel currentRegion = region.next();
         for( int i = 0; i < m_starBlockList.at( currentRegion )->getBlockCount(); ++i ) {
             StarBlock *block = m_starBlockList.at( currentRegion )->block( i );
-            for( int j = 0; j < block->getStarCount(); ++j ) {
 #ifdef KSTARS_LITE
+            for( int j = 0; j < block->getStarCount(); ++j ) {
                 StarObject* star =  &(block->star( j )->star);
-#else
-                StarObject* star =  block->star( j );
-#endif
                 if( !star ) continue;
                 if ( star->mag() > m_zoomMagLimit ) continue;
 
@@ -438,6 +569,22 @@ SkyObject* DeepStarComponent::objectNearest( SkyPoint *p, double &maxrad )
                     maxrad = r;
                 }
             }
+#else
+            // Only the nearest star gets a StarObject
+            block->JITupdate();
+            int jBest = -1;
+            for( int j = 0; j < block->getStarCount(); ++j ) {
+                if ( block->mag( j ) > m_zoomMagLimit ) continue;
+
+                double r = block->angularDistanceTo( j, p );
+                if ( r < maxrad ) {
+                    jBest = j;
+                    maxrad = r;
+                }
+            }
+            if( jBest >= 0 )
+                oBest = block->star( jBest );
+#endif
         }
     }
 
@@ -482,17 +629,24 @@ bool DeepStarComponent::starsInAperture( QList<StarObject *> &list, const SkyPoi
         sbl->fillToMag( maglim );
         for( int i = 0; i < sbl->getBlockCount(); ++i ) {
             StarBlock *block = sbl->block( i );
-            for( int j = 0; j < block->getStarCount(); ++j ) {
 #ifdef KSTARS_LITE
+            for( int j = 0; j < block->getStarCount(); ++j ) {
                 StarObject *star = &(block->star( j )->star);
-#else
-                StarObject *star = block->star( j );
-#endif
                 if( star->mag() > maglim )
                     break; // Stars are organized by magnitude, so this should work
                 if( star->angularDistanceTo( &center ).Degrees() <= radius )
                     list.append( star );
             }
+#else
+            // Only the stars in the aperture get a StarObject
+            block->JITupdate();
+            for( int j = 0; j < block->getStarCount(); ++j ) {
+                if( block->mag( j ) > maglim )
+                    break; // Stars are organized by magnitude, so this should work
+                if( block->angularDistanceTo( j, &center ) <= radius )
+                    list.append( block->star( j ) );
+            }
+#endif
         }
     }
 
@@ -519,6 +673,37 @@ void DeepStarComponent::byteSwap( starData *stardata ) {
     stardata->bv_index = bswap_16( stardata->bv_index );
 }
 
+template <typename T>
+static inline const T *mappedRecordImpl( const char *record, T *scratch, bool byteswap ) {
+    if( !byteswap && ( reinterpret_cast<quintptr>( record ) % Q_ALIGNOF( T ) ) == 0 )
+        return reinterpret_cast<const T *>( record );
+    memcpy( scratch, record, sizeof( T ) );
+    if( byteswap )
+        DeepStarComponent::byteSwap( scratch );
+    return scratch;
+}
+
+const deepStarData *DeepStarComponent::mappedRecord( const char *record, deepStarData *scratch, bool byteswap ) {
+    return mappedRecordImpl( record, scratch, byteswap );
+}
+
+const starData *DeepStarComponent::mappedRecord( const char *record, starData *scratch, bool byteswap ) {
+    return mappedRecordImpl( record, scratch, byteswap );
+}
+
+float DeepStarComponent::recordMag( const char *record, quint32 recordSize, bool byteswap ) {
+    if( recordSize == sizeof( starData ) ) {
+        starData stardata;
+        return mappedRecord( record, &stardata, byteswap )->mag / 100.0;
+    }
+
+    deepStarData deepstardata;
+    const deepStarData *data = mappedRecord( record, &deepstardata, byteswap );
+    if( data->V == 30000 && data->B != 30000 )
+        return ( data->B - 1600 ) / 1000.0;
+    return data->V / 1000.0;
+}
+
 bool DeepStarComponent::verifySBLIntegrity() {
     float faintMag = -5.0;
     bool integrity = true;
@@ -45,6 +45,7 @@ class SkyLabeler;
 class BinFileHelper;
 class StarBlockFactory;
 class StarBlockList;
+class StarBlockPrefetcher;
 
 class DeepStarComponent: public ListComponent
 {
@@ -119,9 +120,41 @@ public:
     static void byteSwap( deepStarData *stardata );
     static void byteSwap( starData *stardata );
 
+    /**
+     *@short Access a star record inside a memory-mapped catalog file
+     *@p record Pointer to the record in the mapped file
+     *@p scratch Storage to use when the record cannot be used in place
+     *@p byteswap Whether the record needs to be byte-swapped
+     *@return The record itself if it is suitably aligned and needs no
+     * byte-swapping, otherwise scratch after copying the record into it
+     */
+    static const deepStarData *mappedRecord( const char *record, deepStarData *scratch, bool byteswap );
+    static const starData *mappedRecord( const char *record, starData *scratch, bool byteswap );
+
+    /**
+     *@short The magnitude of a raw star record, as StarBlock stores it
+     *@p record Pointer to the record
+     *@p recordSize Size of the records of the catalog, 32 for starData and 16 for deepStarData
+     *@p byteswap Whether the record needs to be byte-swapped
+     */
+    static float recordMag( const char *record, quint32 recordSize, bool byteswap );
+
     static StarBlockFactory m_StarBlockFactory;
 
 private:
+    /**
+     *@short Queue the trixels that are about to become visible for asynchronous loading
+     *
+     *The direction in which the view is moving is extrapolated from the focus of the
+     *previous draw, and the stars of the trixels in the aperture around the predicted
+     *focus are read ahead on the prefetcher thread.
+     *
+     *@p focus The current focus of the sky map
+     *@p radius The radius of the visible aperture in degrees
+     *@p maglim The magnitude limit to which stars are being drawn
+     */
+    void prefetchAhead( SkyPoint *focus, float radius, float maglim );
+
     SkyMesh*       m_skyMesh;
     KSNumbers      m_reindexNum;
     int            meshLevel;
@@ -145,6 +178,11 @@ private:
 
     bool           staticStars;
 
+    // Asynchronous loading of star blocks, see prefetchAhead()
+    StarBlockPrefetcher *m_prefetcher;
+    double         m_lastFocusRA;    // Focus of the previous draw, in degrees
+    double         m_lastFocusDec;
+
     // Stuff required for reading data
     deepStarData  deepstardata;
     starData      stardata;
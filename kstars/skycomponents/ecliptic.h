@@ -39,6 +39,7 @@ public:
     explicit Ecliptic( SkyComposite *parent );
 
     virtual void draw( SkyPainter *skyp );
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation; }
     virtual void drawCompassLabels();
     virtual bool selected();
 
@@ -41,6 +41,7 @@ public:
 
     virtual bool selected();
     virtual void draw( SkyPainter *skyp );
+    virtual int drawDependencies() const { return DependsOnSkyRotation; }
     virtual void drawCompassLabels();
     virtual LineListLabel* label() {return &m_label;}
 
@@ -41,6 +41,7 @@ public:
     void preDraw( SkyPainter *skyp );
 
     bool selected();
+    virtual int drawDependencies() const { return DependsOnSkyRotation; }
 };
 
 
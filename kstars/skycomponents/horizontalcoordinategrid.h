@@ -43,6 +43,7 @@ public:
     void update( KSNumbers* );
 
     bool selected();
+    virtual int drawDependencies() const { return DependsOnHorizon; }
 };
 
 
@@ -47,6 +47,7 @@ public:
   
     virtual void draw( SkyPainter *skyp );
     virtual bool selected();
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation; }
 
 protected:    
     /** @short Returns an IndexHash from the SkyMesh that contains the set
@@ -86,8 +86,12 @@ void SatellitesComponent::update( KSNumbers * )
     if( ! selected() )
         return;
     
+    // The terms that depend on the time and the observer are computed once for all satellites
+    KStarsData *data = KStarsData::Instance();
+    Satellite::Instant instant( data->clock()->utc().djd(), data->geo() );
+
     foreach( SatelliteGroup *group, m_groups ) {
-        group->updateSatellitesPos();
+        group->updateSatellitesPos( instant );
     }
 }
 
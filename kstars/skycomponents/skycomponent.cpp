@@ -47,6 +47,11 @@ SkyObject* SkyComponent::objectNearest( SkyPoint *, double & ) {
 void SkyComponent::drawTrails( SkyPainter* )
 {}
 
+int SkyComponent::drawDependencies() const
+{
+    return DependsOnEverything;
+}
+
 void SkyComponent::objectsInArea( QList<SkyObject*>&, const SkyRegion& )
 {}
 
@@ -139,6 +139,29 @@ public:
     /** @short Draw trails for objects. */
     virtual void drawTrails( SkyPainter *skyp );
 
+    /**
+     * @short What the appearance of a component on the map depends on.
+     *
+     * The sky map keeps consecutive components in cached layers, and only
+     * redraws a layer when something its components depend on has changed.
+     * The focus, zoom factor, projection and size of the map always matter.
+     */
+    enum DrawDependency {
+        DependsOnEpoch       = 0x01, ///< Precession and nutation epoch, i.e. KStarsData::updateNum()
+        DependsOnSkyRotation = 0x02, ///< Fixed on the celestial sphere, so it turns with the sidereal time in horizontal coordinates
+        DependsOnHorizon     = 0x04, ///< Fixed with respect to the horizon, so it turns with the sidereal time in equatorial coordinates
+        DependsOnTime        = 0x08, ///< Moves with any step of the simulation clock, like the solar system bodies
+        DependsOnLoadedData  = 0x10, ///< Shows data that changes on its own, like the deep star blocks read in the background. See SkyMap::forceLayerUpdate()
+        DependsOnEverything  = 0x1f
+    };
+
+    /**
+     * @return the DrawDependency flags of this component. The default is
+     * DependsOnEverything, which is always correct but never lets the
+     * component be cached across time steps.
+     */
+    virtual int drawDependencies() const;
+
     /**
      * @short Update the sky position(s) of this component.
      *
@@ -71,6 +71,14 @@ void SkyComposite::update( KSNumbers *num )
         component->update( num );
 }
 
+int SkyComposite::drawDependencies() const
+{
+    int dependencies = 0;
+    foreach ( SkyComponent *component, m_Components )
+        dependencies |= component->drawDependencies();
+    return dependencies;
+}
+
 SkyObject* SkyComposite::findByName( const QString &name ) {
     foreach ( SkyComponent *comp, components() ) {
         SkyObject* o = comp->findByName( name );
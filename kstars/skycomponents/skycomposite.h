@@ -71,6 +71,9 @@ public:
      */
     virtual void update( KSNumbers *num=0 );
 
+    /** @return the DrawDependency flags of all sub components combined */
+    virtual int drawDependencies() const;
+
     /** @short Add a new sub component to the composite
      * @p comp Pointer to the SkyComponent to be added
      * @p priority A priority ordering for various operations on the list of all sky components (notably objectNearest())
@@ -389,6 +389,69 @@ void SkyLabeler::draw(QPainter& p)
     //m_p.begin(&m_picture);
 }
 
+#ifndef KSTARS_LITE
+void SkyLabeler::restartPicture( const QPicture &labels, const QFont &font, const QPen &pen )
+{
+    // A QPicture can only be copied or replayed once its painter is done
+    if( m_p.isActive() )
+        m_p.end();
+    m_picture = QPicture();
+    m_p.begin( &m_picture );
+    m_p.drawPicture( 0, 0, labels );
+    m_p.setFont( font );
+    m_p.setPen( pen );
+}
+
+void SkyLabeler::saveState( State *state )
+{
+    state->rows.resize( screenRows.size() );
+    for ( int y = 0; y < screenRows.size(); y++ ) {
+        const LabelRow* row = screenRows[y];
+        QVector<QPoint> &runs = state->rows[y];
+        runs.clear();
+        runs.reserve( row->size() );
+        for ( int i = 0; i < row->size(); i++ )
+            runs.append( QPoint( row->at(i)->start, row->at(i)->end ) );
+    }
+
+    state->marks    = m_marks;
+    state->hits     = m_hits;
+    state->misses   = m_misses;
+    state->elements = m_elements;
+    state->font     = m_p.font();
+    state->pen      = m_p.pen();
+
+    if( m_p.isActive() )
+        m_p.end();
+    state->picture = m_picture;
+    restartPicture( state->picture, state->font, state->pen );
+}
+
+void SkyLabeler::restoreState( const State &state )
+{
+    for ( int y = 0; y < screenRows.size(); y++ ) {
+        LabelRow* row = screenRows[y];
+        for ( int i = 0; i < row->size(); i++ ) {
+            delete row->at(i);
+        }
+        row->clear();
+        if ( y >= state.rows.size() )
+            continue;
+        const QVector<QPoint> &runs = state.rows[y];
+        for ( int i = 0; i < runs.size(); i++ )
+            row->append( new LabelRun( runs[i].x(), runs[i].y() ) );
+    }
+
+    m_marks    = state.marks;
+    m_hits     = state.hits;
+    m_misses   = state.misses;
+    m_elements = state.elements;
+
+    restartPicture( state.picture, state.font, state.pen );
+    m_fontMetrics = QFontMetrics( state.font );
+}
+#endif
+
 // We use Run Length Encoding to hold the information instead of an array of
 // chars.  This is both faster and smaller but the code is more complicated.
 //
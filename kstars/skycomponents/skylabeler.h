@@ -340,6 +340,35 @@ public:
     int hits()  { return m_hits; }
     int marks() { return m_marks; }
 
+#ifndef KSTARS_LITE
+    /**
+     * @short A snapshot of the labels drawn and the regions marked so far.
+     * @see saveState()
+     */
+    struct State {
+        QPicture picture;
+        QVector< QVector<QPoint> > rows;  ///< start and end of each LabelRun
+        QFont font;
+        QPen pen;
+        int marks, hits, misses, elements;
+    };
+
+    /**
+     * @short stores the labels drawn and the regions marked since reset()
+     * in @p state.  Labels drawn afterwards go on top of them as usual.
+     * This lets the sky map reuse a cached image of the components drawn
+     * so far and still get the same labels.
+     */
+    void saveState( State *state );
+
+    /**
+     * @short replaces the labels drawn and the regions marked since reset()
+     * with the ones in @p state, which must have been saved for a sky map of
+     * the same size.  The queued labels are left alone.
+     */
+    void restoreState( const State &state );
+#endif
+
 private:
     ScreenRows screenRows;
 
@@ -370,6 +399,14 @@ private:
 
     QVector<LabelList>   labelList;
 
+#ifndef KSTARS_LITE
+    /**
+     * @short starts a new m_picture that already contains @p labels, and
+     * sets up m_p to draw on it with @p font and @p pen.
+     */
+    void restartPicture( const QPicture &labels, const QFont &font, const QPen &pen );
+#endif
+
     const Projector* m_proj;
 
     static SkyLabeler* pinstance;
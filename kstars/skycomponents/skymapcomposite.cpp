@@ -233,6 +233,22 @@ void SkyMapComposite::updateMoons(KSNumbers *num )
     m_SolarSystem->updateMoons( num );
 }
 
+#ifndef KSTARS_LITE
+/**
+ * @return the combined DrawDependency flags of the components in @p layer
+ * that are going to be drawn
+ */
+static int layerDependencies( const QList<SkyComponent*> &layer )
+{
+    int dependencies = 0;
+    foreach ( SkyComponent *component, layer ) {
+        if ( component->selected() )
+            dependencies |= component->drawDependencies();
+    }
+    return dependencies;
+}
+#endif
+
 //Reimplement draw function so that we have control over the order of
 //elements, and we can add object labels
 //
@@ -299,35 +315,65 @@ void SkyMapComposite::draw( SkyPainter *skyp )
             }
     }
 
-    m_MilkyWay->draw( skyp );
+    // The components are drawn in layers. A layer that does not need to be
+    // redrawn, because nothing its components depend on has changed since
+    // the last draw, is skipped by the painter and taken from its cache.
+    QList<SkyComponent*> layer;
 
-    m_EquatorialCoordinateGrid->draw( skyp );
-    m_HorizontalCoordinateGrid->draw( skyp );
+    layer << m_MilkyWay << m_EquatorialCoordinateGrid;
+    if ( skyp->beginLayer( layerDependencies( layer ) ) ) {
+        m_MilkyWay->draw( skyp );
+        m_EquatorialCoordinateGrid->draw( skyp );
+    }
+    skyp->endLayer();
 
-    //Draw constellation boundary lines only if we draw western constellations
-    if ( m_Cultures->current() == "Western" )
-    {
-        m_CBoundLines->draw( skyp );
-        m_ConstellationArt->draw( skyp );
+    layer.clear();
+    layer << m_HorizontalCoordinateGrid;
+    if ( skyp->beginLayer( layerDependencies( layer ) ) ) {
+        m_HorizontalCoordinateGrid->draw( skyp );
     }
+    skyp->endLayer();
+
+    layer.clear();
+    if ( m_Cultures->current() == "Western" )
+        layer << m_CBoundLines << m_ConstellationArt;
     else if ( m_Cultures->current() == "Inuit" )
-    {
-        m_ConstellationArt->draw( skyp );
-    }
+        layer << m_ConstellationArt;
+    layer << m_CLines << m_Equator << m_Ecliptic << m_DeepSky << m_CustomCatalogs
+          << m_internetResolvedComponent << m_manualAdditionsComponent << m_Stars;
+    if ( skyp->beginLayer( layerDependencies( layer ) ) ) {
+        //Draw constellation boundary lines only if we draw western constellations
+        if ( m_Cultures->current() == "Western" )
+        {
+            m_CBoundLines->draw( skyp );
+            m_ConstellationArt->draw( skyp );
+        }
+        else if ( m_Cultures->current() == "Inuit" )
+        {
+            m_ConstellationArt->draw( skyp );
+        }
 
-    m_CLines->draw( skyp );
+        m_CLines->draw( skyp );
 
-    m_Equator->draw( skyp );
+        m_Equator->draw( skyp );
 
-    m_Ecliptic->draw( skyp );
+        m_Ecliptic->draw( skyp );
 
-    m_DeepSky->draw( skyp );
+        m_DeepSky->draw( skyp );
+        skyp->flush();
 
-    m_CustomCatalogs->draw( skyp );
-    m_internetResolvedComponent->draw( skyp );
-    m_manualAdditionsComponent->draw( skyp );
+        m_CustomCatalogs->draw( skyp );
+        m_internetResolvedComponent->draw( skyp );
+        m_manualAdditionsComponent->draw( skyp );
+
+        m_Stars->draw( skyp );
+        skyp->flush();
+    }
+    skyp->endLayer();
 
-    m_Stars->draw( skyp );
+    // Everything else moves with time or can be changed by the user at any
+    // moment, so it is always drawn.
+    skyp->beginLayer( SkyComponent::DependsOnEverything );
 
     m_SolarSystem->drawTrails( skyp );
     m_SolarSystem->draw( skyp );
@@ -358,6 +404,8 @@ void SkyMapComposite::draw( SkyPainter *skyp )
 
     m_Horizon->draw( skyp );
 
+    skyp->endLayer();
+
     m_skyMesh->inDraw( false );
 
     // DEBUG Edit. Keywords: Trixel boundaries. Currently works only in QPainter mode
@@ -729,6 +777,14 @@ const QList<SkyObject*>& SkyMapComposite::comets() const {
     return m_SolarSystem->comets();
 }
 
+void SkyMapComposite::updateCulledBody( SkyObject *o ) {
+    m_SolarSystem->updateCulledBody( o );
+}
+
+void SkyMapComposite::updateCulledBodies() {
+    m_SolarSystem->updateCulledBodies();
+}
+
 const QList<SkyObject*>& SkyMapComposite::supernovae() const
 {
     return m_Supernovae->objectList();
@@ -212,6 +212,17 @@ public:
     const QList<SkyObject*>& asteroids() const;
     const QList<SkyObject*>& comets() const;
     const QList<SkyObject*>& supernovae() const;
+
+    /** @short Asteroids and comets too faint to be drawn are not computed at each
+     * update. Compute @p o if it is one of them, before using its position.
+     */
+    void updateCulledBody( SkyObject *o );
+
+    /** @short Compute all the asteroids and comets left alone at the last update,
+     * before reading the positions or magnitudes of asteroids() and comets().
+     */
+    void updateCulledBodies();
+
     QList<SkyObject*> planets();
     QList<SkyObject*> moons();
 
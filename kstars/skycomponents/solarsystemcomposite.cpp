@@ -161,6 +161,16 @@ const QList<SkyObject*>& SolarSystemComposite::comets() const {
     return m_CometsComponent->objectList();
 }
 
+void SolarSystemComposite::updateCulledBody( SkyObject *o ) {
+    m_AsteroidsComponent->updateCulledBody( o );
+    m_CometsComponent->updateCulledBody( o );
+}
+
+void SolarSystemComposite::updateCulledBodies() {
+    m_AsteroidsComponent->updateCulledBodies();
+    m_CometsComponent->updateCulledBodies();
+}
+
 const QList<SkyObject*>& SolarSystemComposite::planetObjects() const {
     return m_planetObjects;
 }
@@ -50,6 +50,12 @@ public:
     const QList<SkyObject*>& planetObjects() const;
     const QList<SkyObject*>& moons() const;
 
+    /** @short Compute @p o if it is an asteroid or a comet left alone at the last update */
+    void updateCulledBody( SkyObject *o );
+
+    /** @short Compute the asteroids and the comets left alone at the last update */
+    void updateCulledBodies();
+
     bool selected();
 
     virtual void update( KSNumbers *num );
@@ -18,20 +18,40 @@
 #include "solarsystemlistcomponent.h"
 #include "solarsystemcomposite.h"
 
+#include <cmath>
+#include <limits>
+
 #include <QPen>
+#include <QtConcurrent>
 #include <KLocalizedString>
 
 #include "Options.h"
 #include "skyobjects/ksplanet.h"
 #include "skyobjects/ksplanetbase.h"
 #include "kstarsdata.h"
+#include "ksnumbers.h"
+#include "skymesh.h"
 #ifndef KSTARS_LITE
 #include "skymap.h"
 #endif
 
+// Gaussian gravitational constant, the speed in AU/day of a body on a circular orbit at 1 AU
+#define GAUSS_K             0.01720209895
+// Largest speed of the Earth, in AU/day
+#define EARTH_SPEED         0.0175
+// Aphelion distance of the Earth, in AU
+#define EARTH_APHELION      1.0167
+// Longest time for which a body is left alone, in days
+#define ENVELOPE_MAX_DAYS   1024.0
+// Allowance for slope parameters above 1 and for the topocentric distance
+#define ENVELOPE_MARGIN     0.5
+
 SolarSystemListComponent::SolarSystemListComponent( SolarSystemComposite *p ) :
     ListComponent( p ),
-    m_Earth( p->earth() )
+    m_skyMesh( SkyMesh::Instance() ),
+    m_Earth( p->earth() ),
+    m_EnvelopeLimit( 0.0 ),
+    m_UpdateJD( std::numeric_limits<double>::quiet_NaN() )
 {}
 
 SolarSystemListComponent::~SolarSystemListComponent()
@@ -39,29 +59,215 @@ SolarSystemListComponent::~SolarSystemListComponent()
     //Object deletes handled by parent class (ListComponent)
 }
 
+double SolarSystemListComponent::magnitudeLimit() const {
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+bool SolarSystemListComponent::magnitudeElements( const SkyObject *, double &, double & ) const {
+    return false;
+}
+
+void SolarSystemListComponent::resetBodies() {
+    const int n = m_ObjectList.size();
+    m_Perihelion.resize( n );
+    m_AbsoluteMagnitude.resize( n );
+    m_EnvelopeJD.fill( 0.0, n );
+    m_EnvelopeDays.fill( 0.0, n );
+    m_Active.clear();
+    m_Index.clear();
+    m_Position.clear();
+    m_UpdateJD = std::numeric_limits<double>::quiet_NaN();
+
+    for ( int i=0; i < n; ++i ) {
+        m_Position.insert( m_ObjectList[i], i );
+
+        double q, H;
+        if ( magnitudeElements( m_ObjectList[i], q, H ) == false ) {
+            q = 0.0;
+            H = std::numeric_limits<double>::quiet_NaN();
+        }
+        m_Perihelion[i] = q;
+        m_AbsoluteMagnitude[i] = H;
+    }
+}
+
 void SolarSystemListComponent::update(KSNumbers * ) {
     if ( selected() ) {
         KStarsData *data = KStarsData::Instance(); 
-        foreach ( SkyObject *o, m_ObjectList ) {
-            // FIXME: get rid of cast. 
-            KSPlanetBase *p = (KSPlanetBase*)o;
+        // The bodies left alone are not drawn
+        foreach ( KSPlanetBase *p, m_Active )
             p->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
-        }
     }
 }
 
 void SolarSystemListComponent::updateSolarSystemBodies(KSNumbers *num ) {
-    if ( selected() ) {
-        KStarsData *data = KStarsData::Instance(); 
-        foreach ( SkyObject *o, m_ObjectList ) {
-            KSPlanetBase *p = (KSPlanetBase*)o;
-            p->findPosition( num, data->geo()->lat(), data->lst(), m_Earth );
-            p->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
+    if ( ! selected() )
+        return;
 
-            if ( p->hasTrail() )
-                p->updateTrail( data->lst(), data->geo()->lat() );
+    KStarsData *data = KStarsData::Instance(); 
+    if ( m_Perihelion.size() != m_ObjectList.size() )
+        resetBodies();
+
+    const double jd = num->julianDay();
+    const double limit = magnitudeLimit();
+    if ( std::isnan( limit ) == false && limit != m_EnvelopeLimit ) {
+        m_EnvelopeDays.fill( 0.0 );
+        m_EnvelopeLimit = limit;
+    }
+
+    // The bodies with a trail and the focus are always computed, in this thread as the trail is labelled
+    QList<KSPlanetBase*> serial;
+    QVector<int> parallel;
+    const QString focus = Options::focusObject();
+    for ( int i=0; i < m_ObjectList.size(); ++i ) {
+        KSPlanetBase *p = (KSPlanetBase*)m_ObjectList[i];
+        if ( p->hasTrail() || p->name() == focus ) {
+            serial.append( p );
+            m_EnvelopeJD[i] = jd;
+            m_EnvelopeDays[i] = 0.0;
+        } else if ( fabs( jd - m_EnvelopeJD[i] ) >= m_EnvelopeDays[i] ) {
+            parallel.append( i );
         }
     }
+
+    foreach ( KSPlanetBase *p, serial ) {
+        p->findPosition( num, data->geo()->lat(), data->lst(), m_Earth );
+        p->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
+
+        if ( p->hasTrail() )
+            p->updateTrail( data->lst(), data->geo()->lat() );
+    }
+
+    // Each body only writes to itself and to its own elements
+    QtConcurrent::blockingMap( parallel, [&]( int i ) {
+        computeBody( i, num, limit );
+    } );
+
+    m_UpdateJD = jd;
+    indexBodies( num );
+}
+
+// Compute the body for num, and the number of days during which it may then be left alone
+void SolarSystemListComponent::computeBody( int i, const KSNumbers *num, double limit ) {
+    KStarsData *data = KStarsData::Instance();
+    KSPlanetBase *p = (KSPlanetBase*)m_ObjectList.at( i );
+    p->findPosition( num, data->geo()->lat(), data->lst(), m_Earth );
+    p->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
+
+    m_EnvelopeJD[i] = num->julianDay();
+    m_EnvelopeDays[i] = std::isnan( limit ) ? 0.0 : envelopeDays( i, p, limit );
+}
+
+// Whether the body still has the position of an earlier update
+bool SolarSystemListComponent::isCulled( int i ) const {
+    return std::isnan( m_UpdateJD ) == false && m_EnvelopeJD[i] != m_UpdateJD;
+}
+
+SkyObject* SolarSystemListComponent::findByName( const QString &name ) {
+    SkyObject *o = ListComponent::findByName( name );
+    if ( o )
+        updateCulledBody( o );
+    return o;
+}
+
+void SolarSystemListComponent::updateCulledBody( SkyObject *o ) {
+    QHash<const SkyObject*, int>::const_iterator it = m_Position.constFind( o );
+    if ( it == m_Position.constEnd() || ! isCulled( it.value() ) )
+        return;
+
+    KSNumbers num( m_UpdateJD );
+    computeBody( it.value(), &num, m_EnvelopeLimit );
+}
+
+void SolarSystemListComponent::updateCulledBodies() {
+    QVector<int> culled;
+    for ( int i=0; i < m_EnvelopeJD.size(); ++i ) {
+        if ( isCulled( i ) )
+            culled.append( i );
+    }
+    if ( culled.isEmpty() )
+        return;
+
+    KSNumbers num( m_UpdateJD );
+    const double limit = m_EnvelopeLimit;
+    QtConcurrent::blockingMap( culled, [&]( int i ) {
+        computeBody( i, &num, limit );
+    } );
+}
+
+// Number of days around the last computation during which the body stays fainter than the limit
+double SolarSystemListComponent::envelopeDays( int i, const KSPlanetBase *p, double limit ) const {
+    const double q = m_Perihelion[i];
+    const double H = m_AbsoluteMagnitude[i];
+    if ( std::isnan( H ) )
+        return 0.0;
+
+    // The speed at perihelion is the largest on the orbit, it bounds how fast r and delta change
+    const double speed = GAUSS_K * sqrt( 2.0 / qMax( q, 0.01 ) );
+
+    for ( double days = ENVELOPE_MAX_DAYS; days >= 1.0; days /= 2.0 ) {
+        double r = qMax( q, p->rsun() - speed * days );
+        double delta = qMax( p->rearth() - ( speed + EARTH_SPEED ) * days, r - EARTH_APHELION );
+        if ( delta > 0.0 && H + 5.0 * log10( r * delta ) > limit + ENVELOPE_MARGIN )
+            return days;
+    }
+
+    return 0.0;
+}
+
+// Index the bodies which may be visible by their J2000 position, like the mesh apertures
+void SolarSystemListComponent::indexBodies( const KSNumbers *num ) {
+    m_Active.clear();
+    m_Index.clear();
+
+    for ( int i=0; i < m_ObjectList.size(); ++i ) {
+        if ( m_EnvelopeDays[i] > 0.0 )
+            continue;
+
+        KSPlanetBase *p = (KSPlanetBase*)m_ObjectList[i];
+        m_Active.append( p );
+
+        double sinRA, cosRA, sinDec, cosDec;
+        p->ra().SinCos( sinRA, cosRA );
+        p->dec().SinCos( sinDec, cosDec );
+
+        // Precess back to J2000. Nutation and aberration are well within the margin of the apertures.
+        Eigen::Vector3d s( cosRA*cosDec, sinRA*cosDec, sinDec );
+        Eigen::Vector3d v = num->p1() * s;
+
+        SkyPoint j2000;
+        j2000.setRA0( dms( atan2( v[1], v[0] ) * 180.0 / dms::PI ).reduce() );
+        j2000.setDec0( dms( asin( qBound( -1.0, v[2], 1.0 ) ) * 180.0 / dms::PI ) );
+        m_Index[ m_skyMesh->index( &j2000 ) ].append( p );
+    }
+}
+
+SkyObject* SolarSystemListComponent::objectNearest( SkyPoint *p, double &maxrad ) {
+    if ( ! selected() )
+        return 0;
+
+    const double limit = magnitudeLimit();
+    SkyObject *oBest = 0;
+
+    MeshIterator region( m_skyMesh, OBJ_NEAREST_BUF );
+    while ( region.hasNext() ) {
+        BodyIndex::const_iterator it = m_Index.constFind( region.next() );
+        if ( it == m_Index.constEnd() )
+            continue;
+
+        foreach ( KSPlanetBase *o, it.value() ) {
+            if ( o->mag() > limit )
+                continue;
+
+            double r = o->angularDistanceTo( p ).Degrees();
+            if ( r < maxrad ) {
+                oBest = o;
+                maxrad = r;
+            }
+        }
+    }
+
+    return oBest;
 }
 
 
@@ -18,13 +18,28 @@
 #ifndef SOLARSYSTEMLISTCOMPONENT_H
 #define SOLARSYSTEMLISTCOMPONENT_H
 
+#include <QHash>
+#include <QVector>
+
 #include "listcomponent.h"
+#include "typedef.h"
 
 class KSPlanet;
+class KSPlanetBase;
+class SkyMesh;
 class SolarSystemComposite;
 
 /**
  *@class SolarSystemListComponent
+ *A list of minor bodies, such as the asteroids or the comets.
+ *
+ *The bodies are updated in parallel. Components which draw the bodies down to a
+ *limiting magnitude provide the perihelion distance and the absolute magnitude
+ *of each body, which are kept in flat arrays. After a body is computed, these
+ *bound its magnitude over the following days, and the body is left alone for as
+ *long as it stays fainter than the limit. The bodies that may be visible are
+ *indexed in the SkyMesh, so that drawing and objectNearest() only visit the
+ *trixels on screen.
  *
  *@author Jason Harris
  *@version 1.0
@@ -46,11 +61,78 @@ public:
      */
     virtual void updateSolarSystemBodies( KSNumbers *num );
 
+    /** @short Find the body nearest to a point, among the indexed bodies which are
+     * not fainter than magnitudeLimit().
+     */
+    virtual SkyObject* objectNearest( SkyPoint *p, double &maxrad );
+
+    /** @short Find a body by name. A body left alone at the last update is
+     * computed for the time of that update before it is returned.
+     */
+    virtual SkyObject* findByName( const QString &name );
+
+    /** @short Compute @p o for the time of the last update, if it is one of the
+     * bodies of this component which were left alone.
+     */
+    void updateCulledBody( SkyObject *o );
+
+    /** @short Compute all the bodies left alone at the last update, in parallel.
+     * To be called before reading the positions or the magnitudes of objectList().
+     */
+    void updateCulledBodies();
+
 protected:
+    typedef QHash< Trixel, QList<KSPlanetBase*> > BodyIndex;
+
     void drawTrails( SkyPainter* skyp );
 
+    /** @return the faintest magnitude of the bodies which are drawn, or NaN if
+     * they are all drawn. Bodies are only left out when there is a limit.
+     */
+    virtual double magnitudeLimit() const;
+
+    /** Provide the elements which bound the magnitude of a body. Its magnitude must
+     * never be brighter than H + 5 log10(r*delta).
+     *@param o the body
+     *@param q perihelion distance, in AU
+     *@param H absolute magnitude
+     *@return false if the magnitude of the body is not bounded, which is the default
+     */
+    virtual bool magnitudeElements( const SkyObject *o, double &q, double &H ) const;
+
+    /** @short Forget the elements, the envelopes and the index.
+     * To be called after m_ObjectList changed.
+     */
+    void resetBodies();
+
+    /** Bodies that may be visible, by trixel of their J2000 position */
+    const BodyIndex& bodyIndex() const { return m_Index; }
+
+    SkyMesh *m_skyMesh;
+
 private:
+    double envelopeDays( int i, const KSPlanetBase *p, double limit ) const;
+    void computeBody( int i, const KSNumbers *num, double limit );
+    bool isCulled( int i ) const;
+    void indexBodies( const KSNumbers *num );
+
     KSPlanet *m_Earth;
+
+    // Elements of the bodies, in the order of m_ObjectList
+    QVector<double> m_Perihelion;
+    QVector<double> m_AbsoluteMagnitude;
+    // The body is fainter than the limit for m_EnvelopeDays around m_EnvelopeJD
+    QVector<double> m_EnvelopeJD;
+    QVector<double> m_EnvelopeDays;
+    double m_EnvelopeLimit;
+    // Julian day of the last update, NaN before the first one
+    double m_UpdateJD;
+    // Position of each body in m_ObjectList
+    QHash<const SkyObject*, int> m_Position;
+
+    // Bodies computed at the last update
+    QList<KSPlanetBase*> m_Active;
+    BodyIndex m_Index;
 };
 
 #endif
@@ -21,9 +21,17 @@
 #include "skyobjects/stardata.h"
 #include "skyobjects/deepstardata.h"
 #include "skymaplite.h"
+#include "kstarsdata.h"
+#include "ksnumbers.h"
+#include "Options.h"
+#include "skymapcomposite.h"
+#include "ksutils.h"
 
 #include <QDebug>
 
+#include <algorithm>
+#include <cmath>
+
 #ifdef KSTARS_LITE
 #include "kstarslite/skyitems/skynodes/pointsourcenode.h"
 
@@ -48,11 +56,22 @@ StarBlock::StarBlock( int nstars ) :
     prev(0),
     next(0),
     drawID(0),
-    nStars(0),
+    m_RA0(nstars), m_Dec0(nstars),
+    m_pmRA(nstars), m_pmDec(nstars),
+    m_Mag(nstars), m_SpType(nstars),
+    m_RA(nstars), m_Dec(nstars),
+    m_Alt(nstars), m_Az(nstars),
+    m_CoordsJD(0.0),
+    m_nCoords(0),
+    m_nHorizontal(0),
+    m_UpdateNumID(0),
+    m_UpdateID(0)
+#ifndef KSTARS_LITE
+    , m_State(nstars, STAR_INITIALIZED)
+#endif
+    , nStars(0)
 #ifdef KSTARS_LITE
-    stars(nstars,StarNode())
-#else
-    stars(nstars, StarObject())
+    , stars(nstars,StarNode())
 #endif
 { }
 
@@ -65,18 +84,25 @@ void StarBlock::reset()
     faintMag = -5.0;
     brightMag = 35.0;
     nStars = 0;
+    m_CoordsJD = 0.0;
+    m_nCoords = 0;
+    m_nHorizontal = 0;
 }
 
 StarBlock::~StarBlock()
 {
     if( parent )
         parent -> releaseBlock( this );
+#ifndef KSTARS_LITE
+    qDeleteAll( m_Objects );
+#endif
 }
 #ifdef KSTARS_LITE
 StarNode* StarBlock::addStar(const starData& data)
 {
     if(isFull())
         return 0;
+    storeStar( nStars, data );
     StarNode& node = stars[nStars++];
     StarObject& star = node.star;
 
@@ -92,6 +118,7 @@ StarNode* StarBlock::addStar(const deepStarData& data)
 {
     if(isFull())
         return 0;
+    storeStar( nStars, data );
     StarNode& node = stars[nStars++];
     StarObject& star = node.star;
 
@@ -102,32 +129,348 @@ StarNode* StarBlock::addStar(const deepStarData& data)
         brightMag = star.mag();
     return &node;
 }
+
+bool StarBlock::appendStar(const starData& data)
+{
+    return addStar( data ) != 0;
+}
+
+bool StarBlock::appendStar(const deepStarData& data)
+{
+    return addStar( data ) != 0;
+}
+
+StarObject &StarBlock::starObject( int i )
+{
+    return stars[i].star;
+}
 #else
 StarObject* StarBlock::addStar(const starData& data)
 {
-    if(isFull())
+    if( !appendStar( data ) )
         return 0;
-    StarObject& star = stars[nStars++];
-    
-    star.init(&data);
-    if( star.mag() > faintMag )
-        faintMag = star.mag();
-    if( star.mag() < brightMag )
-        brightMag = star.mag();
-    return &star;
+    return &starObject( nStars - 1 );
 }
 
 StarObject* StarBlock::addStar(const deepStarData& data)
 {
-    if(isFull())
+    if( !appendStar( data ) )
         return 0;
-    StarObject& star = stars[nStars++];
-    
-    star.init(&data);
-    if( star.mag() > faintMag )
-        faintMag = star.mag();
-    if( star.mag() < brightMag )
-        brightMag = star.mag();
+    return &starObject( nStars - 1 );
+}
+
+bool StarBlock::appendStar(const starData& data)
+{
+    if(isFull())
+        return false;
+    // A block only ever holds the records of the catalog it is filled from
+    if( m_Records.isEmpty() ) {
+        m_Records.resize( size() );
+        if( nStars == 0 )
+            m_DeepRecords.clear();
+    }
+    storeStar( nStars, data );
+    m_Records[nStars] = data;
+    m_State[nStars] = STAR_FROM_RECORD;
+    float mag = m_Mag[nStars++];
+    if( mag > faintMag )
+        faintMag = mag;
+    if( mag < brightMag )
+        brightMag = mag;
+    return true;
+}
+
+bool StarBlock::appendStar(const deepStarData& data)
+{
+    if(isFull())
+        return false;
+    if( m_DeepRecords.isEmpty() ) {
+        m_DeepRecords.resize( size() );
+        if( nStars == 0 )
+            m_Records.clear();
+    }
+    storeStar( nStars, data );
+    m_DeepRecords[nStars] = data;
+    m_State[nStars] = STAR_FROM_DEEP_RECORD;
+    float mag = m_Mag[nStars++];
+    if( mag > faintMag )
+        faintMag = mag;
+    if( mag < brightMag )
+        brightMag = mag;
+    return true;
+}
+
+StarObject &StarBlock::starObject( int i )
+{
+    if( m_Objects.isEmpty() )
+        m_Objects.fill( 0, size() );
+    if( !m_Objects[i] )
+        m_Objects[i] = new StarObject();
+
+    StarObject &star = *m_Objects[i];
+    if( m_State[i] == STAR_FROM_RECORD )
+        star.init( &m_Records[i] );
+    else if( m_State[i] == STAR_FROM_DEEP_RECORD )
+        star.init( &m_DeepRecords[i] );
+    m_State[i] = STAR_INITIALIZED;
+    return star;
+}
+
+StarObject *StarBlock::star( int i )
+{
+    StarObject &star = starObject( i );
+    if( i < m_nHorizontal && star.updateID != m_UpdateID )
+        syncStar( i );
     return &star;
 }
 #endif
+
+// NOTE: The conversions below must match those in StarObject::init()
+void StarBlock::storeStar( int i, const starData &data )
+{
+    m_RA0[i] = data.RA / 1000000.0 * 15.0 * dms::DegToRad;
+    m_Dec0[i] = data.Dec / 100000.0 * dms::DegToRad;
+    m_pmRA[i] = data.dRA / 10.0;
+    m_pmDec[i] = data.dDec / 10.0;
+    m_Mag[i] = data.mag / 100.0;
+    m_SpType[i] = data.spec_type[0];
+}
+
+void StarBlock::storeStar( int i, const deepStarData &data )
+{
+    m_RA0[i] = data.RA / 1000000.0 * 15.0 * dms::DegToRad;
+    m_Dec0[i] = data.Dec / 100000.0 * dms::DegToRad;
+    m_pmRA[i] = data.dRA / 100.0;
+    m_pmDec[i] = data.dDec / 100.0;
+
+    if( data.V == 30000 && data.B != 30000 )
+        m_Mag[i] = ( data.B - 1600 ) / 1000.0;
+    else
+        m_Mag[i] = data.V / 1000.0;
+
+    char sp = 'B';
+    if( data.B == 30000 || data.V == 30000 )
+        sp = '?';
+    else {
+        double BV_Index = ( data.B - data.V ) / 1000.0;
+        ( BV_Index > 0.0 ) && ( sp = 'A' );
+        ( BV_Index > 0.325 ) && ( sp = 'F' );
+        ( BV_Index > 0.575 ) && ( sp = 'G' );
+        ( BV_Index > 0.975 ) && ( sp = 'K' );
+        ( BV_Index > 1.6 ) && ( sp = 'M' );
+    }
+    m_SpType[i] = sp;
+}
+
+void StarBlock::JITupdate()
+{
+    KStarsData *data = KStarsData::Instance();
+
+    if( m_UpdateID == data->updateID() && m_nHorizontal == nStars )
+        return;
+
+    if( m_UpdateNumID != data->updateNumID() || m_nCoords < nStars ) {
+        const KSNumbers *num = data->updateNum();
+        int first = m_nCoords;
+
+        // Same short-circuit as in StarObject::JITupdate(): update once per solar minute
+        if( Options::alwaysRecomputeCoordinates() || fabs( m_CoordsJD - num->getJD() ) >= 0.00069444 ) {
+            first = 0;
+            m_CoordsJD = num->getJD();
+        }
+        if( first < nStars )
+            updateApparentCoords( num, first );
+
+        m_nCoords = nStars;
+        m_UpdateNumID = data->updateNumID();
+    }
+
+    updateHorizontalCoords( data->lst(), data->geo()->lat() );
+    m_nHorizontal = nStars;
+    m_UpdateID = data->updateID();
+}
+
+// NOTE: Each step below is a separate loop over the compact arrays, with
+// no function calls other than the branch-free ones of KSUtils and no
+// branches other than selections, so that the compiler can vectorize it
+// (the file is built with the flags they need, see kstars/CMakeLists.txt).
+// The steps mirror StarObject::getIndexCoords(), SkyPoint::precess(),
+// SkyPoint::nutate(), SkyPoint::aberrate() and
+// SkyPoint::EquatorialToHorizontal(). Please keep them in sync.
+void StarBlock::updateApparentCoords( const KSNumbers *num, int first )
+{
+    using namespace KSUtils;
+
+    const double *ra0 = m_RA0.constData();
+    const double *dec0 = m_Dec0.constData();
+    const float *pmRA = m_pmRA.constData();
+    const float *pmDec = m_pmDec.constData();
+    double *ra = m_RA.data();
+    double *dec = m_Dec.data();
+
+    // Step 0: Proper motion along a great circle. Motions of less than an arcsecond are ignored.
+    const double jm = num->julianMillenia();
+    const double sign = ( jm < 0 ) ? -1.0 : 1.0;
+    const double arcsecToRad = dms::PI / ( 180.0 * 3600.0 );
+    for( int i = first; i < nStars; ++i ) {
+        double sinDec0, cosDec0;
+        sinCosBranchFree( dec0[i], sinDec0, cosDec0 );
+        double weightedPmRA = cosDec0 * pmRA[i];
+        double pm = sqrt( weightedPmRA * weightedPmRA + pmDec[i] * pmDec[i] ) * jm; // arcseconds
+        double sinDir0, cosDir0, sinDst, cosDst;
+        sinCosBranchFree( atan2BranchFree( sign * pmRA[i], sign * pmDec[i] ), sinDir0, cosDir0 );
+        sinCosBranchFree( fabs( pm ) * arcsecToRad, sinDst, cosDst );
+        double sinLat1 = sinDec0 * cosDst + cosDec0 * sinDst * cosDir0;
+        double dtheta = atan2BranchFree( sinDir0 * sinDst * cosDec0, cosDst - sinDec0 * sinLat1 );
+        double lat1 = asinBranchFree( sinLat1 );
+        bool moves = ( pm * pm >= 1.0 ); // false for NaN as well
+        ra[i] = ra0[i] + ( moves ? dtheta : 0.0 );
+        dec[i] = moves ? lat1 : dec0[i];
+    }
+
+    // Step 1: Precession
+    const Eigen::Matrix3d &P = num->p2();
+    const double p00 = P(0, 0), p01 = P(0, 1), p02 = P(0, 2);
+    const double p10 = P(1, 0), p11 = P(1, 1), p12 = P(1, 2);
+    const double p20 = P(2, 0), p21 = P(2, 1), p22 = P(2, 2);
+    const double twoPi = 2.0 * dms::PI;
+    for( int i = first; i < nStars; ++i ) {
+        double sinRA, cosRA, sinDec, cosDec;
+        sinCosBranchFree( ra[i], sinRA, cosRA );
+        sinCosBranchFree( dec[i], sinDec, cosDec );
+        double s0 = cosRA * cosDec, s1 = sinRA * cosDec, s2 = sinDec;
+        double v0 = p00 * s0 + p01 * s1 + p02 * s2;
+        double v1 = p10 * s0 + p11 * s1 + p12 * s2;
+        double v2 = p20 * s0 + p21 * s1 + p22 * s2;
+        double r = atan2BranchFree( v1, v0 );
+        ra[i] = r + ( ( r < 0.0 ) ? twoPi : 0.0 );
+        dec[i] = asinBranchFree( v2 );
+    }
+
+    // Step 2: Nutation, using the approximate method below 80 degrees of declination
+    double sinOb, cosOb;
+    num->obliquity()->SinCos( sinOb, cosOb );
+    const double dEcLong = num->dEcLong() * dms::DegToRad;
+    const double dObliq = num->dObliq() * dms::DegToRad;
+    const double maxDec = 80.0 * dms::DegToRad;
+    for( int i = first; i < nStars; ++i ) {
+        double sinRA, cosRA, sinDec, cosDec;
+        sinCosBranchFree( ra[i], sinRA, cosRA );
+        sinCosBranchFree( dec[i], sinDec, cosDec );
+        double tanDec = sinDec / cosDec;
+        double dRA  = dEcLong * ( cosOb + sinOb * sinRA * tanDec ) - dObliq * cosRA * tanDec;
+        double dDec = dEcLong * ( sinOb * cosRA ) + dObliq * sinRA;
+        bool approx = ( fabs( dec[i] ) < maxDec );
+        ra[i] += approx ? dRA : 0.0;
+        dec[i] += approx ? dDec : 0.0;
+    }
+    for( int i = first; i < nStars; ++i ) {
+        if( fabs( dec[i] ) < maxDec )
+            continue;
+        // Rare: use the exact method of SkyPoint
+        SkyPoint p;
+        dms a;
+        a.setRadians( ra[i] );
+        p.setRA( a );
+        a.setRadians( dec[i] );
+        p.setDec( a );
+        p.nutate( num );
+        ra[i] = p.ra().radians();
+        dec[i] = p.dec().radians();
+    }
+
+    // Step 3: Aberration
+    const double K = num->constAberr().radians();
+    const double e = num->earthEccentricity();
+    double sinL, cosL, sinP, cosP;
+    num->sunTrueLongitude().SinCos( sinL, cosL );
+    num->earthPerihelionLongitude().SinCos( sinP, cosP );
+    for( int i = first; i < nStars; ++i ) {
+        double sinRA, cosRA, sinDec, cosDec;
+        sinCosBranchFree( ra[i], sinRA, cosRA );
+        sinCosBranchFree( dec[i], sinDec, cosDec );
+        double dRA = K * ( cosRA * cosOb / cosDec ) * ( e * cosP - cosL );
+        double dDec = K * ( sinRA * ( sinOb * cosDec - cosOb * sinDec ) * ( e * cosP - cosL ) + cosRA * sinDec * ( e * sinP - sinL ) );
+        ra[i] += dRA;
+        dec[i] += dDec;
+    }
+
+    // The gravitational bending of light is only significant close to the Sun
+    // (see SkyPoint::checkBendLight()). Let StarObject handle those few stars.
+    if( Options::useRelativistic() ) {
+        static SkyObject *sun = 0;
+        if( !sun )
+            sun = KStarsData::Instance()->skyComposite()->findByName( "Sun" );
+        if( sun ) {
+            double sinSunRA, cosSunRA, sinSunDec, cosSunDec;
+            sun->ra().SinCos( sinSunRA, cosSunRA );
+            sun->dec().SinCos( sinSunDec, cosSunDec );
+            const double cosMaxAngle = cos( 1.75 * ( 30.0 / 200.0 ) );
+            for( int i = first; i < nStars; ++i ) {
+                double cosDist = sin( dec[i] ) * sinSunDec + cos( dec[i] ) * cosSunDec * cos( ra[i] - sun->ra().radians() );
+                if( cosDist < cosMaxAngle )
+                    continue;
+                StarObject &star = starObject( i );
+                star.updateCoords( num, true, 0, 0, true );
+                ra[i] = star.ra().radians();
+                dec[i] = star.dec().radians();
+            }
+        }
+    }
+}
+
+void StarBlock::updateHorizontalCoords( const CachingDms *LST, const CachingDms *lat )
+{
+    using namespace KSUtils;
+
+    const double *ra = m_RA.constData();
+    const double *dec = m_Dec.constData();
+    double *alt = m_Alt.data();
+    double *az = m_Az.data();
+
+    double sinLat, cosLat;
+    lat->SinCos( sinLat, cosLat );
+    const double lst = LST->radians();
+    const double twoPi = 2.0 * dms::PI;
+
+    for( int i = 0; i < nStars; ++i ) {
+        double sinHA, cosHA, sinDec, cosDec;
+        sinCosBranchFree( lst - ra[i], sinHA, cosHA );
+        sinCosBranchFree( dec[i], sinDec, cosDec );
+        double sinAlt = sinDec * sinLat + cosDec * cosLat * cosHA;
+        double cos2Alt = 1.0 - sinAlt * sinAlt;
+        double cosAlt = sqrt( ( cos2Alt > 0.0 ) ? cos2Alt : 0.0 );
+        // acosBranchFree() clamps the argument to [-1, 1]
+        double A = acosBranchFree( ( sinDec - sinLat * sinAlt ) / ( cosLat * cosAlt ) );
+        alt[i] = asinBranchFree( sinAlt );
+        az[i] = ( sinHA > 0.0 ) ? twoPi - A : A; // resolve acos() ambiguity
+    }
+}
+
+void StarBlock::toSkyPoint( int i, SkyPoint *p ) const
+{
+    dms a;
+    a.setRadians( m_RA[i] );
+    p->setRA( a );
+    a.setRadians( m_Dec[i] );
+    p->setDec( a );
+    a.setRadians( m_Alt[i] );
+    p->setAlt( a );
+    a.setRadians( m_Az[i] );
+    p->setAz( a );
+}
+
+double StarBlock::angularDistanceTo( int i, const SkyPoint *p ) const
+{
+    SkyPoint star;
+    toSkyPoint( i, &star );
+    return star.angularDistanceTo( p ).Degrees();
+}
+
+void StarBlock::syncStar( int i )
+{
+    StarObject &star = starObject( i );
+    toSkyPoint( i, &star );
+    star.updateID = m_UpdateID;
+    star.updateNumID = m_UpdateNumID;
+}
@@ -20,14 +20,17 @@
 
 #include "typedef.h"
 #include "starblocklist.h"
+#include "skyobjects/stardata.h"
+#include "skyobjects/deepstardata.h"
 
 #include <QVector>
 
 class StarObject;
 class StarBlockList;
 class PointSourceNode;
-struct starData;
-struct deepStarData;
+class SkyPoint;
+class KSNumbers;
+class CachingDms;
 
 #ifdef KSTARS_LITE
 #include "starobject.h"
@@ -80,6 +83,20 @@ public:
     StarObject* addStar(const deepStarData& data);
 #endif
 
+    /**
+     *@short Add a star to the block without creating its StarObject
+     *
+     *Only the compact per-star arrays are filled. The StarObject is
+     *created from the record the first time it is accessed through
+     *star(), which for most faint stars is never. In KStars Lite this
+     *is the same as addStar().
+     *
+     *@param  data    data to initialize star with.
+     *@return false if the block is full, true otherwise.
+     */
+    bool appendStar(const starData& data);
+    bool appendStar(const deepStarData& data);
+
     /**
      *@short Returns true if the StarBlock is full
      *
@@ -96,19 +113,56 @@ public:
      *
      *@return The number of stars that this StarBlock can hold
      */
-    inline int size() const { return stars.size(); }
+    inline int size() const { return m_Mag.size(); }
 
     /**
      *@short  Return the i-th star in this StarBlock
      *
+     *In KStars, the StarObject is created when it is first asked for, so this
+     *should only be used for the stars that are picked, labelled or shown in detail.
+     *
      *@param  Index of StarBlock to return
      *@return A pointer to the i-th StarObject
      */
 #ifdef KSTARS_LITE
     inline StarNode *star( int i ) { return &stars[i]; }
 #else
-    inline StarObject *star( int i ) { return &stars[i]; }
+    StarObject *star( int i );
 #endif
+
+    /**
+     *@short  Return the magnitude of the i-th star, without touching its StarObject
+     */
+    inline float mag( int i ) const { return m_Mag[i]; }
+
+    /**
+     *@short  Return the spectral type character of the i-th star, without touching its StarObject
+     */
+    inline char spchar( int i ) const { return m_SpType[i]; }
+
+    /**
+     *@short  Update the coordinates of all stars in the block in one batch
+     *
+     *This is the block-wise equivalent of StarObject::JITupdate(). The proper
+     *motion, precession, nutation and aberration corrections, and the conversion to
+     *horizontal coordinates, are computed on the compact per-star arrays, in loops
+     *that the compiler can vectorize. The StarObjects are not touched; they pick
+     *up the new coordinates when they are next accessed through star().
+     */
+    void JITupdate();
+
+    /**
+     *@short  Copy the current coordinates of the i-th star into p
+     *@note   JITupdate() must have been called first
+     */
+    void toSkyPoint( int i, SkyPoint *p ) const;
+
+    /**
+     *@short  Return the angular distance in degrees from the i-th star to p, without touching its StarObject
+     *@note   JITupdate() must have been called first
+     */
+    double angularDistanceTo( int i, const SkyPoint *p ) const;
+
     // These methods are there because we might want to make faintMag and brightMag private at some point
     /**
      *@short  Return the magnitude of the brightest star in this StarBlock
@@ -147,13 +201,70 @@ public:
     StarBlock(const StarBlock&);
     StarBlock& operator = (const StarBlock&);
 
+    /**
+     *@short  Record the catalog data of the star at index i in the compact arrays
+     */
+    void storeStar( int i, const starData &data );
+    void storeStar( int i, const deepStarData &data );
+
+    /**
+     *@short  Compute the apparent equatorial coordinates of the stars from first to nStars - 1
+     */
+    void updateApparentCoords( const KSNumbers *num, int first );
+
+    /**
+     *@short  Compute the horizontal coordinates of all the stars
+     */
+    void updateHorizontalCoords( const CachingDms *LST, const CachingDms *lat );
+
+    /**
+     *@short  Copy the coordinates in the compact arrays to the StarObject of star i
+     */
+    void syncStar( int i );
+
+    /**
+     *@short  Return the StarObject of star i, creating or initializing it if required, but without syncing its coordinates
+     */
+    StarObject &starObject( int i );
+
+    // Compact structure-of-arrays copy of the stars, used by JITupdate()
+    QVector<double> m_RA0, m_Dec0;     // Catalog (J2000) coordinates in radians
+    QVector<float>  m_pmRA, m_pmDec;   // Proper motion in milliarcseconds per year
+    QVector<float>  m_Mag;
+    QVector<char>   m_SpType;
+    QVector<double> m_RA, m_Dec;       // Apparent coordinates in radians
+    QVector<double> m_Alt, m_Az;       // Horizontal coordinates in radians
+
+    double   m_CoordsJD;     // JD for which m_RA and m_Dec were computed
+    int      m_nCoords;      // Number of stars whose m_RA and m_Dec are valid for m_CoordsJD
+    int      m_nHorizontal;  // Number of stars whose m_Alt and m_Az are valid for m_UpdateID
+    UpdateID m_UpdateNumID;  // KStarsData::updateNumID() at the last JITupdate()
+    UpdateID m_UpdateID;     // KStarsData::updateID() at the last JITupdate()
+
+#ifndef KSTARS_LITE
+    enum StarState {
+        STAR_FROM_RECORD,       // StarObject not initialized yet, data in m_Records
+        STAR_FROM_DEEP_RECORD,  // StarObject not initialized yet, data in m_DeepRecords
+        STAR_INITIALIZED        // StarObject initialized
+    };
+
+    // Catalog records of stars whose StarObject has not been initialized yet.
+    // Only the one for the type of catalog the block is filled from is allocated.
+    QVector<starData>     m_Records;
+    QVector<deepStarData> m_DeepRecords;
+    QVector<char>         m_State;   // One of the StarState values for each star
+
+    // StarObjects created so far, NULL for the others. Empty until the first one
+    // is created. They are kept when the block is reused, as pointers to them may
+    // still be held, and are initialized again from the record of their new star.
+    QVector<StarObject*>  m_Objects;
+#endif
+
     /** Number of initialized stars in StarBlock. */
     int nStars;
-    /** Array of stars. */
 #ifdef KSTARS_LITE
+    /** Array of stars. */
     QVector<StarNode> stars;
-#else
-    QVector<StarObject> stars;
 #endif
 };
 
@@ -21,6 +21,7 @@
 #include "skyobjects/stardata.h"
 #include "skyobjects/deepstardata.h"
 #include "starcomponent.h"
+#include "starblockprefetcher.h"
 
 #ifdef KSTARS_LITE
 #include "skymaplite.h"
@@ -77,14 +78,10 @@ int StarBlockList::releaseBlock( StarBlock *block ) {
 bool StarBlockList::fillToMag( float maglim ) {
     // TODO: Remove staticity of BinFileHelper
     BinFileHelper *dSReader;
-    StarBlockFactory *SBFactory;
-    starData stardata;
-    deepStarData deepstardata;
     FILE *dataFile;
 
     dSReader = parent->getStarReader();
     dataFile = dSReader->getFileHandle();
-    SBFactory = StarBlockFactory::Instance();
 
     if( staticStars )
         return false;
@@ -104,7 +101,11 @@ bool StarBlockList::fillToMag( float maglim ) {
 
     Q_ASSERT( nBlocks == (unsigned int) blocks.size() );
 
-    BinFileHelper::unsigned_KDE_fseek( dataFile, readOffset, SEEK_SET );
+    // Prefer zero-copy access to the records through the memory mapping, and fall back to fread() otherwise
+    quint32 nRecords = dSReader->getRecordCount( trixelId ) - nStars;
+    const char *record = dSReader->getMappedData( readOffset, nRecords * dSReader->guessRecordSize() );
+    if( !record )
+        BinFileHelper::unsigned_KDE_fseek( dataFile, readOffset, SEEK_SET );
     
     /*
     qDebug() << "Reading trixel" << trixel << ", id on disk =" << trixelId << ", currently nStars =" << nStars
@@ -112,7 +113,52 @@ bool StarBlockList::fillToMag( float maglim ) {
              << "to maglim =" << maglim << "with current faintMag =" << faintMag << endl;
     */
 
-    while( maglim >= faintMag && nStars < dSReader->getRecordCount( trixelId ) ) {
+    return fillFromRecords( maglim, record, nRecords );
+}
+
+bool StarBlockList::fillToMag( float maglim, const QByteArray &records, quint32 offset ) {
+    BinFileHelper *dSReader = parent->getStarReader();
+    quint32 recordSize = dSReader->guessRecordSize();
+
+    if( staticStars )
+        return false;
+
+    if( faintMag >= maglim )
+        return true;
+
+    if( readOffset <= 0 )
+        readOffset = dSReader->getOffset( trixel );
+
+    // The records must continue exactly where we stopped reading the last time
+    quint32 skip = readOffset - offset;
+    if( (quint32) readOffset < offset || skip >= (quint32) records.size() || skip % recordSize != 0 )
+        return false;
+
+    return fillFromRecords( maglim, records.constData() + skip, ( records.size() - skip ) / recordSize );
+}
+
+bool StarBlockList::isFilledToMag( float maglim ) const {
+    return staticStars || faintMag > maglim || nStars >= parent->getStarReader()->getRecordCount( trixel );
+}
+
+void StarBlockList::prefetch( StarBlockPrefetcher *prefetcher, float maglim ) const {
+    BinFileHelper *dSReader = parent->getStarReader();
+    if( staticStars || !prefetcher )
+        return;
+
+    quint32 offset = ( readOffset > 0 ) ? readOffset : dSReader->getOffset( trixel );
+    prefetcher->request( trixel, offset, ( dSReader->getRecordCount( trixel ) - nStars ) * dSReader->guessRecordSize(), maglim );
+}
+
+bool StarBlockList::fillFromRecords( float maglim, const char *record, quint32 nRecords ) {
+    BinFileHelper *dSReader = parent->getStarReader();
+    FILE *dataFile = dSReader->getFileHandle();
+    StarBlockFactory *SBFactory = StarBlockFactory::Instance();
+    starData stardata;
+    deepStarData deepstardata;
+    bool largeRecords = ( dSReader->guessRecordSize() == 32 );
+
+    while( maglim >= faintMag && nStars < dSReader->getRecordCount( trixel ) && nRecords > 0 ) {
         if( nBlocks == 0 || blocks[nBlocks - 1]->isFull() ) {
             StarBlock *newBlock;
             newBlock = SBFactory->getBlock();
@@ -131,19 +177,31 @@ bool StarBlockList::fillToMag( float maglim ) {
             ++nBlocks;
         }
 	// TODO: Make this more general
-	if( dSReader->guessRecordSize() == 32 ) {
-            fread( &stardata, sizeof( starData ), 1, dataFile );
-            if( dSReader->getByteSwap() )
-                DeepStarComponent::byteSwap( &stardata );
+	if( largeRecords ) {
+            if( record ) {
+                blocks[nBlocks - 1]->appendStar( *DeepStarComponent::mappedRecord( record, &stardata, dSReader->getByteSwap() ) );
+                record += sizeof( starData );
+            }
+            else {
+                fread( &stardata, sizeof( starData ), 1, dataFile );
+                if( dSReader->getByteSwap() )
+                    DeepStarComponent::byteSwap( &stardata );
+                blocks[nBlocks - 1]->appendStar(stardata);
+            }
             readOffset += sizeof( starData );
-            blocks[nBlocks - 1]->addStar(stardata);
 	}
 	else {
-            fread( &deepstardata, sizeof( deepStarData ), 1, dataFile );
-            if( dSReader->getByteSwap() )
-                DeepStarComponent::byteSwap( &deepstardata );
+            if( record ) {
+                blocks[nBlocks - 1]->appendStar( *DeepStarComponent::mappedRecord( record, &deepstardata, dSReader->getByteSwap() ) );
+                record += sizeof( deepStarData );
+            }
+            else {
+                fread( &deepstardata, sizeof( deepStarData ), 1, dataFile );
+                if( dSReader->getByteSwap() )
+                    DeepStarComponent::byteSwap( &deepstardata );
+                blocks[nBlocks - 1]->appendStar(deepstardata);
+            }
             readOffset += sizeof( deepStarData );
-            blocks[nBlocks - 1]->addStar(deepstardata);
 	}
 
     /*
@@ -154,6 +212,7 @@ bool StarBlockList::fillToMag( float maglim ) {
     */
     faintMag = blocks[nBlocks - 1]->getFaintMag();
     nStars++;
+    nRecords--;
     }
 
     return ( ( maglim < faintMag ) ? true : false );
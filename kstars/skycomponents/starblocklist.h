@@ -22,8 +22,11 @@
 #include "deepstarcomponent.h"
 #include "typedef.h"
 
+#include <QByteArray>
+
 class StarBlock;
 class DeepStarComponent;
+class StarBlockPrefetcher;
 
 /**
  *@class StarBlockList
@@ -61,6 +64,33 @@ class StarBlockList {
      */
     bool fillToMag( float maglim );
 
+    /**
+     *@short Loads stars to the given magnitude limit from records that are already in memory
+     *
+     *Unlike fillToMag( float ), this never touches the data file. It is meant to consume the
+     *records read in advance by a StarBlockPrefetcher.
+     *
+     *@param maglim  Magnitude limit to load stars upto
+     *@param records Raw records of this trixel, as stored in the data file
+     *@param offset  Offset in the data file of the first record in records
+     *@return true if stars fainter than maglim have been reached, false otherwise (including when
+     *        the records do not continue from where the list stopped reading)
+     */
+    bool fillToMag( float maglim, const QByteArray &records, quint32 offset );
+
+    /**
+     *@short  Check whether the list holds all the stars down to the given magnitude limit
+     *@return true if no more stars need to be loaded for maglim
+     */
+    bool isFilledToMag( float maglim ) const;
+
+    /**
+     *@short  Queue the records of this trixel that have not been loaded yet for asynchronous reading
+     *@param  prefetcher  The prefetcher of the parent DeepStarComponent
+     *@param  maglim      Magnitude limit to read stars upto
+     */
+    void prefetch( StarBlockPrefetcher *prefetcher, float maglim ) const;
+
     /**
      *@short Sets the first StarBlock in the list to point to the given StarBlock
      *
@@ -112,6 +142,13 @@ class StarBlockList {
     inline Trixel getTrixel() const { return trixel; }
 
  private:
+    /**
+     *@short Adds stars to the list until maglim is reached
+     *@param record   Pointer to the next record in memory, or NULL to fread() them from the data file
+     *@param nRecords Maximum number of records to add
+     */
+    bool fillFromRecords( float maglim, const char *record, quint32 nRecords );
+
     Trixel trixel;
     unsigned long nStars;
     long readOffset;
@@ -0,0 +1,165 @@
+/***************************************************************************
+                 starblockprefetcher.cpp  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "starblockprefetcher.h"
+#include "deepstarcomponent.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+
+// Maximum number of trixels whose records may wait to be picked up. Records
+// of trixels that were predicted to become visible but never did are
+// dropped first once this is exceeded.
+#define MAX_READY_TRIXELS 512
+
+// Number of records read at a time, before looking at the magnitude of the last one
+#define RECORDS_PER_READ 128
+
+StarBlockPrefetcher::StarBlockPrefetcher( const QString &filePath, quint32 recordSize, bool byteSwap, QObject *parent ) :
+    QThread( parent ),
+    m_FilePath( filePath ),
+    m_RecordSize( recordSize ),
+    m_ByteSwap( byteSwap ),
+    m_Abort( false ),
+    m_Failed( false )
+{
+}
+
+StarBlockPrefetcher::~StarBlockPrefetcher() {
+    m_Mutex.lock();
+    m_Abort = true;
+    m_Condition.wakeOne();
+    m_Mutex.unlock();
+
+    wait();
+}
+
+void StarBlockPrefetcher::request( Trixel trixel, quint32 offset, quint32 length, float maglim ) {
+    if( length == 0 || m_RecordSize == 0 )
+        return;
+
+    QMutexLocker locker( &m_Mutex );
+
+    if( m_Failed || m_Pending.contains( trixel ) || m_Ready.contains( trixel ) )
+        return;
+
+    Request req;
+    req.trixel = trixel;
+    req.offset = offset;
+    req.length = length - length % m_RecordSize;
+    req.maglim = maglim;
+    m_Queue.append( req );
+    m_Pending.insert( trixel );
+
+    if( !isRunning() )
+        start( QThread::LowPriority );
+    else
+        m_Condition.wakeOne();
+}
+
+bool StarBlockPrefetcher::isPending( Trixel trixel ) const {
+    QMutexLocker locker( &m_Mutex );
+    return m_Pending.contains( trixel );
+}
+
+bool StarBlockPrefetcher::take( Trixel trixel, QByteArray &records, quint32 &offset ) {
+    QMutexLocker locker( &m_Mutex );
+
+    if( !m_Ready.contains( trixel ) )
+        return false;
+
+    QPair<quint32, QByteArray> entry = m_Ready.take( trixel );
+    m_ReadyOrder.removeOne( trixel );
+    offset = entry.first;
+    records = entry.second;
+    return true;
+}
+
+void StarBlockPrefetcher::clearPending() {
+    QMutexLocker locker( &m_Mutex );
+
+    foreach( const Request &req, m_Queue )
+        m_Pending.remove( req.trixel );
+    m_Queue.clear();
+}
+
+void StarBlockPrefetcher::run() {
+    QFile file( m_FilePath );
+    if( !file.open( QIODevice::ReadOnly ) ) {
+        qWarning() << "StarBlockPrefetcher: Could not open " << m_FilePath;
+        // Do not restart the thread for every request that follows
+        QMutexLocker locker( &m_Mutex );
+        m_Failed = true;
+        m_Queue.clear();
+        m_Pending.clear();
+        return;
+    }
+
+    bool readSomething = false;
+
+    forever {
+        m_Mutex.lock();
+        if( m_Queue.isEmpty() && !m_Abort ) {
+            if( readSomething ) {
+                readSomething = false;
+                m_Mutex.unlock();
+                emit recordsReady();
+                continue;
+            }
+            m_Condition.wait( &m_Mutex );
+        }
+        if( m_Abort ) {
+            m_Mutex.unlock();
+            return;
+        }
+        if( m_Queue.isEmpty() ) {
+            m_Mutex.unlock();
+            continue;
+        }
+        Request req = m_Queue.takeFirst();
+        m_Mutex.unlock();
+
+        // Read up to the first record fainter than the magnitude limit
+        QByteArray records;
+        bool complete = file.seek( req.offset );
+        while( complete && (quint32) records.size() < req.length ) {
+            quint32 chunk = qMin( req.length - records.size(), RECORDS_PER_READ * m_RecordSize );
+            QByteArray data = file.read( chunk );
+            if( data.size() != (int) chunk ) {
+                complete = false;
+                break;
+            }
+            records.append( data );
+            if( DeepStarComponent::recordMag( data.constData() + chunk - m_RecordSize, m_RecordSize, m_ByteSwap ) > req.maglim )
+                break;
+        }
+
+        m_Mutex.lock();
+        m_Pending.remove( req.trixel );
+        if( complete && !records.isEmpty() ) {
+            m_Ready.insert( req.trixel, qMakePair( req.offset, records ) );
+            m_ReadyOrder.append( req.trixel );
+            while( m_ReadyOrder.size() > MAX_READY_TRIXELS )
+                m_Ready.remove( m_ReadyOrder.takeFirst() );
+            readSomething = true;
+        }
+        else
+            qWarning() << "StarBlockPrefetcher: Short read of " << req.length << " bytes at offset " << req.offset << " for trixel " << req.trixel;
+        m_Mutex.unlock();
+    }
+}
@@ -0,0 +1,135 @@
+/***************************************************************************
+                  starblockprefetcher.h  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef STARBLOCKPREFETCHER_H
+#define STARBLOCKPREFETCHER_H
+
+#include "typedef.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+/**
+ *@class StarBlockPrefetcher
+ *
+ *Reads star records of a deep star catalog on a worker thread, so that
+ *the draw path does not have to wait for the disk. The draw path requests
+ *the records of trixels that are (or are about to become) visible, and
+ *later picks up whatever has arrived with take(), filling the StarBlocks
+ *from memory through StarBlockList::fillToMag().
+ *
+ *The worker thread only performs file I/O. StarBlockList and
+ *StarBlockFactory are not thread-safe, so they are still only touched
+ *from the thread that draws the sky.
+ *
+ *@short Asynchronous reader of star records for dynamically loaded catalogs
+ *@author The KStars Team
+ *@version 0.1
+ */
+
+class StarBlockPrefetcher : public QThread
+{
+    Q_OBJECT
+
+public:
+    /**
+     *Constructor
+     *@param filePath   Full path to the binary star catalog
+     *@param recordSize Size of a star record in the catalog
+     *@param byteSwap   Whether the records need to be byte swapped
+     *@param parent     Parent QObject
+     */
+    StarBlockPrefetcher( const QString &filePath, quint32 recordSize, bool byteSwap, QObject *parent = 0 );
+
+    /**
+     *Destructor. Stops the worker thread and waits for it to finish.
+     */
+    ~StarBlockPrefetcher();
+
+    /**
+     *@short Queue a read of the records of a trixel
+     *
+     *Requests for trixels that are already queued, being read or ready are ignored,
+     *and so are all requests once the catalog could not be opened. The records are
+     *sorted by magnitude, so reading stops past the first record fainter than maglim,
+     *as StarBlockList::fillToMag() does.
+     *
+     *@param trixel  The trixel the records belong to
+     *@param offset  Offset in the file of the first record to read
+     *@param length  Number of bytes to read at most
+     *@param maglim  Magnitude limit to read records upto
+     */
+    void request( Trixel trixel, quint32 offset, quint32 length, float maglim );
+
+    /**
+     *@short  Check whether records of the given trixel are queued or being read
+     */
+    bool isPending( Trixel trixel ) const;
+
+    /**
+     *@short  Retrieve the records read for the given trixel, if they are available
+     *@param  trixel  The trixel whose records are required
+     *@param  records Filled with the records read from the file
+     *@param  offset  Set to the offset in the file of the first record in records
+     *@return true if records were available, false otherwise. Never blocks on I/O.
+     */
+    bool take( Trixel trixel, QByteArray &records, quint32 &offset );
+
+    /**
+     *@short  Drop all queued requests that the worker has not started on yet
+     */
+    void clearPending();
+
+signals:
+    /**
+     *@short Emitted from the worker thread whenever it runs out of queued requests
+     *after having read some records.
+     */
+    void recordsReady();
+
+protected:
+    void run() Q_DECL_OVERRIDE;
+
+private:
+    struct Request {
+        Trixel trixel;
+        quint32 offset;
+        quint32 length;
+        float maglim;
+    };
+
+    QString m_FilePath;
+    quint32 m_RecordSize;
+    bool m_ByteSwap;
+    mutable QMutex m_Mutex;
+    QWaitCondition m_Condition;
+    QList<Request> m_Queue;                               // Requests not yet started
+    QSet<Trixel> m_Pending;                               // Trixels queued or being read
+    QHash< Trixel, QPair<quint32, QByteArray> > m_Ready;  // Records read but not yet taken
+    QList<Trixel> m_ReadyOrder;                           // Order in which m_Ready was filled
+    bool m_Abort;
+    bool m_Failed;                                        // The catalog could not be opened
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "starcomponent.h"
 
 #include <qplatformdefs.h>
+#include <QVarLengthArray>
 
 #include "Options.h"
 #include "kstarsdata.h"
@@ -237,11 +238,16 @@ float StarComponent::zoomMagnitudeLimit() {
 void StarComponent::draw( SkyPainter *skyp )
 {
 #ifndef KSTARS_LITE
+    // The labels are kept until the next draw() rather than cleared in
+    // drawLabels(), so that they can be drawn again when the sky map
+    // reuses a cached image of this component.
+    for ( int i = 0; i <= MAX_LINENUMBER_MAG; i++ )
+        m_labelList[ i ]->clear();
+
     if( !selected() )
         return;
 
     SkyMap *map             = SkyMap::Instance();
-    const Projector *proj   = map->projector();
     KStarsData* data        = KStarsData::Instance();
     UpdateID updateID       = data->updateID();
 
@@ -294,11 +300,24 @@ void StarComponent::draw( SkyPainter *skyp )
 
     int nTrixels = 0;
 
+    // The stars of each trixel are collected and handed to the painter in one
+    // batch, so that they are projected together.
+    QVarLengthArray<SkyPoint*, 256> points;
+    QVarLengthArray<float, 256> mags;
+    QVarLengthArray<char, 256> spTypes;
+    QVarLengthArray<QPointF, 256> screen;
+    QVarLengthArray<bool, 256> drawn;
+
     while( region.hasNext() ) {
         ++nTrixels;
         Trixel currentRegion = region.next();
         StarList* starList = m_starIndex->at( currentRegion );
 
+        points.resize( starList->size() );
+        mags.resize( starList->size() );
+        spTypes.resize( starList->size() );
+        int nStars = 0;
+
         for (int i=0; i < starList->size(); ++i) {
             StarObject *curStar = starList->at( i );
             if( !curStar )
@@ -313,11 +332,23 @@ void StarComponent::draw( SkyPainter *skyp )
             if ( curStar->updateID != updateID )
                 curStar->JITupdate();
 
-            bool drawn = skyp->drawPointSource( curStar, mag, curStar->spchar() );
+            points[ nStars ] = curStar;
+            mags[ nStars ] = mag;
+            spTypes[ nStars ] = curStar->spchar();
+            ++nStars;
+        }
+
+        screen.resize( nStars );
+        drawn.resize( nStars );
+        skyp->drawPointSources( points.constData(), mags.constData(), spTypes.constData(), nStars,
+                                screen.data(), drawn.data() );
 
+        if ( m_hideLabels )
+            continue;
+        for ( int i = 0; i < nStars; ++i ) {
             //FIXME_SKYPAINTER: find a better way to do this.
-            if ( drawn && !(m_hideLabels || mag > labelMagLim) )
-                addLabel( proj->toScreen(curStar), curStar );
+            if ( drawn[ i ] && mags[ i ] <= labelMagLim )
+                addLabel( screen[ i ], static_cast<StarObject *>( points[ i ] ) );
         }
     }
 
@@ -363,7 +394,6 @@ void StarComponent::drawLabels()
         for ( int j = 0; j < list->size(); j++ ) {
             labeler->drawNameLabel( list->at(j).obj, list->at(j).o );
         }
-        list->clear();
     }
 
 }
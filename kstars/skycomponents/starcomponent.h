@@ -89,8 +89,10 @@ public:
 
     void draw( SkyPainter *skyp );
 
-    /** @short draw all the labels in the prioritized LabelLists and then
-     * clear the LabelLists. */
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation | DependsOnLoadedData; }
+
+    /** @short draw all the labels in the prioritized LabelLists. The
+     * LabelLists are cleared by the next call to draw(). */
     void drawLabels();
 
     static float zoomMagnitudeLimit();
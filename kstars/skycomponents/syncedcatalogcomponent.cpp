@@ -22,6 +22,9 @@
 #include "deepskyobject.h"
 #include "Options.h"
 #include "catalogdata.h"
+#ifndef KSTARS_LITE
+#include "skymap.h"
+#endif
 
 /* KDE Includes */
 
@@ -102,5 +105,10 @@ DeepSkyObject *SyncedCatalogComponent::addObject( CatalogEntryData catalogEntry
     }
     m_ObjectList.append( newObj );
     qDebug() << "Added new SkyObject " << newObj->name() << " to synced catalog " << m_catName << " which now contains " << m_ObjectList.count() << " objects.";
+#ifndef KSTARS_LITE
+    // The cached layer of the sky map with this catalog has to show the new object
+    if( SkyMap::Instance() )
+        SkyMap::Instance()->forceLayerUpdate( DependsOnLoadedData );
+#endif
     return newObj;
 }
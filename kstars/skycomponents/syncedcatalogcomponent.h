@@ -61,6 +61,9 @@ class SyncedCatalogComponent : public CatalogComponent {
 
     virtual void loadData() { _loadData( false ); }
 
+    /** Objects are added while the sky map is shown, see addObject() */
+    virtual int drawDependencies() const { return DependsOnEpoch | DependsOnSkyRotation | DependsOnLoadedData; }
+
     //    virtual bool selected();
 
  private:
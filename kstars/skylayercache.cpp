@@ -0,0 +1,164 @@
+/***************************************************************************
+                  skylayercache.cpp  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "skylayercache.h"
+
+#include <QPainter>
+
+#include "Options.h"
+#include "kstarsdata.h"
+#include "skymap.h"
+#include "projections/projector.h"
+#include "skycomponents/skycomponent.h"
+
+SkyLayerCache::SkyLayerCache()
+{
+    m_view = ViewState();
+}
+
+void SkyLayerCache::invalidate()
+{
+    // The pixmaps are kept for the next frames
+    for ( int i = 0; i < m_layers.size(); i++ )
+        m_layers[i].valid = false;
+}
+
+void SkyLayerCache::invalidate( int dependencies )
+{
+    for ( int i = 0; i < m_layers.size(); i++ ) {
+        if ( m_layers[i].valid && ( m_layers[i].dependencies & dependencies ) ) {
+            // The layers above were drawn with the labels of this one
+            for ( int j = i; j < m_layers.size(); j++ )
+                m_layers[j].valid = false;
+            return;
+        }
+    }
+}
+
+bool SkyLayerCache::keeps( int dependencies ) const
+{
+    // Nothing can be reused while the map is slewing
+    return dependencies != SkyComponent::DependsOnEverything && !m_view.slewing;
+}
+
+void SkyLayerCache::beginFrame()
+{
+    SkyMap *map = SkyMap::Instance();
+    KStarsData *data = KStarsData::Instance();
+
+    m_view.size       = map->size();
+    m_view.zoom       = Options::zoomFactor();
+    m_view.projection = map->projector()->type();
+    m_view.useAltAz   = Options::useAltAz();
+    m_view.fillGround = Options::showGround();
+    m_view.slewing    = map->isSlewing();
+
+    if ( m_view.useAltAz ) {
+        m_view.focusLong = map->focus()->az().Degrees();
+        m_view.focusLat  = map->focus()->alt().Degrees();
+    } else {
+        m_view.focusLong = map->focus()->ra().Degrees();
+        m_view.focusLat  = map->focus()->dec().Degrees();
+    }
+
+    m_view.lst      = data->lst()->Degrees();
+    m_view.latitude = data->geo()->lat()->Degrees();
+    m_view.epoch    = data->updateNum()->julianDay();
+    m_view.jd       = data->ut().djd();
+}
+
+bool SkyLayerCache::isValid( int layer, int dependencies ) const
+{
+    if ( dependencies == SkyComponent::DependsOnEverything || m_view.slewing )
+        return false;
+    if ( layer >= m_layers.size() || !m_layers[layer].valid || m_layers[layer].dependencies != dependencies )
+        return false;
+
+    const ViewState &v = m_layers[layer].view;
+    if ( v.size != m_view.size || v.zoom != m_view.zoom || v.projection != m_view.projection
+         || v.useAltAz != m_view.useAltAz || v.fillGround != m_view.fillGround
+         || v.focusLong != m_view.focusLong || v.focusLat != m_view.focusLat )
+        return false;
+
+    if ( ( dependencies & SkyComponent::DependsOnEpoch ) && v.epoch != m_view.epoch )
+        return false;
+    if ( ( dependencies & SkyComponent::DependsOnTime ) && v.jd != m_view.jd )
+        return false;
+
+    // The celestial sphere turns on the map with the sidereal time in
+    // horizontal coordinates, and so does the horizon in equatorial
+    // coordinates. When the ground is filled, the part of the sky hidden
+    // below the horizon moves in either case. The same goes for a change
+    // of the latitude.
+    if ( v.lst != m_view.lst || v.latitude != m_view.latitude ) {
+        if ( ( dependencies & SkyComponent::DependsOnSkyRotation ) && ( m_view.useAltAz || m_view.fillGround ) )
+            return false;
+        if ( ( dependencies & SkyComponent::DependsOnHorizon ) && !m_view.useAltAz )
+            return false;
+    }
+
+    return true;
+}
+
+QPixmap *SkyLayerCache::image( int layer, const QPixmap &device )
+{
+    if ( layer >= m_layers.size() )
+        m_layers.resize( layer + 1 );
+
+    QPixmap &image = m_layers[layer].image;
+    if ( image.size() != device.size() || image.devicePixelRatio() != device.devicePixelRatio() ) {
+        image = QPixmap( device.size() );
+        image.setDevicePixelRatio( device.devicePixelRatio() );
+    }
+    image.fill( Qt::transparent );
+    return &image;
+}
+
+void SkyLayerCache::draw( int layer, QPainter *p ) const
+{
+    Q_ASSERT( layer < m_layers.size() && m_layers[layer].valid );
+
+    p->save();
+    p->setClipping( false );
+    p->drawPixmap( 0, 0, m_layers[layer].image );
+    p->restore();
+}
+
+void SkyLayerCache::restoreLabels( int layer ) const
+{
+    Q_ASSERT( layer < m_layers.size() && m_layers[layer].valid );
+    SkyLabeler::Instance()->restoreState( m_layers[layer].labels );
+}
+
+void SkyLayerCache::store( int layer, int dependencies )
+{
+    if ( layer >= m_layers.size() )
+        m_layers.resize( layer + 1 );
+
+    // The layers above this one were drawn with its old labels
+    for ( int i = layer; i < m_layers.size(); i++ )
+        m_layers[i].valid = false;
+
+    if ( !keeps( dependencies ) )
+        return;
+
+    Layer &l = m_layers[layer];
+    SkyLabeler::Instance()->saveState( &l.labels );
+    l.view = m_view;
+    l.dependencies = dependencies;
+    l.valid = true;
+}
@@ -0,0 +1,134 @@
+/***************************************************************************
+                   skylayercache.h  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef SKYLAYERCACHE_H_
+#define SKYLAYERCACHE_H_
+
+#include <QPixmap>
+#include <QSize>
+#include <QVector>
+
+#include "skycomponents/skylabeler.h"
+
+class QPainter;
+
+/**
+ *@class SkyLayerCache
+ *@short Images of the sky map taken after each of its layers was drawn.
+ *
+ * SkyMapComposite::draw() groups the components into layers (see
+ * SkyPainter::beginLayer()). Each layer that may be kept is drawn on its own
+ * transparent pixmap, which is then drawn on the sky map. store() records the
+ * labels drawn so far and the view the layer was drawn for. On the next
+ * redraw, every layer whose components do not depend on anything that has
+ * changed since (see SkyComponent::drawDependencies()) is drawn from its
+ * pixmap, as long as all the layers below it could be too. The pixmaps are
+ * kept from one frame to the next and only reallocated when the map is
+ * resized.
+ *
+ * Anything that changes the sky map in a way the dependencies cannot see,
+ * like the options or the color scheme, must call invalidate(). SkyMap does
+ * so in forceUpdate().
+ *
+ *@version 1.0
+ */
+class SkyLayerCache
+{
+public:
+    SkyLayerCache();
+
+    /** @short forget all the stored layers. */
+    void invalidate();
+
+    /**
+     * @short forget the stored layers with any of the DrawDependency flags in
+     * @p dependencies, and all the layers above them.
+     */
+    void invalidate( int dependencies );
+
+    /**
+     * @return true if a layer with these DrawDependency flags is worth
+     * drawing on its own pixmap, so that it can be kept.
+     */
+    bool keeps( int dependencies ) const;
+
+    /**
+     * @short record the view that the layers of the current frame are drawn
+     * for. Must be called before any of the other methods in each frame, once
+     * the positions of the sky objects have been synchronized.
+     */
+    void beginFrame();
+
+    /**
+     * @return true if the image stored for @p layer can be used instead of
+     * drawing it, i.e. it was stored for the same components and nothing they
+     * depend on has changed since.
+     * @param layer the position of the layer from the bottom of the sky map
+     * @param dependencies the combined SkyComponent::DrawDependency flags of
+     * the components in the layer
+     */
+    bool isValid( int layer, int dependencies ) const;
+
+    /**
+     * @return the pixmap that @p layer is drawn on, cleared and of the same
+     * size as @p device
+     */
+    QPixmap *image( int layer, const QPixmap &device );
+
+    /** @short draw the pixmap of @p layer on @p p, over what is there. */
+    void draw( int layer, QPainter *p ) const;
+
+    /** @short restore the labels drawn up to and including @p layer. */
+    void restoreLabels( int layer ) const;
+
+    /**
+     * @short record that @p layer has been drawn on its pixmap, along with
+     * the labels drawn so far.  Layers that are not kept() only forget what
+     * was stored for them and above them.
+     */
+    void store( int layer, int dependencies );
+
+private:
+    /** What the components of the sky map may depend on */
+    struct ViewState {
+        QSize size;
+        double zoom;
+        int projection;
+        bool useAltAz;
+        bool fillGround;
+        bool slewing;
+        double focusLong, focusLat;  ///< Az/Alt in horizontal coordinates, otherwise RA/Dec
+        double lst;
+        double latitude;
+        long double epoch;
+        long double jd;
+    };
+
+    struct Layer {
+        Layer() : dependencies( 0 ), valid( false ) {}
+        QPixmap image;
+        SkyLabeler::State labels;
+        ViewState view;
+        int dependencies;
+        bool valid;
+    };
+
+    QVector<Layer> m_layers;
+    ViewState m_view;
+};
+
+#endif
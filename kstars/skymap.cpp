@@ -408,9 +408,9 @@ void SkyMap::slotUpdateSky( bool now ) {
     updateFocus();
 
     if ( now )
-        QTimer::singleShot( 0, this, SLOT( forceUpdateNow() ) ); // Why is it done this way rather than just calling forceUpdateNow()? -- asimha
+        QTimer::singleShot( 0, this, SLOT( forceTimeUpdateNow() ) ); // Why is it done this way rather than just calling forceUpdateNow()? -- asimha
     else
-        forceUpdate();
+        forceTimeUpdate();
 }
 
 void SkyMap::slotDSS() {
@@ -976,6 +976,24 @@ void SkyMap::setZoomFactor(double factor) {
 // if now=true, SkyMap::paintEvent() is run immediately, rather than being added to the event queue
 // also, determine new coordinates of mouse cursor.
 void SkyMap::forceUpdate( bool now )
+{
+    SkyMapDrawAbstract *skyMapDraw = getSkyMapDrawAbstract();
+    if ( skyMapDraw )
+        skyMapDraw->invalidateLayerCache();
+
+    forceTimeUpdate( now );
+}
+
+void SkyMap::forceLayerUpdate( int dependencies )
+{
+    SkyMapDrawAbstract *skyMapDraw = getSkyMapDrawAbstract();
+    if ( skyMapDraw )
+        skyMapDraw->invalidateLayerCache( dependencies );
+
+    forceTimeUpdate();
+}
+
+void SkyMap::forceTimeUpdate( bool now )
 {
     QPoint mp( mapFromGlobal( QCursor::pos() ) );
     if (! projector()->unusablePoint( mp )) {
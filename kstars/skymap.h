@@ -305,9 +305,28 @@ public slots:
      */
     void forceUpdateNow() { forceUpdate( true ); }
 
+    /** @short Like forceUpdate(), for when only the simulation clock has advanced.
+     * Unlike forceUpdate(), this keeps the cached layers of the sky map, so the
+     * ones whose components do not depend on the time are not redrawn.
+     * @param now if true, paintEvent() is run immediately.  Otherwise, it is added to the event queue
+     * @see SkyLayerCache
+     */
+    void forceTimeUpdate( bool now=false );
+
+    /** @short Convenience function; simply calls forceTimeUpdate(true).
+     * @see forceTimeUpdate()
+     */
+    void forceTimeUpdateNow() { forceTimeUpdate( true ); }
+
+    /** @short Like forceTimeUpdate(), for when the data of some components has changed.
+     * Only the cached layers of the sky map with components that have any of the
+     * SkyComponent::DrawDependency flags in @p dependencies are redrawn.
+     */
+    void forceLayerUpdate( int dependencies );
+
     /**
-     * @short Update the focus point and call forceUpdate()
-     * @param now is passed on to forceUpdate()
+     * @short Update the focus point and call forceTimeUpdate()
+     * @param now is passed on to forceTimeUpdate()
      */
     void slotUpdateSky( bool now );
 
@@ -360,6 +360,10 @@ void SkyMapDrawAbstract::exportSkyImage(SkyQPainter *painter, bool scale)
         painter->scale(scale, scale);
     }
 
+    // This redraws every component for the paint device, so the layers
+    // cached for the sky map no longer match the labels of the components
+    invalidateLayerCache();
+
     painter->drawSkyBackground();
     m_KStarsData->skyComposite()->draw(painter);
     drawOverlays(*painter);
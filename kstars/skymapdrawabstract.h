@@ -19,6 +19,7 @@
 #define SKYMAPDRAWABSTRACT_H_
 
 #include "kstarsdata.h"
+#include "skylayercache.h"
 #include <QPainter>
 #include <QPaintEvent>
 #include <QPaintDevice>
@@ -129,6 +130,19 @@ class SkyMapDrawAbstract {
      */
     static void setDrawLock( bool state );
 
+    /**
+     *@short Forget the cached images of the sky map layers, so that the next
+     * redraw recomputes all of them.
+     *@see SkyLayerCache
+     */
+    inline void invalidateLayerCache() { m_layerCache.invalidate(); }
+
+    /**
+     *@short Forget the cached images of the layers whose components have any
+     * of the SkyComponent::DrawDependency flags in @p dependencies.
+     */
+    inline void invalidateLayerCache( int dependencies ) { m_layerCache.invalidate( dependencies ); }
+
     // *********************** PURE VIRTUAL METHODS ******************* //
     // NOTE: The following methods differ between GL and QPainter backends
     //       Thus, they are pure virtual and must be implemented by the sublcass
@@ -154,6 +168,7 @@ class SkyMapDrawAbstract {
     KStarsData *m_KStarsData;
     SkyMap *m_SkyMap;
     static bool m_DrawLock;
+    SkyLayerCache m_layerCache;
 
     /** Calculate FPS and dump result to stderr using qDebug */
     //void calculateFPS();
@@ -20,6 +20,7 @@
 #include "skymap.h"
 #include "projections/projector.h"
 #include "printing/legend.h"
+#include "Options.h"
 
 SkyMapQDraw::SkyMapQDraw( SkyMap *sm ) : QWidget( sm ), SkyMapDrawAbstract( sm ) {
     m_SkyPixmap = new QPixmap( width(), height() );
@@ -66,6 +67,8 @@ void SkyMapQDraw::paintEvent( QPaintEvent *event ) {
     m_SkyMap->setupProjector();
     
     SkyQPainter psky(this, m_SkyPixmap); 
+    psky.setParallelRendering( Options::parallelRendering() );
+    psky.setLayerCache( &m_layerCache );
     //FIXME: we may want to move this into the components.
     psky.begin();
     
@@ -104,4 +107,5 @@ void SkyMapQDraw::resizeEvent( QResizeEvent *e ) {
     Q_UNUSED(e);
     delete m_SkyPixmap;
     m_SkyPixmap = new QPixmap( width(), height() );
+    invalidateLayerCache();
 }
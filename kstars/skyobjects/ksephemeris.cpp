@@ -0,0 +1,355 @@
+/***************************************************************************
+                          ksephemeris.cpp  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "ksephemeris.h"
+
+#include <cmath>
+
+#include <QtConcurrent>
+
+#include "kstarsdatetime.h"
+#include "ksmoon.h"
+#include "ksplanet.h"
+#include "kssun.h"
+#include "vsop87.h"
+
+// Chebyshev coefficients of each coordinate, over each piece of a segment
+#define EPHEMERIS_COEFFICIENTS  14
+// Pieces a segment may be split in before it is left to the series
+#define EPHEMERIS_MAX_PIECES    16
+// Segments kept for all bodies, about 20 MB
+#define EPHEMERIS_MAX_SEGMENTS  50000
+// Prepared intervals that are remembered
+#define EPHEMERIS_MAX_WINDOWS   16
+
+constexpr double KSEphemeris::TOLERANCE;
+
+namespace {
+
+struct BodyData {
+    // Length of the segments, in days
+    double days;
+    // Smallest distance of the body, in AU, by which the tolerance of the distance is scaled
+    double distance;
+};
+
+// The segments are as long as the polynomials allow with some margin, fewer of them need fitting
+const BodyData BODIES[KSEphemeris::BODY_COUNT] = {
+    {  16.0,  0.30  },  // Mercury
+    {  64.0,  0.71  },  // Venus
+    {  32.0,  0.98  },  // Earth
+    { 128.0,  1.38  },  // Mars
+    { 256.0,  4.95  },  // Jupiter
+    { 256.0,  9.0   },  // Saturn
+    { 512.0, 18.3   },  // Uranus
+    { 512.0, 29.8   },  // Neptune
+    {   8.0,  0.0024 }  // Moon
+};
+
+// Value at x in [-1, 1] of the Chebyshev series, by Clenshaw's recurrence
+double chebyshev( const double *c, double x ) {
+    double b1 = 0.0, b2 = 0.0;
+
+    for ( int j = EPHEMERIS_COEFFICIENTS - 1; j >= 1; --j ) {
+        double b = 2.0*x*b1 - b2 + c[j];
+        b2 = b1;
+        b1 = b;
+    }
+
+    return x*b1 - b2 + c[0];
+}
+
+// Scopes held by the current thread
+thread_local int scopeCount = 0;
+
+}
+
+KSEphemeris::Scope::Scope() {
+    ++scopeCount;
+}
+
+KSEphemeris::Scope::~Scope() {
+    --scopeCount;
+}
+
+KSEphemeris::KSEphemeris() : segmentCount( 0 ) {
+    moon = new KSMoon();
+    moon->loadData();
+}
+
+KSEphemeris *KSEphemeris::Instance() {
+    // Never deleted, the objects may use it until the very end
+    static KSEphemeris *ephemeris = new KSEphemeris();
+    return ephemeris;
+}
+
+int KSEphemeris::body( const KSPlanetBase *object ) {
+    if ( dynamic_cast<const KSMoon *>( object ) )
+        return MOON;
+    if ( dynamic_cast<const KSSun *>( object ) )
+        return EARTH;
+
+    const KSPlanet *planet = dynamic_cast<const KSPlanet *>( object );
+    if ( planet )
+        return VSOP87::planet( planet->untranslatedName() );
+
+    return -1;
+}
+
+void KSEphemeris::prepare( long double startJD, long double stopJD, const QList<int> &bodies ) {
+    const double start = startJD - J2000;
+    const double stop  = stopJD - J2000;
+    QVector<Job> jobs;
+
+    {
+        QReadLocker locker( &lock );
+        if ( isPrepared( start, stop, bodies ) )
+            return;
+    }
+
+    {
+        QWriteLocker locker( &lock );
+
+        if ( covers( start, stop ) == false ) {
+            windows.append( qMakePair( start, stop ) );
+            if ( windows.size() > EPHEMERIS_MAX_WINDOWS )
+                windows.removeFirst();
+        }
+
+        foreach ( int b, bodies ) {
+            if ( b < 0 || b >= BODY_COUNT )
+                continue;
+
+            const qint64 first = (qint64) floor( start / BODIES[b].days );
+            const qint64 last  = (qint64) floor( stop / BODIES[b].days );
+            for ( qint64 index = first; index <= last; ++index ) {
+                if ( segments[b].contains( index ) == false ) {
+                    Job job;
+                    job.body  = b;
+                    job.index = index;
+                    jobs.append( job );
+                }
+            }
+        }
+    }
+
+    // More segments than are kept would be fitted for nothing, these are left to be fitted as needed
+    if ( jobs.isEmpty() || jobs.size() > EPHEMERIS_MAX_SEGMENTS / 2 )
+        return;
+
+    // The segments do not depend on each other
+    QtConcurrent::blockingMap( jobs, [this]( Job &job ) {
+        fit( job.body, job.index, job.segment );
+    } );
+
+    QWriteLocker locker( &lock );
+    foreach ( const Job &job, jobs )
+        insert( job.body, job.index, job.segment );
+}
+
+bool KSEphemeris::ecliptic( int body, double jm, EclipticPosition &ret ) {
+    // Only the tools that prepared the ephemeris use it
+    if ( scopeCount == 0 || body < 0 || body >= BODY_COUNT )
+        return false;
+
+    const double days = jm * 365250.0;
+    const double length = BODIES[body].days;
+    const qint64 index = (qint64) floor( days / length );
+    Segment segment;
+    bool found = false;
+
+    {
+        QReadLocker locker( &lock );
+
+        QHash<qint64, Segment>::const_iterator it = segments[body].constFind( index );
+        if ( it != segments[body].constEnd() ) {
+            segment = it.value();
+            found = true;
+        } else if ( covers( days ) == false )
+            return false;
+    }
+
+    // Fit the segment the first time it is needed within a prepared interval
+    if ( found == false ) {
+        fit( body, index, segment );
+
+        QWriteLocker locker( &lock );
+        insert( body, index, segment );
+    }
+
+    if ( segment.pieces == 0 )
+        return false;
+
+    // Position within the piece, in [-1, 1]
+    const double pieceLength = length / segment.pieces;
+    const double offset = days - index * length;
+    const int piece = qBound( 0, (int) ( offset / pieceLength ), segment.pieces - 1 );
+    const double x = qBound( -1.0, 2.0 * ( offset - piece * pieceLength ) / pieceLength - 1.0, 1.0 );
+    const double *c = segment.coefficients.constData() + piece * 3 * EPHEMERIS_COEFFICIENTS;
+
+    ret.longitude.setRadians( chebyshev( c, x ) );
+    ret.longitude = ret.longitude.reduce();
+    ret.latitude.setRadians( chebyshev( c + EPHEMERIS_COEFFICIENTS, x ) );
+    ret.radius = chebyshev( c + 2 * EPHEMERIS_COEFFICIENTS, x );
+
+    return true;
+}
+
+void KSEphemeris::clear() {
+    QWriteLocker locker( &lock );
+
+    windows.clear();
+    for ( int b=0; b < BODY_COUNT; ++b )
+        segments[b].clear();
+    segmentCount = 0;
+}
+
+bool KSEphemeris::covers( double days ) const {
+    for ( int i=0; i < windows.size(); ++i ) {
+        if ( days >= windows[i].first && days <= windows[i].second )
+            return true;
+    }
+
+    return false;
+}
+
+bool KSEphemeris::covers( double start, double stop ) const {
+    for ( int i=0; i < windows.size(); ++i ) {
+        if ( start >= windows[i].first && stop <= windows[i].second )
+            return true;
+    }
+
+    return false;
+}
+
+// The interval lies within a prepared one, and the segments of the bodies are all fitted
+bool KSEphemeris::isPrepared( double start, double stop, const QList<int> &bodies ) const {
+    if ( covers( start, stop ) == false )
+        return false;
+
+    foreach ( int b, bodies ) {
+        if ( b < 0 || b >= BODY_COUNT )
+            continue;
+
+        const qint64 first = (qint64) floor( start / BODIES[b].days );
+        const qint64 last  = (qint64) floor( stop / BODIES[b].days );
+        for ( qint64 index = first; index <= last; ++index ) {
+            if ( segments[b].contains( index ) == false )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void KSEphemeris::insert( int body, qint64 index, const Segment &segment ) {
+    if ( segments[body].contains( index ) )
+        return;
+
+    // Start over rather than grow without bounds. The segments that are still needed are fitted again.
+    if ( segmentCount >= EPHEMERIS_MAX_SEGMENTS ) {
+        for ( int b=0; b < BODY_COUNT; ++b )
+            segments[b].clear();
+        segmentCount = 0;
+    }
+
+    segments[body].insert( index, segment );
+    segmentCount++;
+}
+
+// Coordinates from the series. The truncation of VSOP87 takes a quarter of the tolerance.
+void KSEphemeris::sample( int body, double days, double coordinates[3] ) const {
+    if ( body == MOON ) {
+        EclipticPosition pos;
+        moon->calcEcliptic( days / 36525.0, pos );
+        coordinates[0] = pos.longitude.radians();
+        coordinates[1] = pos.latitude.radians();
+        coordinates[2] = pos.radius;
+        return;
+    }
+
+    const double jm = days / 365250.0;
+    coordinates[0] = VSOP87::evaluate( body, VSOP87::LONGITUDE, jm, TOLERANCE / 4 );
+    coordinates[1] = VSOP87::evaluate( body, VSOP87::LATITUDE, jm, TOLERANCE / 4 );
+    coordinates[2] = VSOP87::evaluate( body, VSOP87::RADIUS, jm, TOLERANCE / 4 * BODIES[body].distance );
+}
+
+bool KSEphemeris::fitPiece( int body, double start, double length, double *coefficients ) const {
+    const int N = EPHEMERIS_COEFFICIENTS;
+    double values[N][3];
+
+    // Interpolate at the Chebyshev nodes
+    for ( int k=0; k < N; ++k ) {
+        double x = cos( dms::PI * ( k + 0.5 ) / N );
+        sample( body, start + ( x + 1.0 ) * length / 2.0, values[k] );
+
+        // The lunar longitude wraps around, keep it continuous
+        if ( k > 0 )
+            values[k][0] -= 2.0 * dms::PI * floor( ( values[k][0] - values[k-1][0] ) / ( 2.0 * dms::PI ) + 0.5 );
+    }
+
+    for ( int c=0; c < 3; ++c ) {
+        for ( int j=0; j < N; ++j ) {
+            double sum = 0.0;
+            for ( int k=0; k < N; ++k )
+                sum += values[k][c] * cos( dms::PI * j * ( k + 0.5 ) / N );
+            coefficients[c*N + j] = ( j == 0 ? 1.0 : 2.0 ) * sum / N;
+        }
+    }
+
+    // The interpolation error of a smooth function follows the next Chebyshev polynomial,
+    // whose extrema are at cos(k*pi/N). The points halfway between them are checked as well,
+    // in case the error does not follow it closely. This bound is empirical, half of the
+    // tolerance is left for the points that are not checked.
+    for ( int k=0; k <= 2*N; ++k ) {
+        double x = cos( dms::PI * k / ( 2*N ) );
+        double coordinates[3];
+        sample( body, start + ( x + 1.0 ) * length / 2.0, coordinates );
+
+        for ( int c=0; c < 3; ++c ) {
+            double error = coordinates[c] - chebyshev( coefficients + c*N, x );
+            if ( c == 0 )
+                error = remainder( error, 2.0 * dms::PI );
+
+            double tolerance = ( c == 2 ) ? TOLERANCE * BODIES[body].distance : TOLERANCE;
+            if ( fabs( error ) > tolerance / 2 )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void KSEphemeris::fit( int body, qint64 index, Segment &segment ) const {
+    const double length = BODIES[body].days;
+
+    for ( int pieces=1; pieces <= EPHEMERIS_MAX_PIECES; pieces *= 2 ) {
+        segment.pieces = pieces;
+        segment.coefficients.resize( pieces * 3 * EPHEMERIS_COEFFICIENTS );
+
+        bool fitted = true;
+        for ( int p=0; p < pieces && fitted; ++p )
+            fitted = fitPiece( body, index * length + p * length / pieces, length / pieces,
+                               segment.coefficients.data() + p * 3 * EPHEMERIS_COEFFICIENTS );
+
+        if ( fitted )
+            return;
+    }
+
+    segment.pieces = 0;
+    segment.coefficients.clear();
+}
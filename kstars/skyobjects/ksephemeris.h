@@ -0,0 +1,133 @@
+/***************************************************************************
+                          ksephemeris.h  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef KSEPHEMERIS_H_
+#define KSEPHEMERIS_H_
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QReadWriteLock>
+#include <QVector>
+
+class EclipticPosition;
+class KSMoon;
+class KSPlanetBase;
+
+/** @class KSEphemeris
+ *Caches the ecliptic coordinates of the major planets and the Moon as piecewise
+ *Chebyshev polynomials.
+ *
+ *Tools that compute positions at many closely spaced instants, such as the
+ *conjunctions tool, the sky calendar or the altitude vs. time plot, declare the
+ *interval of time they work over with prepare(), and hold a Scope while they
+ *compute. Within the prepared intervals, and only in a thread that holds a Scope,
+ *KSPlanet, KSSun and KSMoon evaluate the polynomials rather than the VSOP87 and
+ *lunar series. Elsewhere, and in particular for the sky map, the series are
+ *evaluated as before.
+ *
+ *The time is cut in segments of a fixed length for each body, which are fitted
+ *when they are first needed, or in parallel by prepare(). Each fit is checked
+ *against the series where its interpolation error is the largest, and the segment
+ *is split until the error is below TOLERANCE. The few segments that cannot be
+ *fitted this way are left to the series.
+ *@short Chebyshev cache of the positions of the Sun, Moon and planets.
+ */
+class KSEphemeris {
+public:
+    /* Bodies of the cache. The planets are in the order of VSOP87::planet(). */
+    enum Body { MERCURY=0, VENUS, EARTH, MARS, JUPITER, SATURN, URANUS, NEPTUNE, MOON, BODY_COUNT };
+
+    /* Error of the polynomials, in radians, and relative to the distance */
+    static constexpr double TOLERANCE = 5e-8;
+
+    /** @class Scope
+     *Lets the current thread use the polynomials while it exists. Positions computed
+     *by a thread without a Scope always come from the series. Scopes may be nested.
+     */
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+    private:
+        Q_DISABLE_COPY( Scope )
+    };
+
+    /** @return the ephemeris shared by all objects */
+    static KSEphemeris *Instance();
+
+    /** @return the body whose coordinates give the position of the object, or -1 if
+     *there is none. This is the Earth for the Sun.
+     */
+    static int body( const KSPlanetBase *object );
+
+    /** @short Use the polynomials between two dates.
+     *Preparing an interval that is already prepared only takes a read lock, so
+     *that callers running in parallel do not wait on each other.
+     *@param startJD first date, as a Julian Day
+     *@param stopJD last date, as a Julian Day
+     *@param bodies bodies whose segments are fitted now, in parallel. The others are fitted when first needed.
+     */
+    void prepare( long double startJD, long double stopJD, const QList<int> &bodies=QList<int>() );
+
+    /** Find the ecliptic coordinates of a body from the polynomials.
+     *@param body planet, in the order of VSOP87::planet(), or MOON
+     *@param jm Julian Millenia since J2000
+     *@param ret heliocentric coordinates of a planet, or geocentric coordinates of the Moon,
+     *with the longitude reduced
+     *@return false if the current thread holds no Scope, if the date is not within a
+     *prepared interval, or if it is not fitted
+     */
+    bool ecliptic( int body, double jm, EclipticPosition &ret );
+
+    /* Forget the intervals and the polynomials */
+    void clear();
+
+private:
+    /* Polynomials over equal pieces of a segment. No pieces if the segment could not be fitted. */
+    struct Segment {
+        Segment() : pieces( 0 ) {}
+        int pieces;
+        QVector<double> coefficients;
+    };
+
+    struct Job {
+        int body;
+        qint64 index;
+        Segment segment;
+    };
+
+    KSEphemeris();
+
+    void sample( int body, double days, double coordinates[3] ) const;
+    bool fitPiece( int body, double start, double length, double *coefficients ) const;
+    void fit( int body, qint64 index, Segment &segment ) const;
+    void insert( int body, qint64 index, const Segment &segment );
+    bool covers( double days ) const;
+    bool covers( double start, double stop ) const;
+    bool isPrepared( double start, double stop, const QList<int> &bodies ) const;
+
+    QReadWriteLock lock;
+    // Prepared intervals, in days since J2000
+    QList< QPair<double, double> > windows;
+    QHash<qint64, Segment> segments[BODY_COUNT];
+    int segmentCount;
+    // Keeps the lunar series loaded
+    KSMoon *moon;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include <QFile>
 #include <QTextStream>
 
+#include "ksephemeris.h"
 #include "ksnumbers.h"
 #include "ksutils.h"
 #include "kssun.h"
@@ -149,17 +150,14 @@ bool KSMoon::loadData() {
     return true;
 }
 
-bool KSMoon::findGeocentricPosition( const KSNumbers *num, const KSPlanetBase* ) {
+void KSMoon::calcEcliptic( double T, EclipticPosition &ret ) const {
     //Algorithms in this subroutine are taken from Chapter 45 of "Astronomical Algorithms"
     //by Jean Meeus (1991, Willmann-Bell, Inc. ISBN 0-943396-35-2.  http://www.willbell.com/math/mc1.htm)
     //updated to Jean Messus (1998, Willmann-Bell, http://www.naughter.com/aa.html )
 
-    double T, L, D, M, M1, F, A1, A2, A3;
+    double L, D, M, M1, F, A1, A2, A3;
     double sumL, sumR, sumB;
 
-    //Julian centuries since J2000
-    T = num->julianCenturies();
-
     double Et = 1.0 - 0.002516*T - 0.0000074*T*T;
 
     //Moon's mean longitude
@@ -182,8 +180,6 @@ bool KSMoon::findGeocentricPosition( const KSNumbers *num, const KSPlanetBase* )
     sumL = 0.0;
     sumR = 0.0;
 
-    if (!loadData()) return false;
-
     for ( int i=0; i < LRData.size(); ++i ) {
         const MoonLRData& mlrd = LRData[i];
 
@@ -213,9 +209,23 @@ bool KSMoon::findGeocentricPosition( const KSNumbers *num, const KSPlanetBase* )
     sumB += ( -2235.0*sin( L ) + 382.0*sin( A3 ) + 175.0*sin( A1-F ) + 175.0*sin( A1+F ) + 127.0*sin( L-M1 ) - 115.0*sin( L+M1 ) );
 
     //Geocentric coordinates
-    setEcLong( dms( sumL/1000000.0 + L * 180.0 / dms::PI) ); //convert radians to degrees
-    setEcLat(  dms( sumB/1000000.0 ) );
-    Rearth = ( 385000.56 + sumR/1000.0 )/AU_KM; //distance from Earth, in AU
+    ret.longitude = dms( sumL/1000000.0 + L * 180.0 / dms::PI ); //convert radians to degrees
+    ret.latitude  = dms( sumB/1000000.0 );
+    ret.radius    = ( 385000.56 + sumR/1000.0 )/AU_KM; //distance from Earth, in AU
+}
+
+bool KSMoon::findGeocentricPosition( const KSNumbers *num, const KSPlanetBase* ) {
+    EclipticPosition pos;
+
+    //Tools that step through time use the cached polynomials
+    if ( KSEphemeris::Instance()->ecliptic( KSEphemeris::MOON, num->julianMillenia(), pos ) == false ) {
+        if (!loadData()) return false;
+        calcEcliptic( num->julianCenturies(), pos );
+    }
+
+    setEcLong( pos.longitude );
+    setEcLat( pos.latitude );
+    Rearth = pos.radius;
 
     EclipticToEquatorial( num->obliquity() );
 
@@ -232,12 +242,7 @@ void KSMoon::findMagnitude(const KSNumbers*)
     // SkyChart v3 Beta
     double phd = phase().Degrees();
     if( std::isnan( phd ) ) // Avoid nanny phases.
-    {
-        findPhase(NULL);
-        phd = phase().Degrees();
-        if (std::isnan( phd ))
-            return;
-    }
+        return;
     int p = floor( phd );
     if( p > 180 )
         p = p - 360;
@@ -249,14 +254,36 @@ void KSMoon::findMagnitude(const KSNumbers*)
     setMag( MagArray[i] + (MagArray[j] - MagArray[i]) * k / 10 );
 }
 
+void KSMoon::updateMag() {
+    // The phase may not be found yet
+    if( std::isnan( phase().Degrees() ) )
+        findPhase(NULL);
+
+    findMagnitude(NULL);
+}
+
+void KSMoon::setPhase( double degrees ) {
+    Phase = degrees; // Phase is obviously in degrees
+    double DegPhase = dms( Phase ).reduce().Degrees();
+    iPhase = int( 0.1*DegPhase+0.5 ) % 36; // iPhase must be in [0,36) range
+}
+
+void KSMoon::findPhaseFrom( const KSPlanetBase *Earth ) {
+    if( !Earth ) {
+        findPhase(NULL);
+        return;
+    }
+
+    // The Sun is seen from the Earth opposite to where the Earth is seen from the Sun
+    setPhase( ecLong().Degrees() - Earth->ecLong().Degrees() - 180.0 );
+}
+
 void KSMoon::findPhase( const KSSun *Sun ) {
 
     if( !Sun )
       Sun = ( const KSSun* ) KStarsData::Instance()->skyComposite()->findByName( "Sun" );
 
-    Phase = (ecLong() - Sun->ecLong()).Degrees(); // Phase is obviously in degrees
-    double DegPhase = dms( Phase ).reduce().Degrees();
-    iPhase = int( 0.1*DegPhase+0.5 ) % 36; // iPhase must be in [0,36) range
+    setPhase( (ecLong() - Sun->ecLong()).Degrees() );
 
     m_image = TextureManager::getImage(
         QString("moon%1").arg(iPhase,2,10,QChar('0')));
@@ -35,8 +35,6 @@ class KSSun;
 
 class KSMoon : public KSPlanetBase  {
 public:
-    using KSPlanetBase::findPhase;
-
     /** Default constructor. Set name="Moon". */
     KSMoon();
     /** Copy constructor */
@@ -52,7 +50,7 @@ public:
      *Determine the phase angle of the moon, and assign the appropriate
      *moon image
      * @param Sun a KSSun pointer with coordinates updated to the time of computation. If not supplied, the findByName() method will be used to find the sun.
-     *@note Overrides KSPlanetBase::findPhase()
+     *@note The image is looked up in the textures, so this is only called on the GUI thread.
      */
     virtual void findPhase( const KSSun *Sun = 0 );
 
@@ -82,15 +80,30 @@ public:
      */
     virtual bool findGeocentricPosition( const KSNumbers *num, const KSPlanetBase* );
 
+    /** Calculate the geocentric ecliptic coordinates of the Moon for the given date.
+     *The series must be loaded with loadData() first.
+     *@param T Julian centuries since J2000
+     *@param ret The ecliptic coordinates are returned by reference through this argument.
+     *The radius is the distance from the Earth, in AU.
+     */
+    void calcEcliptic( double T, EclipticPosition &ret ) const;
+
     /**
      * @brief updateMag calls findMagnitude() to calculate current magnitude of moon
      * according to current phase. This function is required to perform findMagnitude() from any where in Kstars
      */
-    void updateMag() { findMagnitude(NULL); }
+    void updateMag();
+
+protected:
+    /** Reimplemented from KSPlanetBase. The phase is found from the Sun as seen from Earth,
+     *and the image is left as it is.
+     */
+    virtual void findPhaseFrom( const KSPlanetBase *Earth );
 
 private:
     virtual void initPopupMenu( KSPopupMenu* pmenu );
     virtual void findMagnitude(const KSNumbers*);
+    void setPhase( double degrees );
 
     static bool data_loaded;
     static int instance_count;
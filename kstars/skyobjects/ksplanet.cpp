@@ -21,102 +21,18 @@
 
 #include <cmath>
 
-#include <QFile>
-#include <QTextStream>
-
 #include <QDebug>
 
+#include "ksephemeris.h"
 #include "ksnumbers.h"
-#include "ksutils.h"
-#include "ksfilereader.h"
-
-KSPlanet::OrbitDataManager KSPlanet::odm;
-
-KSPlanet::OrbitDataColl::OrbitDataColl() {
-}
-
-KSPlanet::OrbitDataManager::OrbitDataManager() {
-    //EMPTY
-}
-
-bool KSPlanet::OrbitDataManager::readOrbitData(const QString &fname,
-        QVector<OrbitData> *vector)
-{
-    QFile f;
-
-    if ( KSUtils::openDataFile( f, fname ) ) {
-        KSFileReader fileReader( f ); // close file is included
-        QStringList  fields;
-        while ( fileReader.hasMoreLines() ) {
-            fields = fileReader.readLine().split( ' ', QString::SkipEmptyParts );
-
-            if ( fields.size() == 3 ) {
-                double A = fields[0].toDouble();
-                double B = fields[1].toDouble();
-                double C = fields[2].toDouble();
-                vector->append( OrbitData(A, B, C) );
-            }
-        }
-    } else {
-        return false;
-    }
-    return true;
-}
-
-bool KSPlanet::OrbitDataManager::loadData( KSPlanet::OrbitDataColl &odc, const QString &n ) {
-    QString fname, snum, line;
-    QFile f;
-    int nCount = 0;
-    QString nl = n.toLower();
-
-    if ( hash.contains( nl ) ) {
-        odc = hash[nl];
-        return true;  //orbit data already loaded
-    }
-
-    //Create a new OrbitDataColl
-    OrbitDataColl ret;
-
-    //Ecliptic Longitude
-    for (int i=0; i<6; ++i) {
-        snum.setNum( i );
-        fname = nl + ".L" + snum + ".vsop";
-        if ( readOrbitData( fname, &ret.Lon[i] ) )
-            nCount++;
-    }
-
-    if ( nCount==0 ) return false;
-
-    //Ecliptic Latitude
-    for (int i=0; i<6; ++i) {
-        snum.setNum( i );
-        fname = nl + ".B" + snum + ".vsop";
-        if ( readOrbitData( fname, &ret.Lat[i] ) )
-            nCount++;
-    }
-
-    if ( nCount==0 ) return false;
-
-    //Heliocentric Distance
-    for (int i=0; i<6; ++i) {
-        snum.setNum( i );
-        fname = nl + ".R" + snum + ".vsop";
-        if ( readOrbitData( fname, &ret.Dst[i] ) )
-            nCount++;
-    }
-
-    if ( nCount==0 ) return false;
-
-    hash[nl] = ret;
-    odc = hash[nl];
-
-    return true;
-}
+#include "vsop87.h"
 
 KSPlanet::KSPlanet( const QString &s, const QString &imfile, const QColor & c, double pSize ) :
     KSPlanetBase(s, imfile, c, pSize ),
     data_loaded(false)
-{ }
+{
+    vsopPlanet = VSOP87::planet( untranslatedName() );
+}
 
 KSPlanet::KSPlanet( int n ) 
     : KSPlanetBase()
@@ -147,6 +63,8 @@ KSPlanet::KSPlanet( int n )
             qDebug() << "Error: Illegal identifier in KSPlanet constructor: " << n;
             break;
     }
+
+    vsopPlanet = VSOP87::planet( untranslatedName() );
 }
 
 KSPlanet* KSPlanet::clone() const
@@ -175,23 +93,13 @@ QString KSPlanet::untranslatedName() const {
         return name();
 }
 
-//we don't need the reference to the ODC, so just give it a junk variable
+//The orbital data is compiled in, there is nothing to load
 bool KSPlanet::loadData() {
-    OrbitDataColl odc;
-    return odm.loadData( odc, untranslatedName() );
+    return vsopPlanet != -1;
 }
 
-void KSPlanet::calcEcliptic(double Tau, EclipticPosition &epret) const {
-    double sum[6];
-    OrbitDataColl odc;
-    double Tpow[6];
-
-    Tpow[0] = 1.0;
-    for (int i=1; i<6; ++i) {
-        Tpow[i] = Tpow[i-1] * Tau;
-    }
-
-    if ( ! odm.loadData( odc, untranslatedName() ) ) {
+void KSPlanet::calcEcliptic(double Tau, EclipticPosition &epret, double accuracy) const {
+    if ( vsopPlanet == -1 ) {
         epret.longitude = dms(0.0);
         epret.latitude  = dms(0.0);
         epret.radius    = 0.0;
@@ -199,52 +107,19 @@ void KSPlanet::calcEcliptic(double Tau, EclipticPosition &epret) const {
         return;
     }
 
-    //Ecliptic Longitude
-    for (int i=0; i<6; ++i) {
-        sum[i] = 0.0;
-        for (int j = 0; j < odc.Lon[i].size(); ++j) {
-            sum[i] += odc.Lon[i][j].A * cos( odc.Lon[i][j].B + odc.Lon[i][j].C*Tau );
-            /*
-            qDebug() << "sum[" << i <<"] =" << sum[i] <<
-            	" A = " << odc.Lon[i][j].A << " B = " << odc.Lon[i][j].B <<
-            	" C = " << odc.Lon[i][j].C << endl;
-            	*/
-        }
-        sum[i] *= Tpow[i];
-        //qDebug() << name() << " : sum[" << i << "] = " << sum[i];
-    }
+    //Tools that step through time use the cached polynomials, which are more accurate than any truncation
+    if ( KSEphemeris::Instance()->ecliptic( vsopPlanet, Tau, epret ) )
+        return;
 
-    epret.longitude.setRadians( sum[0] + sum[1] + sum[2] + sum[3] + sum[4] + sum[5] );
+    //Ecliptic Longitude
+    epret.longitude.setRadians( VSOP87::evaluate( vsopPlanet, VSOP87::LONGITUDE, Tau, accuracy ) );
     epret.longitude.setD( epret.longitude.reduce().Degrees() );
 
     //Compute Ecliptic Latitude
-    for (uint i=0; i<6; ++i) {
-        sum[i] = 0.0;
-        for (int j = 0; j < odc.Lat[i].size(); ++j) {
-            sum[i] += odc.Lat[i][j].A * cos( odc.Lat[i][j].B + odc.Lat[i][j].C*Tau );
-        }
-        sum[i] *= Tpow[i];
-    }
-
-
-    epret.latitude.setRadians( sum[0] + sum[1] + sum[2] + sum[3] + sum[4] + sum[5] );
+    epret.latitude.setRadians( VSOP87::evaluate( vsopPlanet, VSOP87::LATITUDE, Tau, accuracy ) );
 
     //Compute Heliocentric Distance
-    for (uint i=0; i<6; ++i) {
-        sum[i] = 0.0;
-        for (int j = 0; j < odc.Dst[i].size(); ++j) {
-            sum[i] += odc.Dst[i][j].A * cos( odc.Dst[i][j].B + odc.Dst[i][j].C*Tau );
-        }
-        sum[i] *= Tpow[i];
-    }
-
-    epret.radius = sum[0] + sum[1] + sum[2] + sum[3] + sum[4] + sum[5];
-
-    /*
-    qDebug() << name() << " pre: Lat = " << epret.latitude.toDMSString() << " Long = " <<
-    	epret.longitude.toDMSString() << " Dist = " << epret.radius << endl;
-    */
-
+    epret.radius = VSOP87::evaluate( vsopPlanet, VSOP87::RADIUS, Tau, accuracy );
 }
 
 bool KSPlanet::findGeocentricPosition( const KSNumbers *num, const KSPlanetBase *Earth ) {
@@ -29,8 +29,7 @@
  *(Earth and Pluto have their own specialized classes derived from KSPlanetBase).  
  *@note The Sun is subclassed from KSPlanet.
  *
- *KSPlanet contains internal classes to manage the computations of a planet's position.
- *The position is computed as a series of sinusoidal sums, similar to a Fourier
+ *The position of a planet is computed by VSOP87 as a series of sinusoidal sums, similar to a Fourier
  *transform.  See "Astronomical Algorithms" by Jean Meeus or the file README.planetmath
  *for details.
  *@short Provides necessary information about objects in the solar system.
@@ -80,8 +79,10 @@ public:
     	*to the ecliptic coordinates is returned as the second object.
     	*@param jm Julian Millenia (=jd/1000)
     	*@param ret The ecliptic coordinates are returned by reference through this argument.
+    	*@param accuracy error that is tolerated in radians, and in AU for the distance.
+    	*The default of 0 evaluates the full series.
     	*/
-    virtual void calcEcliptic(double jm, EclipticPosition &ret) const;
+    virtual void calcEcliptic(double jm, EclipticPosition &ret, double accuracy=0) const;
 
 protected:
 
@@ -95,88 +96,10 @@ protected:
     	*/
     virtual bool findGeocentricPosition( const KSNumbers *num, const KSPlanetBase *Earth=NULL );
 
-    /** @class OrbitData
-    	*This class contains doubles A,B,C which represent a single term in a planet's
-    	*positional expansion sums (each sum-term is A*COS(B+C*T)).
-    	*@author Mark Hollomon
-    	*@version 1.0
+    /** Index of the VSOP87 tables of the planet, -1 if there are none
+    	*@see VSOP87::planet()
     	*/
-    class OrbitData  {
-    public:
-        /**
-        	*Default constructor
-        	*/
-        OrbitData() : A(0.), B(0.), C(0.) {}
-        /**
-        	*Constructor 
-        	*@param a the A value
-        	*@param b the B value
-        	*@param c the C value
-        	*/
-        OrbitData(double a, double b, double c) : A(a), B(b), C(c) {}
-
-        /**
-        	*Assignment operator
-        	*/
-        OrbitData operator= ( const OrbitData o ) { return o; }
-
-        double A, B, C;
-    };
-
-    typedef QVector<OrbitData> OBArray[6];
-
-    /** OrbitDataColl contains three groups of six QVectors.  Each QVector is a
-    	*list of OrbitData objects, representing a single sum used in computing
-    	*the planet's position.  A set of six of these vectors comprises the large
-    	*"meta-sum" which yields the planet's Longitude, Latitude, or Distance value.
-    	*@author Mark Hollomon
-    	*@version 1.0
-    	*/
-    class OrbitDataColl {
-    public:
-        /**Constructor*/
-        OrbitDataColl();
-
-        OBArray Lon;
-        OBArray Lat;
-        OBArray Dst;
-    };
-
-
-    /** OrbitDataManager places the OrbitDataColl objects for all planets in a QDict
-    	*indexed by the planets' names.  It also loads the positional data of each planet
-    	*from disk.
-    	*@author Mark Hollomon
-    	*@version 1.0
-    	*/
-    class OrbitDataManager {
-    public:
-        /** Constructor*/
-        OrbitDataManager();
-
-        /** Load orbital data for a planet from disk.
-        	*The data is stored on disk in a series of files named 
-        	*"name.[LBR][0...5].vsop", where "L"=Longitude data, "B"=Latitude data,
-        	*and R=Radius data.
-        	*@param n the name of the planet whose data is to be loaded from disk.
-        	*@param odc reference to the OrbitDataColl containing the planet's orbital data.
-        	*@return true if data successfully loaded
-        	*/
-        bool loadData( OrbitDataColl &odc, const QString &n);
-
-    private:
-        /** Read a single orbital data file from disk into an OrbitData vector.
-        *The data files are named "name.[LBR][0...5].vsop", where 
-        *"L"=Longitude data, "B"=Latitude data, and R=Radius data.
-        *@param fname the filename to be read.
-        *@param vector pointer to the OrbitData vector to be filled with these data.
-        */
-        bool readOrbitData(const QString &fname, QVector<KSPlanet::OrbitData> *vector);
-
-        QHash<QString, OrbitDataColl> hash;
-    };
-
-    static OrbitDataManager odm;
+    int vsopPlanet;
 
 private:
     virtual void findMagnitude(const KSNumbers*);
@@ -123,7 +123,7 @@ void KSPlanetBase::updateCoords( const KSNumbers *num, bool includePlanets, cons
 void KSPlanetBase::findPosition( const KSNumbers *num, const CachingDms *lat, const CachingDms *LST, const KSPlanetBase *Earth ) {
     // DEBUG edit
     findGeocentricPosition( num, Earth );  //private function, reimplemented in each subclass
-    findPhase();
+    findPhaseFrom( Earth );
     setAngularSize( asin(physicalSize()/Rearth/AU_KM)*60.*180./dms::PI ); //angular size in arcmin
 
     if ( lat && LST )
@@ -275,9 +275,16 @@ double KSPlanetBase::labelOffset() const {
     return 0.5*size + 4.;
 }
 
-void KSPlanetBase::findPhase() {
+void KSPlanetBase::findPhaseFrom( const KSPlanetBase *Earth ) {
+    // The phase of the Earth is not defined
+    if ( name() == "Earth" )
+        return;
+
+    if ( ! Earth )
+        Earth = KStarsData::Instance()->skyComposite()->earth();
+
     /* Compute the phase of the planet in degrees */
-    double earthSun = KStarsData::Instance()->skyComposite()->earth()->rsun();
+    double earthSun = Earth->rsun();
     double cosPhase = (rsun()*rsun() + rearth()*rearth() - earthSun*earthSun)
         / (2 * rsun() * rearth() );
     Phase = acos ( cosPhase ) * 180.0 / dms::PI;
@@ -230,8 +230,11 @@ protected:
      */
     void findPA( const KSNumbers *num );
 
-    /** Determine the phase of the planet. */
-    virtual void findPhase();
+    /** Determine the phase of the planet as seen from Earth. Only the given Earth is read, so
+     * that copies of the planets may be positioned on worker threads. If Earth is NULL, the
+     * Earth of the sky is used.
+     */
+    virtual void findPhaseFrom( const KSPlanetBase *Earth );
 
     // Geocentric ecliptic position, but distance to the Sun
     EclipticPosition ep;
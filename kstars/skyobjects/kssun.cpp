@@ -21,7 +21,9 @@
 
 #include <cmath>
 
+#include "ksephemeris.h"
 #include "ksnumbers.h"
+#include "vsop87.h"
 #include "kstarsdata.h"
 #include "kstarsdatetime.h"
 
@@ -38,8 +40,7 @@ KSSun* KSSun::clone() const
 }
 
 bool KSSun::loadData() {
-    OrbitDataColl odc;
-    return (odm.loadData(odc, "earth") != 0);
+    return VSOP87::planet( "earth" ) != -1;
 }
 
 // We don't need to do anything here
@@ -70,57 +71,29 @@ bool KSSun::findGeocentricPosition( const KSNumbers *num, const KSPlanetBase *Ea
         setRearth( Earth->rsun() );
 
     } else {
-        double sum[6];
         dms EarthLong, EarthLat; //heliocentric coords of Earth
-        OrbitDataColl odc;
         double T = num->julianMillenia(); //Julian millenia since J2000
-        double Tpow[6];
+        int earth = VSOP87::planet( "earth" );
+        EclipticPosition pos;
 
-        Tpow[0] = 1.0;
-        for (int i=1; i<6; ++i) {
-            Tpow[i] = Tpow[i-1] * T;
-        }
         //First, find heliocentric coordinates
-
-        if ( ! odm.loadData(odc, "earth") ) return false;
-
-        //Ecliptic Longitude
-        for (int i=0; i<6; ++i) {
-            sum[i] = 0.0;
-            for (int j = 0; j < odc.Lon[i].size(); ++j) {
-                sum[i] += odc.Lon[i][j].A * cos( odc.Lon[i][j].B + odc.Lon[i][j].C*T );
-            }
-            sum[i] *= Tpow[i];
-            //qDebug() << name() << " : sum[" << i << "] = " << sum[i];
-        }
-
-        EarthLong.setRadians( sum[0] + sum[1] + sum[2] +
-                              sum[3] + sum[4] + sum[5] );
-        EarthLong = EarthLong.reduce();
-
-        //Compute Ecliptic Latitude
-        for (int i=0; i<6; ++i) {
-            sum[i] = 0.0;
-            for (int j = 0; j < odc.Lat[i].size(); ++j) {
-                sum[i] += odc.Lat[i][j].A * cos( odc.Lat[i][j].B + odc.Lat[i][j].C*T );
-            }
-            sum[i] *= Tpow[i];
+        if ( earth == -1 ) return false;
+
+        if ( KSEphemeris::Instance()->ecliptic( KSEphemeris::EARTH, T, pos ) ) {
+            EarthLong = pos.longitude;
+            EarthLat  = pos.latitude;
+            ep.radius = pos.radius;
+        } else {
+            //Ecliptic Longitude
+            EarthLong.setRadians( VSOP87::evaluate( earth, VSOP87::LONGITUDE, T ) );
+            EarthLong = EarthLong.reduce();
+
+            //Compute Ecliptic Latitude
+            EarthLat.setRadians( VSOP87::evaluate( earth, VSOP87::LATITUDE, T ) );
+
+            //Compute Heliocentric Distance
+            ep.radius = VSOP87::evaluate( earth, VSOP87::RADIUS, T );
         }
-
-
-        EarthLat.setRadians( sum[0] + sum[1] + sum[2] + sum[3] +
-                             sum[4] + sum[5] );
-
-        //Compute Heliocentric Distance
-        for (int i=0; i<6; ++i) {
-            sum[i] = 0.0;
-            for (int j = 0; j < odc.Dst[i].size(); ++j) {
-                sum[i] += odc.Dst[i][j].A * cos( odc.Dst[i][j].B + odc.Dst[i][j].C*T );
-            }
-            sum[i] *= Tpow[i];
-        }
-
-        ep.radius = sum[0] + sum[1] + sum[2] + sum[3] + sum[4] + sum[5];
         setRearth( ep.radius );
 
         setEcLong( (EarthLong + dms(180.0)).reduce() );
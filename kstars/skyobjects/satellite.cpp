@@ -24,9 +24,7 @@
 #include <QDebug>
 
 #include "kstarsdata.h"
-#include "ksplanetbase.h"
-#include "skymapcomposite.h"
-#include "kssun.h"
+#include "geolocation.h"
 #include "Options.h"
 #ifndef KSTARS_LITE
 #include "kspopupmenu.h"
@@ -62,6 +60,62 @@
 #define F       3.35281066474748e-3         // Flattening factor
 #define MFACTOR 7.292115e-5
 
+// Pass prediction
+#define PASS_SAMPLES    90                  // Samples per revolution
+#define PASS_MIN_STEP   0.5                 // Shortest sampling step (minutes)
+#define PASS_MAX_STEP   10.0                // Longest sampling step (minutes)
+#define PASS_PRECISION  ( 1.0 / 86400.0 )   // Precision of the times of a pass (days)
+
+Satellite::Instant::Instant( double jd, GeoLocation *geo ) :
+    jd( jd ),
+    lst( geo->GSTtoLST( KStarsDateTime( (long double) jd ).gst() ) ),
+    lat( *geo->lat() )
+{
+    double thetageo, c, sq, achcp;
+
+    // Observer ECI position
+    sinlat = sin( lat.radians() );
+    coslat = cos( lat.radians() );
+    thetageo = geo->LMST( jd );
+    sintheta = sin( thetageo );
+    costheta = cos( thetageo );
+    c = 1.0 / sqrt( 1.0 + F * ( F - 2.0 ) * sinlat * sinlat );
+    sq = ( 1.0 - F ) * ( 1.0 - F ) * c;
+    achcp = ( RADIUSEARTHKM * c + MEANALT) * coslat;
+    obs_posx = achcp * costheta;
+    obs_posy = achcp * sintheta;
+    obs_posz = ( RADIUSEARTHKM * sq + MEANALT ) * sinlat;
+    obs_posw = sqrt( obs_posx*obs_posx + obs_posy*obs_posy + obs_posz*obs_posz );
+
+    // Find ECI coordinates of the sun
+    double mjd, year, T, M, L, e, C, O, Lsa, nu, R, eps;
+
+    mjd  = jd - 2415020.0;
+    year = 1900.0 + mjd / 365.25;
+    T    = ( mjd + deltaET( year ) / ( MINPD * 60.0 ) ) / 36525.0;
+    M    = DEG2RAD * ( Modulus( 358.47583 + Modulus( 35999.04975 * T, 360.0 ) - ( 0.000150 + 0.0000033 * T ) * T*T, 360.0 ) );
+    L    = DEG2RAD * ( Modulus( 279.69668 + Modulus( 36000.76892 * T, 360.0 ) + 0.0003025 * T*T, 360.0 ) );
+    e    = 0.01675104 - ( 0.0000418 + 0.000000126 * T ) * T;
+    C    = DEG2RAD * ( ( 1.919460 - ( 0.004789 + 0.000014 * T ) * T ) *
+           sin( M ) + ( 0.020094 - 0.000100 *  T) *
+           sin( 2 * M ) + 0.000293 * sin( 3 * M ) );
+    O    = DEG2RAD * ( Modulus( 259.18 - 1934.142 * T, 360.0 ) );
+    Lsa  = Modulus( L + C - DEG2RAD * ( 0.00569  -0.00479 * sin( O ) ), TWOPI );
+    nu   = Modulus( M + C, TWOPI);
+    R    = 1.0000002 * ( 1.0 - e*e ) / ( 1.0 + e * cos( nu ) );
+    eps  = DEG2RAD * ( 23.452294 - ( 0.0130125 + ( 0.00000164 - 0.000000503 * T ) * T ) * T + 0.00256 * cos( O ) );
+    R    = AU * R;
+
+    sun_posx = R * cos( Lsa );
+    sun_posy = R * sin( Lsa ) * cos( eps );
+    sun_posz = R * sin( Lsa ) * sin( eps );
+    sun_posw = R;
+
+    // Altitude of the sun, as for the satellite
+    double top_z = coslat*costheta*( sun_posx - obs_posx ) + coslat*sintheta*( sun_posy - obs_posy ) + sinlat*( sun_posz - obs_posz );
+    sun_alt = arcSin( top_z / sun_posw ) / DEG2RAD;
+}
+
 
 Satellite::Satellite( const QString name, const QString line1, const QString line2 )
 {
@@ -657,13 +711,16 @@ void Satellite::init()
 int Satellite::updatePos()
 {
     KStarsData *data = KStarsData::Instance();
-    return sgp4( ( data->clock()->utc().djd() - m_tle_jd ) * MINPD );
+    return updatePos( Instant( data->clock()->utc().djd(), data->geo() ) );
 }
 
-int Satellite::sgp4( double tsince )
+int Satellite::updatePos( const Instant &instant )
+{
+    return sgp4( ( instant.jd - m_tle_jd ) * MINPD, instant );
+}
+
+int Satellite::sgp4( double tsince, const Instant &instant )
 {
-    KStarsData *data = KStarsData::Instance();
-    
     int ktr;
     double am   , axnl  , aynl , betal ,  cosim , cnod  ,
            cos2u, coseo1, cosi , cosip ,  cosisq, cossu , cosu,
@@ -677,15 +734,11 @@ int Satellite::sgp4( double tsince )
            nm   , nodem , xinc , xincp ,  xl    , xlm   , mp  ,
            xmdf , xmx   , xmy  , nodedf, xnode  , nodep , tc  ,
            sat_posx, sat_posy , sat_posz, sat_posw, sat_velx ,
-           sat_vely  , sat_velz , sinlat, obs_posx, obs_posy,
-           obs_posz, obs_posw, /*obs_velx, obs_vely, obs_velz,*/
-           coslat, thetageo, sintheta, costheta, c, sq, achcp,
+           sat_vely  , sat_velz , /*obs_velx, obs_vely, obs_velz,*/
            vkmpersec;
 
     const double temp4 =   1.5e-12;
 
-    double jul_utc = data->clock()->utc().djd();
-
     vkmpersec = RADIUSEARTHKM * XKE / 60.0;
 
     // Update for secular gravity and atmospheric drag
@@ -1071,19 +1124,11 @@ int Satellite::sgp4( double tsince )
         return( 6 );
     }
 
-    // Observer ECI position and velocity
-    sinlat = sin( data->geo()->lat()->radians() );
-    coslat = cos( data->geo()->lat()->radians() );
-    thetageo = data->geo()->LMST( jul_utc );
-    sintheta = sin( thetageo );
-    costheta = cos( thetageo );
-    c = 1.0 / sqrt( 1.0 + F * ( F - 2.0 ) * sinlat * sinlat );
-    sq = ( 1.0 - F ) * ( 1.0 - F ) * c;
-    achcp = ( RADIUSEARTHKM * c + MEANALT) * coslat;
-    obs_posx = achcp * costheta;
-    obs_posy = achcp * sintheta;
-    obs_posz = ( RADIUSEARTHKM * sq + MEANALT ) * sinlat;
-    obs_posw = sqrt( obs_posx*obs_posx + obs_posy*sat_posy + obs_posz*obs_posz );
+    // Observer ECI position and velocity, shared by all satellites
+    const double sinlat = instant.sinlat, coslat = instant.coslat;
+    const double sintheta = instant.sintheta, costheta = instant.costheta;
+    const double obs_posx = instant.obs_posx, obs_posy = instant.obs_posy, obs_posz = instant.obs_posz;
+    const double obs_posw = instant.obs_posw;
     /*obs_velx = -MFACTOR * obs_posy;
     obs_vely = MFACTOR * obs_posx;
     obs_velz = 0.;*/
@@ -1115,32 +1160,11 @@ int Satellite::sgp4( double tsince )
 
     setAz( azimut / DEG2RAD );
     setAlt( elevation / DEG2RAD );
-    HorizontalToEquatorial( data->lst(), data->geo()->lat() );
+    HorizontalToEquatorial( &instant.lst, &instant.lat );
 
     // is the satellite visible ?
-    // Find ECI coordinates of the sun
-    double mjd, year, T, M, L, e, C, O, Lsa, nu, R, eps;
-
-    mjd  = jul_utc - 2415020.0;
-    year = 1900.0 + mjd / 365.25;
-    T    = ( mjd + deltaET( year ) / ( MINPD * 60.0 ) ) / 36525.0;
-    M    = DEG2RAD * ( Modulus( 358.47583 + Modulus( 35999.04975 * T, 360.0 ) - ( 0.000150 + 0.0000033 * T ) * T*T, 360.0 ) );
-    L    = DEG2RAD * ( Modulus( 279.69668 + Modulus( 36000.76892 * T, 360.0 ) + 0.0003025 * T*T, 360.0 ) );
-    e    = 0.01675104 - ( 0.0000418 + 0.000000126 * T ) * T;
-    C    = DEG2RAD * ( ( 1.919460 - ( 0.004789 + 0.000014 * T ) * T ) *
-           sin( M ) + ( 0.020094 - 0.000100 *  T) *
-           sin( 2 * M ) + 0.000293 * sin( 3 * M ) );
-    O    = DEG2RAD * ( Modulus( 259.18 - 1934.142 * T, 360.0 ) );
-    Lsa  = Modulus( L + C - DEG2RAD * ( 0.00569  -0.00479 * sin( O ) ), TWOPI );
-    nu   = Modulus( M + C, TWOPI);
-    R    = 1.0000002 * ( 1.0 - e*e ) / ( 1.0 + e * cos( nu ) );
-    eps  = DEG2RAD * ( 23.452294 - ( 0.0130125 + ( 0.00000164 - 0.000000503 * T ) * T ) * T + 0.00256 * cos( O ) );
-    R    = AU * R;
-
-    double sun_posx = R * cos( Lsa );
-    double sun_posy = R * sin( Lsa ) * cos( eps );
-    double sun_posz = R * sin( Lsa ) * sin( eps );
-    double sun_posw = R;
+    const double sun_posx = instant.sun_posx, sun_posy = instant.sun_posy, sun_posz = instant.sun_posz;
+    const double sun_posw = instant.sun_posw;
 
     // Calculates satellite's eclipse status and depth
     double sd_sun, sd_earth, delta, depth;
@@ -1158,14 +1182,129 @@ int Satellite::sgp4( double tsince )
     double earth_w = sat_posw;
     delta = PIO2 - arcSin( ( sun_posx*earth_x + sun_posy*earth_y + sun_posz*earth_z )  / ( sun_posw*earth_w ) );
     depth = sd_earth - sd_sun - delta;
-    KSSun *sun = (KSSun*)data->skyComposite()->findByName( "Sun" );
 
     m_is_eclipsed = sd_earth >= sd_sun  &&  depth >= 0;
-    m_is_visible  = !m_is_eclipsed && sun->alt().Degrees() <= -12.0 && elevation >= 0.0;
+    m_is_visible  = !m_is_eclipsed && instant.sun_alt <= -12.0 && elevation >= 0.0;
 
     return( 0 );
 }
 
+// Altitude of a satellite in degrees, or -90 if its position cannot be computed
+static double passAltitude( Satellite &sat, double jd, GeoLocation *geo )
+{
+    if ( sat.updatePos( Satellite::Instant( jd, geo ) ) != 0 )
+        return -90.0;
+    return sat.alt().Degrees();
+}
+
+// Time at which the satellite crosses the horizon between low and high, by bisection
+static double passCrossing( Satellite &sat, double low, double high, bool rising, GeoLocation *geo )
+{
+    while ( high - low > PASS_PRECISION ) {
+        double mid = ( low + high ) / 2.0;
+        if ( ( passAltitude( sat, mid, geo ) >= 0.0 ) == rising )
+            high = mid;
+        else
+            low = mid;
+    }
+
+    // The end that is above the horizon
+    return rising ? high : low;
+}
+
+// Time of the highest altitude between low and high, by golden section search
+static double passCulmination( Satellite &sat, double low, double high, GeoLocation *geo )
+{
+    const double r = ( sqrt( 5.0 ) - 1.0 ) / 2.0;
+    double a = high - r * ( high - low );
+    double b = low + r * ( high - low );
+    double alt_a = passAltitude( sat, a, geo );
+    double alt_b = passAltitude( sat, b, geo );
+
+    while ( high - low > PASS_PRECISION ) {
+        if ( alt_a < alt_b ) {
+            low = a;
+            a = b;
+            alt_a = alt_b;
+            b = low + r * ( high - low );
+            alt_b = passAltitude( sat, b, geo );
+        } else {
+            high = b;
+            b = a;
+            alt_b = alt_a;
+            a = high - r * ( high - low );
+            alt_a = passAltitude( sat, a, geo );
+        }
+    }
+
+    return ( low + high ) / 2.0;
+}
+
+QList<Satellite::Pass> Satellite::findPasses( double startJD, double stopJD, GeoLocation *geo ) const
+{
+    QList<Pass> passes;
+    Pass pass;
+
+    // The propagation changes the state of the satellite
+    Satellite sat( *this );
+
+    // A low orbit crosses the sky in a few minutes
+    const double period = TWOPI / m_mean_motion;
+    const double step = qBound( PASS_MIN_STEP, period / PASS_SAMPLES, PASS_MAX_STEP ) / MINPD;
+
+    bool above = passAltitude( sat, startJD, geo ) >= 0.0;
+    if ( above ) {
+        pass.rise = startJD;
+        pass.riseAz = sat.az();
+        pass.visible = sat.isVisible();
+    }
+
+    for ( double jd = startJD; jd < stopJD; ) {
+        const double next = qMin( jd + step, stopJD );
+        const bool nextAbove = passAltitude( sat, next, geo ) >= 0.0;
+        const bool nextVisible = sat.isVisible();
+
+        if ( nextAbove && ! above ) {
+            pass.rise = passCrossing( sat, jd, next, true, geo );
+            passAltitude( sat, pass.rise, geo );
+            pass.riseAz = sat.az();
+            pass.visible = sat.isVisible();
+        } else if ( above && ! nextAbove ) {
+            pass.set = passCrossing( sat, jd, next, false, geo );
+            passAltitude( sat, pass.set, geo );
+            pass.setAz = sat.az();
+            pass.visible = pass.visible || sat.isVisible();
+
+            pass.culmination = passCulmination( sat, pass.rise, pass.set, geo );
+            pass.maxAlt = dms( passAltitude( sat, pass.culmination, geo ) );
+            pass.culminationAz = sat.az();
+            pass.visible = pass.visible || sat.isVisible();
+            passes.append( pass );
+        }
+
+        if ( nextAbove )
+            pass.visible = pass.visible || nextVisible;
+
+        above = nextAbove;
+        jd = next;
+    }
+
+    // Cut the pass in progress
+    if ( above ) {
+        pass.set = stopJD;
+        passAltitude( sat, pass.set, geo );
+        pass.setAz = sat.az();
+
+        pass.culmination = passCulmination( sat, pass.rise, pass.set, geo );
+        pass.maxAlt = dms( passAltitude( sat, pass.culmination, geo ) );
+        pass.culminationAz = sat.az();
+        pass.visible = pass.visible || sat.isVisible();
+        passes.append( pass );
+    }
+
+    return passes;
+}
+
 QString Satellite::sgp4ErrorString(int code)
 {
     switch (code)
@@ -19,11 +19,13 @@
 #define SATELLITE_H
 
 
+#include <QList>
 #include <QString>
 
 #include "skyobject.h"
 #include "skypoint.h"
 
+class GeoLocation;
 class KSPopupMenu;
 
 /**
@@ -35,6 +37,46 @@ class KSPopupMenu;
 class Satellite : public SkyObject
 {
 public:
+    /**
+     *@class Satellite::Instant
+     *Terms of the propagation that depend only on the time and on the observer.
+     *They are computed once and shared by all satellites updated for the same instant.
+     */
+    class Instant
+    {
+    public:
+        /**
+         *@param jd Julian date (UTC)
+         *@param geo location of the observer
+         */
+        Instant( double jd, GeoLocation *geo );
+
+        double jd;                  // Julian date (UTC)
+        CachingDms lst;             // Local sidereal time
+        CachingDms lat;             // Latitude of the observer
+        double sinlat, coslat;
+        double sintheta, costheta;  // Local mean sidereal time, in ECI
+        double obs_posx, obs_posy, obs_posz, obs_posw;  // Observer ECI position (km)
+        double sun_posx, sun_posy, sun_posz, sun_posw;  // Sun ECI position (km)
+        double sun_alt;             // Altitude of the Sun (degrees)
+    };
+
+    /**
+     *@struct Satellite::Pass
+     *A pass of the satellite above the horizon
+     */
+    struct Pass
+    {
+        double rise;                // Julian date (UTC) of the rise
+        double culmination;         // Julian date (UTC) of the highest altitude
+        double set;                 // Julian date (UTC) of the set
+        dms riseAz;                 // Azimuth at rise
+        dms maxAlt;                 // Altitude at culmination
+        dms culminationAz;          // Azimuth at culmination
+        dms setAz;                  // Azimuth at set
+        bool visible;               // True if the satellite is visible during some part of the pass
+    };
+
     /**
      *@short Constructor
      */
@@ -52,10 +94,27 @@ public:
     ~Satellite();
 
     /**
-     *@short Update satellite position
+     *@short Update satellite position at the time of the simulation clock
      */
     int updatePos();
 
+    /**
+     *@short Update satellite position
+     *@param instant time and location of the observer
+     *@note Only this satellite is changed, several satellites may be updated in parallel.
+     */
+    int updatePos( const Instant &instant );
+
+    /**
+     *@short Find the passes of the satellite above the horizon
+     *@param startJD first Julian date (UTC)
+     *@param stopJD last Julian date (UTC)
+     *@param geo location of the observer
+     *@return the passes between the two dates. A pass in progress at startJD or stopJD is cut there.
+     *@note The passes are found on a copy, the position of the satellite does not change.
+     */
+    QList<Pass> findPasses( double startJD, double stopJD, GeoLocation *geo ) const;
+
     /**
      *@return True if the satellite is visible (above horizon, in the sunlight and sun at least 12° under horizon)
      */
@@ -107,12 +166,12 @@ private:
     /**
      *@short Compute satellite position
      */
-    int sgp4( double tsince );    
+    int sgp4( double tsince, const Instant &instant );
 
     /**
      *@return Arcsine of the argument
      */
-    double arcSin( double arg );
+    static double arcSin( double arg );
 
     /**
      *Provides the difference between UT (approximately the same as UTC)
@@ -120,12 +179,12 @@ private:
      *This function is based on a least squares fit of data from 1950
      *to 1991 and will need to be updated periodically.
      */
-    double deltaET( double year );
+    static double deltaET( double year );
 
     /**
      *@return arg1 mod arg2
      */
-    double Modulus(double arg1, double arg2);
+    static double Modulus(double arg1, double arg2);
 
     
     virtual void initPopupMenu( KSPopupMenu *pmenu );
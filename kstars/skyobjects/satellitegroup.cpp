@@ -18,10 +18,24 @@
 #include <QFile>
 #include <QDir>
 #include <QStandardPaths>
+#include <QtConcurrent>
 
 #include "satellitegroup.h"
 #include "ksutils.h"
 #include "kspaths.h"
+#include "kstarsdata.h"
+
+// Fewer satellites are updated in the calling thread, the pool would cost more than it saves
+#define SATELLITES_PARALLEL_MIN 32
+
+namespace {
+
+struct SatelliteUpdate {
+    Satellite *satellite;
+    int rc;
+};
+
+}
 
 SatelliteGroup::SatelliteGroup( QString name, QString tle_filename, QUrl update_url )
 {
@@ -64,19 +78,37 @@ void SatelliteGroup::readTLE()
 
 void SatelliteGroup::updateSatellitesPos()
 {
-    QMutableListIterator<Satellite *> sats(*this);
-    while (sats.hasNext())
-    {
-        Satellite *sat = sats.next();
-
-        if ( sat->selected() )
-        {
-            int rc = sat->updatePos();
-            // If position cannot be calculated, remove it from list
-            if (rc != 0)
-                sats.remove();
+    KStarsData *data = KStarsData::Instance();
+    updateSatellitesPos( Satellite::Instant( data->clock()->utc().djd(), data->geo() ) );
+}
+
+void SatelliteGroup::updateSatellitesPos( const Satellite::Instant &instant )
+{
+    QVector<SatelliteUpdate> updates;
+    foreach ( Satellite *sat, *this ) {
+        if ( sat->selected() ) {
+            SatelliteUpdate update;
+            update.satellite = sat;
+            update.rc = 0;
+            updates.append( update );
         }
     }
+
+    // Each satellite only changes its own state
+    if ( updates.size() < SATELLITES_PARALLEL_MIN ) {
+        for ( int i=0; i < updates.size(); ++i )
+            updates[i].rc = updates[i].satellite->updatePos( instant );
+    } else {
+        QtConcurrent::blockingMap( updates, [&instant]( SatelliteUpdate &update ) {
+            update.rc = update.satellite->updatePos( instant );
+        } );
+    }
+
+    // If position cannot be calculated, remove it from list
+    foreach ( const SatelliteUpdate &update, updates ) {
+        if ( update.rc != 0 )
+            removeOne( update.satellite );
+    }
 }
 
 QUrl SatelliteGroup::tleFilename()
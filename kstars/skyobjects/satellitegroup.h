@@ -55,6 +55,12 @@ public:
      */
     void updateSatellitesPos();
 
+    /**
+     *Compute the position of the selected satellites of the group, in parallel.
+     *@param instant time and location of the observer, shared by all groups
+     */
+    void updateSatellitesPos( const Satellite::Instant &instant );
+
     /**
      *@return TLE filename
      */
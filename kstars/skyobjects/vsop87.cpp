@@ -0,0 +1,126 @@
+/***************************************************************************
+                          vsop87.cpp  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "vsop87.h"
+
+#include <cmath>
+
+#include <QVector>
+
+// Generated at build time from the .vsop data files
+#include "vsop87tables.h"
+
+// Partial sums that are accumulated independently
+#define VSOP87_LANES 4
+
+namespace {
+
+// Sum of A*cos(B + C*T) over n terms
+double sumSeries( const double *A, const double *B, const double *C, int n, double T ) {
+    double lanes[VSOP87_LANES] = { 0 };
+    int j = 0;
+
+    // The lanes do not depend on each other, so they may be evaluated with SIMD instructions
+    for ( ; j + VSOP87_LANES <= n; j += VSOP87_LANES ) {
+        for ( int k=0; k < VSOP87_LANES; ++k )
+            lanes[k] += A[j+k] * cos( B[j+k] + C[j+k]*T );
+    }
+
+    double sum = 0.0;
+    for ( ; j < n; ++j )
+        sum += A[j] * cos( B[j] + C[j]*T );
+
+    for ( int k=0; k < VSOP87_LANES; ++k )
+        sum += lanes[k];
+
+    return sum;
+}
+
+// For each term, the sum of the amplitudes of the terms that follow it in its series, itself included
+QVector<double> remainingAmplitudes() {
+    const int series = VSOP87_PLANET_COUNT * 3 * 6;
+    QVector<double> remaining( VSOP87_START[series] );
+
+    for ( int s=0; s < series; ++s ) {
+        double sum = 0.0;
+        for ( int j = VSOP87_START[s+1] - 1; j >= VSOP87_START[s]; --j ) {
+            sum += fabs( VSOP87_A[j] );
+            remaining[j] = sum;
+        }
+    }
+
+    return remaining;
+}
+
+}
+
+int VSOP87::planet( const QString &name ) {
+    for ( int i=0; i < VSOP87_PLANET_COUNT; ++i ) {
+        if ( name.compare( QLatin1String( VSOP87_PLANETS[i] ), Qt::CaseInsensitive ) == 0 )
+            return i;
+    }
+
+    return -1;
+}
+
+int VSOP87::terms( int planet, Coordinate coordinate, int power ) {
+    int series = ( planet * 3 + coordinate ) * 6 + power;
+    return VSOP87_START[series + 1] - VSOP87_START[series];
+}
+
+int VSOP87::length( int series, double jm, double accuracy ) {
+    const int start = VSOP87_START[series];
+    const int end   = VSOP87_START[series + 1];
+
+    if ( accuracy <= 0 )
+        return end - start;
+
+    const double scale = pow( fabs( jm ), series % 6 );
+    if ( scale == 0 )
+        return 0;
+
+    static const QVector<double> remaining = remainingAmplitudes();
+
+    // The error is shared evenly by the six series of the coordinate. Keep the
+    // fewest leading terms for which the amplitudes of the others fit in it.
+    const double budget = accuracy / ( 6 * scale );
+    int low = start, high = end;
+    while ( low < high ) {
+        int middle = ( low + high ) / 2;
+        if ( remaining[middle] <= budget )
+            high = middle;
+        else
+            low = middle + 1;
+    }
+
+    return low - start;
+}
+
+double VSOP87::evaluate( int planet, Coordinate coordinate, double jm, double accuracy ) {
+    const int first = ( planet * 3 + coordinate ) * 6;
+    double result = 0.0;
+
+    // Horner's scheme over the powers of T
+    for ( int power=5; power >= 0; --power ) {
+        const int start = VSOP87_START[first + power];
+        const int n = length( first + power, jm, accuracy );
+
+        result = result * jm + sumSeries( VSOP87_A + start, VSOP87_B + start, VSOP87_C + start, n, jm );
+    }
+
+    return result;
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+                          vsop87.h  -  K Desktop Planetarium
+                             -------------------
+    begin                : Sat 17 Oct 2026
+    copyright            : (C) 2026 by the KStars Team
+    email                : kstars-devel@kde.org
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef VSOP87_H_
+#define VSOP87_H_
+
+#include <QString>
+
+/** @class VSOP87
+ *Evaluates the VSOP87 series of the heliocentric ecliptic coordinates of the major planets.
+ *
+ *Each coordinate is the sum of six series, the n-th one multiplied by T^n, where T
+ *is the time in Julian millenia since J2000. Each series is a sum of terms
+ *A*cos(B + C*T). See README.planetmath for details.
+ *
+ *The coefficients are compiled in. They are generated at build time from the
+ *data files by cmake/modules/VSOP87Tables.cmake, into one array for each of A, B
+ *and C, so that a series is evaluated over contiguous memory in several
+ *independent lanes.
+ *
+ *The series may be truncated to a given accuracy, for callers that step through
+ *time quickly and do not need the full precision. The terms that are left out
+ *add up to less than the accuracy at the given time, whatever their phase.
+ *@short Evaluates the VSOP87 planetary theory.
+ */
+class VSOP87 {
+public:
+    enum Coordinate { LONGITUDE=0, LATITUDE=1, RADIUS=2 };
+
+    /** @return the index of the tables of the planet, or -1 if there are none
+     *@param name the untranslated name of the planet, in any case
+     */
+    static int planet( const QString &name );
+
+    /** @return the coordinate of the planet at the given time, in radians for the
+     *longitude and latitude, in AU for the radius. The longitude is not reduced.
+     *@param planet index of the planet, from planet()
+     *@param coordinate the coordinate to evaluate
+     *@param jm Julian millenia since J2000
+     *@param accuracy error that is tolerated, in the unit of the coordinate. 0 keeps all terms.
+     */
+    static double evaluate( int planet, Coordinate coordinate, double jm, double accuracy=0 );
+
+    /** @return the number of terms of one of the six series of a coordinate */
+    static int terms( int planet, Coordinate coordinate, int power );
+
+private:
+    static int length( int series, double jm, double accuracy );
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "skypainter.h"
 
 #include "skymap.h"
+#include "projections/projector.h"
 #include "Options.h"
 #include "kstarsdata.h"
 #include "skycomponents/skiplist.h"
@@ -66,3 +67,26 @@ float SkyPainter::starWidth(float mag) const
     return size;
 }
 
+void SkyPainter::drawPointSources(SkyPoint *const *points, const float *mags, const char *sp, int n,
+                                  QPointF *pos, bool *drawn)
+{
+    for( int i = 0; i < n; ++i ) {
+        bool isDrawn = drawPointSource( points[i], mags[i], sp[i] );
+        if( pos && isDrawn )
+            pos[i] = m_sm->projector()->toScreen( points[i] );
+        if( drawn )
+            drawn[i] = isDrawn;
+    }
+}
+
+void SkyPainter::drawDeepSkyObjects(DeepSkyObject *const *objs, int n, bool drawImage,
+                                    QPointF *pos, bool *drawn)
+{
+    for( int i = 0; i < n; ++i ) {
+        bool isDrawn = drawDeepSkyObject( objs[i], drawImage );
+        if( pos && isDrawn )
+            pos[i] = m_sm->projector()->toScreen( objs[i] );
+        if( drawn )
+            drawn[i] = isDrawn;
+    }
+}
@@ -76,6 +76,28 @@ public:
         */
     virtual void end() =0;
 
+    /** @short Finish drawing anything that drawPointSources() or drawDeepSkyObjects()
+        have deferred, so that whatever is drawn next appears on top of it.
+        The default implementation does nothing.
+        */
+    virtual void flush() {}
+
+    /** @short Start a layer of the sky map, made of the components drawn until
+        the matching endLayer(). A painter that keeps images of the layers it
+        has drawn before may decide that this one is still up to date.
+        @param dependencies the combined SkyComponent::DrawDependency flags of
+        the components in the layer
+        @return false if the layer does not need to be drawn. The default
+        implementation always returns true.
+        @note endLayer() must be called whatever this returns.
+        */
+    virtual bool beginLayer( int dependencies ) { Q_UNUSED( dependencies ); return true; }
+
+    /** @short Finish the layer started by beginLayer().
+        The default implementation does nothing.
+        */
+    virtual void endLayer() {}
+
     ////////////////////////////////////
     //                                //
     // SKY DRAWING FUNCTIONS:         //
@@ -118,6 +140,19 @@ public:
         */
     virtual bool drawPointSource(SkyPoint *loc, float mag, char sp = 'A') =0;
 
+    /** @short Draw an array of point sources (e.g., the stars of a trixel).
+        The default implementation calls drawPointSource() for each source;
+        backends reimplement it to project all the points at once.
+        @param points the locations of the sources in the sky
+        @param mags the magnitudes of the sources
+        @param sp the spectral classes of the sources
+        @param n the number of sources
+        @param pos if not null, receives the screen position of each drawn source
+        @param drawn if not null, receives whether each source was drawn
+        */
+    virtual void drawPointSources(SkyPoint *const *points, const float *mags, const char *sp, int n,
+                                  QPointF *pos = 0, bool *drawn = 0);
+
     /** @short Draw a deep sky object
         @param obj the object to draw
         @param drawImage if true, try to draw the image of the object
@@ -125,6 +160,18 @@ public:
         */
     virtual bool drawDeepSkyObject(DeepSkyObject *obj, bool drawImage = false) =0;
 
+    /** @short Draw an array of deep sky objects
+        The default implementation calls drawDeepSkyObject() for each object;
+        backends reimplement it to project all the objects at once.
+        @param objs the objects to draw
+        @param n the number of objects
+        @param drawImage if true, try to draw the images of the objects
+        @param pos if not null, receives the screen position of each drawn object
+        @param drawn if not null, receives whether each object was drawn
+        */
+    virtual void drawDeepSkyObjects(DeepSkyObject *const *objs, int n, bool drawImage = false,
+                                    QPointF *pos = 0, bool *drawn = 0);
+
     /** @short Draw a planet
         @param planet the planet to draw
         @return true if it was drawn
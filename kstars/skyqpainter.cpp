@@ -22,6 +22,7 @@
 #include "kstarsdata.h"
 #include "Options.h"
 #include "skymap.h"
+#include "skylayercache.h"
 
 #include "skycomponents/linelist.h"
 #include "skycomponents/skiplist.h"
@@ -41,7 +42,10 @@
 #include "ksutils.h"
 
 #include <QMap>
+#include <QThread>
+#include <QVarLengthArray>
 #include <QWidget>
+#include <QtConcurrent>
 
 #include <functional>
 
@@ -73,6 +77,16 @@ namespace {
     //
     // These pixmaps are never deallocated. Not really good...
     QPixmap* imageCache[nSPclasses][nStarSizes] = {{0}};
+
+    // The same images as QImages, which unlike QPixmaps may be drawn
+    // outside of the GUI thread
+    QImage starImageCache[nSPclasses][nStarSizes];
+
+    // A horizontal band of the canvas rasterized by one thread in SkyQPainter::flush()
+    struct SkyBand {
+        int top;
+        QImage image;
+    };
 }
 
 int SkyQPainter::starColorMode = 0;
@@ -87,6 +101,14 @@ SkyQPainter::SkyQPainter( QPaintDevice *pd )
     m_pd = pd;
     m_size = QSize( pd->width(), pd->height() );
     m_vectorStars = false;
+    m_parallel = false;
+    m_imageSprites = false;
+    m_layerCache = 0;
+    m_layer = 0;
+    m_layerDependencies = 0;
+    m_skippingLayers = true;
+    m_layerSkipped = false;
+    m_layerImage = 0;
 }
 
 SkyQPainter::SkyQPainter( QPaintDevice *pd, const QSize &size )
@@ -96,6 +118,14 @@ SkyQPainter::SkyQPainter( QPaintDevice *pd, const QSize &size )
     m_pd = pd;
     m_size = size;
     m_vectorStars = false;
+    m_parallel = false;
+    m_imageSprites = false;
+    m_layerCache = 0;
+    m_layer = 0;
+    m_layerDependencies = 0;
+    m_skippingLayers = true;
+    m_layerSkipped = false;
+    m_layerImage = 0;
 }
 
 SkyQPainter::SkyQPainter( QWidget *widget, QPaintDevice *pd )
@@ -106,6 +136,14 @@ SkyQPainter::SkyQPainter( QWidget *widget, QPaintDevice *pd )
     m_pd = ( pd ? pd : widget );
     m_size = widget->size();
     m_vectorStars = false;
+    m_parallel = false;
+    m_imageSprites = false;
+    m_layerCache = 0;
+    m_layer = 0;
+    m_layerDependencies = 0;
+    m_skippingLayers = true;
+    m_layerSkipped = false;
+    m_layerImage = 0;
 }
 
 SkyQPainter::~SkyQPainter()
@@ -123,7 +161,152 @@ void SkyQPainter::begin()
 
 void SkyQPainter::end()
 {
+    // Every layer was still valid: take the labels of the last one
+    if( m_layerCache && m_skippingLayers && m_layer > 0 )
+        m_layerCache->restoreLabels( m_layer - 1 );
+    flush();
+    QPainter::end();
+}
+
+void SkyQPainter::setLayerCache( SkyLayerCache *cache )
+{
+    m_layerCache = ( m_pd->devType() == QInternal::Pixmap ) ? cache : 0;
+    m_layer = 0;
+    m_skippingLayers = true;
+}
+
+void SkyQPainter::switchDevice( QPaintDevice *pd )
+{
+    const QPainter::RenderHints hints = renderHints();
+    const QPen pen = this->pen();
+    const QBrush brush = this->brush();
+    const QFont font = this->font();
+    const bool clipping = hasClipping();
+    const QPainterPath clip = clipping ? clipPath() : QPainterPath();
+
     QPainter::end();
+    QPainter::begin( pd );
+    setRenderHints( hints );
+    setPen( pen );
+    setBrush( brush );
+    setFont( font );
+    if( clipping )
+        setClipPath( clip );
+}
+
+bool SkyQPainter::beginLayer( int dependencies )
+{
+    m_layerDependencies = dependencies;
+    m_layerSkipped = false;
+    m_layerImage = 0;
+    if( !m_layerCache )
+        return true;
+
+    if( m_layer == 0 )
+        m_layerCache->beginFrame();
+
+    if( m_skippingLayers ) {
+        if( m_layerCache->isValid( m_layer, dependencies ) ) {
+            m_layerCache->draw( m_layer, this );
+            m_layerSkipped = true;
+            return false;
+        }
+        // Draw this layer on top of the ones that are still valid
+        m_skippingLayers = false;
+        if( m_layer > 0 )
+            m_layerCache->restoreLabels( m_layer - 1 );
+    }
+
+    // A layer that may be kept is drawn on its own pixmap
+    if( m_layerCache->keeps( dependencies ) ) {
+        flush();
+        m_layerImage = m_layerCache->image( m_layer, *static_cast<QPixmap *>( m_pd ) );
+        switchDevice( m_layerImage );
+    }
+    return true;
+}
+
+void SkyQPainter::endLayer()
+{
+    if( !m_layerCache )
+        return;
+
+    const int layer = m_layer++;
+    if( m_layerSkipped )
+        return;
+
+    flush();
+    m_layerCache->store( layer, m_layerDependencies );
+    if( m_layerImage ) {
+        switchDevice( m_pd );
+        m_layerCache->draw( layer, this );
+        m_layerImage = 0;
+    }
+}
+
+void SkyQPainter::flush()
+{
+    if( m_deferred.isEmpty() )
+        return;
+
+    const int nBands = qBound( 1, QThread::idealThreadCount(), m_size.height() );
+    const int bandHeight = ( m_size.height() + nBands - 1 ) / nBands;
+    QVector<SkyBand> bands( nBands );
+    for( int i = 0; i < nBands; ++i ) {
+        bands[i].top = i * bandHeight;
+        int height = qMin( bandHeight, m_size.height() - bands[i].top );
+        if( height > 0 ) {
+            bands[i].image = QImage( m_size.width(), height, QImage::Format_ARGB32_Premultiplied );
+            bands[i].image.fill( Qt::transparent );
+        }
+    }
+
+    const QPainterPath clip = hasClipping() ? clipPath() : QPainterPath();
+    const QPainter::RenderHints hints = renderHints();
+    QtConcurrent::blockingMap( bands, [this, &clip, hints]( SkyBand &band ) {
+        if( !band.image.isNull() )
+            rasterizeBand( band.top, &band.image, clip, hints );
+    } );
+    m_deferred.clear();
+
+    foreach( const SkyBand &band, bands ) {
+        if( !band.image.isNull() )
+            drawImage( QPointF( 0, band.top ), band.image );
+    }
+}
+
+void SkyQPainter::rasterizeBand(int top, QImage *band, const QPainterPath &clip, QPainter::RenderHints hints) const
+{
+    const float bottom = top + band->height();
+
+    SkyQPainter p( band, m_size );
+    p.QPainter::begin( band );
+    p.m_proj = m_proj;
+    p.m_vectorStars = m_vectorStars;
+    p.m_imageSprites = true;
+    p.setRenderHints( hints );
+    p.translate( 0, -top );
+    if( !clip.isEmpty() )
+        p.setClipPath( clip );
+
+    foreach( const DeferredBatch &batch, m_deferred ) {
+        if( batch.objs.isEmpty() ) {
+            for( int i = 0; i < batch.pos.size(); ++i ) {
+                float r = 0.5 * batch.size[i] + 1;
+                if( batch.pos[i].y() + r >= top && batch.pos[i].y() - r <= bottom )
+                    p.drawPointSource( batch.pos[i], batch.size[i], batch.sp[i] );
+            }
+        } else {
+            p.setPen( batch.pen );
+            p.setBrush( batch.brush );
+            for( int i = 0; i < batch.pos.size(); ++i ) {
+                if( batch.pos[i].y() + batch.size[i] >= top && batch.pos[i].y() - batch.size[i] <= bottom )
+                    p.drawDeepSkyObjectAt( batch.pos[i], batch.objs[i], batch.drawImage );
+            }
+        }
+    }
+
+    p.QPainter::end();
 }
 
 void SkyQPainter::drawSkyBackground()
@@ -222,6 +405,7 @@ void SkyQPainter::initStarImages()
             if( !pmap[size] )
                 pmap[size] = new QPixmap();
             *pmap[size] = BigImage.scaled( size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+            starImageCache[ harvardToIndex(color) ][size] = pmap[size]->toImage();
         }
     }
     starColorMode = Options::starColorMode();
@@ -255,16 +439,21 @@ void SkyQPainter::drawSkyPolyline(LineList* list, SkipList* skipList, LineListLa
     SkyList *points = list->points();
     bool isVisible, isVisibleLast;
 
-    QPointF   oLast = m_proj->toScreen( points->first(), true, &isVisibleLast );
+    const int n = points->size();
+    QVarLengthArray<QPointF, 256> screen( n );
+    QVarLengthArray<bool, 256> visible( n );
+    m_proj->toScreenBatch( points->constData(), n, true, screen.data(), visible.data() );
+
+    QPointF   oLast = screen[0];
     // & with the result of checkVisibility to clip away things below horizon
-    isVisibleLast &= m_proj->checkVisibility( points->first() );
+    isVisibleLast = visible[0] && m_proj->checkVisibility( points->first() );
     QPointF oThis, oThis2;
 
-    for ( int j = 1 ; j < points->size() ; j++ ) {
+    for ( int j = 1 ; j < n ; j++ ) {
         SkyPoint* pThis = points->at( j );
-        oThis2 = oThis = m_proj->toScreen( pThis, true, &isVisible );
+        oThis2 = oThis = screen[j];
         // & with the result of checkVisibility to clip away things below horizon
-        isVisible &= m_proj->checkVisibility(pThis);
+        isVisible = visible[j] && m_proj->checkVisibility(pThis);
         bool doSkip = false;
         if( skipList ) {
             doSkip = skipList->skip(j);
@@ -293,16 +482,21 @@ void SkyQPainter::drawSkyPolyline(LineList* list, SkipList* skipList, LineListLa
 
 void SkyQPainter::drawSkyPolygon(LineList* list, bool forceClip)
 {
-    bool isVisible, isVisibleLast;
+    bool isVisible = false, isVisibleLast;
     SkyList *points = list->points();
     QPolygonF polygon;
 
+    const int n = points->size();
+    QVarLengthArray<QPointF, 256> screen( n );
+    QVarLengthArray<bool, 256> visible( n );
+    m_proj->toScreenBatch( points->constData(), n, forceClip, screen.data(), visible.data() );
+
     if (forceClip == false)
     {
-        for ( int i = 0; i < points->size(); ++i )
+        for ( int i = 0; i < n; ++i )
         {
-            polygon << m_proj->toScreen( points->at( i ), false, &isVisibleLast);
-            isVisible |= isVisibleLast;
+            polygon << screen[i];
+            isVisible |= visible[i];
         }
 
         // If 1+ points are visible, draw it
@@ -314,15 +508,15 @@ void SkyQPainter::drawSkyPolygon(LineList* list, bool forceClip)
 
 
     SkyPoint* pLast = points->last();
-    QPointF   oLast = m_proj->toScreen( pLast, true, &isVisibleLast );
+    QPointF   oLast = screen[n-1];
     // & with the result of checkVisibility to clip away things below horizon
-    isVisibleLast &= m_proj->checkVisibility(pLast);
+    isVisibleLast = visible[n-1] && m_proj->checkVisibility(pLast);
 
-    for ( int i = 0; i < points->size(); ++i ) {
+    for ( int i = 0; i < n; ++i ) {
         SkyPoint* pThis = points->at( i );
-        QPointF oThis = m_proj->toScreen( pThis, true, &isVisible );
+        QPointF oThis = screen[i];
         // & with the result of checkVisibility to clip away things below horizon
-        isVisible &= m_proj->checkVisibility(pThis);
+        isVisible = visible[i] && m_proj->checkVisibility(pThis);
 
 
         if ( isVisible && isVisibleLast ) {
@@ -400,6 +594,41 @@ bool SkyQPainter::drawPlanet(KSPlanetBase* planet)
     return true;
 }
 
+void SkyQPainter::drawPointSources(SkyPoint *const *points, const float *mags, const char *sp, int n,
+                                   QPointF *pos, bool *drawn)
+{
+    if( n <= 0 )
+        return;
+
+    QVarLengthArray<QPointF, 256> screen( n );
+    QVarLengthArray<bool, 256> visible( n );
+    m_proj->toScreenBatch( points, n, true, screen.data(), visible.data() );
+
+    DeferredBatch *batch = 0;
+    if( m_parallel ) {
+        m_deferred.append( DeferredBatch() );
+        batch = &m_deferred.last();
+    }
+
+    for( int i = 0; i < n; ++i ) {
+        // FIXME: onScreen here should use canvas size rather than SkyMap size, see drawPointSource()
+        bool isDrawn = visible[i] && m_proj->onScreen( screen[i] ) && m_proj->checkVisibility( points[i] );
+        if( isDrawn ) {
+            if( batch ) {
+                batch->pos.append( screen[i] );
+                batch->size.append( starWidth( mags[i] ) );
+                batch->sp.append( sp[i] );
+            } else {
+                drawPointSource( screen[i], starWidth( mags[i] ), sp[i] );
+            }
+            if( pos )
+                pos[i] = screen[i];
+        }
+        if( drawn )
+            drawn[i] = isDrawn;
+    }
+}
+
 bool SkyQPainter::drawPointSource(SkyPoint* loc, float mag, char sp)
 {
     //Check if it's even visible before doing anything
@@ -420,9 +649,15 @@ void SkyQPainter::drawPointSource(const QPointF& pos, float size, char sp)
     int isize = qMin(static_cast<int>(size), 14);
     if( !m_vectorStars || starColorMode == 0  ) {
         // Draw stars as bitmaps, either because we were asked to, or because we're painting real colors
-        QPixmap* im = imageCache[ harvardToIndex(sp) ][isize];
-        float offset = 0.5 * im->width();
-        drawPixmap( QPointF(pos.x()-offset, pos.y()-offset), *im );
+        if( m_imageSprites ) {
+            const QImage &im = starImageCache[ harvardToIndex(sp) ][isize];
+            float offset = 0.5 * im.width();
+            drawImage( QPointF(pos.x()-offset, pos.y()-offset), im );
+        } else {
+            QPixmap* im = imageCache[ harvardToIndex(sp) ][isize];
+            float offset = 0.5 * im->width();
+            drawPixmap( QPointF(pos.x()-offset, pos.y()-offset), *im );
+        }
     }
     else {
         // Draw stars as vectors, for better printing / SVG export etc.
@@ -489,6 +724,55 @@ bool SkyQPainter::drawDeepSkyObject(DeepSkyObject* obj, bool drawImage)
     QPointF pos = m_proj->toScreen(obj, true, &visible);
     if( !visible || !m_proj->onScreen(pos) ) return false;
 
+    drawDeepSkyObjectAt(pos, obj, drawImage);
+    return true;
+}
+
+void SkyQPainter::drawDeepSkyObjects(DeepSkyObject *const *objs, int n, bool drawImage,
+                                     QPointF *pos, bool *drawn)
+{
+    if( n <= 0 )
+        return;
+
+    QVarLengthArray<SkyPoint*, 256> points( n );
+    for( int i = 0; i < n; ++i )
+        points[i] = objs[i];
+
+    QVarLengthArray<QPointF, 256> screen( n );
+    QVarLengthArray<bool, 256> visible( n );
+    m_proj->toScreenBatch( points.constData(), n, true, screen.data(), visible.data() );
+
+    DeferredBatch *batch = 0;
+    if( m_parallel ) {
+        m_deferred.append( DeferredBatch() );
+        batch = &m_deferred.last();
+        batch->pen = pen();
+        batch->brush = brush();
+        batch->drawImage = drawImage;
+    }
+
+    for( int i = 0; i < n; ++i ) {
+        bool isDrawn = visible[i] && m_proj->onScreen( screen[i] ) && m_proj->checkVisibility( objs[i] );
+        if( isDrawn ) {
+            if( batch ) {
+                // Generous extent of the symbol or image, used to pick the bands it touches
+                float size = qMax( objs[i]->a(), 1.0f ) * dms::PI * Options::zoomFactor() / 10800.0;
+                batch->pos.append( screen[i] );
+                batch->size.append( size + 8 );
+                batch->objs.append( objs[i] );
+            } else {
+                drawDeepSkyObjectAt( screen[i], objs[i], drawImage );
+            }
+            if( pos )
+                pos[i] = screen[i];
+        }
+        if( drawn )
+            drawn[i] = isDrawn;
+    }
+}
+
+void SkyQPainter::drawDeepSkyObjectAt(const QPointF& pos, DeepSkyObject* obj, bool drawImage)
+{
     // if size is 0.0 set it to 1.0, this are normally stars (type 0 and 1)
     // if we use size 0.0 the star wouldn't be drawn
     float majorAxis = obj->a();
@@ -505,8 +789,6 @@ bool SkyQPainter::drawDeepSkyObject(DeepSkyObject* obj, bool drawImage)
 
     //Draw Symbol
     drawDeepSkySymbol(pos, obj->type(), size, obj->e(), positionAngle);
-
-    return true;
 }
 
 bool SkyQPainter::drawDeepSkyImage(const QPointF& pos, DeepSkyObject* obj, float positionAngle)
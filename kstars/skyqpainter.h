@@ -23,6 +23,7 @@
 #include "skypainter.h"
 
 class Projector;
+class SkyLayerCache;
 class QWidget;
 class QSize;
 class QMessageBox;
@@ -64,8 +65,30 @@ public:
     inline void setVectorStars( bool vectorStars ) { m_vectorStars = vectorStars; }
     inline bool getVectorStars() const { return m_vectorStars; }
 
+    /**
+     * @short Rasterize stars and deep sky objects on several threads.
+     * While enabled, drawPointSources() and drawDeepSkyObjects() still project
+     * their input immediately, so that screen positions are available for labels,
+     * but only record what has to be drawn for each trixel. flush() then splits the
+     * canvas into horizontal bands, one per thread, rasterizes the recorded trixels
+     * into a QImage per band and composites the bands in order.
+     */
+    inline void setParallelRendering( bool parallel ) { m_parallel = parallel; }
+    inline bool parallelRendering() const { return m_parallel; }
+
+    /**
+     * @short Skip the layers of the sky map that are still the same as in
+     * @p cache, and keep the ones that have to be drawn in it.
+     * @note only takes effect when painting on a QPixmap. Must be called
+     * before the first beginLayer() of a frame.
+     */
+    void setLayerCache( SkyLayerCache *cache );
+
     virtual void begin();
     virtual void end();
+    virtual void flush();
+    virtual bool beginLayer( int dependencies );
+    virtual void endLayer();
     
     /** Recalculates the star pixmaps. */
     static void initStarImages();
@@ -77,7 +100,11 @@ public:
                                  LineListLabel *label = 0);
     virtual void drawSkyPolygon(LineList* list, bool forceClip=true);
     virtual bool drawPointSource(SkyPoint *loc, float mag, char sp = 'A');
+    virtual void drawPointSources(SkyPoint *const *points, const float *mags, const char *sp, int n,
+                                  QPointF *pos = 0, bool *drawn = 0);
     virtual bool drawDeepSkyObject(DeepSkyObject *obj, bool drawImage = false);
+    virtual void drawDeepSkyObjects(DeepSkyObject *const *objs, int n, bool drawImage = false,
+                                    QPointF *pos = 0, bool *drawn = 0);
     virtual bool drawPlanet(KSPlanetBase *planet);
     virtual void drawObservingList(const QList<SkyObject*>& obs);
     virtual void drawFlags();
@@ -91,11 +118,39 @@ public:
     virtual bool drawConstellationArtImage(ConstellationsArt *obj);
 
 private:
+    /** Stars or deep sky objects of one trixel, recorded for rasterization by flush() */
+    struct DeferredBatch {
+        QVector<QPointF> pos;
+        QVector<float> size;            ///< Star width, or extent of the deep sky object on screen
+        QVector<char> sp;
+        QVector<DeepSkyObject*> objs;   ///< Empty for a batch of stars
+        QPen pen;
+        QBrush brush;
+        bool drawImage;
+    };
+
     virtual bool drawDeepSkyImage (const QPointF& pos, DeepSkyObject* obj,
                                          float positionAngle);
+    /** Draw the symbol and image of a deep sky object already projected to @p pos */
+    void drawDeepSkyObjectAt(const QPointF& pos, DeepSkyObject* obj, bool drawImage);
+    /** Rasterize the deferred batches that fall in the rows [@p top, @p top + band->height())
+        of the canvas into @p band. Called from the worker threads of flush(). */
+    void rasterizeBand(int top, QImage *band, const QPainterPath &clip, QPainter::RenderHints hints) const;
     QPaintDevice *m_pd;
     const Projector* m_proj;
     bool m_vectorStars;
+    bool m_parallel;
+    bool m_imageSprites; ///< Draw star bitmaps from QImages, which may be used off the GUI thread
+    /** @short Paint on pd from now on, with the same render hints and clipping */
+    void switchDevice( QPaintDevice *pd );
+
+    QVector<DeferredBatch> m_deferred;
+    SkyLayerCache *m_layerCache;
+    int m_layer;                ///< Number of layers begun in this frame
+    int m_layerDependencies;
+    bool m_skippingLayers;      ///< No layer has been drawn yet in this frame
+    bool m_layerSkipped;
+    QPixmap *m_layerImage;      ///< Pixmap of the layer being drawn, if it may be kept
     QSize m_size;
     static int starColorMode;
     static QColor m_starColor;
@@ -39,6 +39,7 @@
 #include "dialogs/finddialog.h"
 #include "dialogs/locationdialog.h"
 #include "geolocation.h"
+#include "skyobjects/ksephemeris.h"
 #include "skyobjects/skypoint.h"
 #include "skyobjects/skyobject.h"
 #include "skyobjects/starobject.h"
@@ -352,10 +353,12 @@ void AltVsTime::processObject( SkyObject *o, bool forceAdd ) {
 
     KSNumbers *num = new KSNumbers( getDate().djd() );
     KSNumbers *oldNum = 0;
+    KSEphemeris::Scope ephemeris;
 
     //If the object is in the solar system, recompute its position for the given epochLabel
     KStarsData* data = KStarsData::Instance();
     if ( o->isSolarSystem() ) {
+        KSEphemeris::Instance()->prepare( getDate().djd() - 1.0, getDate().djd() + 2.0 );
         oldNum = new KSNumbers( data->ut().djd() );
         o->updateCoords( num, true, geo->lat(), data->lst(), true );
     }
@@ -975,6 +978,10 @@ void AltVsTime::slotUpdateDateLoc() {
     KSNumbers *oldNum = 0;
     CachingDms LST = geo->GSTtoLST( today.gst() );
 
+    //The rise and set times of the Sun and planets are searched with many positions over the day
+    KSEphemeris::Scope ephemeris;
+    KSEphemeris::Instance()->prepare( today.djd() - 1.0, today.djd() + 2.0 );
+
     //First determine time of sunset and sunrise
     computeSunRiseSetTimes();
     // Determine dawn/dusk time and min/max sun elevation
@@ -30,6 +30,7 @@
 #include <QHeaderView>
 #include <QPointer>
 #include <QFileDialog>
+#include <QtConcurrent>
 
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -50,11 +51,15 @@
 #include "skyobjects/kspluto.h"
 #include "skyobjects/kscomet.h"
 #include "skyobjects/ksasteroid.h"
+#include "skyobjects/ksephemeris.h"
 #include "skycomponents/skymapcomposite.h"
 #include "skymap.h"
 
+// Objects searched by each job. Each job copies the planet once, and its results are listed together.
+#define CONJUNCTIONS_BATCH  16
+
 ConjunctionsTool::ConjunctionsTool(QWidget *parentSplit)
-    : QFrame(parentSplit), Object1( 0 ), Object2( 0 ) {
+    : QFrame(parentSplit), Object1( 0 ), Object2( 0 ), m_ProgressDlg( 0 ), m_Opposition( false ) {
 
     setupUi(this);
 
@@ -124,6 +129,10 @@ ConjunctionsTool::ConjunctionsTool(QWidget *parentSplit)
 
     m_index = 0;
 
+    m_Watcher = new QFutureWatcher< QList<Found> >( this );
+    connect( m_Watcher, SIGNAL( resultReadyAt(int) ), this, SLOT( slotConjunctionsFound(int) ) );
+    connect( m_Watcher, SIGNAL( finished() ), this, SLOT( slotComputeFinished() ) );
+
     // signals and slots connections
     connect(LocationButton, SIGNAL(clicked()), this, SLOT(slotLocation()));
     connect(Obj1FindButton, SIGNAL(clicked()), this, SLOT(slotFindObject()));
@@ -139,6 +148,11 @@ ConjunctionsTool::ConjunctionsTool(QWidget *parentSplit)
 }
 
 ConjunctionsTool::~ConjunctionsTool(){
+    // The jobs use the copies of the objects until they are done
+    slotAbort();
+    m_Watcher->waitForFinished();
+    slotComputeFinished();
+
     delete Object1;
     delete Object2;
 }
@@ -230,8 +244,18 @@ void ConjunctionsTool::slotFilterReg( const QString & filter)
     m_SortModel->setFilterKeyColumn( -1 );
 }
 
+void ConjunctionsTool::slotAbort()
+{
+    m_Abort.store( 1 );
+    m_Watcher->cancel();
+}
+
 void ConjunctionsTool::slotCompute (void)
 {
+    // A computation is already running
+    if( m_Watcher->isRunning() )
+        return;
+
     KStarsDateTime dtStart = startDate -> dateTime();   // Start date
     KStarsDateTime dtStop = stopDate -> dateTime();     // Stop date
     long double startJD = dtStart.djd();                // Start julian day
@@ -240,7 +264,6 @@ void ConjunctionsTool::slotCompute (void)
     if( Opposition->currentIndex() ) opposition = true;
     QStringList objects;                                // List of sky object used as Object1
     KStarsData *data = KStarsData::Instance();
-    int progress = 0;
 
     // Check if we have a valid angle in maxSeparationBox
     dms maxSeparation( 0.0 );
@@ -264,11 +287,6 @@ void ConjunctionsTool::slotCompute (void)
     	return;
     }
 
-    // Init KSConjunct object
-    KSConjunct ksc;
-    connect( &ksc, SIGNAL(madeProgress(int)), this, SLOT(showProgress(int)) );
-    ksc.setGeoLocation( geoPlace );
-
     switch ( FilterTypeComboBox->currentIndex() ) {
         case 1: // All object types
             foreach( int type, data->skyComposite()->objectNames().keys() )
@@ -334,42 +352,120 @@ void ConjunctionsTool::slotCompute (void)
         objects.removeAll( "Iapetus" );
     }
 
+    // The jobs search copies of the objects, the sky keeps its own
+    Searcher searcher;
+    searcher.startJD = startJD;
+    searcher.stopJD = stopJD;
+    searcher.maxSeparation = maxSeparation;
+    searcher.opposition = opposition;
+    searcher.geo = geoPlace;
+    searcher.abort = &m_Abort;
+    searcher.progressReceiver = NULL;
+
     if ( FilterTypeComboBox->currentIndex() != 0 ) {
-        // Show a progress dialog while processing
-        QProgressDialog progressDlg( i18n( "Compute conjunction..." ), i18n( "Abort" ), 0, objects.count(), this);
-        progressDlg.setWindowModality( Qt::WindowModal );
-        progressDlg.setValue( 0 );
-
-        foreach( QString object, objects ) {
-            // If the user click on the 'cancel' button
-            if ( progressDlg.wasCanceled() )
-                break;
-
-            // Update progress dialog
-            ++progress;
-            progressDlg.setValue( progress );
-            progressDlg.setLabelText( i18n( "Compute conjunction between %1 and %2", Object2->name(), object ) );
-
-            // Compute conjuction
-            Object1 = data->skyComposite()->findByName( object );
-            showConjunctions( ksc.findClosestApproach(*Object1, *Object2, startJD, stopJD, maxSeparation, opposition), object, Object2->name() );
+        Search search;
+        foreach( const QString &object, objects ) {
+            SkyObject *o = data->skyComposite()->findByName( object );
+            if ( o == NULL )
+                continue;
+
+            if ( search.objects.isEmpty() )
+                search.planet = static_cast<KSPlanetBase *>( Object2->clone() );
+            search.objects.append( o->clone() );
+
+            if ( search.objects.count() == CONJUNCTIONS_BATCH ) {
+                m_Searches.append( search );
+                search.objects.clear();
+            }
         }
+        if ( search.objects.isEmpty() == false )
+            m_Searches.append( search );
 
-        progressDlg.setValue( objects.count() );
+        // Show a progress dialog while processing
+        m_ProgressDlg = new QProgressDialog( i18n( "Compute conjunction..." ), i18n( "Abort" ), 0, m_Searches.count(), this );
+        m_ProgressDlg->setWindowModality( Qt::WindowModal );
+        m_ProgressDlg->setValue( 0 );
+        connect( m_ProgressDlg, SIGNAL( canceled() ), this, SLOT( slotAbort() ) );
+        connect( m_Watcher, SIGNAL( progressValueChanged(int) ), m_ProgressDlg, SLOT( setValue(int) ) );
     } else {
-        // Change cursor while we search for conjunction
-        QApplication::setOverrideCursor( QCursor(Qt::WaitCursor) );
+        Search search;
+        search.objects.append( Object1->clone() );
+        search.planet = static_cast<KSPlanetBase *>( Object2->clone() );
+        m_Searches.append( search );
 
+        searcher.progressReceiver = this;
         ComputeStack->setCurrentIndex( 1 );
-        showConjunctions( ksc.findClosestApproach(*Object1, *Object2, startJD, stopJD, maxSeparation, opposition), Object1->name(), Object2->name() );
-        ComputeStack->setCurrentIndex( 0 );
+    }
 
-        // Restore cursor
-        QApplication::restoreOverrideCursor();
+    // Fit the bodies over the whole interval once, rather than in every job. The rate of
+    // the separation is found a little beyond the ends.
+    QList<int> bodies;
+    bodies << KSEphemeris::EARTH << KSEphemeris::body( Object2 );
+    foreach( const Search &search, m_Searches ) {
+        foreach( SkyObject *object, search.objects ) {
+            KSPlanetBase *planet = dynamic_cast<KSPlanetBase *>( object );
+            if ( planet && bodies.contains( KSEphemeris::body( planet ) ) == false )
+                bodies << KSEphemeris::body( planet );
+        }
     }
+    KSEphemeris::Instance()->prepare( startJD - 1.0, stopJD + 1.0, bodies );
 
     delete Object2;
     Object2 = NULL;
+
+    m_Opposition = opposition;
+    m_Abort.store( 0 );
+    ComputeButton->setEnabled( false );
+    m_Watcher->setFuture( QtConcurrent::mapped( m_Searches, searcher ) );
+}
+
+QList<ConjunctionsTool::Found> ConjunctionsTool::Searcher::operator()( const Search &search ) const
+{
+    QList<Found> found;
+
+    // The ephemeris prepared by the tool is only used by the jobs
+    KSEphemeris::Scope ephemeris;
+
+    // One instance per job, with its own Earth
+    KSConjunct ksc;
+    ksc.setGeoLocation( geo );
+    ksc.setAbortFlag( abort );
+    if ( progressReceiver )
+        QObject::connect( &ksc, SIGNAL(madeProgress(int)), progressReceiver, SLOT(showProgress(int)) );
+
+    foreach( SkyObject *object, search.objects ) {
+        if ( abort->load() )
+            break;
+
+        Found f;
+        f.object1 = object->name();
+        f.object2 = search.planet->name();
+        f.conjunctions = ksc.findClosestApproach( *object, *search.planet, startJD, stopJD, maxSeparation, opposition );
+        found.append( f );
+    }
+
+    return found;
+}
+
+void ConjunctionsTool::slotConjunctionsFound( int index )
+{
+    foreach( const Found &f, m_Watcher->resultAt( index ) )
+        showConjunctions( f.conjunctions, f.object1, f.object2 );
+}
+
+void ConjunctionsTool::slotComputeFinished()
+{
+    foreach( const Search &search, m_Searches ) {
+        qDeleteAll( search.objects );
+        delete search.planet;
+    }
+    m_Searches.clear();
+
+    delete m_ProgressDlg;
+    m_ProgressDlg = NULL;
+
+    ComputeStack->setCurrentIndex( 0 );
+    ComputeButton->setEnabled( true );
 }
 
 void ConjunctionsTool::showProgress(int n) {
@@ -386,7 +482,7 @@ void ConjunctionsTool::showConjunctions(const QMap<long double, dms> &conjunctio
         dt.setDJD( it.key() );
         QStandardItem* typeItem;
 
-        if ( ! Opposition->currentIndex() )
+        if ( ! m_Opposition )
             typeItem = new QStandardItem( i18n( "Conjunction" ) );
         else
             typeItem = new QStandardItem( i18n( "Opposition" ) );
@@ -27,6 +27,8 @@
 
 #include <QTextStream>
 #include <QAbstractTableModel>
+#include <QAtomicInt>
+#include <QFutureWatcher>
 #include <QStandardItemModel>
 #include <QSortFilterProxyModel>
 
@@ -36,10 +38,14 @@
 
 class GeoLocation;
 class KSPlanetBase;
+class QProgressDialog;
 class dms;
 
 /**
   *@short Predicts conjunctions using KSConjunct in the background
+  *
+  *The objects are searched in jobs that run in parallel, each on its own copies of the
+  *objects. The conjunctions are listed as soon as the job that found them is done.
   */
 
 class ConjunctionsTool : public QFrame, public Ui::ConjunctionsDlg {
@@ -61,8 +67,41 @@ public slots:
     void slotClear();
     void slotExport();
     void slotFilterReg( const QString & );
+    void slotAbort();
+
+private slots:
+    void slotConjunctionsFound( int index );
+    void slotComputeFinished();
 
 private:
+    /* Conjunctions found between two objects */
+    struct Found {
+        QString object1;
+        QString object2;
+        QMap<long double, dms> conjunctions;
+    };
+
+    /* Copies of the objects searched by one job, deleted when the computation is over */
+    struct Search {
+        QList<SkyObject *> objects;
+        KSPlanetBase *planet;
+    };
+
+    /* Searches one job in a worker thread */
+    struct Searcher {
+        typedef QList<Found> result_type;
+
+        long double startJD;
+        long double stopJD;
+        dms maxSeparation;
+        bool opposition;
+        GeoLocation *geo;
+        const QAtomicInt *abort;
+        ConjunctionsTool *progressReceiver;   // Shows the progress of a single object
+
+        QList<Found> operator()( const Search &search ) const;
+    };
+
     SkyObject *Object1;
     KSPlanetBase *Object2;        // Second object is always a planet.
 
@@ -77,6 +116,12 @@ private:
     QSortFilterProxyModel *m_SortModel;
 
     int m_index;
+
+    QFutureWatcher< QList<Found> > *m_Watcher;
+    QList<Search> m_Searches;
+    QProgressDialog *m_ProgressDlg;
+    QAtomicInt m_Abort;
+    bool m_Opposition;
 };
 
 #endif
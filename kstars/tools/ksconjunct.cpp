@@ -20,14 +20,27 @@
 #include <cmath>
 
 #include "ksnumbers.h"
+#include "skyobjects/ksephemeris.h"
 #include "skyobjects/ksplanetbase.h"
 #include "skyobjects/ksplanet.h"
 #include "skyobjects/ksasteroid.h"
 #include "skyobjects/kscomet.h"
 #include "kstarsdata.h"
 
-KSConjunct::KSConjunct() {
+// Samples of the separation over the shortest period of the apparent motion of the objects
+#define CONJUNCT_SAMPLES     32
+// Interval over which the rate of the separation is found, in days
+#define CONJUNCT_RATE_STEP   0.001
+// Precision of the time of the minimum, in days
+#define CONJUNCT_PRECISION   ( 10.0 / 86400.0 )
+
+KSConjunct::KSConjunct() : abortFlag( NULL ) {
     geoPlace = KStarsData::Instance()->geo();
+    m_Earth = new KSPlanet( I18N_NOOP( "Earth" ), QString(), QColor( "white" ), 12756.28 /*diameter in km*/ );
+}
+
+KSConjunct::~KSConjunct() {
+    delete m_Earth;
 }
 
 void KSConjunct::setGeoLocation( GeoLocation *geo ) {
@@ -37,94 +50,59 @@ void KSConjunct::setGeoLocation( GeoLocation *geo ) {
         geoPlace = KStarsData::Instance()->geo();
 }
 
+void KSConjunct::setAbortFlag( const QAtomicInt *flag ) {
+    abortFlag = flag;
+}
+
 QMap<long double, dms> KSConjunct::findClosestApproach(SkyObject& Object1, KSPlanetBase& Object2, long double startJD, long double stopJD, dms maxSeparation,bool _opposition) {
 
   QMap<long double, dms> Separations;
   QPair<long double, dms> extremum;
-  dms Dist;
-  dms prevDist;
-  double step, step0;
-  int Sign, prevSign;
   opposition=_opposition;
-  //  qDebug() << "Entered KSConjunct::findClosestApproach() with startJD = " << (double)startJD;
-  //  qDebug() << "Initial Positional Information: \n";
-  //  qDebug() << Object1.name() << ": RA = " << Object1.ra() -> toHMSString() << "; Dec = " << Object1.dec() -> toDMSString() << "\n";
-  //  qDebug() << Object2.name() << ": RA = " << Object2.ra() -> toHMSString() << "; Dec = " << Object2.dec() -> toDMSString() << "\n";
-  prevSign = 0;
-
-  step0 = (stopJD - startJD) / 4.0;  // I'm an idiot for having done this without having the lines that follow -- asimha
-
-  // TODO: Work out a solid footing on which one can decide step0. -- asimha
-  if( step0 > 24.8 * 365.25 ) // Sample pluto's orbit (248.09 years) at least 10 times.
-      step0 = 24.8 * 365.25;
-
-  // FIXME: This can be done better, but for now, I'm doing it the dumb way -- asimha
-  if( Object1.name() == i18n( "Neptune" ) || Object2.name() == i18n( "Neptune" ) || Object1.name() == i18n( "Uranus" ) || Object2.name() == i18n( "Uranus" ) )
-      if( step0 > 3652.5 )
-          step0 = 3652.5;
-  if( Object1.name() == i18n( "Jupiter" ) || Object2.name() == i18n( "Jupiter" ) || Object1.name() == i18n( "Saturn" ) || Object2.name() == i18n( "Saturn" ) )
-      if( step0 > 365.25 )
-          step0 = 365;
-  if(Object1.name() == i18n( "Mars" ) || Object2.name() == i18n( "Mars" ))
-    if (step0 > 10.0)
-      step0 = 10.0;
-  if(Object1.name() == i18n( "Venus" ) || Object1.name() == i18n( "Mercury" ) || Object2.name() == i18n( "Mercury" ) || Object2.name() == i18n( "Venus" ))
-    if (step0 > 5.0)
-      step0 = 5.0;
-  if(Object1.name() == "Moon" || Object2.name() == "Moon")
-    if (step0 > 0.25)
-      step0 = 0.25;
-
-  step = step0;
-
-  //	qDebug() << "Initial Separation between " << Object1.name() << " and " << Object2.name() << " = " << (prevDist.toDMSString());
-
-  long double jd = startJD;
-  prevDist = findDistance(jd, &Object1, &Object2);
-  jd += step;
-  while ( jd <= stopJD ) {
-    int progress = int( 100.0*(jd - startJD)/(stopJD - startJD) );
-    emit madeProgress( progress );
-
-    Dist = findDistance(jd, &Object1, &Object2);
-    Sign = sgn(Dist - prevDist);
-    //	qDebug() << "Dist = " << Dist.toDMSString() << "; prevDist = " << prevDist.toDMSString() << "; Difference = " << (Dist.Degrees() - prevDist.Degrees()) << "; Step = " << step;
-
-    //How close are we to a conjunction, and how fast are we approaching one?
-    double factor = fabs( (Dist.Degrees() - prevDist.Degrees()) / Dist.Degrees());
-    if ( factor > 10.0 ) { //let's go faster!
-        step = step0 * factor/10.0;
-    } else { //slow down, we're getting close!
-        step = step0;
-    }
 
-    if( Sign != prevSign && prevSign == -1) { //all right, we may have just passed a conjunction
-        if ( step > step0 ) { //mini-loop to back up and make sure we're close enough
-            //            qDebug() << "Entering slow loop: " << endl;
-            jd -= step;
-            step = step0;
-            Sign = prevSign;
-            while ( jd <= stopJD ) {
-                Dist = findDistance(jd, &Object1, &Object2);
-                Sign = sgn(Dist - prevDist);
-                //	qDebug() << "Dist=" << Dist.toDMSString() << "; prevDist=" << prevDist.toDMSString() << "; Diff=" << (Dist.Degrees() - prevDist.Degrees()) << "djd=" << (int)(jd - startJD);
-                if ( Sign != prevSign ) break;
-
-                prevDist = Dist;
-                prevSign = Sign;
-                jd += step;
-            }
-        }
-
-        //	qDebug() << "Sign = " << Sign << " and " << "prevSign = " << prevSign << ": Entering findPrecise()\n";
-        if(findPrecise(&extremum, &Object1, &Object2, jd, step, Sign))
-            if(extremum.second.radians() < maxSeparation.radians())
+  if( stopJD <= startJD )
+      return Separations;
+
+  // The separation may go through a minimum in every loop of the apparent motion of either object
+  double period = apparentPeriod( &Object1 );
+  double period2 = apparentPeriod( &Object2 );
+  if( period == 0.0 || ( period2 > 0.0 && period2 < period ) )
+      period = period2;
+
+  const int steps = qMax( 2, int( ceil( ( stopJD - startJD ) * CONJUNCT_SAMPLES / period ) ) );
+  const long double step = ( stopJD - startJD ) / steps;
+
+  long double jd0 = startJD;
+  long double jd1 = startJD + step;
+  double dist0 = findDistance(jd0, &Object1, &Object2).radians();
+  double dist1 = findDistance(jd1, &Object1, &Object2).radians();
+  int lastProgress = 0;
+
+  for( int i = 2; i <= steps; ++i ) {
+    if( abortFlag != NULL && abortFlag->load() )
+        break;
+
+    long double jd2 = startJD + i * step;
+    double dist2 = findDistance(jd2, &Object1, &Object2).radians();
+
+    // A minimum among the samples. The separation is convex around a close approach, so it
+    // cannot fall below the smallest sample by more than the larger of the two differences.
+    if( dist1 < dist0 && dist1 <= dist2 && dist1 - qMax( dist0 - dist1, dist2 - dist1 ) < maxSeparation.radians() ) {
+        if( findPrecise(&extremum, &Object1, &Object2, jd0, jd2) )
+            if( extremum.second.radians() < maxSeparation.radians() )
                 Separations.insert(extremum.first, extremum.second);
     }
 
-    prevDist = Dist;
-    prevSign = Sign;
-    jd += step;
+    int progress = 100 * i / steps;
+    if( progress != lastProgress ) {
+        emit madeProgress( progress );
+        lastProgress = progress;
+    }
+
+    jd0 = jd1;
+    dist0 = dist1;
+    jd1 = jd2;
+    dist1 = dist2;
   }
 
   return Separations;
@@ -137,7 +115,7 @@ dms KSConjunct::findDistance(long double jd, SkyObject *Object1, KSPlanetBase *O
   KSNumbers num(jd);
   dms dist;
 
-  KSPlanet *m_Earth = new KSPlanet( I18N_NOOP( "Earth" ), QString(), QColor( "white" ), 12756.28 /*diameter in km*/ );
+  // The same Earth serves both objects
   m_Earth -> findPosition( &num );
   CachingDms LST(geoPlace->GSTtoLST(t.gst()));
 
@@ -155,50 +133,69 @@ dms KSConjunct::findDistance(long double jd, SkyObject *Object1, KSPlanetBase *O
   return dist;
 }
 
-bool KSConjunct::findPrecise(QPair<long double, dms> *out, SkyObject *Object1, KSPlanetBase *Object2, long double jd, double step, int prevSign) {
-  dms prevDist;
-  int Sign;
-  dms Dist;
+double KSConjunct::findRate(long double jd, SkyObject *Object1, KSPlanetBase *Object2)
+{
+  return ( findDistance(jd + CONJUNCT_RATE_STEP, Object1, Object2).radians()
+           - findDistance(jd - CONJUNCT_RATE_STEP, Object1, Object2).radians() ) / ( 2 * CONJUNCT_RATE_STEP );
+}
 
+bool KSConjunct::findPrecise(QPair<long double, dms> *out, SkyObject *Object1, KSPlanetBase *Object2, long double low, long double high) {
   if( out == NULL ) {
     qDebug() << "ERROR: Argument out to KSConjunct::findPrecise(...) was NULL!";
     return false;
   }
 
-  prevDist = findDistance(jd, Object1, Object2);
+  double rateLow = findRate(low, Object1, Object2);
+  double rateHigh = findRate(high, Object1, Object2);
 
-  step = -step / 2.0;
-  prevSign = -prevSign;
-
-  while(true) {
-    jd += step;
-    Dist = findDistance(jd, Object1, Object2);
-    //    qDebug() << "Dist=" << Dist.toDMSString() << "; prevDist=" << prevDist.toDMSString() << "; Diff=" << (Dist.Degrees() - prevDist.Degrees()) << "step=" << step;
+  // The separation must decrease, then increase
+  if( rateLow >= 0 || rateHigh <= 0 )
+    return false;
 
-    if(fabs(step) < 1.0 / (24.0*60.0) ) {
-      out -> first = jd - step / 2.0;
-      out -> second = findDistance(jd - step/2.0, Object1, Object2);
-      if(out -> second.radians() < findDistance(jd - 5.0, Object1, Object2).radians())
-        return true;
-      else
-        return false;
-    }
-    Sign = sgn(Dist - prevDist);
-    if(Sign != prevSign) {
-      step = -step / 2.0;
-      Sign = -Sign;
+  // Regula falsi on the rate, with the Illinois modification: when the same end of the interval
+  // is kept twice in a row, the rate there is halved so that it moves as well
+  int moved = 0;
+  for( int i = 0; i < 64 && high - low > CONJUNCT_PRECISION; ++i ) {
+    long double jd = ( low * rateHigh - high * rateLow ) / ( rateHigh - rateLow );
+    double rate = findRate(jd, Object1, Object2);
+
+    if( rate < 0 ) {
+      low = jd;
+      rateLow = rate;
+      if( moved < 0 )
+        rateHigh /= 2;
+      moved = -1;
+    } else if( rate > 0 ) {
+      high = jd;
+      rateHigh = rate;
+      if( moved > 0 )
+        rateLow /= 2;
+      moved = 1;
+    } else {
+      low = high = jd;
     }
-    prevSign = Sign;
-    prevDist = Dist;
   }
-}
-
-int KSConjunct::sgn(dms a) {
-
-  // Auxiliary function used by the KSConjunct::findClosestApproach(...)
-  // method and the KSConjunct::findPrecise(...) method
-
-  return ((a.radians() > 0)?1:((a.radians() < 0)?-1:0));
 
+  out -> first = ( low + high ) / 2;
+  out -> second = findDistance(out -> first, Object1, Object2);
+  return true;
 }
 
+double KSConjunct::apparentPeriod(const SkyObject *object) {
+  const KSPlanetBase *planet = dynamic_cast<const KSPlanetBase*>(object);
+  if( planet == NULL )
+    return 0.0;
+
+  // The sidereal month, and the orbits of Mercury and Venus. The motion of the
+  // other objects goes through a loop every year, as seen from the Earth.
+  switch( KSEphemeris::body( planet ) ) {
+    case KSEphemeris::MOON:
+      return 27.32;
+    case KSEphemeris::MERCURY:
+      return 87.97;
+    case KSEphemeris::VENUS:
+      return 224.70;
+    default:
+      return 365.25;
+  }
+}
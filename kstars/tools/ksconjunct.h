@@ -19,6 +19,7 @@
 #ifndef KSCONJUNCT_H_
 #define KSCONJUNCT_H_
 
+#include <QAtomicInt>
 #include <QMap>
 #include <QObject>
 
@@ -39,6 +40,11 @@ class dms;
   *A class that implements a method to compute close conjunctions between any two solar system
   *objects excluding planetary moons. Given two such objects, this class has implementations of
   *algorithms required to find the time of closest approach in a given range of time.
+  *
+  *The separation is sampled at a fraction of the shortest period of the apparent motion of
+  *the objects, and each minimum found on the samples is refined by finding where the rate of
+  *the separation changes sign. The objects are only read and written by the instance that
+  *searches them, so that several instances may search different objects in parallel.
   *@short Implements algorithms to find close conjunctions of planets in a given time range.
   *@author Akarsh Simha
   *@version 1.0
@@ -49,16 +55,16 @@ class KSConjunct :public QObject {
  
  public:
   /**
-    *Constructor.  Instantiates a KSNumbers for internal computations.
+    *Constructor.  Instantiates the Earth used for internal computations.
     */
   
   KSConjunct();
 
   /**
-   *Destructor.  (Empty)
+   *Destructor.
    */
 
-  ~KSConjunct() { }
+  ~KSConjunct();
 
   /**
    *@short Sets the geographic location to compute conjunctions at
@@ -67,6 +73,13 @@ class KSConjunct :public QObject {
    */
   void setGeoLocation( GeoLocation *geo );
 
+  /**
+   *@short Stop the search as soon as the flag is set
+   *
+   *@param flag  Pointer to a flag shared with the thread that may abort the search, or NULL
+   */
+  void setAbortFlag( const QAtomicInt *flag );
+
   /**
    *@short Compute the closest approach of two planets in the given range
    *
@@ -78,6 +91,9 @@ class KSConjunct :public QObject {
    *                       how close the conjunction should be to be output.
    *@param opposition A parameter to see if we are computing conjunction or opposition
    *@return Hash containing julian days of close conjunctions against separation
+   *@note The positions of Object1 and Object2 are changed by the search.
+   *@note The caller prepares KSEphemeris over the period, slightly widened, once for all the searches,
+   *and holds a KSEphemeris::Scope in the thread of the search.
    */
 
   QMap<long double, dms> findClosestApproach(SkyObject& Object1, KSPlanetBase& Object2, long double startJD, long double stopJD, dms maxSeparation, bool _opposition=false);
@@ -97,39 +113,43 @@ class KSConjunct :public QObject {
     *@return The angular distance between the two bodies.
     */
 
-  // TODO: Make pointers to Object1 and Object2 private objects instead of passing them to the methods again and again. 
-  //       Should improve performance, at least marginally.
-
   dms findDistance(long double jd, SkyObject *Object1, KSPlanetBase *Object2);
 
+  /**
+    *@short Finds the rate of change of the angular distance between two objects.
+    *
+    *@return The rate, in radians per day
+    */
+
+  double findRate(long double jd, SkyObject *Object1, KSPlanetBase *Object2);
+
   /**
     *@short Compute the precise value of the extremum once the extremum has been detected.
     *
     *@param out  A pointer to a QPair that stores the Julian Day and Separation corresponding to the extremum
     *@param Object1  A pointer to the first solar system body
     *@param Object2  A pointer to the second solar system body
-    *@param jd  Julian day corresponding to the endpoint of the interval where extremum was detected.
-    *@param step  The step in jd taken during computation earlier. (Defines the interval size)
-    *@param prevSign The previous sign of increment in moving from jd - step to jd
+    *@param low  Julian day before the minimum, where the separation decreases
+    *@param high  Julian day after the minimum, where the separation increases
     *
-    *@return true if the extremum is a minimum
+    *@return true if a minimum was found between low and high
     */
 
-  bool findPrecise(QPair<long double, dms> *out, SkyObject *Object1, KSPlanetBase *Object2, long double jd, double step, int prevSign);
+  bool findPrecise(QPair<long double, dms> *out, SkyObject *Object1, KSPlanetBase *Object2, long double low, long double high);
 
   /**
-    *@short Return the sign of an angle
-    *
-    *@param a  The angle whose sign has to be returned
+    *@short The period of the apparent motion of an object
     *
-    *@return (-1, 0, 1) if a.radians() is (-ve, zero, +ve)
+    *@return The shortest period over which the separation to the object may go
+    *through a minimum, in days. Fixed objects have none, and return 0.
     */
 
-  int sgn(dms a);
+  static double apparentPeriod(const SkyObject *object);
 
   bool opposition;
   GeoLocation *geoPlace;
+  KSPlanet *m_Earth;
+  const QAtomicInt *abortFlag;
 };
 
 #endif
-  
@@ -687,6 +687,7 @@ void ObsListWizard::applyFilters( bool doBuildList )
     //Comets
     if ( isItemSelected( i18n( "Comets" ), olw->TypeList ) )
     {
+        data->skyComposite()->updateCulledBodies();
         foreach ( SkyObject *o, data->skyComposite()->comets() )
         {
             if ( olw->SelectByMagnitude->isChecked() )
@@ -729,6 +730,7 @@ void ObsListWizard::applyFilters( bool doBuildList )
     //Asteroids
     if ( isItemSelected( i18n( "Asteroids" ), olw->TypeList ) )
     {
+        data->skyComposite()->updateCulledBodies();
         foreach ( SkyObject *o, data->skyComposite()->asteroids() )
         {
             if ( olw->SelectByMagnitude->isChecked() )
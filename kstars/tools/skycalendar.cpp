@@ -32,6 +32,7 @@
 #include "dialogs/locationdialog.h"
 #include "kstarsdatetime.h"
 #include "kstarsdata.h"
+#include "skyobjects/ksephemeris.h"
 #include "skyobjects/ksplanet.h"
 #include "skycomponents/skymapcomposite.h"
 
@@ -140,6 +141,13 @@ void SkyCalendar::addPlanetEvents( int nPlanet ) {
     QColor pColor = ksp->color();
     QVector<QPointF> vRise, vSet, vTransit;
 
+    // The rise, set and transit times are searched with many positions over the year
+    KSEphemeris::Scope ephemeris;
+    QList<int> bodies;
+    bodies << KSEphemeris::EARTH << KSEphemeris::body( ksp );
+    KSEphemeris::Instance()->prepare( KStarsDateTime( QDate( year(), 1, 1 ), QTime() ).djd() - 1.0,
+                                      KStarsDateTime( QDate( year() + 1, 1, 1 ), QTime() ).djd() + 1.0, bodies );
+
     for( KStarsDateTime kdt( QDate( year(), 1, 1 ), QTime( 12, 0, 0 ) );
          kdt.date().year() == year();
          kdt = kdt.addDays( scUI->spinBox_Interval->value() ) )
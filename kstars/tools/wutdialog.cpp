@@ -35,6 +35,7 @@
 #include "dialogs/detaildialog.h"
 #include "dialogs/locationdialog.h"
 #include "dialogs/timedialog.h"
+#include "skyobjects/ksephemeris.h"
 #include "skyobjects/kssun.h"
 #include "skyobjects/ksmoon.h"
 #include "skycomponents/skymapcomposite.h"
@@ -144,6 +145,10 @@ void WUTDialog::init() {
         m_CategoryInitialized[ c ] = false;
     }
 
+    //The rise and set times are searched with many positions over the night
+    KSEphemeris::Scope ephemeris;
+    KSEphemeris::Instance()->prepare( UT0.djd() - 1.0, UT0.djd() + 1.0 );
+
     // sun almanac information
     KSSun *oSun = dynamic_cast<KSSun*>( data->objectNamed("Sun") );
     sunRiseTomorrow = oSun->riseSetTime( TomorrowUT, geo, true );
@@ -291,6 +296,7 @@ void WUTDialog::slotLoadList( const QString &c ) {
         }
 
         else if ( c == m_Categories[6] ) { //Asteroids
+            data->skyComposite()->updateCulledBodies();
             foreach ( SkyObject *o, data->skyComposite()->asteroids() )
             if ( checkVisibility(o) && o->name() != i18n("Pluto") && o->mag() <= m_Mag )
                 visibleObjects(c).append(o);
@@ -299,6 +305,7 @@ void WUTDialog::slotLoadList( const QString &c ) {
         }
 
         else if ( c == m_Categories[7] ) { //Comets
+            data->skyComposite()->updateCulledBodies();
             foreach ( SkyObject *o, data->skyComposite()->comets() )
             if ( checkVisibility(o) && o->mag() <= m_Mag)
                 visibleObjects(c).append(o);